@@ -0,0 +1,169 @@
+#include "epaper_arena.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "epaper_arena";
+
+// Frames are word aligned and padded to a word for DMA
+#define EPD_ARENA_SLOT  ((EPD_FRAME_SIZE + 3) & ~3)
+
+// Scratch: always internal DMA RAM, available without EPD_Arena_Init
+static DMA_ATTR uint8_t s_bounce[EPD_ARENA_BOUNCE_COUNT][EPD_ARENA_BOUNCE_SIZE];
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+static DMA_ATTR uint8_t s_native[EPD_NATIVE_FRAME_SIZE];
+#define EPD_ARENA_SCRATCH_BYTES (sizeof(s_bounce) + sizeof(s_native))
+#else
+#define EPD_ARENA_SCRATCH_BYTES (sizeof(s_bounce))
+#endif
+
+#if defined(CONFIG_CROWPANEL_EPAPER_ARENA_STATIC)
+#if CONFIG_CROWPANEL_EPAPER_ARENA_SHADOW
+#define EPD_ARENA_STATIC_SHADOW 1
+#else
+#define EPD_ARENA_STATIC_SHADOW 0
+#endif
+#if CONFIG_CROWPANEL_EPAPER_ARENA_OLD_RAM
+#define EPD_ARENA_STATIC_OLD_RAM 1
+#else
+#define EPD_ARENA_STATIC_OLD_RAM 0
+#endif
+#define EPD_ARENA_STATIC_SLOTS (CONFIG_CROWPANEL_EPAPER_ARENA_FRAMES + EPD_ARENA_STATIC_SHADOW + EPD_ARENA_STATIC_OLD_RAM)
+#if EPD_ARENA_STATIC_SLOTS > 0
+static DMA_ATTR uint8_t s_static[EPD_ARENA_STATIC_SLOTS * EPD_ARENA_SLOT];
+#endif
+#endif
+
+static struct {
+    bool ready;
+    EPD_ArenaConfig_t cfg;
+    EPD_ArenaPlacement_t placement; // Actual placement after fallback
+    uint8_t *block;                 // frames, then the shadow, then the mirror
+    bool heap;                      // block came from heap_caps_malloc
+} s_arena;
+
+static size_t EPD_Arena_Slots(const EPD_ArenaConfig_t *config) {
+    return config->frames + (config->shadow ? 1 : 0) + (config->old_ram ? 1 : 0);
+}
+
+static uint8_t *EPD_Arena_Alloc(EPD_ArenaPlacement_t placement, size_t size, bool *heap) {
+    *heap = false;
+    switch (placement) {
+        case EPD_ARENA_STATIC:
+#if defined(CONFIG_CROWPANEL_EPAPER_ARENA_STATIC) && EPD_ARENA_STATIC_SLOTS > 0
+            return (size <= sizeof(s_static)) ? s_static : NULL;
+#else
+            return NULL;
+#endif
+        case EPD_ARENA_PSRAM:
+            *heap = true;
+            return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        case EPD_ARENA_INTERNAL_DMA:
+        default:
+            *heap = true;
+            return heap_caps_malloc(size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    }
+}
+
+esp_err_t EPD_Arena_Init(const EPD_ArenaConfig_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_arena.ready) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t slots = EPD_Arena_Slots(config);
+    size_t size = slots * EPD_ARENA_SLOT;
+    EPD_ArenaPlacement_t placement = config->placement;
+    uint8_t *block = NULL;
+    bool heap = false;
+
+    if (size > 0) {
+        block = EPD_Arena_Alloc(placement, size, &heap);
+        if (block == NULL && placement == EPD_ARENA_PSRAM) {
+            ESP_LOGW(TAG, "No PSRAM for %u bytes, using internal RAM", (unsigned)size);
+            placement = EPD_ARENA_INTERNAL_DMA;
+            block = EPD_Arena_Alloc(placement, size, &heap);
+        }
+        if (block == NULL) {
+            ESP_LOGE(TAG, "Failed to reserve %u frames (%u bytes)", (unsigned)slots, (unsigned)size);
+            return (placement == EPD_ARENA_STATIC) ? ESP_ERR_INVALID_SIZE : ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_arena.cfg = *config;
+    s_arena.placement = placement;
+    s_arena.block = block;
+    s_arena.heap = heap;
+    s_arena.ready = true;
+    EPD_Arena_LogFootprint();
+    return ESP_OK;
+}
+
+void EPD_Arena_Deinit(void) {
+    if (s_arena.heap) {
+        heap_caps_free(s_arena.block);
+    }
+    memset(&s_arena, 0, sizeof(s_arena));
+}
+
+bool EPD_Arena_Ready(void) {
+    return s_arena.ready;
+}
+
+uint8_t *EPD_Arena_Frame(uint8_t index) {
+    if (!s_arena.ready || index >= s_arena.cfg.frames) {
+        return NULL;
+    }
+    return s_arena.block + (size_t)index * EPD_ARENA_SLOT;
+}
+
+uint8_t *EPD_Arena_Shadow(void) {
+    if (!s_arena.ready || !s_arena.cfg.shadow) {
+        return NULL;
+    }
+    return s_arena.block + (size_t)s_arena.cfg.frames * EPD_ARENA_SLOT;
+}
+
+uint8_t *EPD_Arena_OldRam(void) {
+    if (!s_arena.ready || !s_arena.cfg.old_ram) {
+        return NULL;
+    }
+    return s_arena.block + (size_t)(EPD_Arena_Slots(&s_arena.cfg) - 1) * EPD_ARENA_SLOT;
+}
+
+uint8_t *EPD_Arena_Bounce(uint8_t index) {
+    return s_bounce[index % EPD_ARENA_BOUNCE_COUNT];
+}
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+uint8_t *EPD_Arena_Native(void) {
+    return s_native;
+}
+#endif
+
+void EPD_Arena_GetFootprint(EPD_ArenaFootprint_t *footprint) {
+    if (footprint == NULL) return;
+    memset(footprint, 0, sizeof(*footprint));
+    footprint->scratch_bytes = EPD_ARENA_SCRATCH_BYTES;
+    if (!s_arena.ready) return;
+
+    footprint->placement = s_arena.placement;
+    footprint->frames = s_arena.cfg.frames;
+    footprint->shadow = s_arena.cfg.shadow;
+    footprint->old_ram = s_arena.cfg.old_ram;
+    footprint->frame_bytes = EPD_Arena_Slots(&s_arena.cfg) * EPD_ARENA_SLOT;
+    footprint->heap_bytes = s_arena.heap ? footprint->frame_bytes : 0;
+}
+
+void EPD_Arena_LogFootprint(void) {
+    static const char *const names[] = { "internal DMA", "PSRAM", "static" };
+    EPD_ArenaFootprint_t fp;
+
+    EPD_Arena_GetFootprint(&fp);
+    ESP_LOGI(TAG, "%u frame(s)%s%s in %s: %u bytes (%u from heap), scratch %u bytes static",
+             fp.frames, fp.shadow ? " + shadow" : "", fp.old_ram ? " + 0x26 mirror" : "", names[fp.placement],
+             (unsigned)fp.frame_bytes, (unsigned)fp.heap_bytes, (unsigned)fp.scratch_bytes);
+}
@@ -0,0 +1,216 @@
+#include "epaper_asset.h"
+#include <string.h>
+
+// Decoded rows staged per EPD_Display_Native_Write
+#define EPD_ASSET_STAGE 256
+
+static size_t EPD_Asset_Stride(const EPD_Asset_t *asset) {
+    return (asset->width + 7) / 8;
+}
+
+// One PackBits row of len bytes into out (NULL only checks it); the
+// converter never lets a run cross a row. Returns the bytes consumed, 0 on
+// corrupt data.
+static size_t EPD_Asset_UnpackRow(const uint8_t *in, size_t avail, uint8_t *out, size_t len) {
+    size_t i = 0, o = 0;
+    while (o < len) {
+        if (i >= avail) return 0;
+        int8_t n = (int8_t)in[i++];
+        if (n >= 0) {
+            size_t count = (size_t)n + 1;
+            if (o + count > len || i + count > avail) return 0;
+            if (out) memcpy(out + o, in + i, count);
+            i += count;
+            o += count;
+        } else if (n != -128) {
+            size_t count = 1 - (int)n;
+            if (o + count > len || i >= avail) return 0;
+            if (out) memset(out + o, in[i], count);
+            i++;
+            o += count;
+        }
+    }
+    return i;
+}
+
+static bool EPD_Asset_Valid(const EPD_Asset_t *asset) {
+    if (asset == NULL || asset->data == NULL || asset->width == 0 ||
+        asset->raw_size != EPD_Asset_Stride(asset) * asset->height) {
+        return false;
+    }
+    if (asset->compression == EPD_ASSET_RAW) {
+        return asset->size == asset->raw_size;
+    }
+    if (asset->compression != EPD_ASSET_PACKBITS) {
+        return false;
+    }
+    size_t stride = EPD_Asset_Stride(asset), pos = 0;
+    for (uint16_t r = 0; r < asset->height; r++) {
+        size_t used = EPD_Asset_UnpackRow(asset->data + pos, asset->size - pos, NULL, stride);
+        if (used == 0) return false;
+        pos += used;
+    }
+    return pos == asset->size;
+}
+
+esp_err_t EPD_Asset_Decode(const EPD_Asset_t *asset, uint8_t *out, size_t out_size) {
+    if (asset == NULL || out == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (out_size < asset->raw_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!EPD_Asset_Valid(asset)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (asset->compression == EPD_ASSET_RAW) {
+        memcpy(out, asset->data, asset->raw_size);
+        return ESP_OK;
+    }
+    size_t stride = EPD_Asset_Stride(asset), pos = 0;
+    for (uint16_t r = 0; r < asset->height; r++, out += stride) {
+        pos += EPD_Asset_UnpackRow(asset->data + pos, asset->size - pos, out, stride);
+    }
+    return ESP_OK;
+}
+
+// One row of len bytes PackBits-encoded into out: runs of 2 to 128 equal
+// bytes, literals of up to 128 others. Returns the bytes written, 0 when
+// they do not fit in avail.
+static size_t EPD_Asset_PackRow(const uint8_t *row, size_t len, uint8_t *out, size_t avail) {
+    size_t i = 0, o = 0;
+    while (i < len) {
+        size_t run = 1;
+        while (i + run < len && run < 128 && row[i + run] == row[i]) run++;
+        if (run >= 2) {
+            if (o + 2 > avail) return 0;
+            out[o++] = (uint8_t)(257 - run);
+            out[o++] = row[i];
+            i += run;
+            continue;
+        }
+        // Literal up to the next pair of equal bytes
+        size_t start = i;
+        while (i < len && i - start < 128) {
+            if (i + 1 < len && row[i + 1] == row[i]) break;
+            i++;
+        }
+        size_t count = i - start;
+        if (o + 1 + count > avail) return 0;
+        out[o++] = (uint8_t)(count - 1);
+        memcpy(out + o, row + start, count);
+        o += count;
+    }
+    return o;
+}
+
+esp_err_t EPD_Asset_Encode(const uint8_t *src, uint16_t width, uint16_t height,
+                           uint8_t *out, size_t out_size, EPD_Asset_t *asset) {
+    if (src == NULL || out == NULL || asset == NULL || width == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t stride = (width + 7) / 8, pos = 0;
+    for (uint16_t r = 0; r < height; r++, src += stride) {
+        size_t used = EPD_Asset_PackRow(src, stride, out + pos, out_size - pos);
+        if (used == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        pos += used;
+    }
+    *asset = (EPD_Asset_t){
+        .data = out,
+        .size = pos,
+        .raw_size = stride * height,
+        .width = width,
+        .height = height,
+        .rotate = ROTATE_0,
+        .format = EPD_ASSET_CANVAS,
+        .compression = EPD_ASSET_PACKBITS,
+    };
+    return ESP_OK;
+}
+
+esp_err_t EPD_Asset_Draw(const EPD_Asset_t *asset, uint16_t x, uint16_t y, EPD_Rop_t rop) {
+    if (asset == NULL || asset->format != EPD_ASSET_CANVAS || Paint.Image == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (asset->rotate != Paint.Rotate) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool swap = (asset->rotate == ROTATE_90 || asset->rotate == ROTATE_270);
+    uint16_t lw = swap ? asset->height : asset->width;
+    uint16_t lh = swap ? asset->width : asset->height;
+    if ((uint32_t)x + lw > Paint.Width || (uint32_t)y + lh > Paint.Height) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!EPD_Asset_Valid(asset)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    // Memory position of the logical top-left corner, as Paint_SetPixel maps it
+    uint16_t X, Y;
+    switch (asset->rotate) {
+        case ROTATE_90:  X = Paint.WidthMemory - y - lh; Y = x; break;
+        case ROTATE_180: X = Paint.WidthMemory - x - lw; Y = Paint.HeightMemory - y - lh; break;
+        case ROTATE_270: X = y; Y = Paint.HeightMemory - x - lw; break;
+        default:         X = x; Y = y; break;
+    }
+
+    if (asset->compression == EPD_ASSET_RAW) {
+        EPD_Blit_Memory(X, Y, asset->width, asset->height, asset->data, NULL, rop);
+        return ESP_OK;
+    }
+    uint8_t row[EPD_FRAME_STRIDE];
+    size_t stride = EPD_Asset_Stride(asset), pos = 0;
+    if (stride > sizeof(row)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    for (uint16_t r = 0; r < asset->height; r++) {
+        pos += EPD_Asset_UnpackRow(asset->data + pos, asset->size - pos, row, stride);
+        EPD_Blit_Memory(X, Y + r, asset->width, 1, row, NULL, rop);
+    }
+    return ESP_OK;
+}
+
+esp_err_t EPD_Asset_Display(const EPD_Asset_t *asset) {
+    if (asset == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (asset->format == EPD_ASSET_CANVAS) {
+        if (asset->rotate != ROTATE_0 || asset->width != EPD_W || asset->height != EPD_H ||
+            asset->compression != EPD_ASSET_RAW) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (!EPD_Asset_Valid(asset)) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        EPD_Display(asset->data);
+        return ESP_OK;
+    }
+    if (asset->raw_size != EPD_NATIVE_FRAME_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    // Checked up front: once RAM 0x24 is being written the frame has to be completed
+    if (!EPD_Asset_Valid(asset)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (asset->compression == EPD_ASSET_RAW) {
+        EPD_Display_Native(asset->data);
+        return ESP_OK;
+    }
+
+    uint8_t stage[EPD_ASSET_STAGE];
+    size_t stride = EPD_Asset_Stride(asset), pos = 0, fill = 0;
+    EPD_Display_Native_Begin();
+    for (uint16_t r = 0; r < asset->height; r++) {
+        if (fill + stride > sizeof(stage)) {
+            EPD_Display_Native_Write(stage, fill);
+            fill = 0;
+        }
+        pos += EPD_Asset_UnpackRow(asset->data + pos, asset->size - pos, stage + fill, stride);
+        fill += stride;
+    }
+    EPD_Display_Native_Write(stage, fill);
+    EPD_Display_Native_End();
+    return ESP_OK;
+}
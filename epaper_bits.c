@@ -0,0 +1,311 @@
+#include "epaper_bits.h"
+#include <string.h>
+
+// Frame bytes seen as words; may_alias keeps these accesses legal on buffers
+// declared as uint8_t
+typedef uint32_t __attribute__((may_alias)) EPD_Word_t;
+
+#define EPD_WORD sizeof(EPD_Word_t)
+
+// Bytes before p reaches a word boundary, at most len
+static inline size_t EPD_Bits_Head(const void *p, size_t len) {
+    size_t head = (EPD_WORD - (uintptr_t)p % EPD_WORD) % EPD_WORD;
+    return (head < len) ? head : len;
+}
+
+// Two buffers can be walked in words together
+static inline bool EPD_Bits_Paired(const void *a, const void *b) {
+    return ((uintptr_t)a ^ (uintptr_t)b) % EPD_WORD == 0;
+}
+
+void EPD_Bits_Fill(uint8_t *dst, uint8_t value, size_t len) {
+    size_t head = EPD_Bits_Head(dst, len);
+    EPD_Word_t v = value * 0x01010101u;
+
+    for (size_t i = 0; i < head; i++) dst[i] = value;
+    dst += head;
+    len -= head;
+
+    EPD_Word_t *w = (EPD_Word_t *)dst;
+    size_t words = len / EPD_WORD;
+    for (size_t i = 0; i < words; i++) w[i] = v;
+
+    for (size_t i = words * EPD_WORD; i < len; i++) dst[i] = value;
+}
+
+// One loop per kernel over head bytes, words and tail bytes; OP(d, s) is
+// the new value of d
+#define EPD_BITS_UNARY(dst, src, len, OP)                                       \
+    do {                                                                        \
+        size_t head_ = EPD_Bits_Paired(dst, src) ? EPD_Bits_Head(dst, len) : len; \
+        for (size_t i = 0; i < head_; i++) dst[i] = OP(dst[i], src[i]);         \
+        dst += head_;                                                           \
+        src += head_;                                                           \
+        len -= head_;                                                           \
+        EPD_Word_t *dw_ = (EPD_Word_t *)dst;                                    \
+        const EPD_Word_t *sw_ = (const EPD_Word_t *)src;                        \
+        size_t words_ = len / EPD_WORD;                                         \
+        for (size_t i = 0; i < words_; i++) dw_[i] = OP(dw_[i], sw_[i]);        \
+        for (size_t i = words_ * EPD_WORD; i < len; i++) dst[i] = OP(dst[i], src[i]); \
+    } while (0)
+
+#define EPD_OP_NOT(d, s) (~(s))
+#define EPD_OP_OR(d, s)  ((d) | (s))
+#define EPD_OP_AND(d, s) ((d) & (s))
+
+void EPD_Bits_Invert(uint8_t *dst, const uint8_t *src, size_t len) {
+    EPD_BITS_UNARY(dst, src, len, EPD_OP_NOT);
+}
+
+void EPD_Bits_Or(uint8_t *dst, const uint8_t *src, size_t len) {
+    EPD_BITS_UNARY(dst, src, len, EPD_OP_OR);
+}
+
+void EPD_Bits_And(uint8_t *dst, const uint8_t *src, size_t len) {
+    EPD_BITS_UNARY(dst, src, len, EPD_OP_AND);
+}
+
+void EPD_Bits_Xor(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t head = (EPD_Bits_Paired(dst, a) && EPD_Bits_Paired(a, b)) ? EPD_Bits_Head(dst, len) : len;
+
+    for (size_t i = 0; i < head; i++) dst[i] = a[i] ^ b[i];
+    dst += head;
+    a += head;
+    b += head;
+    len -= head;
+
+    EPD_Word_t *dw = (EPD_Word_t *)dst;
+    const EPD_Word_t *aw = (const EPD_Word_t *)a, *bw = (const EPD_Word_t *)b;
+    size_t words = len / EPD_WORD;
+    for (size_t i = 0; i < words; i++) dw[i] = aw[i] ^ bw[i];
+
+    for (size_t i = words * EPD_WORD; i < len; i++) dst[i] = a[i] ^ b[i];
+}
+
+uint32_t EPD_Bits_Count(const uint8_t *src, size_t len) {
+    size_t head = EPD_Bits_Head(src, len);
+    uint32_t n = 0;
+
+    for (size_t i = 0; i < head; i++) n += __builtin_popcount(src[i]);
+    src += head;
+    len -= head;
+
+    const EPD_Word_t *w = (const EPD_Word_t *)src;
+    size_t words = len / EPD_WORD;
+    for (size_t i = 0; i < words; i++) n += __builtin_popcount(w[i]);
+
+    for (size_t i = words * EPD_WORD; i < len; i++) n += __builtin_popcount(src[i]);
+    return n;
+}
+
+uint32_t EPD_Bits_CountDiff(const uint8_t *a, const uint8_t *b, size_t len) {
+    size_t head = EPD_Bits_Paired(a, b) ? EPD_Bits_Head(a, len) : len;
+    uint32_t n = 0;
+
+    for (size_t i = 0; i < head; i++) n += __builtin_popcount(a[i] ^ b[i]);
+    a += head;
+    b += head;
+    len -= head;
+
+    const EPD_Word_t *aw = (const EPD_Word_t *)a, *bw = (const EPD_Word_t *)b;
+    size_t words = len / EPD_WORD;
+    for (size_t i = 0; i < words; i++) n += __builtin_popcount(aw[i] ^ bw[i]);
+
+    for (size_t i = words * EPD_WORD; i < len; i++) n += __builtin_popcount(a[i] ^ b[i]);
+    return n;
+}
+
+bool EPD_Bits_DiffSpan(const uint8_t *a, const uint8_t *b, size_t len, size_t *first, size_t *last) {
+    size_t head = EPD_Bits_Paired(a, b) ? EPD_Bits_Head(a, len) : len;
+    size_t words = (len - head) / EPD_WORD;
+    size_t tail = head + words * EPD_WORD;     // First byte after the words
+    const EPD_Word_t *aw = (const EPD_Word_t *)(a + head), *bw = (const EPD_Word_t *)(b + head);
+    size_t f = 0, l;     // l: one past the last difference
+
+    // Forward: whole words are skipped, the byte is found in the one that differs
+    while (f < head && a[f] == b[f]) f++;
+    if (f == head) {
+        size_t i = 0;
+        while (i < words && aw[i] == bw[i]) i++;
+        f = head + i * EPD_WORD;
+        while (f < len && a[f] == b[f]) f++;
+        if (f == len) {
+            return false;
+        }
+    }
+    // Backward the same way; the difference at f stops it at the latest there
+    l = len;
+    while (l > tail && a[l - 1] == b[l - 1]) l--;
+    if (l == tail) {
+        size_t i = words;
+        while (i > 0 && aw[i - 1] == bw[i - 1]) i--;
+        l = head + i * EPD_WORD;
+        while (a[l - 1] == b[l - 1]) l--;
+    }
+    if (first) *first = f;
+    if (last) *last = l - 1;
+    return true;
+}
+
+void EPD_Bits_FillRect(uint8_t *dst, size_t stride, size_t wb, uint16_t h, uint8_t value) {
+    if (wb == stride) {
+        EPD_Bits_Fill(dst, value, wb * h);
+        return;
+    }
+    for (uint16_t r = 0; r < h; r++, dst += stride) {
+        EPD_Bits_Fill(dst, value, wb);
+    }
+}
+
+void EPD_Bits_CopyRect(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                       size_t wb, uint16_t h) {
+    if (wb == dst_stride && wb == src_stride) {
+        memcpy(dst, src, wb * h);
+        return;
+    }
+    for (uint16_t r = 0; r < h; r++, dst += dst_stride, src += src_stride) {
+        memcpy(dst, src, wb);
+    }
+}
+
+uint32_t EPD_Bits_CountRect(const uint8_t *src, size_t stride, size_t wb, uint16_t h) {
+    if (wb == stride) {
+        return EPD_Bits_Count(src, wb * h);
+    }
+    uint32_t n = 0;
+    for (uint16_t r = 0; r < h; r++, src += stride) {
+        n += EPD_Bits_Count(src, wb);
+    }
+    return n;
+}
+
+// Masks of the run's bits in its first and last byte
+static inline void EPD_Bits_EdgeMasks(size_t bit0, size_t end, uint8_t *m0, uint8_t *m1) {
+    *m0 = 0xFF >> (bit0 % 8);
+    *m1 = 0xFF << (7 - (end - 1) % 8);
+}
+
+void EPD_Bits_FillBits(uint8_t *row, size_t bit0, size_t nbits, uint8_t value) {
+    if (nbits == 0) {
+        return;
+    }
+    size_t b0 = bit0 / 8, b1 = (bit0 + nbits - 1) / 8;
+    uint8_t m0, m1;
+    EPD_Bits_EdgeMasks(bit0, bit0 + nbits, &m0, &m1);
+
+    if (b0 == b1) {
+        m0 &= m1;
+        row[b0] = (row[b0] & ~m0) | (value & m0);
+        return;
+    }
+    row[b0] = (row[b0] & ~m0) | (value & m0);
+    EPD_Bits_Fill(row + b0 + 1, value, b1 - b0 - 1);
+    row[b1] = (row[b1] & ~m1) | (value & m1);
+}
+
+void EPD_Bits_CopyBits(uint8_t *dst, const uint8_t *src, size_t bit0, size_t nbits) {
+    if (nbits == 0) {
+        return;
+    }
+    size_t b0 = bit0 / 8, b1 = (bit0 + nbits - 1) / 8;
+    uint8_t m0, m1;
+    EPD_Bits_EdgeMasks(bit0, bit0 + nbits, &m0, &m1);
+
+    if (b0 == b1) {
+        m0 &= m1;
+        dst[b0] = (dst[b0] & ~m0) | (src[b0] & m0);
+        return;
+    }
+    dst[b0] = (dst[b0] & ~m0) | (src[b0] & m0);
+    memcpy(dst + b0 + 1, src + b0 + 1, b1 - b0 - 1);
+    dst[b1] = (dst[b1] & ~m1) | (src[b1] & m1);
+}
+
+// Big-endian word at any address: bit 0 of the run is the word's MSB
+static inline uint32_t EPD_Bits_LoadBE(const uint8_t *p) {
+    uint32_t w;
+    memcpy(&w, p, sizeof(w));
+    return __builtin_bswap32(w);
+}
+
+static inline void EPD_Bits_StoreBE(uint8_t *p, uint32_t w) {
+    w = __builtin_bswap32(w);
+    memcpy(p, &w, sizeof(w));
+}
+
+// The shifts rewrite whole bytes b0..b1 from the bytes of the run (bytes past
+// it read as 0), then put back the bits of the first and last byte that lie
+// outside the run and fill the bits shifted in. Left walks up and right walks
+// down, so every byte is read before it is overwritten.
+void EPD_Bits_ShiftLeft(uint8_t *row, size_t bit0, size_t nbits, size_t shift, uint8_t fill) {
+    if (shift >= nbits) {
+        EPD_Bits_FillBits(row, bit0, nbits, fill);
+        return;
+    }
+    if (shift == 0) {
+        return;
+    }
+    size_t end = bit0 + nbits, b0 = bit0 / 8, b1 = (end - 1) / 8;
+    size_t q = shift / 8, r = shift % 8, k = b0;
+    uint8_t first = row[b0], last = row[b1], m0, m1;
+    EPD_Bits_EdgeMasks(bit0, end, &m0, &m1);
+
+    // Byte k takes bits 8k + shift on: bytes k + q and k + q + 1
+    for (; k + q + 4 <= b1; k += 4) {
+        uint32_t w = EPD_Bits_LoadBE(row + k + q);
+        if (r) {
+            w = (w << r) | (row[k + q + 4] >> (8 - r));
+        }
+        EPD_Bits_StoreBE(row + k, w);
+    }
+    for (; k <= b1; k++) {
+        uint8_t a = (k + q <= b1) ? row[k + q] : 0;
+        uint8_t b = (k + q + 1 <= b1) ? row[k + q + 1] : 0;
+        row[k] = r ? (uint8_t)((a << r) | (b >> (8 - r))) : a;
+    }
+
+    if (b0 == b1) {
+        m0 &= m1;
+    } else {
+        row[b1] = (last & ~m1) | (row[b1] & m1);
+    }
+    row[b0] = (first & ~m0) | (row[b0] & m0);
+    EPD_Bits_FillBits(row, end - shift, shift, fill);
+}
+
+void EPD_Bits_ShiftRight(uint8_t *row, size_t bit0, size_t nbits, size_t shift, uint8_t fill) {
+    if (shift >= nbits) {
+        EPD_Bits_FillBits(row, bit0, nbits, fill);
+        return;
+    }
+    if (shift == 0) {
+        return;
+    }
+    size_t end = bit0 + nbits, b0 = bit0 / 8, b1 = (end - 1) / 8;
+    size_t q = shift / 8, r = shift % 8, k = b1 + 1;
+    uint8_t first = row[b0], last = row[b1], m0, m1;
+    EPD_Bits_EdgeMasks(bit0, end, &m0, &m1);
+
+    // Byte k takes bits 8k - shift on: bytes k - q - 1 and k - q. Words
+    // cover bytes k - 4 .. k - 1 while their source starts at b0 or later.
+    for (; k >= b0 + q + 5; k -= 4) {
+        uint32_t w = EPD_Bits_LoadBE(row + k - 4 - q);
+        if (r) {
+            w = (w >> r) | ((uint32_t)row[k - 5 - q] << (32 - r));
+        }
+        EPD_Bits_StoreBE(row + k - 4, w);
+    }
+    while (k-- > b0) {
+        uint8_t a = (k >= b0 + q) ? row[k - q] : 0;
+        uint8_t p = (k >= b0 + q + 1) ? row[k - q - 1] : 0;
+        row[k] = r ? (uint8_t)((p << (8 - r)) | (a >> r)) : a;
+    }
+
+    if (b0 == b1) {
+        m0 &= m1;
+    } else {
+        row[b1] = (last & ~m1) | (row[b1] & m1);
+    }
+    row[b0] = (first & ~m0) | (row[b0] & m0);
+    EPD_Bits_FillBits(row, bit0, shift, fill);
+}
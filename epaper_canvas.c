@@ -0,0 +1,161 @@
+#include "epaper_canvas.h"
+#include "epaper_arena.h"
+#include "epaper_bits.h"
+#include "epaper_refresh_policy.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "epaper_canvas";
+
+static struct {
+    uint8_t *front;             // Last presented frame
+    uint8_t *back;              // Drawing target
+    EPD_CanvasStats_t stats;
+} s_canvas;
+
+// Outlives Init/Deinit: a task may still hold it while the canvas is torn down
+static SemaphoreHandle_t s_lock;
+static StaticSemaphore_t s_lock_buf;
+
+// One present at a time: the frame being sent is the front canvas, which
+// only the present in progress may touch once s_lock is released
+static SemaphoreHandle_t s_present;
+static StaticSemaphore_t s_present_buf;
+
+esp_err_t EPD_Canvas_Init(uint8_t *front, uint8_t *back, uint16_t Rotate) {
+    if ((front == NULL) != (back == NULL) || (front != NULL && front == back)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (front == NULL) {
+        if (!EPD_Arena_Ready()) {
+            EPD_ArenaConfig_t arena = EPD_ARENA_CONFIG_DEFAULT();
+            if (arena.frames < 2) arena.frames = 2;
+            esp_err_t ret = EPD_Arena_Init(&arena);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        front = EPD_Arena_Frame(0);
+        back = EPD_Arena_Frame(1);
+        if (front == NULL || back == NULL) {
+            ESP_LOGE(TAG, "Framebuffer arena has fewer than two frames");
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+    // Without a policy (and its shadow) every present would be a full refresh
+    if (!EPD_Policy_Ready()) {
+        EPD_PolicyConfig_t policy = EPD_POLICY_CONFIG_DEFAULT();
+        esp_err_t ret = EPD_Policy_Init(&policy);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Refresh policy init failed: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateRecursiveMutexStatic(&s_lock_buf);
+        s_present = xSemaphoreCreateRecursiveMutexStatic(&s_present_buf);
+    }
+    EPD_Canvas_Lock(portMAX_DELAY);
+    memset(&s_canvas, 0, sizeof(s_canvas));
+    s_canvas.front = front;
+    s_canvas.back = back;
+    memset(front, 0xFF, EPD_FRAME_SIZE);
+    memset(back, 0xFF, EPD_FRAME_SIZE);
+    Paint_NewImage(back, EPD_W, EPD_H, Rotate, WHITE);
+    EPD_SetAsyncRefresh(true);
+    EPD_Canvas_Unlock();
+    return ESP_OK;
+}
+
+void EPD_Canvas_Deinit(void) {
+    if (s_present == NULL) {
+        return;
+    }
+    xSemaphoreTakeRecursive(s_present, portMAX_DELAY);
+    EPD_WaitIdle();
+    EPD_Canvas_Lock(portMAX_DELAY);
+    EPD_SetAsyncRefresh(false);
+    memset(&s_canvas, 0, sizeof(s_canvas));
+    EPD_Canvas_Unlock();
+    xSemaphoreGiveRecursive(s_present);
+}
+
+bool EPD_Canvas_Lock(TickType_t wait) {
+    return s_lock == NULL || xSemaphoreTakeRecursive(s_lock, wait) == pdTRUE;
+}
+
+void EPD_Canvas_Unlock(void) {
+    if (s_lock != NULL) {
+        xSemaphoreGiveRecursive(s_lock);
+    }
+}
+
+uint8_t *EPD_Canvas_Back(void) {
+    return s_canvas.back;
+}
+
+const uint8_t *EPD_Canvas_Front(void) {
+    return s_canvas.front;
+}
+
+EPD_RefreshMode_t EPD_Canvas_Present(void) {
+    if (s_present == NULL) {
+        return EPD_REFRESH_NONE;
+    }
+    xSemaphoreTakeRecursive(s_present, portMAX_DELAY);
+    // Let the previous refresh finish before taking the canvas, so tasks
+    // drawing under the lock never wait for a waveform
+    EPD_WaitIdle();
+    EPD_Canvas_Lock(portMAX_DELAY);
+    if (s_canvas.back == NULL) {
+        EPD_Canvas_Unlock();
+        xSemaphoreGiveRecursive(s_present);
+        return EPD_REFRESH_NONE;
+    }
+
+    uint8_t *presented = s_canvas.back;
+    s_canvas.back = s_canvas.front;
+    s_canvas.front = presented;
+
+    // Copy-on-swap: bring the new back canvas up to the presented frame,
+    // touching only the changed span of the rows that changed between the
+    // last two frames
+    uint16_t copied = 0;
+    for (uint16_t y = 0; y < EPD_H; y++) {
+        uint32_t offset = (uint32_t)y * EPD_FRAME_STRIDE;
+        size_t first, last;
+        if (EPD_Bits_DiffSpan(s_canvas.back + offset, presented + offset, EPD_FRAME_STRIDE, &first, &last)) {
+            memcpy(s_canvas.back + offset + first, presented + offset + first, last - first + 1);
+            copied++;
+        }
+    }
+
+    Paint.Image = s_canvas.back;
+    Paint.Planes[0] = s_canvas.back;
+    EPD_Canvas_Unlock();
+
+    // Swapped before the refresh so it runs without the lock: a mode that
+    // waits for a waveform in between (the two passes of EPD_REFRESH_CLEAN)
+    // does not hold up the drawing tasks. Returns once the last update has
+    // started (async refresh).
+    EPD_RefreshMode_t mode = EPD_Policy_Present(presented);
+
+    EPD_Canvas_Lock(portMAX_DELAY);
+    s_canvas.stats.mode = mode;
+    s_canvas.stats.copied_rows = copied;
+    s_canvas.stats.presents++;
+    EPD_Canvas_Unlock();
+    xSemaphoreGiveRecursive(s_present);
+    return mode;
+}
+
+void EPD_Canvas_GetStats(EPD_CanvasStats_t *stats) {
+    if (stats) {
+        EPD_Canvas_Lock(portMAX_DELAY);
+        *stats = s_canvas.stats;
+        EPD_Canvas_Unlock();
+    }
+}
@@ -0,0 +1,169 @@
+#include "epaper_chart.h"
+#include <string.h>
+
+esp_err_t EPD_Chart_Init(EPD_Chart_t *chart, const EPD_ChartConfig_t *config) {
+    if (chart == NULL || config == NULL || config->min >= config->max || config->step == 0 ||
+        config->width == 0 || config->height == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint16_t shown = (config->width + config->step - 1) / config->step;
+    if (shown > EPD_CHART_MAX_SAMPLES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(chart, 0, sizeof(*chart));
+    chart->cfg = *config;
+    chart->shown = shown;
+    return ESP_OK;
+}
+
+void EPD_Chart_Invalidate(EPD_Chart_t *chart) {
+    chart->drawn = false;
+}
+
+void EPD_Chart_Reset(EPD_Chart_t *chart) {
+    chart->count = 0;
+    chart->head = 0;
+    chart->drawn = false;
+}
+
+void EPD_Chart_GetRect(const EPD_Chart_t *chart, EPD_Rect_t *rect) {
+    const EPD_ChartConfig_t *cfg = &chart->cfg;
+    uint16_t x = cfg->x, y = cfg->y, w = cfg->width, h = cfg->height;
+
+    // Clipped to the canvas, as the drawing is
+    if (x >= Paint.Width || y >= Paint.Height) {
+        *rect = (EPD_Rect_t){ 0, 0, 0, 0 };
+        return;
+    }
+    if (w > Paint.Width - x) w = Paint.Width - x;
+    if (h > Paint.Height - y) h = Paint.Height - y;
+    switch (Paint.Rotate) {
+        case ROTATE_90:
+            *rect = (EPD_Rect_t){ Paint.WidthMemory - y - h, x, h, w };
+            break;
+        case ROTATE_180:
+            *rect = (EPD_Rect_t){ Paint.WidthMemory - x - w, Paint.HeightMemory - y - h, w, h };
+            break;
+        case ROTATE_270:
+            *rect = (EPD_Rect_t){ y, Paint.HeightMemory - x - w, h, w };
+            break;
+        default:
+            *rect = (EPD_Rect_t){ x, y, w, h };
+            break;
+    }
+}
+
+// Canvas row of a value: min on the bottom row, max on the top one
+static uint16_t EPD_Chart_Row(const EPD_ChartConfig_t *cfg, int32_t value) {
+    if (value < cfg->min) value = cfg->min;
+    if (value > cfg->max) value = cfg->max;
+    int64_t range = (int64_t)cfg->max - cfg->min;
+    int64_t up = (((int64_t)value - cfg->min) * (cfg->height - 1) + range / 2) / range;
+    return cfg->y + cfg->height - 1 - (uint16_t)up;
+}
+
+// Rows y0..y1 (either order) of canvas column x
+static void EPD_Chart_Run(int32_t x, uint16_t y0, uint16_t y1, uint16_t color) {
+    if (y0 > y1) {
+        uint16_t t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    for (uint16_t y = y0; y <= y1; y++) {
+        Paint_SetPixel(x, y, color);
+    }
+}
+
+// The `step` columns of a sample whose last column is `right`, joined to
+// the previous sample's row prev (negative when there is none). Columns left
+// of the plot are skipped, so a sample only draws inside its own columns.
+static void EPD_Chart_Column(const EPD_ChartConfig_t *cfg, int32_t right, int32_t prev, uint16_t row) {
+    uint16_t bottom = cfg->y + cfg->height - 1;
+
+    for (uint8_t j = 1; j <= cfg->step; j++) {
+        int32_t x = right - cfg->step + j;
+        if (x < cfg->x) {
+            continue;
+        }
+        if (cfg->style == EPD_CHART_AREA) {
+            // The line's row at this column, down to the bottom
+            int32_t from = (prev < 0) ? row : prev;
+            EPD_Chart_Run(x, from + (row - from) * j / cfg->step, bottom, cfg->color);
+            continue;
+        }
+        if (prev < 0) {
+            EPD_Chart_Run(x, row, row, cfg->color);
+            continue;
+        }
+        // The part of the line from prev to row over this column: from one
+        // row past where the column before it ended, to where this one ends
+        int32_t a = prev + (row - prev) * (j - 1) / cfg->step;
+        int32_t b = prev + (row - prev) * j / cfg->step;
+        if (a != b) {
+            a += (b > a) ? 1 : -1;
+        }
+        EPD_Chart_Run(x, a, b, cfg->color);
+    }
+}
+
+// Last canvas column of the plot: the right edge clipped to the canvas, so
+// the newest sample is always visible
+static inline int32_t EPD_Chart_Right(const EPD_ChartConfig_t *cfg) {
+    int32_t right = cfg->x + cfg->width - 1;
+    return (right < Paint.Width) ? right : Paint.Width - 1;
+}
+
+// Sample `age` pushes ago (0 = newest)
+static inline int32_t EPD_Chart_Sample(const EPD_Chart_t *chart, uint16_t age) {
+    uint16_t slots = chart->shown + 1;
+    return chart->samples[(chart->head + slots - 1 - age) % slots];
+}
+
+static void EPD_Chart_Redraw(EPD_Chart_t *chart) {
+    const EPD_ChartConfig_t *cfg = &chart->cfg;
+    int32_t right = EPD_Chart_Right(cfg);
+
+    for (uint16_t r = 0; r < cfg->height; r++) {
+        EPD_FillSpan(cfg->x, right, cfg->y + r, cfg->background);
+    }
+    // Oldest first; the extra sample past the shown ones only starts a line
+    uint16_t drawn = (chart->count > chart->shown) ? chart->shown : chart->count;
+    for (uint16_t age = drawn; age-- > 0;) {
+        int32_t prev = (age + 1 < chart->count) ? EPD_Chart_Row(cfg, EPD_Chart_Sample(chart, age + 1)) : -1;
+        EPD_Chart_Column(cfg, right - (int32_t)age * cfg->step, prev,
+                         EPD_Chart_Row(cfg, EPD_Chart_Sample(chart, age)));
+    }
+}
+
+void EPD_Chart_Push(EPD_Chart_t *chart, int32_t value, EPD_Rect_t *dirty) {
+    const EPD_ChartConfig_t *cfg = &chart->cfg;
+    uint16_t slots = chart->shown + 1;
+
+    chart->samples[chart->head] = value;
+    chart->head = (chart->head + 1) % slots;
+    if (chart->count < slots) {
+        chart->count++;
+    }
+
+    if (chart->drawn) {
+        EPD_ScrollLeft(cfg->x, cfg->y, cfg->width, cfg->height, cfg->step, cfg->background);
+        int32_t prev = (chart->count > 1) ? EPD_Chart_Row(cfg, EPD_Chart_Sample(chart, 1)) : -1;
+        EPD_Chart_Column(cfg, EPD_Chart_Right(cfg), prev, EPD_Chart_Row(cfg, value));
+    } else {
+        EPD_Chart_Redraw(chart);
+        chart->drawn = true;
+    }
+    if (dirty) {
+        EPD_Chart_GetRect(chart, dirty);
+    }
+}
+
+void EPD_Chart_Update(EPD_Chart_t *chart, int32_t value) {
+    EPD_Rect_t rect;
+
+    EPD_Chart_Push(chart, value, &rect);
+    if (rect.width && rect.height) {
+        EPD_Display_Part_Stride(rect.x, rect.y, rect.width, rect.height, Paint.Image);
+    }
+}
@@ -0,0 +1,199 @@
+#include "epaper_cmdring.h"
+#include <string.h>
+
+// Bounded MPMC queue after D. Vyukov, used with a single consumer. Slot i
+// starts with seq = i. A producer at position pos may fill the slot when
+// seq == pos; it claims pos by advancing head with a CAS, copies the command
+// and releases seq = pos + 1. The consumer at position pos runs the slot once
+// seq == pos + 1 and hands it back to the producers one lap later with
+// seq = pos + capacity. seq - pos < 0 means the ring is full (the slot still
+// holds a command from the previous lap).
+
+esp_err_t EPD_CmdRing_Init(EPD_CmdRing_t *ring, EPD_CmdSlot_t *slots, uint32_t capacity) {
+    if (ring == NULL || slots == NULL || capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(ring, 0, sizeof(*ring));
+    ring->slots = slots;
+    ring->mask = capacity - 1;
+    for (uint32_t i = 0; i < capacity; i++) {
+        __atomic_store_n(&slots[i].seq, i, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return ESP_OK;
+}
+
+bool EPD_CmdRing_Push(EPD_CmdRing_t *ring, const EPD_DrawCmd_t *cmd) {
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    EPD_CmdSlot_t *slot;
+
+    for (;;) {
+        slot = &ring->slots[pos & ring->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            // On failure pos is reloaded with the current head
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        } else {
+            // Another producer claimed pos first
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->cmd = *cmd;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool EPD_CmdRing_PushString(EPD_CmdRing_t *ring, uint16_t x, uint16_t y, const char *text,
+                            uint8_t size, uint16_t color) {
+    EPD_DrawCmd_t cmd = {
+        .op = EPD_CMD_STRING,
+        .size = size,
+        .color = color,
+        .x0 = x,
+        .y0 = y,
+    };
+    strncpy(cmd.text, text, sizeof(cmd.text) - 1);
+    return EPD_CmdRing_Push(ring, &cmd);
+}
+
+void EPD_Cmd_Run(const EPD_DrawCmd_t *cmd) {
+    switch (cmd->op) {
+        case EPD_CMD_FILL:
+            EPD_Full((uint8_t)cmd->color);
+            break;
+        case EPD_CMD_PIXEL:
+            Paint_SetPixel(cmd->x0, cmd->y0, cmd->color);
+            break;
+        case EPD_CMD_LINE:
+            EPD_DrawLine(cmd->x0, cmd->y0, cmd->x1, cmd->y1, cmd->color);
+            break;
+        case EPD_CMD_RECT:
+            EPD_DrawRectangle(cmd->x0, cmd->y0, cmd->x1, cmd->y1, cmd->color, cmd->mode);
+            break;
+        case EPD_CMD_CIRCLE:
+            EPD_DrawCircle(cmd->x0, cmd->y0, cmd->x1, cmd->color, cmd->mode);
+            break;
+        case EPD_CMD_CLEAR_WINDOW:
+            EPD_ClearWindows(cmd->x0, cmd->y0, cmd->x1, cmd->y1, cmd->color);
+            break;
+        case EPD_CMD_STRING:
+            EPD_ShowString(cmd->x0, cmd->y0, cmd->text, cmd->size, cmd->color);
+            break;
+        case EPD_CMD_NUM:
+            EPD_ShowNum(cmd->x0, cmd->y0, cmd->num, cmd->mode, cmd->size, cmd->color);
+            break;
+        case EPD_CMD_PICTURE:
+            EPD_ShowPicture(cmd->x0, cmd->y0, cmd->x1, cmd->y1, cmd->image, cmd->color);
+            break;
+        case EPD_CMD_BLIT:
+            EPD_Blit(cmd->x0, cmd->y0, cmd->x1, cmd->y1, cmd->image, NULL, (EPD_Rop_t)cmd->mode);
+            break;
+        case EPD_CMD_CALL:
+            if (cmd->call.fn) {
+                cmd->call.fn(cmd->call.arg);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// Inclusive box; false when it lies beyond 16-bit coordinates, where the
+// drawing code wraps around
+static bool EPD_Cmd_Box(int32_t x0, int32_t y0, int32_t x1, int32_t y1, EPD_Rect_t *rect) {
+    if (x1 > UINT16_MAX || y1 > UINT16_MAX) {
+        return false;
+    }
+    rect->x = (x0 < 0) ? 0 : x0;
+    rect->y = (y0 < 0) ? 0 : y0;
+    rect->width = x1 - rect->x + 1;
+    rect->height = y1 - rect->y + 1;
+    return true;
+}
+
+bool EPD_Cmd_Bounds(const EPD_DrawCmd_t *cmd, EPD_Rect_t *rect) {
+    int32_t x0 = cmd->x0, y0 = cmd->y0, x1 = cmd->x1, y1 = cmd->y1;
+    bool box;
+
+    switch (cmd->op) {
+        case EPD_CMD_PIXEL:
+            box = EPD_Cmd_Box(x0, y0, x0, y0, rect);
+            break;
+        case EPD_CMD_LINE:
+        case EPD_CMD_RECT:
+            box = EPD_Cmd_Box(x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1, x0 < x1 ? x1 : x0, y0 < y1 ? y1 : y0, rect);
+            break;
+        case EPD_CMD_CIRCLE:
+            box = EPD_Cmd_Box(x0 - x1, y0 - x1, x0 + x1, y0 + x1, rect);
+            break;
+        case EPD_CMD_CLEAR_WINDOW:
+            if (x1 <= x0 || y1 <= y0) {
+                return false;
+            }
+            box = EPD_Cmd_Box(x0, y0, x1 - 1, y1 - 1, rect);
+            break;
+        case EPD_CMD_STRING:
+        case EPD_CMD_NUM: {
+            // Glyphs start one pixel in and are at most a size wide; the
+            // 8 pixel font steps 4 or 6 pixels, the others size / 2
+            int32_t n = (cmd->op == EPD_CMD_STRING) ? (int32_t)strnlen(cmd->text, sizeof(cmd->text)) : cmd->mode;
+            if (n == 0) {
+                return false;
+            }
+            box = EPD_Cmd_Box(x0, y0, x0 + n * (cmd->size / 2 + 2) + cmd->size,
+                              y0 + (cmd->size + 7) / 8 * 8 + 1, rect);
+            break;
+        }
+        case EPD_CMD_PICTURE:
+        case EPD_CMD_BLIT:
+            if (x1 == 0 || y1 == 0) {
+                return false;
+            }
+            // Pictures that are not whole bytes wide wander off their box
+            box = (cmd->op == EPD_CMD_BLIT || x1 % 8 == 0) &&
+                  EPD_Cmd_Box(x0, y0, x0 + x1 - 1, y0 + y1 - 1, rect);
+            break;
+        default:
+            box = false;    // FILL, CALL: anywhere
+            break;
+    }
+    if (!box) {
+        rect->x = 0;
+        rect->y = 0;
+        rect->width = Paint.Width;
+        rect->height = Paint.Height;
+    }
+    return true;
+}
+
+size_t EPD_CmdRing_Drain(EPD_CmdRing_t *ring, size_t max) {
+    size_t done = 0;
+
+    if (max == 0) {
+        // Claimed so far; producers that keep pushing wait for the next drain
+        max = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - ring->tail;
+    }
+    while (done < max) {
+        uint32_t pos = ring->tail;
+        EPD_CmdSlot_t *slot = &ring->slots[pos & ring->mask];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if ((int32_t)(seq - (pos + 1)) < 0) {
+            break;  // empty, or the next producer has not finished its copy
+        }
+        // Run from a copy so the slot goes back to the producers right away
+        EPD_DrawCmd_t cmd = slot->cmd;
+        __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);
+        ring->tail = pos + 1;
+        EPD_Cmd_Run(&cmd);
+        done++;
+    }
+    return done;
+}
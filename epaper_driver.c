@@ -1,13 +1,23 @@
 #include "epaper_driver.h"
 #include "epaper_fonts.h"
+#include "epaper_trace.h"
+#include "epaper_arena.h"
+#include "epaper_heatmap.h"
+#include "epaper_bits.h"
+#include "epaper_warmboot.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
 #include "esp_log.h"
 #include <string.h>
 #include "sdkconfig.h" 
-#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_attr.h"
+#include <stdbool.h>
 
 static const char *TAG = "epaper_driver";
 
@@ -30,8 +40,6 @@ spi_device_handle_t spi_handle = NULL;
 #define PIN_PWR             CONFIG_CROWPANEL_EPAPER_POWER_PIN
 
 // GPIO Helper Macros
-#define EPD_CS_0()  gpio_set_level(PIN_CS, 0)
-#define EPD_CS_1()  gpio_set_level(PIN_CS, 1)
 #define EPD_DC_0()  gpio_set_level(PIN_DC, 0)
 #define EPD_DC_1()  gpio_set_level(PIN_DC, 1)
 #define EPD_RST_0() gpio_set_level(PIN_RST, 0)
@@ -41,95 +49,378 @@ spi_device_handle_t spi_handle = NULL;
 // Delay Helper
 #define delay(ms) vTaskDelay(pdMS_TO_TICKS(ms))
 
+// Controller state cache
+//
+// Tracks what the controller currently has in effect so that init, clear and
+// display sequences only reset the chip or rewrite a register when needed.
+#define EPD_MODE_NONE       0   // Registers at reset defaults
+#define EPD_MODE_FULL       1   // EPD_Init
+#define EPD_MODE_FAST_BASE  2   // EPD_Init_Fast(mode) -> EPD_MODE_FAST_BASE + mode
+
+#define EPD_REG_SHADOW_MAX  4
+
+typedef struct {
+    uint8_t reg;
+    uint8_t len;                        // 0 = value unknown
+    uint8_t data[EPD_REG_SHADOW_MAX];
+} EPD_RegShadow_t;
+
+static struct {
+    bool powered;                       // Power rail switched on by EPD_PowerOn
+    bool awake;                         // Out of hardware reset and not in deep sleep
+    uint8_t mode;                       // Waveform setup currently loaded
+    bool async;                         // EPD_SetAsyncRefresh: return once the update has started
+    bool busy_pending;                  // Update started, BUSY not yet seen low
+    const uint8_t *after_busy;          // Command table to run once the pending update is done
+    EPD_RegShadow_t regs[9];
+} s_epd = {
+    .regs = {
+        { .reg = 0x01 },                // Driver output control
+        { .reg = 0x11 },                // Data entry mode
+        { .reg = 0x18 },                // Temperature sensor selection
+        { .reg = 0x1A },                // Temperature register
+        { .reg = 0x21 },                // Display update control 1
+        { .reg = 0x22 },                // Display update control 2
+        { .reg = 0x3C },                // Border waveform
+        { .reg = 0x44 },                // RAM X window
+        { .reg = 0x45 },                // RAM Y window
+    },
+};
+
+// Previous-image RAM (0x26) sync
+//
+// Partial waveforms drive each pixel from its 0x26 (old) value to its 0x24
+// (new) value, so 0x26 has to hold what the panel shows. The driver mirrors
+// the panel in the arena's old-RAM frame (logical layout), grows a pending
+// box over the bytes each 0x24 write changes and, before the next partial
+// update, rewrites just that box of 0x26 from the mirror.
+static struct {
+    bool enabled;                       // EPD_SetOldRamSync
+    bool color;                         // 0x26 holds a color plane: no sync until a black/white full frame
+    bool valid;                         // Mirror covers the whole panel
+    bool hold;                          // EPD_Clear_R26H: leave 0x26 alone for one partial update
+    uint8_t *mirror;                    // EPD_Arena_OldRam() the state refers to
+    uint16_t xb0, xb1, y0, y1;          // Pending box, inclusive; empty when xb0 > xb1
+} s_old = {
+    .enabled = true,
+    .xb0 = UINT16_MAX,
+    .y0 = UINT16_MAX,
+};
+
+// Controller state saved by EPD_Sleep_Mode and restored on the next wake
+static struct {
+    uint8_t mode;                       // EPD_SleepMode_t while asleep, 0 when awake
+    uint8_t waveform;                   // s_epd.mode before sleeping
+    EPD_RegShadow_t regs[9];            // s_epd.regs before sleeping
+    int64_t wake_us;                    // Start of the last wake, until the first update after it
+    uint8_t wake_mode;                  // Mode the measured wake came from
+    EPD_WakeStats_t stats[2];           // EPD_SLEEP_RETAIN, EPD_SLEEP_DEEP
+} s_sleep;
+
+static void EPD_OldRam_Clean(void) {
+    s_old.xb0 = UINT16_MAX;
+    s_old.xb1 = 0;
+    s_old.y0 = UINT16_MAX;
+    s_old.y1 = 0;
+}
+
+static void EPD_State_Invalidate(void) {
+    for (size_t i = 0; i < sizeof(s_epd.regs) / sizeof(s_epd.regs[0]); i++) {
+        s_epd.regs[i].len = 0;
+    }
+    s_epd.mode = EPD_MODE_NONE;
+}
+
 // Internal SPI Write Functions
-static void EPD_WriteByte(uint8_t data) {
-    if (spi_handle == NULL) return;
-    spi_transaction_t t = {
-        .length = 8,
-        .tx_buffer = &data
-    };
-    spi_device_transmit(spi_handle, &t);
+//
+// Every transfer carries its DC level in t->user; the pre-transfer callback
+// drives DC and the SPI peripheral drives CS. Short transfers (commands and
+// their parameters) use the polling path, which avoids the interrupt and
+// task switch of a queued transaction. RAM data is queued for DMA with up to
+// EPD_SPI_QUEUE_SIZE chunks in flight; data that is not DMA-capable goes
+// through the arena's bounce buffers.
+#define EPD_SPI_QUEUE_SIZE      8
+#define EPD_SPI_MAX_TRANSFER    (EPD_FRAME_SIZE + 100)
+#define EPD_SPI_BOUNCE_SIZE     EPD_ARENA_BOUNCE_SIZE
+#define EPD_SPI_POLL_MAX        16      // Longest transfer sent with polling
+
+static int s_bus_depth;         // Nesting of EPD_Bus_Acquire
+static SemaphoreHandle_t s_bus_lock;    // Owner of the panel between Acquire and Release
+static StaticSemaphore_t s_bus_lock_buf;
+static bool s_bus_held;         // spi_device_acquire_bus currently in effect
+
+static spi_transaction_t s_spi_pool[EPD_SPI_QUEUE_SIZE];
+static size_t s_spi_head;       // Next pool slot to use (oldest in flight when full)
+static size_t s_spi_inflight;
+
+static void IRAM_ATTR EPD_SPI_PreTransfer(spi_transaction_t *t) {
+    gpio_set_level(PIN_DC, (int)(intptr_t)t->user);
+}
+
+// Wait until at most `keep` queued transactions are still in flight
+static void EPD_SPI_Drain(size_t keep) {
+    spi_transaction_t *done;
+    while (s_spi_inflight > keep) {
+        if (spi_device_get_trans_result(spi_handle, &done, portMAX_DELAY) != ESP_OK) {
+            break;
+        }
+        s_spi_inflight--;
+    }
 }
 
-static void EPD_WriteBytes(const uint8_t *data, size_t len) {
+// Send one transfer. Short ones complete before returning; longer buffers are
+// queued and must stay valid until the queue is drained.
+static void EPD_SPI_Queue(int dc, const uint8_t *data, size_t len) {
     if (spi_handle == NULL || len == 0) return;
-    
-    spi_transaction_t t = {
-        .length = len * 8, // length in bits
-        .tx_buffer = data
-    };
-    spi_device_transmit(spi_handle, &t);
+
+    if (len <= EPD_SPI_POLL_MAX) {
+        spi_transaction_t t = {
+            .length = len * 8,
+            .user = (void *)(intptr_t)dc,
+            .tx_buffer = data,
+        };
+        if (len <= sizeof(t.tx_data)) {
+            t.flags = SPI_TRANS_USE_TXDATA;
+            memcpy(t.tx_data, data, len);
+        }
+        EPD_SPI_Drain(0); // polling cannot overlap queued transactions
+        spi_device_polling_transmit(spi_handle, &t);
+        EPD_TRACE_SPI(len);
+        return;
+    }
+
+    if (s_spi_inflight == EPD_SPI_QUEUE_SIZE) {
+        EPD_SPI_Drain(EPD_SPI_QUEUE_SIZE - 1);
+    }
+    spi_transaction_t *t = &s_spi_pool[s_spi_head];
+    s_spi_head = (s_spi_head + 1) % EPD_SPI_QUEUE_SIZE;
+
+    memset(t, 0, sizeof(*t));
+    t->length = len * 8; // length in bits
+    t->user = (void *)(intptr_t)dc;
+    t->tx_buffer = data;
+    if (spi_device_queue_trans(spi_handle, t, portMAX_DELAY) == ESP_OK) {
+        s_spi_inflight++;
+        EPD_TRACE_SPI(len);
+    }
+}
+
+static void EPD_WaitPending(void);
+static void EPD_Resume(void);
+
+// Hold the bus for a whole frame sequence. Other devices on the bus (e.g. an
+// SD card) get it back between frames and while the panel is refreshing.
+// Taking the bus also finishes an update started by an async refresh, since
+// the controller ignores commands while BUSY is high, and wakes a controller
+// put to sleep by EPD_Sleep_Mode. Calls from several tasks are serialized:
+// the first Acquire of a task waits until the owner's last Release.
+static void EPD_Bus_Take(bool wake) {
+    if (s_bus_lock != NULL) {
+        xSemaphoreTakeRecursive(s_bus_lock, portMAX_DELAY);
+    }
+    if (s_bus_depth++ == 0) {
+        if (spi_handle != NULL) {
+            s_bus_held = (spi_device_acquire_bus(spi_handle, portMAX_DELAY) == ESP_OK);
+        }
+        EPD_WaitPending();
+    }
+    if (wake && s_sleep.mode != 0) {
+        EPD_Resume();
+    }
+}
+
+void EPD_Bus_Acquire(void) {
+    EPD_Bus_Take(true);
+}
+
+void EPD_Bus_Release(void) {
+    if (s_bus_depth == 0) return;
+    if (--s_bus_depth == 0 && s_bus_held) {
+        EPD_SPI_Drain(0);
+        spi_device_release_bus(spi_handle);
+        s_bus_held = false;
+    }
+    if (s_bus_lock != NULL) {
+        xSemaphoreGiveRecursive(s_bus_lock);
+    }
 }
 
 static void EPD_WR_REG(uint8_t reg) {
-    EPD_DC_0();
-    EPD_CS_0();
-    EPD_WriteByte(reg);
-    EPD_CS_1();
+    EPD_TRACE_BEGIN(span);
+    EPD_SPI_Queue(0, &reg, 1);
+    EPD_TRACE_END(span, EPD_PHASE_SPI_CMD);
 }
 
-static void EPD_WR_DATA8(uint8_t data) {
-    EPD_DC_1();
-    EPD_CS_0();
-    EPD_WriteByte(data);
-    EPD_CS_1();
+// Stream data (inverted if invert) through the two bounce buffers, refilling
+// one while the other is still on the bus
+static void EPD_WR_DATA_BOUNCED(const uint8_t *data, size_t len, bool invert) {
+    uint8_t n = 0;
+
+    EPD_SPI_Drain(0);
+    while (len > 0) {
+        size_t current = (len > EPD_SPI_BOUNCE_SIZE) ? EPD_SPI_BOUNCE_SIZE : len;
+        uint8_t *buf = EPD_Arena_Bounce(n);
+        if (invert) {
+            EPD_Bits_Invert(buf, data, current);
+        } else {
+            memcpy(buf, data, current);
+        }
+        EPD_SPI_Queue(1, buf, current);
+        EPD_SPI_Drain(1); // the other buffer is free again
+        data += current;
+        len -= current;
+        n ^= 1;
+    }
+    EPD_SPI_Drain(0);
 }
 
 static void EPD_WR_DATA_BUFFER(const uint8_t *data, size_t len) {
-    if (len == 0) return;
-    EPD_DC_1();
-    EPD_CS_0();
-    EPD_WriteBytes(data, len);
-    EPD_CS_1();
+    EPD_TRACE_BEGIN(span);
+    if (!esp_ptr_dma_capable(data)) {
+        // PSRAM or flash: bounce here instead of a temporary copy per transaction in the SPI driver
+        EPD_WR_DATA_BOUNCED(data, len, false);
+        EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
+        return;
+    }
+    while (len > 0) {
+        size_t current = (len > EPD_SPI_MAX_TRANSFER) ? EPD_SPI_MAX_TRANSFER : len;
+        EPD_SPI_Queue(1, data, current);
+        data += current;
+        len -= current;
+    }
+    EPD_SPI_Drain(0); // caller's buffer may change once we return
+    EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
 }
 
 static void EPD_WR_DATA_REPEAT(uint8_t data, size_t count) {
     if (count == 0 || spi_handle == NULL) return;
-    
-    #define CHUNK_SIZE 128
-    uint8_t buffer[CHUNK_SIZE];
-    memset(buffer, data, CHUNK_SIZE);
-    
-    EPD_DC_1();
-    EPD_CS_0();
-    
-    size_t remaining = count;
-    while (remaining > 0) {
-        size_t current = (remaining > CHUNK_SIZE) ? CHUNK_SIZE : remaining;
-        spi_transaction_t t = {
-           .length = current * 8,
-           .tx_buffer = buffer
-        };
-        spi_device_transmit(spi_handle, &t);
-        remaining -= current;
+    EPD_TRACE_BEGIN(span);
+
+    EPD_SPI_Drain(0);
+    uint8_t *buf = EPD_Arena_Bounce(0);
+    memset(buf, data, EPD_SPI_BOUNCE_SIZE);
+
+    while (count > 0) {
+        size_t current = (count > EPD_SPI_BOUNCE_SIZE) ? EPD_SPI_BOUNCE_SIZE : count;
+        EPD_SPI_Queue(1, buf, current);
+        count -= current;
     }
-    
-    EPD_CS_1();
-    #undef CHUNK_SIZE
+    EPD_SPI_Drain(0);
+    EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
 }
 
-static void EPD_ReadBusy(void) {
-    int timeout = 0;
-    while (1) {
-        int busy_state = EPD_ReadBUSY;
-        if (busy_state == 0) {
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+static void EPD_WR_DATA_INVERTED(const uint8_t *data, size_t len) {
+    EPD_TRACE_BEGIN(span);
+    EPD_WR_DATA_BOUNCED(data, len, true);
+    EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
+}
+#endif
+
+// Command tables
+//
+// Encoding: <cmd>, <n | EPD_SEQ_BUSY>, <n parameter bytes>, ..., EPD_SEQ_END.
+// Parameters are limited to 4 bytes so each command goes out as one command
+// transaction plus one inline-data transaction. EPD_SEQ_BUSY waits for BUSY
+// after the command.
+#define EPD_SEQ_BUSY    0x80
+#define EPD_SEQ_END     0xFF
+
+static void EPD_RunSequence(const uint8_t *seq);
+
+// Register write that is skipped when the controller already holds the value
+static void EPD_WR_CMD(uint8_t reg, const uint8_t *data, uint8_t len) {
+    EPD_RegShadow_t *shadow = NULL;
+    for (size_t i = 0; i < sizeof(s_epd.regs) / sizeof(s_epd.regs[0]); i++) {
+        if (s_epd.regs[i].reg == reg) {
+            shadow = &s_epd.regs[i];
             break;
         }
-        if (timeout++ > 500) { // 5 seconds timeout
+    }
+    if (shadow && len <= EPD_REG_SHADOW_MAX) {
+        if (shadow->len == len && memcmp(shadow->data, data, len) == 0) {
+            return;
+        }
+        memcpy(shadow->data, data, len);
+        shadow->len = len;
+    }
+
+    EPD_TRACE_BEGIN(span);
+    EPD_SPI_Queue(0, &reg, 1);
+    EPD_SPI_Queue(1, data, len);
+    EPD_TRACE_END(span, EPD_PHASE_SPI_CMD);
+}
+
+static void EPD_ReadBusy(void) {
+    EPD_TRACE_BEGIN(span);
+    EPD_SPI_Drain(0); // BUSY only means something once the command is out
+
+    // Short operations (soft reset, register loads) finish within a couple of
+    // milliseconds, so spin briefly before yielding to the scheduler. Long
+    // waits (refresh waveforms) hand the bus back to other devices.
+    int64_t start = esp_timer_get_time();
+    bool bus_dropped = false;
+    while (EPD_ReadBUSY != 0) {
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed > 5000000) { // 5 seconds timeout
             ESP_LOGW(TAG, "BUSY pin timeout! Pin is still HIGH after 5s");
             break;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        if (elapsed < 2000) {
+            esp_rom_delay_us(100);
+        } else {
+            if (s_bus_held) {
+                spi_device_release_bus(spi_handle);
+                s_bus_held = false;
+                bus_dropped = true;
+            }
+            vTaskDelay(1);
+        }
     }
+    if (bus_dropped) {
+        s_bus_held = (spi_device_acquire_bus(spi_handle, portMAX_DELAY) == ESP_OK);
+    }
+    EPD_TRACE_END(span, EPD_PHASE_BUSY);
 }
 
+// Hardware reset, then SW reset 0x12 as the power-on flow requires: every
+// register back to its default, RAM kept
 static void EPD_RESET(void) {
-    EPD_RST_1();
-    delay(100);
+    EPD_TRACE_BEGIN(span);
     EPD_RST_0();
-    delay(10);
+    delay(10);                    // Minimum RES# low pulse, without spinning a CPU
     EPD_RST_1();
-    delay(10);
+    esp_rom_delay_us(200);        // Let the controller assert BUSY
+    EPD_ReadBusy();               // Internal reset done
+    EPD_WR_REG(0x12);
+    EPD_ReadBusy();
+    EPD_State_Invalidate();
+    s_epd.awake = true;
+    EPD_TRACE_END(span, EPD_PHASE_RESET);
+}
+
+// Hardware and SW reset only when the controller is in reset or deep sleep
+static void EPD_Wake(void) {
+    if (!s_epd.awake) {
+        EPD_RESET();
+    }
+}
+
+static void EPD_SoftReset(void) {
+    EPD_WR_REG(0x12);
+    EPD_ReadBusy();
+    EPD_State_Invalidate();
+}
+
+static void EPD_RunSequence(const uint8_t *seq) {
+    while (seq[0] != EPD_SEQ_END) {
+        uint8_t n = seq[1] & ~EPD_SEQ_BUSY;
+        EPD_WR_CMD(seq[0], &seq[2], n);
+        if (seq[1] & EPD_SEQ_BUSY) {
+            EPD_ReadBusy();
+        }
+        seq += 2 + n;
+    }
 }
 
 // Power Management
@@ -138,6 +429,9 @@ void EPD_PowerOn(void) {
         ESP_LOGW(TAG, "Power pin not configured (PIN_PWR < 0)");
         return;
     }
+    if (s_epd.powered) {
+        return;
+    }
     
     // Configure Power Pin if not done
     gpio_config_t power_conf = {
@@ -149,19 +443,28 @@ void EPD_PowerOn(void) {
     };
     gpio_config(&power_conf);
     gpio_set_level(PIN_PWR, 1);
-    delay(200); // Increased from 100ms to 200ms
+    delay(CONFIG_CROWPANEL_EPAPER_POWER_ON_DELAY_MS);
+    s_epd.powered = true;
+    // A cold controller needs a hardware reset before it accepts commands
+    s_epd.awake = false;
+    s_sleep.mode = 0;
+    // and its RAM holds noise
+    s_old.valid = false;
+    EPD_OldRam_Clean();
 }
 
 void EPD_GPIOInit(void) {
+    if (s_bus_lock == NULL) {
+        s_bus_lock = xSemaphoreCreateRecursiveMutexStatic(&s_bus_lock_buf);
+    }
+
     // Initialize Power Pin
     EPD_PowerOn();
-    vTaskDelay(pdMS_TO_TICKS(10)); // Wait for power to stabilize
 
     // Initialize GPIOs
     gpio_config_t io_conf = {
         .pin_bit_mask = ((1ULL << PIN_DC) | 
-                         (1ULL << PIN_RST) | 
-                         (1ULL << PIN_CS)),
+                         (1ULL << PIN_RST)),
         .mode = GPIO_MODE_OUTPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
@@ -181,7 +484,7 @@ void EPD_GPIOInit(void) {
         .sclk_io_num = PIN_CLK,
         .quadwp_io_num = -1,
         .quadhd_io_num = -1,
-        .max_transfer_sz = EPD_W * EPD_H / 8 + 100
+        .max_transfer_sz = EPD_SPI_MAX_TRANSFER
     };
 
     // Check if we can init bus, if not, assume it is already init
@@ -191,10 +494,11 @@ void EPD_GPIOInit(void) {
     }
 
     spi_device_interface_config_t devcfg = {
-        .clock_speed_hz = 10 * 1000 * 1000, // 10 MHz
+        .clock_speed_hz = CONFIG_CROWPANEL_EPAPER_SPI_CLOCK_MHZ * 1000 * 1000,
         .mode = 0,
-        .spics_io_num = -1, // We handle CS manually
-        .queue_size = 7,
+        .spics_io_num = PIN_CS,
+        .queue_size = EPD_SPI_QUEUE_SIZE,
+        .pre_cb = EPD_SPI_PreTransfer, // drives DC from t->user
     };
 
     ret = spi_bus_add_device(SPI_HOST_ID, &devcfg, &spi_handle);
@@ -204,58 +508,119 @@ void EPD_GPIOInit(void) {
 }
 
 // Low Level Helpers
-static void EPD_Address_Set(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
-    EPD_WR_REG(0x44); // SET_RAM_X_ADDRESS_START_END_POSITION
-    EPD_WR_DATA8((xs >> 3) & 0xFF);
-    EPD_WR_DATA8((xe >> 3) & 0xFF);
 
-    EPD_WR_REG(0x45); // SET_RAM_Y_ADDRESS_START_END_POSITION
-    EPD_WR_DATA8(ys & 0xFF);
-    EPD_WR_DATA8((ys >> 8) & 0xFF);
-    EPD_WR_DATA8(ye & 0xFF);
-    EPD_WR_DATA8((ye >> 8) & 0xFF);
+// RAM window and cursor as one table: 0x44/0x45 are skipped when unchanged
+static void EPD_SetWindow(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
+    const uint8_t seq[] = {
+        0x44, 2, (xs >> 3) & 0xFF, (xe >> 3) & 0xFF,                        // SET_RAM_X_ADDRESS_START_END_POSITION
+        0x45, 4, ys & 0xFF, (ys >> 8) & 0xFF, ye & 0xFF, (ye >> 8) & 0xFF,  // SET_RAM_Y_ADDRESS_START_END_POSITION
+        0x4E, 1, (xs >> 3) & 0xFF,                                          // SET_RAM_X_ADDRESS_COUNTER (units of 8 pixels)
+        0x4F, 2, ys & 0xFF, (ys >> 8) & 0xFF,                               // SET_RAM_Y_ADDRESS_COUNTER
+        EPD_SEQ_END,
+    };
+    EPD_RunSequence(seq);
 }
 
-static void EPD_SetCursor(uint16_t xs, uint16_t ys) {
-    EPD_WR_REG(0x4E); // SET_RAM_X_ADDRESS_COUNTER
-    EPD_WR_DATA8((xs >> 3) & 0xFF); // X address is in units of 8 pixels
+// Update tables end with the master activation (0x20); EPD_Activate decides
+// whether to wait for BUSY
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+static const uint8_t s_seq_update[] = {
+    0x22, 1, 0xF7,              // Changed to 0xF7 to match working Arduino example
+    0x20, 0,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_update_part[] = {
+    0x22, 1, 0xFC,              // Example says FC
+    0x20, 0,
+    EPD_SEQ_END,
+};
+#else
+static const uint8_t s_seq_update[] = {
+    0x22, 1, 0xF7,
+    0x20, 0,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_update_part[] = {
+    0x22, 1, 0xFF,
+    0x20, 0,
+    EPD_SEQ_END,
+};
+#endif
 
-    EPD_WR_REG(0x4F); // SET_RAM_Y_ADDRESS_COUNTER
-    EPD_WR_DATA8(ys & 0xFF);
-    EPD_WR_DATA8((ys >> 8) & 0xFF);
+static const uint8_t s_seq_update_fast[] = {
+    0x22, 1, 0xC7,
+    0x20, 0,
+    EPD_SEQ_END,
+};
+
+// Border and update control for partial refresh
+static const uint8_t s_seq_part_setup[] = {
+    0x3C, 1, 0x80,              // BorderWavefrom
+    0x21, 2, 0x00, 0x00,        // Display update control
+    0x11, 1, 0x03,              // Data entry mode: X+ Y+
+    EPD_SEQ_END,
+};
+
+// Start the update in seq and wait for it, or with async refresh enabled leave
+// it running; `after` (may be NULL) is sent once BUSY has cleared.
+static void EPD_Activate(const uint8_t *seq, const uint8_t *after) {
+    if (s_sleep.wake_us != 0) {
+        EPD_WakeStats_t *st = &s_sleep.stats[s_sleep.wake_mode == EPD_SLEEP_DEEP];
+        uint32_t us = (uint32_t)(esp_timer_get_time() - s_sleep.wake_us);
+        st->latency_us_last = us;
+        st->latency_us_total += us;
+        if (us > st->latency_us_max) st->latency_us_max = us;
+        s_sleep.wake_us = 0;
+    }
+    // From here the panel no longer shows the frame saved for a warm boot
+    EPD_WarmBoot_Forget();
+    EPD_RunSequence(seq);
+    s_epd.busy_pending = true;
+    s_epd.after_busy = after;
+    if (!s_epd.async) {
+        EPD_WaitPending();
+    }
 }
 
-static void EPD_Update(void) {
-    EPD_WR_REG(0x22);
-#if defined(CONFIG_CROWPANEL_EPAPER_4_2_INCH)
-    EPD_WR_DATA8(0xF7);
-#elif defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    EPD_WR_DATA8(0xF7); // Changed to 0xF7 to match working Arduino example
-#else 
-    EPD_WR_DATA8(0xF7); // Default
-#endif
-    EPD_WR_REG(0x20);
+static void EPD_WaitPending(void) {
+    if (!s_epd.busy_pending) return;
     EPD_ReadBusy();
+    s_epd.busy_pending = false;
+    if (s_epd.after_busy) {
+        const uint8_t *after = s_epd.after_busy;
+        s_epd.after_busy = NULL;
+        EPD_RunSequence(after);
+    }
+}
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+static const uint8_t s_seq_part_restore[] = {
+    0x3C, 1, 0x01,              // Border
+    EPD_SEQ_END,
+};
+#endif
+
+static void EPD_Update(void) {
+    EPD_Activate(s_seq_update, NULL);
 }
 
 static void EPD_Update_Fast(void) {
-    EPD_WR_REG(0x22);
-    EPD_WR_DATA8(0xC7);
-    EPD_WR_REG(0x20);
-    EPD_ReadBusy();
+    EPD_Activate(s_seq_update_fast, NULL);
 }
 
-static void EPD_Update_Part(void) {
-    EPD_WR_REG(0x22);
-#if defined(CONFIG_CROWPANEL_EPAPER_4_2_INCH)
-    EPD_WR_DATA8(0xFF);
-#elif defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    EPD_WR_DATA8(0xFC); // Example says FC
-#else
-    EPD_WR_DATA8(0xFF);
-#endif
-    EPD_WR_REG(0x20);
-    EPD_ReadBusy();
+void EPD_SetAsyncRefresh(bool enable) {
+    s_epd.async = enable;
+}
+
+bool EPD_IsBusy(void) {
+    return s_epd.busy_pending && EPD_ReadBUSY != 0;
+}
+
+void EPD_WaitIdle(void) {
+    EPD_Bus_Take(false); // waits for and completes a pending update
+    EPD_Bus_Release();
 }
 
 // Driver Implementation
@@ -264,155 +629,280 @@ static void EPD_Update_Part(void) {
 // ==========================================
 // 4.2 Inch Initialization (SSD1683)
 // ==========================================
+static const uint8_t s_seq_frame_setup[] = {
+    0x21, 2, 0x40, 0x00,                    // Display update control
+    0x3C, 1, 0x05,                          // BorderWavefrom
+    0x11, 1, 0x03,                          // data entry mode: X-mode
+    0x44, 2, 0x00, (EPD_W - 1) >> 3,        // RAM X window
+    0x45, 4, 0x00, 0x00, (EPD_H - 1) & 0xFF, (EPD_H - 1) >> 8,  // RAM Y window
+    0x4E, 1, 0x00,                          // Cursor
+    0x4F, 2 | EPD_SEQ_BUSY, 0x00, 0x00,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_fast_1_5s[] = {
+    0x1A, 1, 0x6E,                          // Temperature register
+    0x22, 1, 0x91,                          // Load temperature value
+    0x20, 0 | EPD_SEQ_BUSY,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_fast_1s[] = {
+    0x1A, 1, 0x5A,
+    0x22, 1, 0x91,
+    0x20, 0 | EPD_SEQ_BUSY,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_fast_default[] = {
+    0x22, 1, 0x91,
+    0x20, 0 | EPD_SEQ_BUSY,
+    EPD_SEQ_END,
+};
+
+// Temperature override and waveform of fast mode `mode`
+static void EPD_Fast_Load(uint8_t mode) {
+    s_epd.mode = EPD_MODE_FAST_BASE + mode;
+    if (mode == Fast_Seconds_1_5s) {
+        EPD_RunSequence(s_seq_fast_1_5s);
+    } else if (mode == Fast_Seconds_1_s) {
+        EPD_RunSequence(s_seq_fast_1s);
+    } else {
+        EPD_RunSequence(s_seq_fast_default);
+    }
+}
+
 void EPD_Init(void) {
-    EPD_RESET();
-    EPD_ReadBusy();
-    EPD_WR_REG(0x12);   // soft reset
-    EPD_ReadBusy();
-    EPD_WR_REG(0x21); // Display update control
-    EPD_WR_DATA8(0x40);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_REG(0x3C); // BorderWavefrom
-    EPD_WR_DATA8(0x05);
-    EPD_WR_REG(0x11); // data entry mode
-    EPD_WR_DATA8(0x03);   // X-mode
-    EPD_Address_Set(0, 0, EPD_W - 1, EPD_H - 1);
-    EPD_SetCursor(0, 0);
-    EPD_ReadBusy();
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_Wake();
+    if (s_epd.mode != EPD_MODE_NONE && s_epd.mode != EPD_MODE_FULL) {
+        EPD_SoftReset();   // drop the fast-mode temperature override
+    }
+    s_epd.mode = EPD_MODE_FULL;
+
+    EPD_RunSequence(s_seq_frame_setup);
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_INIT);
 }
 
 void EPD_Init_Fast(uint8_t mode) {
-    EPD_RESET();
-    EPD_ReadBusy();
-    EPD_WR_REG(0x12);   // soft reset
-    EPD_ReadBusy();
-    EPD_WR_REG(0x21);
-    EPD_WR_DATA8(0x40);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_REG(0x3C);
-    EPD_WR_DATA8(0x05);
-    
-    if (mode == Fast_Seconds_1_5s) {
-        EPD_WR_REG(0x1A); 
-        EPD_WR_DATA8(0x6E);
-    } else if (mode == Fast_Seconds_1_s) {
-        EPD_WR_REG(0x1A);
-        EPD_WR_DATA8(0x5A);
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_Wake();
+    if (s_epd.mode != EPD_MODE_FAST_BASE + mode) {
+        if (s_epd.mode != EPD_MODE_NONE) {
+            EPD_SoftReset();
+        }
+        EPD_Fast_Load(mode);
     }
-    
-    EPD_WR_REG(0x22); // Load temperature value
-    EPD_WR_DATA8(0x91);
-    EPD_WR_REG(0x20);
-    EPD_ReadBusy();
-    EPD_WR_REG(0x11); // data entry mode
-    EPD_WR_DATA8(0x03);   // X-mode
-    EPD_Address_Set(0, 0, EPD_W - 1, EPD_H - 1);
-    EPD_SetCursor(0, 0);
-    EPD_ReadBusy();
+
+    EPD_RunSequence(s_seq_frame_setup);
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_INIT_FAST);
 }
 
 #elif defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
 // ==========================================
 // 2.13 Inch Initialization (Corrected for Portrait Controller 122x250)
 // ==========================================
-void EPD_Init(void) {
-    EPD_RESET();
-    EPD_ReadBusy();
-    
-    EPD_WR_REG(0x12); // SW Reset
-    EPD_ReadBusy();
-
-    // Driver output control (Gate MUX)
-    EPD_WR_REG(0x01);
-    EPD_WR_DATA8(0xF9); // (250-1) & 0xFF = 0xF9 -> MUX lines = 250
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x00);
-
-    // Data entry mode
-    EPD_WR_REG(0x11);
-    EPD_WR_DATA8(0x03); // X+ Y+
-
-    // Set RAM address window - 122(W) x 250(H) Physical
-    EPD_WR_REG(0x44); 
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x0F); // 15 * 8 = 120 (approx 122)
-
-    EPD_WR_REG(0x45); 
-    EPD_WR_DATA8(0x00); // Start Y Low
-    EPD_WR_DATA8(0x00); // Start Y High
-    EPD_WR_DATA8(0xF9); // End Y Low (249)
-    EPD_WR_DATA8(0x00); // End Y High
-
-    // Border
-    EPD_WR_REG(0x3C);
-    EPD_WR_DATA8(0x01);
-    
-    EPD_ReadBusy();
+static const uint8_t s_seq_init[] = {
+    0x01, 3, 0xF9, 0x00, 0x00,              // Driver output control: (250-1) & 0xFF = 0xF9 -> MUX lines = 250
+    0x11, 1, 0x03,                          // Data entry mode: X+ Y+
+    0x44, 2, 0x00, 0x0F,                    // RAM X window - 122(W) physical: 15 * 8 = 120 (approx 122)
+    0x45, 4, 0x00, 0x00, 0xF9, 0x00,        // RAM Y window - 250(H) physical: 0..249
+    0x3C, 1 | EPD_SEQ_BUSY, 0x01,           // Border
+    0x18, 1, 0x80,                          // Temp sensor
+    0x4E, 1, 0x00,                          // Reset Cursor
+    0x4F, 2 | EPD_SEQ_BUSY, 0x00, 0x00,
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_fast_temperature[] = {
+    0x18, 1, 0x80,                          // Temperature sensor control: internal sensor
+    0x22, 1, 0xB1,                          // Display Update Control 2: load temperature value
+    0x20, 0 | EPD_SEQ_BUSY,                 // Master Activation
+    0x1A, 2, 0x64, 0x00,                    // Write temperature register
+    0x22, 1, 0x91,                          // Display Update Control 2: load temperature value
+    0x20, 0 | EPD_SEQ_BUSY,                 // Master Activation
+    EPD_SEQ_END,
+};
+
+static const uint8_t s_seq_fast_setup[] = {
+    0x11, 1, 0x03,                          // Data entry mode: X+ Y+
+    0x44, 2, 0x00, 0x1F,                    // RAM X window - 250x122 landscape: 31 (32*8=256, covers 250)
+    0x45, 4, 0x00, 0x00, 0x79, 0x00,        // RAM Y window: 121 (122-1)
+    0x4E, 1, 0x00,                          // Set initial cursor
+    0x4F, 2 | EPD_SEQ_BUSY, 0x00, 0x00,
+    EPD_SEQ_END,
+};
+
+// Temperature override and waveform of fast mode `mode`
+static void EPD_Fast_Load(uint8_t mode) {
+    s_epd.mode = EPD_MODE_FAST_BASE + mode;
+    EPD_RunSequence(s_seq_fast_temperature);
+}
 
-    // Temp sensor
-    EPD_WR_REG(0x18);
-    EPD_WR_DATA8(0x80);
+void EPD_Init(void) {
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_Wake();
+    if (s_epd.mode != EPD_MODE_NONE && s_epd.mode != EPD_MODE_FULL) {
+        EPD_SoftReset(); // drop the fast-mode temperature override
+    }
+    s_epd.mode = EPD_MODE_FULL;
 
-    // Reset Cursor
-    EPD_WR_REG(0x4E);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_REG(0x4F);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x00);
-    
-    EPD_ReadBusy();
+    EPD_RunSequence(s_seq_init);
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_INIT);
 }
 
 void EPD_Init_Fast(uint8_t mode) {
-    EPD_RESET();
-    
-    EPD_WR_REG(0x12);  // SW Reset
-    EPD_ReadBusy();   
-    
-    EPD_WR_REG(0x18); // Temperature sensor control
-    EPD_WR_DATA8(0x80); // Internal sensor
-        
-    EPD_WR_REG(0x22); // Display Update Control 2
-    EPD_WR_DATA8(0xB1); // Load temperature value    
-    EPD_WR_REG(0x20); // Master Activation
-    EPD_ReadBusy();   
-
-    EPD_WR_REG(0x1A); // Write temperature register
-    EPD_WR_DATA8(0x64); // Temperature value    
-    EPD_WR_DATA8(0x00);  
-            
-    EPD_WR_REG(0x22); // Display Update Control 2
-    EPD_WR_DATA8(0x91); // Load temperature value    
-    EPD_WR_REG(0x20); // Master Activation
-    EPD_ReadBusy();
-    
-    // Configure data entry mode
-    EPD_WR_REG(0x11); // Data entry mode
-    EPD_WR_DATA8(0x03); // X+ Y+
-    
-    // Set RAM address window - 250x122 landscape
-    EPD_WR_REG(0x44); // Set RAM X address
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x1F); // 31 (32*8=256, covers 250)
-    
-    EPD_WR_REG(0x45); // Set RAM Y address
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x79); // 121 (122-1)
-    EPD_WR_DATA8(0x00);
-    
-    // Set initial cursor
-    EPD_WR_REG(0x4E);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_REG(0x4F);
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x00);
-    
-    EPD_ReadBusy();
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_Wake();
+    if (s_epd.mode != EPD_MODE_FAST_BASE + mode) {
+        if (s_epd.mode != EPD_MODE_NONE) {
+            EPD_SoftReset();
+        }
+        EPD_Fast_Load(mode);
+    }
+
+    EPD_RunSequence(s_seq_fast_setup);
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_INIT_FAST);
 }
 #endif
 
+static void EPD_WR_DATA_RECT(const uint8_t *Image, uint16_t xb, uint16_t y, uint16_t wb, uint16_t h);
+
+// Mirror in use, NULL when sync is off, suspended by a color frame or the
+// arena has none; a different buffer than last time knows nothing about the
+// panel
+static uint8_t *EPD_OldRam_Mirror(void) {
+    uint8_t *mirror = (s_old.enabled && !s_old.color) ? EPD_Arena_OldRam() : NULL;
+    if (mirror != s_old.mirror) {
+        s_old.mirror = mirror;
+        s_old.valid = false;
+        EPD_OldRam_Clean();
+    }
+    return mirror;
+}
+
+// Record a 0x24 write of wb x h bytes at byte column xb, row y; rows are
+// `stride` bytes apart in Data. Only the changed span of each row is copied
+// into the mirror and added to the pending box.
+static void EPD_OldRam_Track(const uint8_t *Data, size_t stride, uint16_t xb, uint16_t y, uint16_t wb, uint16_t h) {
+    if (xb == 0 && wb == EPD_FRAME_STRIDE && y == 0 && h == EPD_H) {
+        s_old.color = false;            // Black/white again from this frame on
+    }
+    uint8_t *mirror = EPD_OldRam_Mirror();
+    if (mirror == NULL || xb >= EPD_FRAME_STRIDE || y >= EPD_H) {
+        return;
+    }
+    if (wb > EPD_FRAME_STRIDE - xb) wb = EPD_FRAME_STRIDE - xb;
+    if (h > EPD_H - y) h = EPD_H - y;
+    if (wb == 0 || h == 0) {
+        return;
+    }
+
+    for (uint16_t r = 0; r < h; r++) {
+        uint8_t *m = mirror + (uint32_t)(y + r) * EPD_FRAME_STRIDE + xb;
+        const uint8_t *d = Data + (size_t)r * stride;
+        uint16_t first = 0, last = wb - 1;
+
+        if (s_old.valid) {
+            size_t f, l;
+            if (!EPD_Bits_DiffSpan(m, d, wb, &f, &l)) continue;
+            first = f;
+            last = l;
+        }
+        memcpy(m + first, d + first, last - first + 1);
+
+        if (xb + first < s_old.xb0) s_old.xb0 = xb + first;
+        if (xb + last > s_old.xb1) s_old.xb1 = xb + last;
+        if (y + r < s_old.y0) s_old.y0 = y + r;
+        if (y + r > s_old.y1) s_old.y1 = y + r;
+    }
+    if (xb == 0 && wb == EPD_FRAME_STRIDE && y == 0 && h == EPD_H) {
+        s_old.valid = true;
+    }
+}
+
+// 0x26 was written over this box with something else than the mirror
+static void EPD_OldRam_Pend(uint16_t xb, uint16_t y, uint16_t wb, uint16_t h) {
+    if (EPD_OldRam_Mirror() == NULL) {
+        return;
+    }
+    if (xb < s_old.xb0) s_old.xb0 = xb;
+    if (xb + wb - 1 > s_old.xb1) s_old.xb1 = xb + wb - 1;
+    if (y < s_old.y0) s_old.y0 = y;
+    if (y + h - 1 > s_old.y1) s_old.y1 = y + h - 1;
+}
+
+// Bring 0x26 up to the mirror; runs at the start of every partial update,
+// when the previous update has finished (the bus acquire waited for it)
+static void EPD_OldRam_Flush(void) {
+    if (s_old.hold) {
+        s_old.hold = false;
+        return;
+    }
+    uint8_t *mirror = EPD_OldRam_Mirror();
+    if (mirror == NULL || s_old.xb0 > s_old.xb1) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_SetWindow(s_old.xb0 * 8, s_old.y0, s_old.xb1 * 8 + 7, s_old.y1);
+    EPD_WR_REG(0x26); // Write RAM (OLD data)
+    EPD_WR_DATA_RECT(mirror, s_old.xb0, s_old.y0, s_old.xb1 - s_old.xb0 + 1, s_old.y1 - s_old.y0 + 1);
+    EPD_OldRam_Clean();
+    EPD_TRACE_END(span, EPD_PHASE_OLD_RAM);
+}
+
+// A whole frame in the mirror's layout into RAM reg (0x24 or 0x26), after
+// s_seq_part_setup
+static void EPD_WR_FRAME(uint8_t reg, const uint8_t *Image) {
+    EPD_SetWindow(0, 0, EPD_FRAME_STRIDE * 8 - 1, EPD_H - 1);
+    EPD_WR_REG(reg);
+    EPD_WR_DATA_RECT(Image, 0, 0, EPD_FRAME_STRIDE, EPD_H);
+}
+
+void EPD_Display_Seed(const uint8_t *Image) {
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_Init();
+    EPD_RunSequence(s_seq_part_setup);
+    EPD_WR_FRAME(0x24, Image); // Write RAM (BW)
+    EPD_WR_FRAME(0x26, Image); // Write RAM (OLD data)
+    s_old.color = false;
+    uint8_t *mirror = EPD_OldRam_Mirror();
+    if (mirror != NULL) {
+        if (mirror != Image) {
+            memcpy(mirror, Image, EPD_FRAME_SIZE);
+        }
+        s_old.valid = true;
+        s_old.hold = false;
+        EPD_OldRam_Clean();
+    }
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_SEED);
+}
+
+const uint8_t *EPD_Shown(void) {
+    EPD_Bus_Take(false);  // an update still running finishes first
+    uint8_t *mirror = EPD_OldRam_Mirror();
+    bool known = (mirror != NULL && s_old.valid);
+    EPD_Bus_Release();
+    return known ? mirror : NULL;
+}
+
+void EPD_SetOldRamSync(bool enable) {
+    s_old.enabled = enable;
+    EPD_OldRam_Mirror();
+}
+
 void EPD_Clear(void) {
+    EPD_TRACE_BEGIN(span);
     uint32_t size;
 #if defined(CONFIG_CROWPANEL_EPAPER_4_2_INCH)
     uint16_t Width = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
@@ -425,6 +915,7 @@ void EPD_Clear(void) {
     size = Width * EPD_H;
 #endif
 
+    EPD_Bus_Acquire();
     EPD_Init();
     
     // Write to both NEW (0x24) and OLD (0x26) data buffers
@@ -433,11 +924,24 @@ void EPD_Clear(void) {
 
     EPD_WR_REG(0x26); // Write RAM (OLD data)
     EPD_WR_DATA_REPEAT(0xFF, size);
+
+    s_old.color = false;
+    uint8_t *mirror = EPD_OldRam_Mirror();
+    if (mirror != NULL) {
+        memset(mirror, 0xFF, EPD_FRAME_SIZE);
+        s_old.valid = true;
+        s_old.hold = false;
+        EPD_OldRam_Clean();
+    }
+    EPD_Heat_Clean(NULL);
     
     EPD_Update();
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_CLEAR);
 }
 
 void EPD_Clear_R26H(void) {
+    EPD_TRACE_BEGIN(span);
     uint32_t size;
 #if defined(CONFIG_CROWPANEL_EPAPER_4_2_INCH)
     uint16_t Width = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
@@ -449,28 +953,33 @@ void EPD_Clear_R26H(void) {
     size = Width * EPD_H;
 #endif
     
+    EPD_Bus_Acquire();
     EPD_WR_REG(0x26); // Write RAM (OLD data)
     EPD_WR_DATA_REPEAT(0xFF, size);
+    EPD_Bus_Release();
+
+    // The next partial update runs from white as asked; 0x26 is brought back
+    // to the panel content before the one after it
+    if (EPD_OldRam_Mirror() != NULL) {
+        s_old.hold = true;
+        if (s_old.valid) {
+            s_old.xb0 = 0;
+            s_old.xb1 = EPD_FRAME_STRIDE - 1;
+            s_old.y0 = 0;
+            s_old.y1 = EPD_H - 1;
+        }
+    }
+    EPD_TRACE_END(span, EPD_PHASE_CLEAR);
 }
 
-void EPD_Display(const uint8_t *Image) {
-    uint16_t Width, Height;
-    Width = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
-    Height = EPD_H;
-    
 #if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    // 2.13" display requires 90 degree rotation and coordinate mapping
-    // Logical: 250(W) x 122(H). Physical: 122(W) x 250(H).
-    
-    // Allocate buffer for physical frame (122x250 pixels)
-    // 122 pixels wide -> 16 bytes per line. 250 lines. = 4000 bytes.
-    size_t phys_buf_size = 4000;
-    uint8_t *phys_buf = heap_caps_malloc(phys_buf_size, MALLOC_CAP_DMA);
-    if (!phys_buf) {
-        ESP_LOGE(TAG, "Failed to allocate rotation buffer");
-        return;
-    }
-    memset(phys_buf, 0xFF, phys_buf_size); // Initialize to White
+// 2.13" display requires 90 degree rotation and coordinate mapping
+// Logical: 250(W) x 122(H). Physical: 122(W) x 250(H).
+// 122 pixels wide -> 16 bytes per line. 250 lines. = EPD_NATIVE_FRAME_SIZE.
+
+static void EPD_Transform_Frame(const uint8_t *Image, uint8_t *phys_buf) {
+    EPD_TRACE_BEGIN(transform);
+    memset(phys_buf, 0xFF, EPD_NATIVE_FRAME_SIZE); // Initialize to White
 
     uint16_t log_stride = (EPD_W + 7) / 8; // 32 bytes for 250 pixels
 
@@ -510,102 +1019,455 @@ void EPD_Display(const uint8_t *Image) {
             phys_buf[y_phys * 16 + x_phys_byte] = byte_to_send;
         }
     }
+    EPD_TRACE_END(transform, EPD_PHASE_TRANSFORM);
+}
+#endif
 
+void EPD_Display(const uint8_t *Image) {
+    EPD_TRACE_BEGIN(span);
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+    // Physical frame (122x250 pixels) in the arena's static rotation buffer,
+    // shared with EPD_Display_Color: only written with the bus held
+    EPD_Bus_Acquire();
+    uint8_t *phys_buf = EPD_Arena_Native();
+    EPD_Transform_Frame(Image, phys_buf);
     EPD_WR_REG(0x24);
-    EPD_WR_DATA_BUFFER(phys_buf, phys_buf_size);
-    
-    free(phys_buf);
+    EPD_WR_DATA_BUFFER(phys_buf, EPD_NATIVE_FRAME_SIZE);
+    EPD_OldRam_Track(Image, EPD_FRAME_STRIDE, 0, 0, EPD_FRAME_STRIDE, EPD_H);
+    EPD_Heat_Clean(NULL);
     EPD_Update();
+    EPD_Bus_Release();
     // EPD_Clear_R26H() was redundant in simple driver, skipping for speed unless needed
 #else
     // 4.2" display uses normal pixel data
+    EPD_Bus_Acquire();
     EPD_WR_REG(0x24);
-    EPD_WR_DATA_BUFFER(Image, Width * Height);
+    EPD_WR_DATA_BUFFER(Image, EPD_FRAME_SIZE);
+    EPD_OldRam_Track(Image, EPD_FRAME_STRIDE, 0, 0, EPD_FRAME_STRIDE, EPD_H);
+    EPD_Heat_Clean(NULL);
     EPD_Update();
+    EPD_Bus_Release();
 #endif
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY);
+}
+
+void EPD_Display_Color(const uint8_t *Image, const uint8_t *Color) {
+    if (Color == NULL) {
+        EPD_Display(Image);
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    // 0x26 now holds the color plane, mirroring the black/white image into it
+    // would paint it red: no sync until the next black/white full frame
+    s_old.color = true;
+    EPD_OldRam_Mirror();
+    // Use the red RAM as is (EPD_Init bypasses it on the 4.2")
+    EPD_WR_CMD(0x21, (const uint8_t[]){ 0x00, 0x00 }, 2);
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+    // One buffer for both planes: EPD_WR_DATA_BUFFER has drained before it returns
+    uint8_t *phys_buf = EPD_Arena_Native();
+    EPD_Transform_Frame(Image, phys_buf);
+    EPD_WR_REG(0x24);
+    EPD_WR_DATA_BUFFER(phys_buf, EPD_NATIVE_FRAME_SIZE);
+    EPD_Transform_Frame(Color, phys_buf);
+    EPD_WR_REG(0x26);
+    EPD_WR_DATA_BUFFER(phys_buf, EPD_NATIVE_FRAME_SIZE);
+#else
+    EPD_WR_REG(0x24);
+    EPD_WR_DATA_BUFFER(Image, EPD_FRAME_SIZE);
+    EPD_WR_REG(0x26);
+    EPD_WR_DATA_BUFFER(Color, EPD_FRAME_SIZE);
+#endif
+
+    EPD_Heat_Clean(NULL);
+    EPD_Update();
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY);
+}
+
+void EPD_Display_Native_Begin(void) {
+    EPD_Bus_Acquire();
+    EPD_WR_REG(0x24);
+}
+
+void EPD_Display_Native_Write(const uint8_t *Data, size_t len) {
+    EPD_WR_DATA_BUFFER(Data, len);
+}
+
+void EPD_Display_Native_End(void) {
+    s_old.valid = false;
+    EPD_OldRam_Clean();
+    EPD_Heat_Clean(NULL);
+    EPD_Update();
+    EPD_Bus_Release();
+}
+
+void EPD_Display_Native(const uint8_t *Native) {
+    EPD_TRACE_BEGIN(span);
+    EPD_Display_Native_Begin();
+    EPD_Display_Native_Write(Native, EPD_NATIVE_FRAME_SIZE);
+    EPD_Display_Native_End();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY);
 }
 
 void EPD_Display_Fast(const uint8_t *Image) {
+    EPD_TRACE_BEGIN(span);
     uint16_t Width, Height;
     Width = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
     Height = EPD_H;
     
+    EPD_Bus_Acquire();
 #if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
     // 2.13" display requires inverted pixel data
     EPD_WR_REG(0x24);
-    for (uint32_t i = 0; i < Width * Height; i++) {
-        EPD_WR_DATA8(~Image[i]);
-    }
+    EPD_WR_DATA_INVERTED(Image, Width * Height);
 #else
     // 4.2" display uses normal pixel data
     EPD_WR_REG(0x24);
     EPD_WR_DATA_BUFFER(Image, Width * Height);
 #endif
+    EPD_OldRam_Track(Image, EPD_FRAME_STRIDE, 0, 0, EPD_FRAME_STRIDE, EPD_H);
+    // The fast waveform drives every pixel too
+    EPD_Heat_Clean(NULL);
     
     EPD_Update_Fast();
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY_FAST);
+}
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define EPD_PART_INVERT true    // 2.13" display requires inverted pixel data
+#else
+#define EPD_PART_INVERT false   // 4.2" display uses normal pixel data
+#endif
+
+static void EPD_Part_Update(void) {
+    EPD_Heat_Commit();
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+    // After partial update on 2.13, restore border setting
+    EPD_Activate(s_seq_update_part, s_seq_part_restore);
+#else
+    EPD_Activate(s_seq_update_part, NULL);
+#endif
 }
 
 void EPD_Display_Part(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image) {
+    EPD_TRACE_BEGIN(span);
     uint16_t Width, Height;
     Width = (sizex % 8 == 0) ? (sizex / 8) : (sizex / 8 + 1);
     Height = sizey;
     
-    // Configure border and display update control
-    EPD_WR_REG(0x3C); // BorderWavefrom
-    EPD_WR_DATA8(0x80);
-    
-    EPD_WR_REG(0x21); // Display update control
-    EPD_WR_DATA8(0x00);
-    EPD_WR_DATA8(0x00);
-    
-    EPD_WR_REG(0x3C); // BorderWavefrom
-    EPD_WR_DATA8(0x80);
-    
-    // Set data entry mode
-    EPD_WR_REG(0x11); // Data entry mode
-    EPD_WR_DATA8(0x03); // X+ Y+
+    EPD_Bus_Acquire();
+
+    // Configure border, display update control and data entry mode
+    EPD_RunSequence(s_seq_part_setup);
+    EPD_OldRam_Flush();
     
     // Set address window
-    EPD_Address_Set(x, y, x + sizex - 1, y + sizey - 1);
-    EPD_SetCursor(x, y);
+    EPD_SetWindow(x, y, x + sizex - 1, y + sizey - 1);
     
     // Write image data
     EPD_WR_REG(0x24); // Write RAM (BW)
     
 #if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    // 2.13" display requires inverted pixel data
-    for (uint32_t i = 0; i < Width * Height; i++) {
-        EPD_WR_DATA8(~Image[i]);
-    }
+    EPD_WR_DATA_INVERTED(Image, Width * Height);
 #else
-    // 4.2" display uses normal pixel data
     EPD_WR_DATA_BUFFER(Image, Width * Height);
 #endif
+    EPD_OldRam_Track(Image, Width, x / 8, y, Width, Height);
+    EPD_Heat_Touch(x, y, sizex, sizey);
     
-    EPD_Update_Part();
-    
+    EPD_Part_Update();
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY_PART);
+}
+
+// Window of a full logical frame: rows are EPD_FRAME_STRIDE apart in Image.
+// Rows longer than a polling transfer are queued straight from the frame, one
+// DMA transaction each (spi_master has no scatter-gather list, the queue of
+// EPD_SPI_QUEUE_SIZE transactions plays that role); narrow, inverted or
+// non-DMA rows are packed into the bounce buffers, where one copy is cheaper
+// than a transaction per row. `invert` sends the complement of the window
+// (partial updates send the 2.13" frame inverted already, see EPD_PART_INVERT).
+static void EPD_WR_DATA_RECT_INV(const uint8_t *Image, uint16_t xb, uint16_t y, uint16_t wb, uint16_t h, bool invert) {
+    const uint8_t *row = Image + (uint32_t)y * EPD_FRAME_STRIDE + xb;
+    bool inv = EPD_PART_INVERT ^ invert;
+
+    if (wb == EPD_FRAME_STRIDE) {
+        // Full rows are contiguous
+        if (inv) {
+            EPD_TRACE_BEGIN(span);
+            EPD_WR_DATA_BOUNCED(row, (size_t)wb * h, true);
+            EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
+        } else {
+            EPD_WR_DATA_BUFFER(row, (size_t)wb * h);
+        }
+        return;
+    }
+
+    EPD_TRACE_BEGIN(span);
+    if (!inv && wb > EPD_SPI_POLL_MAX && esp_ptr_dma_capable(Image)) {
+        for (uint16_t r = 0; r < h; r++, row += EPD_FRAME_STRIDE) {
+            EPD_SPI_Queue(1, row, wb);
+        }
+        EPD_SPI_Drain(0);
+        EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
+        return;
+    }
+
+    uint8_t n = 0;
+    size_t fill = 0;
+    uint8_t *buf = EPD_Arena_Bounce(n);
+    EPD_SPI_Drain(0);
+    for (uint16_t r = 0; r < h; r++, row += EPD_FRAME_STRIDE) {
+        if (fill + wb > EPD_SPI_BOUNCE_SIZE) {
+            EPD_SPI_Queue(1, buf, fill);
+            EPD_SPI_Drain(1); // the other buffer is free again
+            n ^= 1;
+            buf = EPD_Arena_Bounce(n);
+            fill = 0;
+        }
+        if (inv) {
+            EPD_Bits_Invert(buf + fill, row, wb);
+        } else {
+            memcpy(buf + fill, row, wb);
+        }
+        fill += wb;
+    }
+    EPD_SPI_Queue(1, buf, fill);
+    EPD_SPI_Drain(0);
+    EPD_TRACE_END(span, EPD_PHASE_SPI_DATA);
+}
+
+static void EPD_WR_DATA_RECT(const uint8_t *Image, uint16_t xb, uint16_t y, uint16_t wb, uint16_t h) {
+    EPD_WR_DATA_RECT_INV(Image, xb, y, wb, h, false);
+}
+
+// Clip to the frame and widen X to byte boundaries; false if empty
+static bool EPD_Part_Clip(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+                          uint16_t *xb, uint16_t *wb, uint16_t *h) {
+    if (x >= EPD_W || y >= EPD_H || sizex == 0 || sizey == 0) {
+        return false;
+    }
+    uint16_t xe = (x + sizex > EPD_W) ? EPD_W : x + sizex;  // exclusive
+    *xb = x / 8;
+    *wb = (xe + 7) / 8 - *xb;
+    *h = (y + sizey > EPD_H) ? EPD_H - y : sizey;
+    return true;
+}
+
+void EPD_Display_Part_Stride(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image) {
+    uint16_t xb, wb, h;
+    if (!EPD_Part_Clip(x, y, sizex, sizey, &xb, &wb, &h)) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_RunSequence(s_seq_part_setup);
+    EPD_OldRam_Flush();
+    EPD_SetWindow(xb * 8, y, (xb + wb) * 8 - 1, y + h - 1);
+    EPD_WR_REG(0x24); // Write RAM (BW)
+    EPD_WR_DATA_RECT(Image, xb, y, wb, h);
+    EPD_OldRam_Track(Image + (uint32_t)y * EPD_FRAME_STRIDE + xb, EPD_FRAME_STRIDE, xb, y, wb, h);
+    EPD_Heat_Touch(xb * 8, y, wb * 8, h);
+    EPD_Part_Update();
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY_PART);
+}
+
+void EPD_Display_Part_Multi(const EPD_Rect_t *rects, size_t count, const uint8_t *Image) {
+    uint16_t xb, wb, h;
+    bool any = false;
+
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    for (size_t i = 0; i < count; i++) {
+        const EPD_Rect_t *r = &rects[i];
+        if (!EPD_Part_Clip(r->x, r->y, r->width, r->height, &xb, &wb, &h)) {
+            continue;
+        }
+        if (!any) {
+            EPD_RunSequence(s_seq_part_setup);
+            EPD_OldRam_Flush();
+            any = true;
+        }
+        // Each window gets its own RAM window and cursor, the update comes once
+        EPD_SetWindow(xb * 8, r->y, (xb + wb) * 8 - 1, r->y + h - 1);
+        EPD_WR_REG(0x24); // Write RAM (BW)
+        EPD_WR_DATA_RECT(Image, xb, r->y, wb, h);
+        EPD_OldRam_Track(Image + (uint32_t)r->y * EPD_FRAME_STRIDE + xb, EPD_FRAME_STRIDE, xb, r->y, wb, h);
+        EPD_Heat_Touch(xb * 8, r->y, wb * 8, h);
+    }
+    if (any) {
+        EPD_Part_Update();
+    }
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY_PART);
+}
+
+void EPD_Display_Part_Clean(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image) {
+    uint16_t xb, wb, h;
+    if (!EPD_Part_Clip(x, y, sizex, sizey, &xb, &wb, &h)) {
+        return;
+    }
+    uint16_t xs = xb * 8, xe = (xb + wb) * 8 - 1, ye = y + h - 1;
+
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Acquire();
+    EPD_RunSequence(s_seq_part_setup);
+    EPD_OldRam_Flush();
+    if (EPD_OldRam_Mirror() == NULL) {
+        // Nothing says what the panel shows; take it to be Image
+        EPD_SetWindow(xs, y, xe, ye);
+        EPD_WR_REG(0x26);
+        EPD_WR_DATA_RECT(Image, xb, y, wb, h);
+    }
+    // First waveform: every pixel of the window to the opposite color
+    EPD_SetWindow(xs, y, xe, ye);
+    EPD_WR_REG(0x24);
+    EPD_WR_DATA_RECT_INV(Image, xb, y, wb, h, true);
+    EPD_Part_Update();
+    EPD_WaitPending();
+
+    // Second waveform: back to Image from the inverted window. Both RAMs
+    // share the address counter, so each write starts at the window origin.
+    EPD_RunSequence(s_seq_part_setup);
+    EPD_SetWindow(xs, y, xe, ye);
+    EPD_WR_REG(0x26);
+    EPD_WR_DATA_RECT_INV(Image, xb, y, wb, h, true);
+    EPD_SetWindow(xs, y, xe, ye);
+    EPD_WR_REG(0x24);
+    EPD_WR_DATA_RECT(Image, xb, y, wb, h);
+    EPD_OldRam_Track(Image + (uint32_t)y * EPD_FRAME_STRIDE + xb, EPD_FRAME_STRIDE, xb, y, wb, h);
+    EPD_OldRam_Pend(xb, y, wb, h);
+    EPD_Part_Update();
+    EPD_Bus_Release();
+
+    EPD_Heat_Clean(&(EPD_Rect_t){ .x = xs, .y = y, .width = wb * 8, .height = h });
+    EPD_TRACE_END(span, EPD_PHASE_DISPLAY_PART);
+}
+
 #if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    // After partial update on 2.13, restore border setting
-    EPD_WR_REG(0x3C);
-    EPD_WR_DATA8(0x01);
+// Sent before 0x10: a sleeping controller takes no further commands
+static const uint8_t s_seq_sleep[] = {
+    0x3C, 1, 0x01,              // Border
+    EPD_SEQ_END,
+};
 #endif
-}
 
 void EPD_Sleep(void) {
-    EPD_WR_REG(0x10);
-    EPD_WR_DATA8(0x01);
+    EPD_Sleep_Mode(EPD_SLEEP_RETAIN);
+}
+
+void EPD_Sleep_Mode(EPD_SleepMode_t mode) {
+    EPD_TRACE_BEGIN(span);
+    EPD_Bus_Take(false);  // an update still running finishes first
+    if (s_sleep.mode == 0 && s_epd.awake) {
 #if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
-    EPD_WR_REG(0x3C);
-    EPD_WR_DATA8(0x01);
+        EPD_RunSequence(s_seq_sleep);
+#endif
+#if CONFIG_CROWPANEL_EPAPER_WARM_BOOT_SAVE_ON_SLEEP
+        EPD_WarmBoot_Save();
 #endif
-    delay(50);
+        uint8_t m = (uint8_t)mode;
+        EPD_WR_REG(0x10);  // Deep sleep mode
+        EPD_SPI_Queue(1, &m, 1);
+        // Only a hardware reset wakes the chip, and it resets the register
+        // file; keep what it held for the wake
+        memcpy(s_sleep.regs, s_epd.regs, sizeof(s_sleep.regs));
+        s_sleep.waveform = s_epd.mode;
+        s_sleep.mode = m;
+        s_epd.awake = false;
+        EPD_State_Invalidate();
+    }
+    EPD_Bus_Release();
+    EPD_TRACE_END(span, EPD_PHASE_SLEEP);
+}
+
+// Hardware reset out of sleep, then what the sleep mode lost: after
+// EPD_SLEEP_DEEP both RAMs from the mirror (in the partial update layout the
+// mirror is kept in), the fast waveform and temperature override, and the
+// registers as they were. Bus held.
+static void EPD_Resume(void) {
+    EPD_TRACE_BEGIN(span);
+    int64_t t0 = esp_timer_get_time();
+    uint8_t mode = s_sleep.mode;
+
+    s_sleep.mode = 0;
+    EPD_RESET();
+    if (mode == EPD_SLEEP_DEEP) {
+        uint8_t *mirror = EPD_OldRam_Mirror();
+        if (mirror != NULL && s_old.valid) {
+            EPD_RunSequence(s_seq_part_setup);
+            EPD_WR_FRAME(0x24, mirror); // Write RAM (BW)
+            if (s_old.hold) {
+                // EPD_Clear_R26H asked for a white 0x26; the pending box
+                // brings it back afterwards
+                EPD_SetWindow(0, 0, EPD_FRAME_STRIDE * 8 - 1, EPD_H - 1);
+                EPD_WR_REG(0x26); // Write RAM (OLD data)
+                EPD_WR_DATA_REPEAT(0xFF, EPD_FRAME_SIZE);
+            } else {
+                EPD_WR_FRAME(0x26, mirror);
+                EPD_OldRam_Clean();
+            }
+        } else {
+            s_old.valid = false;
+            EPD_OldRam_Clean();
+        }
+    }
+    if (s_sleep.waveform >= EPD_MODE_FAST_BASE) {
+        EPD_Fast_Load(s_sleep.waveform - EPD_MODE_FAST_BASE);
+    }
+    s_epd.mode = s_sleep.waveform;
+    for (size_t i = 0; i < sizeof(s_sleep.regs) / sizeof(s_sleep.regs[0]); i++) {
+        if (s_sleep.regs[i].len != 0) {
+            EPD_WR_CMD(s_sleep.regs[i].reg, s_sleep.regs[i].data, s_sleep.regs[i].len);
+        }
+    }
+    // The cursor is not shadowed; full frame writes start at the origin of
+    // the RAM window (0x44, 0x45)
+    const EPD_RegShadow_t *x = &s_sleep.regs[7], *y = &s_sleep.regs[8];
+    const uint8_t cursor[] = {
+        0x4E, 1, x->len ? x->data[0] : 0x00,
+        0x4F, 2, y->len ? y->data[0] : 0x00, y->len ? y->data[1] : 0x00,
+        EPD_SEQ_END,
+    };
+    EPD_RunSequence(cursor);
+
+    EPD_WakeStats_t *st = &s_sleep.stats[mode == EPD_SLEEP_DEEP];
+    st->wakes++;
+    st->resume_us_last = (uint32_t)(esp_timer_get_time() - t0);
+    s_sleep.wake_us = t0;
+    s_sleep.wake_mode = mode;
+    EPD_TRACE_END(span, EPD_PHASE_WAKE);
+}
+
+void EPD_Sleep_GetStats(EPD_SleepMode_t mode, EPD_WakeStats_t *stats) {
+    *stats = s_sleep.stats[mode == EPD_SLEEP_DEEP];
+}
+
+void EPD_Sleep_ResetStats(void) {
+    memset(s_sleep.stats, 0, sizeof(s_sleep.stats));
+    s_sleep.wake_us = 0;
 }
 
 // GUI Implementation
 
 void Paint_NewImage(uint8_t *image, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color) {
-    Paint.Image = 0x00;
-    Paint.Image = image;
+    Paint_NewImagePlanes(&image, 1, Width, Height, Rotate, Color);
+}
+
+void Paint_NewImagePlanes(uint8_t *const planes[], uint8_t count, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color) {
+    if (count < 1) count = 1;
+    if (count > EPD_MAX_PLANES) count = EPD_MAX_PLANES;
+    memset(Paint.Planes, 0, sizeof(Paint.Planes));
+    for (uint8_t p = 0; p < count; p++) {
+        Paint.Planes[p] = planes[p];
+    }
+    Paint.PlaneCount = count;
+    Paint.Image = planes[0];
 
     Paint.WidthMemory = Width;
     Paint.HeightMemory = Height;
@@ -622,10 +1484,43 @@ void Paint_NewImage(uint8_t *image, uint16_t Width, uint16_t Height, uint16_t Ro
     }
 }
 
+// Memory rows the calling task may draw into, see EPD_Paint_SetBand. Thread
+// local, so band workers on both cores share Paint and clip independently.
+static __thread struct {
+    uint16_t y0, y1;
+} s_band = { 0, UINT16_MAX };
+
+void EPD_Paint_SetBand(uint16_t y0, uint16_t y1) {
+    s_band.y0 = y0;
+    s_band.y1 = y1;
+}
+
+// The band as logical coordinates [*lo, *hi) on the axis that maps to memory
+// rows: y under ROTATE_0/180, x under ROTATE_90/270 (*axis_x). False when the
+// band covers the canvas, so the primitives only clip for a band worker.
+static bool Paint_BandAxis(int32_t *lo, int32_t *hi, bool *axis_x) {
+    int32_t hm = Paint.HeightMemory;
+    int32_t y1 = (s_band.y1 < hm) ? s_band.y1 : hm;
+    if (s_band.y0 == 0 && y1 == hm) {
+        return false;
+    }
+    bool flip = (Paint.Rotate == ROTATE_180 || Paint.Rotate == ROTATE_270);
+    *axis_x = (Paint.Rotate == ROTATE_90 || Paint.Rotate == ROTATE_270);
+    *lo = flip ? hm - y1 : s_band.y0;
+    *hi = flip ? hm - s_band.y0 : y1;
+    return true;
+}
+
+// Value of each plane for a color, bit p = plane p: the black/white plane is
+// 0 only for BLACK, the color plane is 1 only for RED
+static inline uint8_t Paint_PlaneBits(uint16_t Color) {
+    return (Color == BLACK ? 0x00 : 0x01) | (Color == RED ? 0x02 : 0x00);
+}
+
 void Paint_SetPixel(uint16_t Xpoint, uint16_t Ypoint, uint16_t Color) {
     uint16_t X, Y;
     uint32_t Addr;
-    uint8_t Rdata;
+    uint8_t Rdata, mask;
     switch (Paint.Rotate) {
         case 0:
             X = Xpoint;
@@ -647,28 +1542,381 @@ void Paint_SetPixel(uint16_t Xpoint, uint16_t Ypoint, uint16_t Color) {
             return;
     }
     if (X >= Paint.WidthMemory || Y >= Paint.HeightMemory) return;
+    if (Y < s_band.y0 || Y >= s_band.y1) return;
 
     Addr = X / 8 + Y * Paint.WidthByte;
-    Rdata = Paint.Image[Addr];
-    if (Color == BLACK) {
-        Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8)); // clear bit
-    } else {
-        Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));  // set bit
+    mask = 0x80 >> (X % 8);
+    if (Paint.PlaneCount <= 1) {
+        Rdata = Paint.Image[Addr];
+        if (Color == BLACK) {
+            Paint.Image[Addr] = Rdata & ~mask; // clear bit
+        } else {
+            Paint.Image[Addr] = Rdata | mask;  // set bit
+        }
+        return;
     }
+
+    // Both planes (EPD_MAX_PLANES) with the same address and mask, see Paint_PlaneBits
+    uint8_t *bw = &Paint.Planes[0][Addr];
+    uint8_t *color = &Paint.Planes[1][Addr];
+    *bw = (Color == BLACK) ? (*bw & ~mask) : (*bw | mask);
+    *color = (Color == RED) ? (*color | mask) : (*color & ~mask);
+}
+
+void EPD_FillSpan(int32_t x0, int32_t x1, int32_t y, uint16_t Color) {
+    if (y < 0 || y >= Paint.Height) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= Paint.Width) x1 = Paint.Width - 1;
+    if (x0 > x1) return;
+
+    uint8_t bits = Paint_PlaneBits(Color);
+    int32_t X0, X1, Y;
+    switch (Paint.Rotate) {
+        case ROTATE_0:
+            Y = y;
+            X0 = x0;
+            X1 = x1;
+            break;
+        case ROTATE_180:
+            Y = Paint.HeightMemory - y - 1;
+            X0 = Paint.WidthMemory - x1 - 1;
+            X1 = Paint.WidthMemory - x0 - 1;
+            break;
+        case ROTATE_90:
+        case ROTATE_270: {
+            // Memory column X, rows Y0..Y1
+            int32_t X = (Paint.Rotate == ROTATE_90) ? Paint.WidthMemory - y - 1 : y;
+            int32_t Y0 = (Paint.Rotate == ROTATE_90) ? x0 : Paint.HeightMemory - x1 - 1;
+            int32_t Y1 = (Paint.Rotate == ROTATE_90) ? x1 : Paint.HeightMemory - x0 - 1;
+            if (Y0 < s_band.y0) Y0 = s_band.y0;
+            if (Y1 > (int32_t)s_band.y1 - 1) Y1 = (int32_t)s_band.y1 - 1;
+            uint8_t mask = 0x80 >> (X % 8);
+            for (uint8_t p = 0; p < Paint.PlaneCount; p++, bits >>= 1) {
+                uint8_t *a = Paint.Planes[p] + X / 8 + (uint32_t)Y0 * Paint.WidthByte;
+                for (int32_t r = Y0; r <= Y1; r++, a += Paint.WidthByte) {
+                    *a = (bits & 0x01) ? (*a | mask) : (*a & ~mask);
+                }
+            }
+            return;
+        }
+        default:
+            return;
+    }
+    if (Y < s_band.y0 || Y >= s_band.y1) return;
+    for (uint8_t p = 0; p < Paint.PlaneCount; p++, bits >>= 1) {
+        EPD_Bits_FillBits(Paint.Planes[p] + (uint32_t)Y * Paint.WidthByte, X0, X1 - X0 + 1,
+                          (bits & 0x01) ? 0xFF : 0x00);
+    }
+}
+
+void EPD_ScrollLeft(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t dx, uint16_t Color) {
+    if (x >= Paint.Width || y >= Paint.Height) return;
+    if (width > Paint.Width - x) width = Paint.Width - x;
+    if (height > Paint.Height - y) height = Paint.Height - y;
+    if (width == 0 || height == 0) return;
+    if (dx > width) dx = width;
+
+    EPD_TRACE_BEGIN(span);
+    uint8_t bits = Paint_PlaneBits(Color);
+    for (uint8_t p = 0; p < Paint.PlaneCount; p++, bits >>= 1) {
+        uint8_t *plane = Paint.Planes[p];
+        uint8_t fill = (bits & 0x01) ? 0xFF : 0x00;
+        switch (Paint.Rotate) {
+            case ROTATE_0:
+            case ROTATE_180: {
+                // Each logical row is a run of one memory row; logical left
+                // is memory right under ROTATE_180
+                bool flip = (Paint.Rotate == ROTATE_180);
+                uint16_t X0 = flip ? Paint.WidthMemory - x - width : x;
+                uint16_t Y0 = flip ? Paint.HeightMemory - y - height : y;
+                uint8_t *row = plane + (uint32_t)Y0 * Paint.WidthByte;
+                for (uint16_t r = 0; r < height; r++, row += Paint.WidthByte) {
+                    if (flip) {
+                        EPD_Bits_ShiftRight(row, X0, width, dx, fill);
+                    } else {
+                        EPD_Bits_ShiftLeft(row, X0, width, dx, fill);
+                    }
+                }
+                break;
+            }
+            case ROTATE_90:
+            case ROTATE_270: {
+                // Logical columns are memory rows: column c takes the run of
+                // column c + dx, in ascending c so sources are read first
+                bool flip = (Paint.Rotate == ROTATE_270);
+                uint16_t X0 = flip ? y : Paint.WidthMemory - y - height;
+                int32_t step = flip ? -(int32_t)Paint.WidthByte : Paint.WidthByte;
+                uint8_t *row = plane + (uint32_t)(flip ? Paint.HeightMemory - x - 1 : x) * Paint.WidthByte;
+                for (uint16_t c = 0; c < width; c++, row += step) {
+                    if (c + dx < width) {
+                        EPD_Bits_CopyBits(row, row + (int32_t)dx * step, X0, height);
+                    } else {
+                        EPD_Bits_FillBits(row, X0, height, fill);
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
 }
 
 void EPD_Full(uint8_t Color) {
-    uint16_t X, Y;
-    uint32_t Addr;
-    for (Y = 0; Y < Paint.HeightByte; Y++) {
-        for (X = 0; X < Paint.WidthByte; X++) {
-            Addr = X + Y * Paint.WidthByte;
-            Paint.Image[Addr] = Color;
+    EPD_TRACE_BEGIN(span);
+    uint8_t bits = Paint_PlaneBits(Color);
+    uint16_t y1 = (s_band.y1 < Paint.HeightByte) ? s_band.y1 : Paint.HeightByte;
+    for (uint8_t p = 0; p < Paint.PlaneCount; p++, bits >>= 1) {
+        // Plane 0 takes Color as a byte pattern unless it is RED, which is
+        // white there as for Paint_SetPixel
+        uint8_t fill = Color;
+        if (p > 0 || Color == RED) {
+            fill = (bits & 0x01) ? 0xFF : 0x00;
+        }
+        // The band's rows are one run of bytes
+        if (y1 > s_band.y0) {
+            EPD_Bits_Fill(Paint.Planes[p] + (uint32_t)s_band.y0 * Paint.WidthByte, fill,
+                          (uint32_t)(y1 - s_band.y0) * Paint.WidthByte);
+        }
+    }
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
+
+// Blitter
+//
+// Bitmaps are combined with the canvas a byte at a time where the rotation
+// allows it: under ROTATE_0 and ROTATE_180 every bitmap row lands on one
+// memory row, so each destination byte takes eight source bits gathered with
+// one shift (from a bit-reversed copy of the row for 180). ROTATE_90/270 turn
+// bitmap rows into memory columns; those take one bit per pixel, stepping the
+// address a memory row at a time.
+
+// Longest bitmap row (clipped to the canvas) the 180 degree path reverses
+#define EPD_BLIT_ROW_MAX    (((EPD_W > EPD_H) ? EPD_W : EPD_H) / 8 + 1)
+
+static inline uint8_t EPD_Rop(uint8_t d, uint8_t s, EPD_Rop_t rop) {
+    switch (rop) {
+        case EPD_ROP_OR:    return d | s;
+        case EPD_ROP_AND:   return d & s;
+        case EPD_ROP_XOR:   return d ^ s;
+        case EPD_ROP_NOT:   return ~s;
+        case EPD_ROP_SET:   return 0xFF;
+        case EPD_ROP_CLEAR: return 0x00;
+        case EPD_ROP_COPY:
+        default:            return s;
+    }
+}
+
+static inline uint8_t EPD_Rev8(uint8_t b) {
+    b = (b >> 4) | (b << 4);
+    b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+    return ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+}
+
+// Eight bits of row starting at `bit`; bits before the row (bit >= -7) or
+// past its `nbytes` bytes read as 0
+static inline uint8_t EPD_Bits8(const uint8_t *row, int32_t bit, int32_t nbytes) {
+    int32_t b = (bit + 8) / 8 - 1;  // floor(bit / 8)
+    uint8_t r = bit & 7;
+    uint8_t hi = (b >= 0 && b < nbytes) ? row[b] : 0;
+    if (r == 0) return hi;
+    uint8_t lo = (b + 1 >= 0 && b + 1 < nbytes) ? row[b + 1] : 0;
+    return (uint8_t)((hi << r) | (lo >> (8 - r)));
+}
+
+// count bytes of sv through the write masks mv
+static void EPD_Blit_Masked(uint8_t *dst, const uint8_t *sv, const uint8_t *mv, uint16_t count, EPD_Rop_t rop) {
+    switch (rop) {
+        case EPD_ROP_OR:
+            for (uint16_t j = 0; j < count; j++) dst[j] |= sv[j] & mv[j];
+            break;
+        case EPD_ROP_AND:
+            for (uint16_t j = 0; j < count; j++) dst[j] &= sv[j] | ~mv[j];
+            break;
+        case EPD_ROP_XOR:
+            for (uint16_t j = 0; j < count; j++) dst[j] ^= sv[j] & mv[j];
+            break;
+        default:
+            for (uint16_t j = 0; j < count; j++) {
+                dst[j] = (dst[j] & ~mv[j]) | (EPD_Rop(dst[j], sv[j], rop) & mv[j]);
+            }
+            break;
+    }
+}
+
+// count whole bytes of sv
+static void EPD_Blit_Whole(uint8_t *dst, const uint8_t *sv, uint16_t count, EPD_Rop_t rop) {
+    switch (rop) {
+        case EPD_ROP_OR:    EPD_Bits_Or(dst, sv, count); break;
+        case EPD_ROP_AND:   EPD_Bits_And(dst, sv, count); break;
+        case EPD_ROP_XOR:   EPD_Bits_Xor(dst, dst, sv, count); break;
+        case EPD_ROP_NOT:   EPD_Bits_Invert(dst, sv, count); break;
+        case EPD_ROP_SET:   EPD_Bits_Fill(dst, 0xFF, count); break;
+        case EPD_ROP_CLEAR: EPD_Bits_Fill(dst, 0x00, count); break;
+        case EPD_ROP_COPY:
+        default:            memcpy(dst, sv, count); break;
+    }
+}
+
+// n bits of the src/mask rows from bit sbit on, onto memory row dst from bit
+// dbit: the source bits are first shifted into destination alignment, with
+// the edge and mask bits folded into one write mask per byte, then the
+// raster op runs as a plain byte loop
+static void EPD_Blit_Span(uint8_t *dst, uint16_t dbit, const uint8_t *src, const uint8_t *mask,
+                          int32_t sbit, int32_t nbytes, uint16_t n, EPD_Rop_t rop) {
+    uint8_t sv[EPD_BLIT_ROW_MAX + 1], mv[EPD_BLIT_ROW_MAX + 1];
+    uint16_t first = dbit / 8, count = (dbit + n - 1) / 8 - first + 1;
+    int32_t s = (int32_t)first * 8 + (sbit - dbit);    // source bit under the first byte
+
+    if (count > sizeof(sv)) {
+        count = sizeof(sv);
+    }
+    for (uint16_t j = 0; j < count; j++, s += 8) {
+        sv[j] = src ? EPD_Bits8(src, s, nbytes) : 0x00;
+        mv[j] = mask ? EPD_Bits8(mask, s, nbytes) : 0xFF;
+    }
+    mv[0] &= 0xFF >> (dbit & 7);
+    mv[count - 1] &= 0xFF << (7 - ((dbit + n - 1) & 7));
+
+    dst += first;
+    if (mask == NULL && count > 2) {
+        // Only the edge bytes are partly written
+        EPD_Blit_Masked(dst, sv, mv, 1, rop);
+        EPD_Blit_Masked(dst + count - 1, sv + count - 1, mv + count - 1, 1, rop);
+        EPD_Blit_Whole(dst + 1, sv + 1, count - 2, rop);
+    } else {
+        EPD_Blit_Masked(dst, sv, mv, count, rop);
+    }
+}
+
+// Bits i0..n-1 of the src/mask rows onto one memory column: bit `bit` of
+// *dst for bit 0, then of each byte `step` further
+static void EPD_Blit_Column(uint8_t *dst, int32_t step, uint8_t bit, const uint8_t *src, const uint8_t *mask,
+                            uint16_t i0, uint16_t n, EPD_Rop_t rop) {
+    dst += (int32_t)i0 * step;
+    for (uint16_t i = i0; i < n; i++, dst += step) {
+        uint8_t sel = 0x80 >> (i & 7);
+        if (mask && !(mask[i >> 3] & sel)) continue;
+        uint8_t s = (src && (src[i >> 3] & sel)) ? 0xFF : 0x00;
+        *dst = (*dst & ~bit) | (EPD_Rop(*dst, s, rop) & bit);
+    }
+}
+
+// (x, y) and the size are in the coordinates of `rotate`, Paint.Rotate for
+// everything drawn on the canvas, ROTATE_0 for memory coordinates
+static void EPD_Blit_Plane(uint8_t *plane, uint16_t rotate, uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+                           const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop) {
+    bool swap = (rotate == ROTATE_90 || rotate == ROTATE_270);
+    uint16_t pw = swap ? Paint.HeightMemory : Paint.WidthMemory;
+    uint16_t ph = swap ? Paint.WidthMemory : Paint.HeightMemory;
+
+    if (x >= pw || y >= ph || sizex == 0 || sizey == 0) {
+        return;
+    }
+    uint16_t cw = (sizex < pw - x) ? sizex : pw - x;
+    uint16_t ch = (sizey < ph - y) ? sizey : ph - y;
+    uint32_t stride = (sizex + 7) / 8;
+    uint16_t nbc = (cw + 7) / 8;    // Source bytes holding the clipped row
+    uint8_t rsrc[EPD_BLIT_ROW_MAX], rmask[EPD_BLIT_ROW_MAX];
+
+    if (rotate == ROTATE_180 && nbc > EPD_BLIT_ROW_MAX) {
+        nbc = EPD_BLIT_ROW_MAX;     // Canvas wider than the panel
+        cw = nbc * 8;
+    }
+
+    // Bitmap columns inside the band for the column-wise rotations
+    int32_t i0 = 0, i1 = cw;
+    if (rotate == ROTATE_90) {
+        i0 = (int32_t)s_band.y0 - x;
+        i1 = (int32_t)s_band.y1 - x;
+    } else if (rotate == ROTATE_270) {
+        i0 = (int32_t)Paint.HeightMemory - x - s_band.y1;
+        i1 = (int32_t)Paint.HeightMemory - x - s_band.y0;
+    }
+    if (i0 < 0) i0 = 0;
+    if (i1 > cw) i1 = cw;
+    if (swap && i0 >= i1) {
+        return;
+    }
+
+    for (uint16_t r = 0; r < ch; r++) {
+        const uint8_t *s = Src ? Src + r * stride : NULL;
+        const uint8_t *m = Mask ? Mask + r * stride : NULL;
+        uint16_t ly = y + r;
+        uint16_t my = (rotate == ROTATE_180) ? Paint.HeightMemory - 1 - ly : ly;
+
+        if (!swap && (my < s_band.y0 || my >= s_band.y1)) {
+            continue;
+        }
+        switch (rotate) {
+            case ROTATE_0:
+                EPD_Blit_Span(plane + (uint32_t)ly * Paint.WidthByte, x, s, m, 0, nbc, cw, rop);
+                break;
+            case ROTATE_180:
+                // Memory X runs backwards: reverse the clipped row, its first
+                // nbc * 8 - cw bits are padding
+                for (uint16_t t = 0; t < nbc; t++) {
+                    if (s) rsrc[t] = EPD_Rev8(s[nbc - 1 - t]);
+                    if (m) rmask[t] = EPD_Rev8(m[nbc - 1 - t]);
+                }
+                EPD_Blit_Span(plane + (uint32_t)(Paint.HeightMemory - 1 - ly) * Paint.WidthByte,
+                              Paint.WidthMemory - x - cw, s ? rsrc : NULL, m ? rmask : NULL,
+                              nbc * 8 - cw, nbc, cw, rop);
+                break;
+            case ROTATE_90: {
+                uint16_t X = Paint.WidthMemory - ly - 1;
+                EPD_Blit_Column(plane + X / 8 + (uint32_t)x * Paint.WidthByte, Paint.WidthByte,
+                                0x80 >> (X % 8), s, m, i0, i1, rop);
+                break;
+            }
+            case ROTATE_270:
+                EPD_Blit_Column(plane + ly / 8 + (uint32_t)(Paint.HeightMemory - x - 1) * Paint.WidthByte,
+                                -(int32_t)Paint.WidthByte, 0x80 >> (ly % 8), s, m, i0, i1, rop);
+                break;
+            default:
+                return;
         }
     }
 }
 
+void EPD_Blit(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+              const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop) {
+    if (Src == NULL && rop != EPD_ROP_SET && rop != EPD_ROP_CLEAR) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_Blit_Plane(Paint.Image, Paint.Rotate, x, y, sizex, sizey, Src, Mask, rop);
+    EPD_TRACE_END(span, EPD_PHASE_PICTURE);
+}
+
+void EPD_Blit_Memory(uint16_t X, uint16_t Y, uint16_t sizex, uint16_t sizey,
+                     const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop) {
+    if (Src == NULL && rop != EPD_ROP_SET && rop != EPD_ROP_CLEAR) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_Blit_Plane(Paint.Image, ROTATE_0, X, Y, sizex, sizey, Src, Mask, rop);
+    EPD_TRACE_END(span, EPD_PHASE_PICTURE);
+}
+
 void EPD_ShowPicture(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *BMP, uint16_t Color) {
+    EPD_TRACE_BEGIN(span);
+    if (sizex % 8 == 0) {
+        // Set bits take the opposite of Color (black for WHITE, else white),
+        // clear bits take Color; on a color canvas only those are red
+        EPD_Rop_t bw = (Color == BLACK) ? EPD_ROP_COPY : (Color == WHITE) ? EPD_ROP_NOT : EPD_ROP_SET;
+        EPD_Blit_Plane(Paint.Image, Paint.Rotate, x, y, sizex, sizey, BMP, NULL, bw);
+        if (Paint.PlaneCount > 1) {
+            EPD_Blit_Plane(Paint.Planes[1], Paint.Rotate, x, y, sizex, sizey, BMP, NULL,
+                           (Color == RED) ? EPD_ROP_NOT : EPD_ROP_CLEAR);
+        }
+        EPD_TRACE_END(span, EPD_PHASE_PICTURE);
+        return;
+    }
+
+    // Widths that are not whole bytes keep the original walk: it only moves
+    // to the next row when a byte ends exactly on the width
     uint16_t j = 0, t;
     uint16_t i, n, temp;
     uint16_t x0, width = 0;
@@ -694,13 +1942,10 @@ void EPD_ShowPicture(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, con
             j++;
         }
     }
+    EPD_TRACE_END(span, EPD_PHASE_PICTURE);
 }
 
 void clear_all(void) {
-    uint16_t Width, Height;
-    Width = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
-    Height = EPD_H;
-    
     // Standard clear sequence
     EPD_Clear();
     
@@ -714,16 +1959,93 @@ void clear_all(void) {
 
 // Clear a rectangular window
 void EPD_ClearWindows(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color) {
+    EPD_TRACE_BEGIN(span);
     uint16_t i, j;
     for (i = ys; i < ye; i++) {
         for (j = xs; j < xe; j++) {
             Paint_SetPixel(j, i, color);
         }
     }
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
+
+static int64_t EPD_DivFloor(int64_t a, int64_t b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+static int64_t EPD_DivCeil(int64_t a, int64_t b) {
+    return -EPD_DivFloor(-a, b);
+}
+
+// State of EPD_DrawLine at its first point whose coordinate on the band axis
+// lies in [lo, hi), and the end moved to the last band step so the loop
+// breaks when it steps past the band; false when it draws none. With W = dx
+// and H = -dy, the
+// loop takes one step on the major axis per point, and after i steps in X and
+// j in Y it holds Esp = W * (j + 1) - H * (i + 1). The minor coordinate of a
+// point follows from the major one:
+//   W >= H: j(i) = min(i, floor((2H(i + 1) - W) / 2W) + 1)
+//   W <  H: i(j) = min(j, floor((2Wj - H) / 2H) + 1)
+// When j(W - 1) is already H and W <= 2H, the loop ends one column short.
+static bool EPD_Line_Seek(uint16_t Xstart, uint16_t Ystart, int dx, int dy, int XAddway, int YAddway,
+                          int32_t lo, int32_t hi, bool axis_x, uint16_t *Xpoint, uint16_t *Ypoint,
+                          uint16_t *Xend, uint16_t *Yend, int *Esp) {
+    int64_t W = dx, H = -dy;
+    int32_t start = axis_x ? Xstart : Ystart, dir = axis_x ? XAddway : YAddway;
+    int64_t n = axis_x ? W : H;
+    int64_t k = (dir > 0) ? lo - start : start - (hi - 1);     // Band axis steps to the band
+    int64_t k_end = (dir > 0) ? hi - 1 - start : start - lo;
+    int64_t i, j;
+
+    if (k < 0) k = 0;
+    if (k > k_end || k > n) {
+        return false;
+    }
+    if (k_end < n) {
+        if (axis_x) {
+            *Xend = Xstart + XAddway * k_end;
+        } else {
+            *Yend = Ystart + YAddway * k_end;
+        }
+    }
+    if (k == 0) {
+        return true;                // Starts inside: nothing to skip
+    }
+    if (W >= H) {
+        if (axis_x) {
+            i = k;
+        } else {
+            i = EPD_DivCeil(W * (2 * k - 1), 2 * H) - 1;
+            if (i < k) i = k;
+        }
+        j = EPD_DivFloor(2 * H * (i + 1) - W, 2 * W) + 1;
+        if (j > i) j = i;
+        if (i == W) {
+            int64_t last = EPD_DivFloor(2 * H * W - W, 2 * W) + 1;     // j(W - 1)
+            if (last > W - 1) last = W - 1;
+            if (last == H && W <= 2 * H) {
+                return false;
+            }
+        }
+    } else {
+        if (axis_x) {
+            j = EPD_DivCeil(H * (2 * k - 1), 2 * W);
+            if (j < k) j = k;
+        } else {
+            j = k;
+        }
+        i = EPD_DivFloor(2 * W * j - H, 2 * H) + 1;
+        if (i > j) i = j;
+    }
+    *Xpoint = Xstart + XAddway * i;
+    *Ypoint = Ystart + YAddway * j;
+    *Esp = (int)(W * (j + 1) - H * (i + 1));
+    return true;
 }
 
 // Draw a line using Bresenham algorithm
 void EPD_DrawLine(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend, uint16_t Color) {
+    EPD_TRACE_BEGIN(span);
     uint16_t Xpoint, Ypoint;
     int dx, dy;
     int XAddway, YAddway;
@@ -735,7 +2057,17 @@ void EPD_DrawLine(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend
     XAddway = Xstart < Xend ? 1 : -1;
     YAddway = Ystart < Yend ? 1 : -1;
     Esp = dx + dy;
-    
+
+    // Band worker: only the points inside the band
+    int32_t lo, hi;
+    bool axis_x;
+    if (Paint_BandAxis(&lo, &hi, &axis_x) &&
+        !EPD_Line_Seek(Xstart, Ystart, dx, dy, XAddway, YAddway, lo, hi, axis_x,
+                       &Xpoint, &Ypoint, &Xend, &Yend, &Esp)) {
+        EPD_TRACE_END(span, EPD_PHASE_DRAW);
+        return;
+    }
+
     for (;;) {
         Paint_SetPixel(Xpoint, Ypoint, Color);
         if (2 * Esp >= dy) {
@@ -751,6 +2083,7 @@ void EPD_DrawLine(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend
             Ypoint += YAddway;
         }
     }
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
 }
 
 // Draw a rectangle
@@ -770,14 +2103,77 @@ void EPD_DrawRectangle(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t
     }
 }
 
+// True when a band is set and the w x h box at (x, y) lies outside it. A box
+// that wraps around 16 bits is never skipped.
+static bool Paint_BandMisses(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    int32_t lo, hi;
+    bool axis_x;
+    if (x + w > 0xFFFF || y + h > 0xFFFF || !Paint_BandAxis(&lo, &hi, &axis_x)) {
+        return false;
+    }
+    int32_t a0 = axis_x ? x : y, a1 = a0 + (axis_x ? w : h);
+    return a1 <= lo || a0 >= hi;
+}
+
+// Pixels a0..a1 of column c (vertical) or row c, only those in the band
+static void Paint_BandRun(int32_t c, int32_t a0, int32_t a1, bool vertical, uint16_t Color,
+                          int32_t lo, int32_t hi, bool axis_x) {
+    if (vertical != axis_x) {
+        // The run crosses the band
+        if (a0 < lo) a0 = lo;
+        if (a1 > hi - 1) a1 = hi - 1;
+    } else if (c < lo || c >= hi) {
+        return;
+    }
+    if (a0 < 0) a0 = 0;
+    for (int32_t a = a0; a <= a1; a++) {
+        if (vertical) {
+            Paint_SetPixel(c, a, Color);
+        } else {
+            Paint_SetPixel(a, c, Color);
+        }
+    }
+}
+
 // Draw a circle using Bresenham algorithm
 void EPD_DrawCircle(uint16_t X_Center, uint16_t Y_Center, uint16_t Radius, uint16_t Color, uint8_t mode) {
+    EPD_TRACE_BEGIN(span);
     int Esp, sCountY;
     uint16_t XCurrent, YCurrent;
     XCurrent = 0;
     YCurrent = Radius;
     Esp = 3 - (Radius << 1);
-    
+
+    // Band worker: the same steps, with each octant run cut to the band.
+    // Only when no coordinate wraps around 16 bits back onto the canvas
+    // (radius 0 does: YCurrent steps below 0).
+    int32_t lo, hi;
+    bool axis_x;
+    if (Radius > 0 && Radius < 0x8000 && X_Center + Radius <= 0xFFFF && Y_Center + Radius <= 0xFFFF &&
+        Paint_BandAxis(&lo, &hi, &axis_x)) {
+        int32_t xc = X_Center, yc = Y_Center;
+        while (XCurrent <= YCurrent) {
+            int32_t a = XCurrent, b = mode ? XCurrent : YCurrent, e = YCurrent;
+            Paint_BandRun(xc + a, yc + b, yc + e, true, Color, lo, hi, axis_x);
+            Paint_BandRun(xc - a, yc + b, yc + e, true, Color, lo, hi, axis_x);
+            Paint_BandRun(xc - a, yc - e, yc - b, true, Color, lo, hi, axis_x);
+            Paint_BandRun(xc + a, yc - e, yc - b, true, Color, lo, hi, axis_x);
+            Paint_BandRun(yc + a, xc - e, xc - b, false, Color, lo, hi, axis_x);
+            Paint_BandRun(yc - a, xc - e, xc - b, false, Color, lo, hi, axis_x);
+            Paint_BandRun(yc - a, xc + b, xc + e, false, Color, lo, hi, axis_x);
+            Paint_BandRun(yc + a, xc + b, xc + e, false, Color, lo, hi, axis_x);
+            if ((int)Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+        EPD_TRACE_END(span, EPD_PHASE_DRAW);
+        return;
+    }
+
     if (mode) {
         // Filled circle
         while (XCurrent <= YCurrent) {
@@ -820,21 +2216,19 @@ void EPD_DrawCircle(uint16_t X_Center, uint16_t Y_Center, uint16_t Radius, uint1
             XCurrent++;
         }
     }
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
 }
 
 // Text Rendering Functions
 
-// Helper function for exponentiation
-static uint32_t EPD_Pow(uint16_t m, uint16_t n) {
-    uint32_t result = 1;
-    while (n--) {
-        result *= m;
-    }
-    return result;
-}
+// Powers of ten that fit a uint32_t
+static const uint32_t s_pow10[10] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
 
 // Display a single character
 void EPD_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t color) {
+    EPD_TRACE_BEGIN(span);
     uint16_t i, m, temp, size2, chr1;
     uint16_t x0, y0;
     x += 1; y += 1; x0 = x; y0 = y;
@@ -843,6 +2237,13 @@ void EPD_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t
     else size2 = (size1 / 8 + ((size1 % 8) ? 1 : 0)) * (size1 / 2);
     
     chr1 = chr - ' '; // Calculate offset from space character
+
+    // Band worker: skip glyphs that miss the band (a string crosses every band
+    // under ROTATE_90/270)
+    if (Paint_BandMisses(x, y, (size1 == 8) ? 6 : size1 / 2, (size1 == 8) ? 8 : (size1 + 7) / 8 * 8)) {
+        EPD_TRACE_END(span, EPD_PHASE_TEXT);
+        return;
+    }
     
     for (i = 0; i < size2; i++) {
         if (size1 == 8) {
@@ -854,6 +2255,7 @@ void EPD_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t
         } else if (size1 == 24) {
             temp = ascii_2412[chr1][i];
         } else {
+            EPD_TRACE_END(span, EPD_PHASE_TEXT);
             return; // Unsupported size
         }
         
@@ -861,7 +2263,7 @@ void EPD_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t
             if (temp & 0x01) {
                 Paint_SetPixel(x, y, color);
             } else {
-                Paint_SetPixel(x, y, !color);
+                Paint_SetPixel(x, y, (color == RED) ? WHITE : !color);
             }
             temp >>= 1;
             y++;
@@ -873,6 +2275,7 @@ void EPD_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t
         }
         y = y0;
     }
+    EPD_TRACE_END(span, EPD_PHASE_TEXT);
 }
 
 // Display a string
@@ -886,33 +2289,53 @@ void EPD_ShowString(uint16_t x, uint16_t y, const char *chr, uint16_t size1, uin
 
 // Display an integer number
 void EPD_ShowNum(uint16_t x, uint16_t y, uint32_t num, uint16_t len, uint16_t size1, uint16_t color) {
-    uint8_t t, temp, m = 0;
-    if (size1 == 8) m = 2;
-    
-    for (t = 0; t < len; t++) {
-        temp = (num / EPD_Pow(10, len - t - 1)) % 10;
-        if (temp == 0) {
-            EPD_ShowChar(x + (size1 / 2 + m) * t, y, '0', size1, color);
-        } else {
-            EPD_ShowChar(x + (size1 / 2 + m) * t, y, temp + '0', size1, color);
-        }
+    uint16_t pitch = size1 / 2 + ((size1 == 8) ? 2 : 0);
+    char digits[10];
+    uint16_t n = (len < sizeof(digits)) ? len : sizeof(digits);
+
+    // Lowest digit first: one divide by a constant per digit; cells beyond
+    // the ten a uint32_t can fill are leading zeros
+    for (uint16_t t = n; t-- > 0; ) {
+        digits[t] = '0' + num % 10;
+        num /= 10;
+    }
+    for (uint16_t t = 0; t < len; t++) {
+        EPD_ShowChar(x + pitch * t, y, (t < len - n) ? '0' : digits[t - (len - n)], size1, color);
     }
 }
 
 // Display a floating point number
 void EPD_ShowFloatNum1(uint16_t x, uint16_t y, float num, uint8_t len, uint8_t pre, uint8_t sizey, uint8_t color) {
-    uint8_t t, temp, sizex;
-    uint16_t num1;
-    sizex = sizey / 2;
-    num1 = num * EPD_Pow(10, pre);
-    
-    for (t = 0; t < len; t++) {
-        temp = (num1 / EPD_Pow(10, len - t - 1)) % 10;
-        if (t == (len - pre)) {
-            EPD_ShowChar(x + (len - pre) * sizex, y, '.', sizey, color);
-            t++;
-            len += 1;
-        }
-        EPD_ShowChar(x + t * sizex, y, temp + 48, sizey, color);
+    uint8_t sizex = sizey / 2;
+    uint8_t point = len - pre;          // Digits before the point
+    char digits[10];
+    uint8_t n = (len < sizeof(digits)) ? len : sizeof(digits);
+    float scaled = num;
+    uint32_t num1;
+
+    // Scaled as a float like before, then clamped to a uint32_t: negative
+    // values (and NaN) show as 0, values from 2^32 up as 4294967295
+    uint8_t p = pre;
+    for (; p > 9; p -= 9) {
+        scaled *= s_pow10[9];
+    }
+    scaled *= s_pow10[p];
+    num1 = !(scaled > 0) ? 0 : (scaled < 4294967296.0f) ? (uint32_t)scaled : UINT32_MAX;
+
+    // Lowest digit first; cells beyond the ten a uint32_t can fill are
+    // leading zeros, as for EPD_ShowNum
+    for (uint8_t t = n; t-- > 0; ) {
+        digits[t] = '0' + num1 % 10;
+        num1 /= 10;
+    }
+
+    // Digits after the point move one cell right; the point itself is drawn
+    // between them, in the same order as before so overlapping cells match
+    for (uint8_t t = 0; t < len; t++) {
+        if (pre > 0 && pre <= len && t == point) {
+            EPD_ShowChar(x + point * sizex, y, '.', sizey, color);
+        }
+        uint8_t cell = (pre > 0 && pre <= len && t >= point) ? t + 1 : t;
+        EPD_ShowChar(x + cell * sizex, y, (t < len - n) ? '0' : digits[t - (len - n)], sizey, color);
     }
 }
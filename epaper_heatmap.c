@@ -0,0 +1,150 @@
+#include "epaper_heatmap.h"
+#include <string.h>
+
+static struct {
+    EPD_HeatConfig_t cfg;
+    EPD_HeatTile_t tiles[EPD_TILE_COUNT];
+    uint8_t touched[(EPD_TILE_COUNT + 7) / 8];  // Tiles written since the last partial update
+} s_heat = {
+    .cfg = EPD_HEAT_CONFIG_DEFAULT(),
+};
+
+esp_err_t EPD_Heat_SetConfig(const EPD_HeatConfig_t *config) {
+    if (config == NULL || config->max_partials == 0 || config->max_partials > UINT8_MAX ||
+        config->full_permille > 1000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_heat.cfg = *config;
+    return ESP_OK;
+}
+
+void EPD_Heat_GetConfig(EPD_HeatConfig_t *config) {
+    *config = s_heat.cfg;
+}
+
+void EPD_Heat_Touch(uint16_t x, uint16_t y, uint16_t width, uint16_t height) {
+    if (x >= EPD_W || y >= EPD_H || width == 0 || height == 0) {
+        return;
+    }
+    uint16_t x1 = (x + width > EPD_W) ? EPD_W - 1 : x + width - 1;
+    uint16_t y1 = (y + height > EPD_H) ? EPD_H - 1 : y + height - 1;
+
+    for (uint16_t ty = y / EPD_TILE_H; ty <= y1 / EPD_TILE_H; ty++) {
+        for (uint16_t tx = x / EPD_TILE_W; tx <= x1 / EPD_TILE_W; tx++) {
+            uint16_t t = ty * EPD_TILES_X + tx;
+            s_heat.touched[t / 8] |= 0x80 >> (t % 8);
+        }
+    }
+}
+
+void EPD_Heat_Commit(void) {
+    for (uint16_t i = 0; i < sizeof(s_heat.touched); i++) {
+        uint8_t bits = s_heat.touched[i];
+        if (bits == 0) continue;
+        s_heat.touched[i] = 0;
+        for (uint16_t t = i * 8; bits != 0; t++, bits <<= 1) {
+            if ((bits & 0x80) && s_heat.tiles[t].partials < UINT8_MAX) {
+                s_heat.tiles[t].partials++;
+            }
+        }
+    }
+}
+
+void EPD_Heat_Clean(const EPD_Rect_t *area) {
+    if (area == NULL) {
+        memset(s_heat.tiles, 0, sizeof(s_heat.tiles));
+        memset(s_heat.touched, 0, sizeof(s_heat.touched));
+        return;
+    }
+    if (area->x >= EPD_W || area->y >= EPD_H || area->width == 0 || area->height == 0) {
+        return;
+    }
+    // Only tiles the area covers completely were driven through both colors
+    uint16_t x1 = (area->x + area->width > EPD_W) ? EPD_W : area->x + area->width;
+    uint16_t y1 = (area->y + area->height > EPD_H) ? EPD_H : area->y + area->height;
+    for (uint16_t ty = area->y / EPD_TILE_H; ty <= (y1 - 1) / EPD_TILE_H; ty++) {
+        for (uint16_t tx = area->x / EPD_TILE_W; tx <= (x1 - 1) / EPD_TILE_W; tx++) {
+            uint16_t tx0 = tx * EPD_TILE_W, ty0 = ty * EPD_TILE_H;
+            uint16_t tx1 = (tx0 + EPD_TILE_W > EPD_W) ? EPD_W : tx0 + EPD_TILE_W;
+            uint16_t ty1 = (ty0 + EPD_TILE_H > EPD_H) ? EPD_H : ty0 + EPD_TILE_H;
+            if (tx0 >= area->x && ty0 >= area->y && tx1 <= x1 && ty1 <= y1) {
+                memset(&s_heat.tiles[ty * EPD_TILES_X + tx], 0, sizeof(EPD_HeatTile_t));
+            }
+        }
+    }
+}
+
+void EPD_Heat_AddChanged(uint16_t t, uint32_t pixels) {
+    if (t >= EPD_TILE_COUNT) {
+        return;
+    }
+    // Compared against the room left, a count near UINT32_MAX cannot wrap
+    uint16_t room = UINT16_MAX - s_heat.tiles[t].changed;
+    s_heat.tiles[t].changed = (pixels > room) ? UINT16_MAX : s_heat.tiles[t].changed + (uint16_t)pixels;
+}
+
+void EPD_Heat_GetTile(uint16_t t, EPD_HeatTile_t *tile) {
+    if (t >= EPD_TILE_COUNT) {
+        memset(tile, 0, sizeof(*tile));
+        return;
+    }
+    *tile = s_heat.tiles[t];
+}
+
+bool EPD_Heat_IsHot(uint16_t t) {
+    if (t >= EPD_TILE_COUNT) {
+        return false;
+    }
+    const EPD_HeatTile_t *tile = &s_heat.tiles[t];
+    return tile->partials >= s_heat.cfg.max_partials ||
+           (s_heat.cfg.max_changed != 0 && tile->changed >= s_heat.cfg.max_changed);
+}
+
+EPD_Cleanup_t EPD_Heat_Plan(EPD_Rect_t *area) {
+    uint16_t tx0 = EPD_TILES_X, tx1 = 0, ty0 = EPD_TILES_Y, ty1 = 0;
+
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        if (!EPD_Heat_IsHot(t)) continue;
+        uint16_t tx = t % EPD_TILES_X, ty = t / EPD_TILES_X;
+        if (tx < tx0) tx0 = tx;
+        if (tx > tx1) tx1 = tx;
+        if (ty < ty0) ty0 = ty;
+        ty1 = ty;
+    }
+    if (tx0 > tx1) {
+        return EPD_CLEANUP_NONE;
+    }
+
+    // Tile width is a multiple of 8, so the box is byte aligned
+    EPD_Rect_t box = {
+        .x = tx0 * EPD_TILE_W,
+        .y = ty0 * EPD_TILE_H,
+    };
+    box.width = ((tx1 + 1) * EPD_TILE_W > EPD_W ? EPD_W : (tx1 + 1) * EPD_TILE_W) - box.x;
+    box.height = ((ty1 + 1) * EPD_TILE_H > EPD_H ? EPD_H : (ty1 + 1) * EPD_TILE_H) - box.y;
+    if (area) {
+        *area = box;
+    }
+    if ((uint32_t)box.width * box.height * 1000 > (uint32_t)s_heat.cfg.full_permille * EPD_W * EPD_H) {
+        return EPD_CLEANUP_FULL;
+    }
+    return EPD_CLEANUP_AREA;
+}
+
+EPD_Cleanup_t EPD_Heat_Cleanup(const uint8_t *Image) {
+    EPD_Rect_t area;
+    EPD_Cleanup_t plan = EPD_Heat_Plan(&area);
+
+    switch (plan) {
+        case EPD_CLEANUP_NONE:
+            break;
+        case EPD_CLEANUP_AREA:
+            EPD_Display_Part_Clean(area.x, area.y, area.width, area.height, Image);
+            break;
+        case EPD_CLEANUP_FULL:
+            EPD_Init();
+            EPD_Display(Image);
+            break;
+    }
+    return plan;
+}
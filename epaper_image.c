@@ -0,0 +1,443 @@
+#include "epaper_image.h"
+#include <string.h>
+
+// Longest run of image pixels that can land on one memory row or column
+#define EPD_IMAGE_MAX_RUN   ((EPD_W > EPD_H) ? EPD_W : EPD_H)
+
+typedef struct {
+    FILE *f;
+    size_t pos;
+    size_t len;
+    uint8_t buf[EPD_IMAGE_CHUNK];
+} EPD_ImageReader_t;
+
+typedef struct {
+    EPD_ImageInfo_t info;
+    bool plain;             // P1/P2: decimal raster
+    bool bottom_up;         // BMP stored last row first
+    uint16_t maxval;        // Netpbm sample maximum (1 for PBM)
+    uint8_t threshold;      // 16-bit PGM samples are compared directly
+    bool invert;
+    uint32_t row_bytes;     // Binary rows, padding included
+    uint8_t white[32];      // Sample or palette index -> white, MSB first
+} EPD_ImageFormat_t;
+
+// Where the decoded pixels go: image rows run along memory rows (rotation
+// 0/180 of image and canvas combined) or along memory columns (90/270)
+typedef struct {
+    bool columns;           // Image rows are memory columns
+    bool reverse;           // Image columns run backwards in memory
+    bool flip;              // Image rows run backwards in memory
+    uint16_t u0, u1;        // Image columns on the canvas
+    uint16_t v0, v1;        // Image rows on the canvas
+    int32_t along;          // Memory coordinate of image column u0 (u1 - 1 when reversed)
+    int32_t across;         // Memory coordinate of image row 0 (height - 1 when flipped)
+    EPD_Rop_t rop;
+} EPD_ImagePlace_t;
+
+static bool EPD_Image_Refill(EPD_ImageReader_t *r) {
+    r->len = fread(r->buf, 1, sizeof(r->buf), r->f);
+    r->pos = 0;
+    return r->len > 0;
+}
+
+static int EPD_Image_Peek(EPD_ImageReader_t *r) {
+    if (r->pos == r->len && !EPD_Image_Refill(r)) return -1;
+    return r->buf[r->pos];
+}
+
+static int EPD_Image_Byte(EPD_ImageReader_t *r) {
+    int c = EPD_Image_Peek(r);
+    if (c >= 0) r->pos++;
+    return c;
+}
+
+static bool EPD_Image_Skip(EPD_ImageReader_t *r, uint32_t n) {
+    while (n > 0) {
+        if (r->pos == r->len && !EPD_Image_Refill(r)) return false;
+        size_t k = r->len - r->pos;
+        if (k > n) k = n;
+        r->pos += k;
+        n -= k;
+    }
+    return true;
+}
+
+// Up to max bytes of the current chunk, consumed; NULL at the end of the file
+static const uint8_t *EPD_Image_Take(EPD_ImageReader_t *r, uint32_t max, size_t *n) {
+    if (r->pos == r->len && !EPD_Image_Refill(r)) return NULL;
+    size_t k = r->len - r->pos;
+    if (k > max) k = max;
+    const uint8_t *p = r->buf + r->pos;
+    r->pos += k;
+    *n = k;
+    return p;
+}
+
+static bool EPD_Image_Read(EPD_ImageReader_t *r, uint8_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        int c = EPD_Image_Byte(r);
+        if (c < 0) return false;
+        out[i] = (uint8_t)c;
+    }
+    return true;
+}
+
+static bool EPD_Image_Space(int c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Next decimal of a Netpbm header or plain raster after whitespace and
+// comments, at most `digits` long (1 for P1 pixels, which need no
+// separator); -1 at the end of the file or on anything else
+static int32_t EPD_Image_Number(EPD_ImageReader_t *r, int digits) {
+    int c;
+    while ((c = EPD_Image_Peek(r)) >= 0) {
+        if (EPD_Image_Space(c)) {
+            r->pos++;
+        } else if (c == '#') {
+            while ((c = EPD_Image_Byte(r)) >= 0 && c != '\n' && c != '\r') {}
+        } else {
+            break;
+        }
+    }
+    int32_t value = -1;
+    for (int n = 0; n < digits && (c = EPD_Image_Peek(r)) >= '0' && c <= '9'; n++) {
+        value = (value < 0 ? 0 : value * 10) + (c - '0');
+        r->pos++;
+    }
+    return value;
+}
+
+static uint32_t EPD_Image_Le(const uint8_t *p, int bytes) {
+    uint32_t v = 0;
+    for (int i = bytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+static void EPD_Image_SetWhite(EPD_ImageFormat_t *fmt, uint16_t index, bool white) {
+    if (white != fmt->invert) {
+        fmt->white[index / 8] |= 0x80 >> (index % 8);
+    }
+}
+
+static inline bool EPD_Image_IsWhite(const EPD_ImageFormat_t *fmt, uint32_t sample) {
+    if (sample > 0xFF) {
+        return ((sample * 255 >= (uint32_t)fmt->threshold * fmt->maxval)) != fmt->invert;
+    }
+    return fmt->white[sample / 8] & (0x80 >> (sample % 8));
+}
+
+static esp_err_t EPD_Image_Netpbm(EPD_ImageReader_t *r, EPD_ImageFormat_t *fmt, int kind) {
+    fmt->plain = (kind == '1' || kind == '2');
+    fmt->info.type = (kind == '1' || kind == '4') ? EPD_IMAGE_PBM : EPD_IMAGE_PGM;
+    int32_t w = EPD_Image_Number(r, 6), h = EPD_Image_Number(r, 6), maxval = 1;
+    if (fmt->info.type == EPD_IMAGE_PGM) {
+        maxval = EPD_Image_Number(r, 6);
+    }
+    // One whitespace byte ends the header (P1/P2 allow more, skipped as separators)
+    if (w <= 0 || w > UINT16_MAX || h <= 0 || h > UINT16_MAX || maxval <= 0 || maxval > UINT16_MAX ||
+        !EPD_Image_Space(EPD_Image_Byte(r))) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    fmt->info.width = w;
+    fmt->info.height = h;
+    fmt->maxval = maxval;
+    fmt->info.bits = (fmt->info.type == EPD_IMAGE_PBM) ? 1 : (maxval > 0xFF) ? 16 : 8;
+    fmt->row_bytes = (fmt->info.bits == 1) ? (uint32_t)(w + 7) / 8 : (uint32_t)w * fmt->info.bits / 8;
+    for (uint16_t i = 0; i < 256; i++) {
+        bool white = (fmt->info.type == EPD_IMAGE_PBM) ? (i == 0)
+                                                       : (uint32_t)i * 255 >= (uint32_t)fmt->threshold * maxval;
+        EPD_Image_SetWhite(fmt, i, white);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t EPD_Image_Bmp(EPD_ImageReader_t *r, EPD_ImageFormat_t *fmt) {
+    // BITMAPFILEHEADER after "BM", then the BITMAPINFOHEADER fields used
+    uint8_t h[52];
+    if (!EPD_Image_Read(r, h, sizeof(h))) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    uint32_t offset = EPD_Image_Le(h + 8, 4), dib = EPD_Image_Le(h + 12, 4);
+    int32_t w = (int32_t)EPD_Image_Le(h + 16, 4), ht = (int32_t)EPD_Image_Le(h + 20, 4);
+    uint16_t bits = EPD_Image_Le(h + 26, 2);
+    uint32_t compression = EPD_Image_Le(h + 28, 4), colors = EPD_Image_Le(h + 44, 4);
+    if (dib < 40) {
+        return ESP_ERR_NOT_SUPPORTED;   // OS/2 core header
+    }
+    if (compression != 0 || (bits != 1 && bits != 4 && bits != 8)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (colors == 0) {
+        colors = 1u << bits;
+    }
+    uint32_t palette = 14 + dib;
+    if (w <= 0 || w > UINT16_MAX || ht == 0 || ht < -UINT16_MAX || ht > UINT16_MAX ||
+        colors > (1u << bits) || offset < palette + colors * 4 || !EPD_Image_Skip(r, dib - 40)) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    fmt->info.type = EPD_IMAGE_BMP;
+    fmt->info.bits = bits;
+    fmt->info.width = w;
+    fmt->info.height = (ht < 0) ? -ht : ht;
+    fmt->bottom_up = (ht > 0);
+    fmt->maxval = 0xFF;
+    fmt->row_bytes = ((uint32_t)w * bits + 31) / 32 * 4;
+    // Indices past the palette stay black (white when inverted)
+    for (uint32_t i = 0; i < (1u << bits); i++) {
+        EPD_Image_SetWhite(fmt, i, false);
+    }
+    for (uint32_t i = 0; i < colors; i++) {
+        uint8_t bgra[4];
+        if (!EPD_Image_Read(r, bgra, sizeof(bgra))) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        uint32_t gray = (29u * bgra[0] + 150u * bgra[1] + 77u * bgra[2]) >> 8;
+        fmt->white[i / 8] &= ~(0x80 >> (i % 8));
+        EPD_Image_SetWhite(fmt, i, gray >= fmt->threshold);
+    }
+    return EPD_Image_Skip(r, offset - palette - colors * 4) ? ESP_OK : ESP_ERR_INVALID_CRC;
+}
+
+static esp_err_t EPD_Image_Header(EPD_ImageReader_t *r, EPD_ImageFormat_t *fmt) {
+    int c0 = EPD_Image_Byte(r), c1 = EPD_Image_Byte(r);
+    if (c0 == 'P' && c1 >= '1' && c1 <= '6') {
+        if (c1 == '3' || c1 == '6') {
+            return ESP_ERR_NOT_SUPPORTED;   // PPM
+        }
+        return EPD_Image_Netpbm(r, fmt, c1);
+    }
+    if (c0 == 'B' && c1 == 'M') {
+        return EPD_Image_Bmp(r, fmt);
+    }
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t EPD_Image_Probe(FILE *f, EPD_ImageInfo_t *info) {
+    if (f == NULL || info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    long start = ftell(f);
+    if (start < 0) {
+        return ESP_ERR_NOT_SUPPORTED;   // Not seekable
+    }
+    EPD_ImageReader_t r = { .f = f };
+    EPD_ImageFormat_t fmt = { .threshold = 128 };
+    esp_err_t err = EPD_Image_Header(&r, &fmt);
+    fseek(f, start, SEEK_SET);
+    if (err == ESP_OK) {
+        *info = fmt.info;
+    }
+    return err;
+}
+
+// Visible image rows and columns, and where they go in canvas memory
+static bool EPD_Image_Place(const EPD_ImageFormat_t *fmt, uint16_t x, uint16_t y, uint16_t rotate,
+                            EPD_ImagePlace_t *pl) {
+    uint16_t w = fmt->info.width, h = fmt->info.height;
+    bool turn = (rotate == ROTATE_90 || rotate == ROTATE_270);
+    int32_t lw = turn ? h : w, lh = turn ? w : h;
+
+    // Memory corner of the logical rectangle, as for EPD_Asset_Draw
+    int32_t X, Y;
+    switch (Paint.Rotate) {
+        case ROTATE_90:  X = (int32_t)Paint.WidthMemory - y - lh; Y = x; break;
+        case ROTATE_180: X = (int32_t)Paint.WidthMemory - x - lw; Y = (int32_t)Paint.HeightMemory - y - lh; break;
+        case ROTATE_270: X = y; Y = (int32_t)Paint.HeightMemory - x - lw; break;
+        default:         X = x; Y = y; break;
+    }
+
+    // Image and canvas rotations add up to a turn of the image in memory
+    uint16_t turns = ((rotate + Paint.Rotate) / 90) % 4;
+    pl->columns = (turns % 2) != 0;
+    pl->reverse = (turns == 2 || turns == 3);
+    pl->flip = (turns == 1 || turns == 2);
+
+    // Memory range of image columns (along) and rows (across), clipped
+    int32_t a = pl->columns ? Y : X, c = pl->columns ? X : Y;
+    int32_t am = pl->columns ? Paint.HeightMemory : Paint.WidthMemory;
+    int32_t cm = pl->columns ? Paint.WidthMemory : Paint.HeightMemory;
+    int32_t a0 = (a < 0) ? -a : 0, a1 = (am - a < w) ? am - a : w;
+    int32_t c0 = (c < 0) ? -c : 0, c1 = (cm - c < h) ? cm - c : h;
+    if (a1 - a0 > EPD_IMAGE_MAX_RUN) {
+        a1 = a0 + EPD_IMAGE_MAX_RUN;
+    }
+    if (a0 >= a1 || c0 >= c1) {
+        return false;
+    }
+    pl->u0 = pl->reverse ? w - a1 : a0;
+    pl->u1 = pl->reverse ? w - a0 : a1;
+    pl->v0 = pl->flip ? h - c1 : c0;
+    pl->v1 = pl->flip ? h - c0 : c1;
+    pl->along = a + a0;
+    pl->across = pl->flip ? c + h - 1 : c;
+    return true;
+}
+
+// Image column u of a visible row is white: bit k of out is column u0 + k
+// (u1 - 1 - k when reversed), or, for columns, byte k under mask
+static inline void EPD_Image_Put(const EPD_ImagePlace_t *pl, uint8_t *out, uint8_t mask, uint16_t u) {
+    if (u < pl->u0) {
+        return;
+    }
+    uint16_t k = pl->reverse ? pl->u1 - 1 - u : u - pl->u0;
+    if (pl->columns) {
+        out[k] |= mask;
+    } else {
+        out[k / 8] |= 0x80 >> (k % 8);
+    }
+}
+
+// One file row; keep false only reads past it
+static bool EPD_Image_Row(EPD_ImageReader_t *r, const EPD_ImageFormat_t *fmt, const EPD_ImagePlace_t *pl,
+                          bool keep, uint8_t *out, uint8_t mask) {
+    uint8_t bits = fmt->info.bits;
+    if (fmt->plain) {
+        for (uint16_t u = 0; u < fmt->info.width; u++) {
+            int32_t s = EPD_Image_Number(r, (fmt->info.type == EPD_IMAGE_PBM) ? 1 : 5);
+            if (s < 0 || s > fmt->maxval) {
+                return false;
+            }
+            if (keep && u < pl->u1 && EPD_Image_IsWhite(fmt, s)) {
+                EPD_Image_Put(pl, out, mask, u);
+            }
+        }
+        return true;
+    }
+    if (!keep) {
+        return EPD_Image_Skip(r, fmt->row_bytes);
+    }
+
+    // Only the bytes up to the last visible column are looked at
+    uint32_t need = (bits == 1) ? (pl->u1 + 7) / 8 : (bits == 4) ? (pl->u1 + 1) / 2 : pl->u1 * (bits / 8);
+    uint32_t done = 0;
+
+    // 1-bit rows that land whole bytes in order: map them a byte at a time
+    if (bits == 1 && !pl->columns && !pl->reverse && pl->u0 == 0) {
+        uint8_t set = (fmt->white[0] & 0x40) ? 0xFF : 0x00, clear = (fmt->white[0] & 0x80) ? 0xFF : 0x00;
+        while (done < need) {
+            size_t n;
+            const uint8_t *p = EPD_Image_Take(r, need - done, &n);
+            if (p == NULL) return false;
+            for (size_t i = 0; i < n; i++) {
+                out[done + i] = (p[i] & set) | (~p[i] & clear);
+            }
+            done += n;
+        }
+        return EPD_Image_Skip(r, fmt->row_bytes - need);
+    }
+
+    uint16_t u = 0;
+    int32_t hi = -1;
+    while (done < need) {
+        size_t n;
+        const uint8_t *p = EPD_Image_Take(r, need - done, &n);
+        if (p == NULL) return false;
+        done += n;
+        for (size_t i = 0; i < n; i++) {
+            uint8_t b = p[i];
+            switch (bits) {
+                case 16:
+                    if (hi < 0) {
+                        hi = b;
+                        break;
+                    }
+                    if ((hi << 8 | b) > fmt->maxval) return false;
+                    if (EPD_Image_IsWhite(fmt, hi << 8 | b)) EPD_Image_Put(pl, out, mask, u);
+                    hi = -1;
+                    u++;
+                    break;
+                case 8:
+                    if (EPD_Image_IsWhite(fmt, b)) EPD_Image_Put(pl, out, mask, u);
+                    u++;
+                    break;
+                case 4:
+                    if (EPD_Image_IsWhite(fmt, b >> 4)) EPD_Image_Put(pl, out, mask, u);
+                    if (++u < pl->u1 && EPD_Image_IsWhite(fmt, b & 0x0F)) EPD_Image_Put(pl, out, mask, u);
+                    u++;
+                    break;
+                default:
+                    for (uint8_t m = 0x80; m != 0 && u < pl->u1; m >>= 1, u++) {
+                        if (EPD_Image_IsWhite(fmt, (b & m) != 0)) EPD_Image_Put(pl, out, mask, u);
+                    }
+                    break;
+            }
+        }
+    }
+    return EPD_Image_Skip(r, fmt->row_bytes - need);
+}
+
+esp_err_t EPD_Image_Draw(FILE *f, uint16_t x, uint16_t y, const EPD_ImageOptions_t *options,
+                         EPD_ImageInfo_t *info) {
+    EPD_ImageOptions_t opt = EPD_IMAGE_OPTIONS_DEFAULT();
+    if (options != NULL) {
+        opt = *options;
+    }
+    if (f == NULL || Paint.Image == NULL || opt.rotate % 90 != 0 || opt.rotate > ROTATE_270) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    EPD_ImageReader_t r = { .f = f };
+    EPD_ImageFormat_t fmt = { .threshold = opt.threshold, .invert = opt.invert };
+    esp_err_t err = EPD_Image_Header(&r, &fmt);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (info != NULL) {
+        *info = fmt.info;
+    }
+    EPD_ImagePlace_t pl = { .rop = opt.rop };
+    if (!EPD_Image_Place(&fmt, x, y, opt.rotate, &pl)) {
+        return ESP_OK;
+    }
+
+    // Rows: one image row per memory row. Columns: up to eight image rows
+    // transposed into a strip one byte wide at memory column `strip`; strips
+    // start at the first visible column and every eighth one after it.
+    uint8_t out[EPD_IMAGE_MAX_RUN];
+    uint16_t n = pl.u1 - pl.u0, h = fmt.info.height, left = pl.v1 - pl.v0;
+    int32_t first = pl.flip ? pl.across - (pl.v1 - 1) : pl.across + pl.v0;
+    int32_t end = first + left, strip = -1;
+    memset(out, 0, sizeof(out));
+    for (uint16_t row = 0; left > 0; row++) {
+        uint16_t v = fmt.bottom_up ? h - 1 - row : row;
+        bool keep = (v >= pl.v0 && v < pl.v1);
+        int32_t c = pl.flip ? pl.across - v : pl.across + v;
+        uint8_t mask = 0;
+        if (keep && pl.columns) {
+            int32_t base = first + (c - first) / 8 * 8;
+            if (base != strip && strip >= 0) {
+                EPD_Blit_Memory(strip, pl.along, (end - strip < 8) ? end - strip : 8, n, out, NULL, pl.rop);
+                memset(out, 0, n);
+            }
+            strip = base;
+            mask = 0x80 >> (c - base);
+        }
+        if (!EPD_Image_Row(&r, &fmt, &pl, keep, out, mask)) {
+            return ESP_ERR_INVALID_CRC;
+        }
+        if (keep && !pl.columns) {
+            EPD_Blit_Memory(pl.along, c, n, 1, out, NULL, pl.rop);
+            memset(out, 0, (n + 7) / 8);
+        }
+        left -= keep;
+    }
+    if (strip >= 0) {
+        EPD_Blit_Memory(strip, pl.along, (end - strip < 8) ? end - strip : 8, n, out, NULL, pl.rop);
+    }
+    return ESP_OK;
+}
+
+esp_err_t EPD_Image_DrawFile(const char *path, uint16_t x, uint16_t y,
+                             const EPD_ImageOptions_t *options, EPD_ImageInfo_t *info) {
+    if (path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t err = EPD_Image_Draw(f, x, y, options, info);
+    fclose(f);
+    return err;
+}
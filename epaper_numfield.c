@@ -0,0 +1,96 @@
+#include "epaper_numfield.h"
+#include <string.h>
+
+esp_err_t EPD_NumField_Init(EPD_NumField_t *field, const EPD_NumFieldConfig_t *config) {
+    if (field == NULL || config == NULL || config->digits < 1 ||
+        config->digits > EPD_NUMFIELD_MAX_DIGITS || config->frac >= config->digits) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (config->size != 8 && config->size != 12 && config->size != 16 && config->size != 24) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(field, 0, sizeof(*field));
+    field->cfg = *config;
+    field->cells = config->digits + (config->frac ? 1 : 0) + (config->sign ? 1 : 0);
+    // Glyph box drawn by EPD_ShowChar: 6 x 8 for the 8 px font, else
+    // size / 2 wide and whole bytes of rows high
+    field->pitch = (config->size == 8) ? 6 : config->size / 2;
+    field->height = (config->size + 7) / 8 * 8;
+    return ESP_OK;
+}
+
+void EPD_NumField_Invalidate(EPD_NumField_t *field) {
+    field->drawn = false;
+}
+
+void EPD_NumField_GetRect(const EPD_NumField_t *field, EPD_Rect_t *rect) {
+    // EPD_ShowChar starts one pixel right of and below (x, y)
+    rect->x = field->cfg.x + 1;
+    rect->y = field->cfg.y + 1;
+    rect->width = field->cells * field->pitch;
+    rect->height = field->height;
+}
+
+// Characters of value, one per cell
+static void EPD_NumField_Format(const EPD_NumField_t *field, int32_t value, char *out) {
+    const EPD_NumFieldConfig_t *cfg = &field->cfg;
+    uint32_t mag = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+    // Integer digits that are always shown: the one before the point
+    uint8_t keep = cfg->frac + 1;
+    int8_t lead = -1;   // Cell of the leftmost significant digit
+    uint8_t c = field->cells;
+
+    for (uint8_t d = 0; d < cfg->digits; d++) {
+        if (d == cfg->frac && cfg->frac) {
+            out[--c] = '.';
+        }
+        uint8_t digit = mag % 10;
+        mag /= 10;
+        out[--c] = '0' + digit;
+        if (digit != 0 || d < keep) {
+            lead = c;
+        }
+    }
+    if (!cfg->zero_pad) {
+        for (uint8_t i = cfg->sign ? 1 : 0; i < lead; i++) {
+            out[i] = ' ';
+        }
+    }
+    if (cfg->sign) {
+        out[0] = ' ';
+        if (value < 0) {
+            // Right before the number when padded with blanks
+            out[cfg->zero_pad ? 0 : lead - 1] = '-';
+        }
+    }
+}
+
+uint8_t EPD_NumField_Set(EPD_NumField_t *field, int32_t value, EPD_Rect_t *dirty) {
+    char text[EPD_NUMFIELD_MAX_CELLS];
+    uint8_t first = field->cells, last = 0, redrawn = 0;
+
+    EPD_NumField_Format(field, value, text);
+    for (uint8_t i = 0; i < field->cells; i++) {
+        if (field->drawn && text[i] == field->shown[i]) {
+            continue;
+        }
+        EPD_ShowChar(field->cfg.x + i * field->pitch, field->cfg.y, text[i], field->cfg.size, field->cfg.color);
+        field->shown[i] = text[i];
+        if (i < first) first = i;
+        last = i;
+        redrawn++;
+    }
+    field->drawn = true;
+
+    if (dirty) {
+        EPD_NumField_GetRect(field, dirty);
+        if (redrawn) {
+            dirty->x += first * field->pitch;
+            dirty->width = (last - first + 1) * field->pitch;
+        } else {
+            dirty->width = 0;
+        }
+    }
+    return redrawn;
+}
@@ -0,0 +1,340 @@
+#include "epaper_raster.h"
+#include "epaper_trace.h"
+#include <string.h>
+
+// sin(0..90 degrees) in 2.14 fixed point
+static const int16_t s_sin_q14[91] = {
+    0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+    2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+    5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+    8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384,
+};
+
+// Quadrants by symmetry, so sin(a + 180) is exactly -sin(a)
+static int32_t EPD_Sin(int32_t deg) {
+    deg %= 360;
+    if (deg < 0) deg += 360;
+    if (deg <= 90) return s_sin_q14[deg];
+    if (deg <= 180) return s_sin_q14[180 - deg];
+    if (deg <= 270) return -s_sin_q14[deg - 180];
+    return -s_sin_q14[360 - deg];
+}
+
+static inline int32_t EPD_Cos(int32_t deg) {
+    return EPD_Sin(deg + 90);
+}
+
+// Division rounding down and up, d > 0
+static inline int64_t EPD_FloorDiv(int64_t n, int64_t d) {
+    return (n >= 0) ? n / d : -((-n + d - 1) / d);
+}
+
+static inline int64_t EPD_CeilDiv(int64_t n, int64_t d) {
+    return -EPD_FloorDiv(-n, d);
+}
+
+static uint32_t EPD_Isqrt(uint64_t n) {
+    uint64_t r = 0, bit = 1ULL << 62;
+
+    while (bit > n) bit >>= 2;
+    while (bit != 0) {
+        if (n >= r + bit) {
+            n -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)r;
+}
+
+// Polygon edge, top to bottom, in 24.8 fixed point. On each row it crosses
+// it stands for its threshold q: the first pixel whose center is at or right
+// of the edge. q is stepped exactly, with the remainder r = q * d - x * d
+// kept like a Bresenham error term.
+typedef struct {
+    int32_t q;
+    int32_t qs;             // Whole pixels per row
+    int64_t r;              // In [0, d)
+    int64_t rs;             // Remainder per row, in [0, d)
+    int64_t d;
+    int16_t y0, y1;         // Rows crossed, clipped to the canvas
+    int8_t dir;             // +1 drawn downward, -1 upward
+} EPD_Edge_t;
+
+// Scanline fill of the polygon pts (24.8 fixed point) with an edge table
+// sorted by first row and an active edge list kept sorted by threshold
+static void EPD_Raster_Fill(const int32_t (*pts)[2], size_t n, EPD_FillRule_t rule, uint16_t Color) {
+    EPD_Edge_t edges[EPD_RASTER_MAX_POINTS];
+    uint8_t active[EPD_RASTER_MAX_POINTS];
+    size_t ne = 0, na = 0, next = 0;
+    int32_t top = 0, bottom = (int32_t)Paint.Height - 1;
+
+    for (size_t i = 0; i < n; i++) {
+        const int32_t *a = pts[i], *b = pts[(i + 1) % n];
+        int8_t dir = 1;
+        if (a[1] == b[1]) {
+            continue;       // Horizontal edges cross no row
+        }
+        if (a[1] > b[1]) {
+            const int32_t *t = a;
+            a = b;
+            b = t;
+            dir = -1;
+        }
+        // Rows whose centers y * 256 are in [a.y, b.y)
+        int32_t y0 = (int32_t)EPD_CeilDiv(a[1], 256);
+        int32_t y1 = (int32_t)EPD_CeilDiv(b[1], 256) - 1;
+        if (y0 < top) y0 = top;
+        if (y1 > bottom) y1 = bottom;
+        if (y0 > y1) {
+            continue;
+        }
+
+        // Threshold on row y: ceil(x(y) / 256) = ceil(N / d) with
+        // N = a.x * dy + (y * 256 - a.y) * dx and d = dy * 256
+        EPD_Edge_t *e = &edges[ne++];
+        int64_t dx = b[0] - a[0], dy = b[1] - a[1];
+        int64_t num = a[0] * dy + ((int64_t)y0 * 256 - a[1]) * dx;
+        e->d = dy * 256;
+        e->q = (int32_t)EPD_CeilDiv(num, e->d);
+        e->r = (int64_t)e->q * e->d - num;
+        e->qs = (int32_t)EPD_FloorDiv(dx * 256, e->d);
+        e->rs = dx * 256 - (int64_t)e->qs * e->d;
+        e->y0 = y0;
+        e->y1 = y1;
+        e->dir = dir;
+        // Edge table by first row
+        for (size_t k = ne - 1; k > 0 && edges[k - 1].y0 > edges[k].y0; k--) {
+            EPD_Edge_t t = edges[k];
+            edges[k] = edges[k - 1];
+            edges[k - 1] = t;
+        }
+    }
+    if (ne == 0) {
+        return;
+    }
+
+    for (int32_t y = edges[0].y0; next < ne || na > 0; y++) {
+        while (next < ne && edges[next].y0 == y) {
+            active[na++] = next++;
+        }
+        size_t keep = 0;
+        for (size_t i = 0; i < na; i++) {
+            if (edges[active[i]].y1 >= y) active[keep++] = active[i];
+        }
+        na = keep;
+        // Nearly sorted from the previous row
+        for (size_t i = 1; i < na; i++) {
+            for (size_t k = i; k > 0 && edges[active[k - 1]].q > edges[active[k]].q; k--) {
+                uint8_t t = active[k];
+                active[k] = active[k - 1];
+                active[k - 1] = t;
+            }
+        }
+
+        int32_t wind = 0, from = 0;
+        bool in = false;
+        for (size_t i = 0; i < na; i++) {
+            EPD_Edge_t *e = &edges[active[i]];
+            wind += (rule == EPD_FILL_NONZERO) ? e->dir : 1;
+            bool inside = (rule == EPD_FILL_NONZERO) ? (wind != 0) : (wind & 1);
+            if (!in && inside) {
+                from = e->q;
+            } else if (in && !inside && e->q > from) {
+                EPD_FillSpan(from, e->q - 1, y, Color);
+            }
+            in = inside;
+
+            e->q += e->qs;
+            e->r -= e->rs;
+            if (e->r < 0) {
+                e->r += e->d;
+                e->q++;
+            }
+        }
+    }
+}
+
+void EPD_FillPolygon(const EPD_Point_t *points, size_t count, EPD_FillRule_t rule, uint16_t Color) {
+    int32_t pts[EPD_RASTER_MAX_POINTS][2];
+
+    if (count > EPD_RASTER_MAX_POINTS) count = EPD_RASTER_MAX_POINTS;
+    if (count < 3) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    for (size_t i = 0; i < count; i++) {
+        pts[i][0] = points[i].x * 256;
+        pts[i][1] = points[i].y * 256;
+    }
+    EPD_Raster_Fill(pts, count, rule, Color);
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
+
+// Vertices per round cap: a half turn in steps of 180 / 8 degrees
+#define EPD_CAP_STEPS   8
+
+// (x, y) turned counterclockwise on the screen by deg, 24.8 fixed point
+static void EPD_Turn(int32_t out[2], int64_t x, int64_t y, int32_t deg) {
+    int64_t c = EPD_Cos(deg), s = EPD_Sin(deg);
+    out[0] = (int32_t)((x * c + y * s + 8192) >> 14);
+    out[1] = (int32_t)((y * c - x * s + 8192) >> 14);
+}
+
+void EPD_DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t width,
+                       EPD_LineCap_t cap, uint16_t Color) {
+    int32_t pts[2 * (EPD_CAP_STEPS + 1)][2];
+    int64_t dx = x1 - x0, dy = y1 - y0;
+    int64_t ux, uy;         // Along the line, half the width long (24.8)
+    size_t n = 0;
+
+    if (width == 0) {
+        return;
+    }
+    if (dx == 0 && dy == 0) {
+        if (cap == EPD_CAP_BUTT) {
+            return;
+        }
+        ux = width * 128;
+        uy = 0;
+    } else {
+        uint32_t len = EPD_Isqrt((uint64_t)(dx * dx + dy * dy) << 16);   // 24.8
+        ux = dx * width * 32768 / len;
+        uy = dy * width * 32768 / len;
+    }
+    EPD_TRACE_BEGIN(span);
+    int64_t ax = x0 * 256, ay = y0 * 256, bx = x1 * 256, by = y1 * 256;
+    if (cap == EPD_CAP_SQUARE) {
+        ax -= ux;
+        ay -= uy;
+        bx += ux;
+        by += uy;
+    }
+
+    if (cap == EPD_CAP_ROUND) {
+        // Around b from the normal (-uy, ux) through u to its opposite, then
+        // around a back to the normal
+        for (int k = 0; k <= EPD_CAP_STEPS; k++, n++) {
+            EPD_Turn(pts[n], -uy, ux, k * 180 / EPD_CAP_STEPS);
+            pts[n][0] += bx;
+            pts[n][1] += by;
+        }
+        for (int k = 0; k <= EPD_CAP_STEPS; k++, n++) {
+            EPD_Turn(pts[n], uy, -ux, k * 180 / EPD_CAP_STEPS);
+            pts[n][0] += ax;
+            pts[n][1] += ay;
+        }
+    } else {
+        const int64_t quad[4][2] = {
+            { ax - uy, ay + ux }, { bx - uy, by + ux }, { bx + uy, by - ux }, { ax + uy, ay - ux },
+        };
+        for (; n < 4; n++) {
+            pts[n][0] = (int32_t)quad[n][0];
+            pts[n][1] = (int32_t)quad[n][1];
+        }
+    }
+    EPD_Raster_Fill(pts, n, EPD_FILL_NONZERO, Color);
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
+
+// Pixels lo..hi of a row, empty when lo > hi
+typedef struct {
+    int32_t lo, hi;
+} EPD_Run_t;
+
+#define EPD_RUN_ALL     ((EPD_Run_t){ -(1 << 30), 1 << 30 })
+#define EPD_RUN_NONE    ((EPD_Run_t){ 1, 0 })
+
+// Ring of pixels with ri^2 - ri < d^2 <= ro^2 + ro (no hole when ri < 1,
+// a one pixel circle when ri == ro), cut to the angles start..end. Each row
+// is the ring's runs intersected with the runs of the angular range: the
+// points on or clockwise of the start ray, and on or counterclockwise of the
+// end ray, both of which are half planes, hence one run per row each.
+static void EPD_Raster_Sector(int16_t cx, int16_t cy, int32_t ro, int32_t ri,
+                              int32_t start, int32_t end, uint16_t Color) {
+    int32_t sweep = end - start;
+    while (sweep <= 0) sweep += 360;
+    bool full = sweep >= 360;
+    int64_t c0 = EPD_Cos(start), s0 = EPD_Sin(start);
+    int64_t c1 = EPD_Cos(start + sweep), s1 = EPD_Sin(start + sweep);
+    int64_t outer = (int64_t)ro * ro + ro, hole = (ri > 0) ? (int64_t)ri * ri - ri : -1;
+    int32_t dy0 = -ro, dy1 = ro;
+
+    if (cy + dy0 < 0) dy0 = -cy;
+    if (cy + dy1 >= Paint.Height) dy1 = Paint.Height - 1 - cy;
+    for (int32_t dy = dy0; dy <= dy1; dy++) {
+        int64_t d2 = (int64_t)dy * dy;
+        EPD_Run_t ring[2], ang[2];
+        size_t nr = 0, nang = 0;
+
+        int32_t a = EPD_Isqrt(outer - d2);
+        if (hole >= d2) {
+            int32_t b = EPD_Isqrt(hole - d2);
+            ring[nr++] = (EPD_Run_t){ -a, -b - 1 };
+            ring[nr++] = (EPD_Run_t){ b + 1, a };
+        } else {
+            ring[nr++] = (EPD_Run_t){ -a, a };
+        }
+
+        if (full) {
+            ang[nang++] = EPD_RUN_ALL;
+        } else {
+            // Start: s0 * dx <= c0 * dy; end: s1 * dx >= c1 * dy
+            int64_t k0 = c0 * dy, k1 = c1 * dy;
+            EPD_Run_t h0 = EPD_RUN_ALL, h1 = EPD_RUN_ALL;
+            if (s0 > 0) h0.hi = EPD_FloorDiv(k0, s0);
+            else if (s0 < 0) h0.lo = EPD_CeilDiv(-k0, -s0);
+            else if (k0 < 0) h0 = EPD_RUN_NONE;
+            if (s1 > 0) h1.lo = EPD_CeilDiv(k1, s1);
+            else if (s1 < 0) h1.hi = EPD_FloorDiv(-k1, -s1);
+            else if (k1 > 0) h1 = EPD_RUN_NONE;
+
+            if (sweep <= 180) {
+                ang[nang++] = (EPD_Run_t){ (h0.lo > h1.lo) ? h0.lo : h1.lo, (h0.hi < h1.hi) ? h0.hi : h1.hi };
+            } else if (h0.lo > h0.hi) {
+                ang[nang++] = h1;
+            } else if (h1.lo > h1.hi) {
+                ang[nang++] = h0;
+            } else if (h1.lo <= h0.hi + 1 && h0.lo <= h1.hi + 1) {
+                ang[nang++] = (EPD_Run_t){ (h0.lo < h1.lo) ? h0.lo : h1.lo, (h0.hi > h1.hi) ? h0.hi : h1.hi };
+            } else {
+                ang[nang++] = h0;
+                ang[nang++] = h1;
+            }
+        }
+
+        for (size_t i = 0; i < nr; i++) {
+            for (size_t j = 0; j < nang; j++) {
+                int32_t lo = (ring[i].lo > ang[j].lo) ? ring[i].lo : ang[j].lo;
+                int32_t hi = (ring[i].hi < ang[j].hi) ? ring[i].hi : ang[j].hi;
+                if (lo <= hi) {
+                    EPD_FillSpan(cx + lo, cx + hi, cy + dy, Color);
+                }
+            }
+        }
+    }
+}
+
+void EPD_DrawArc(int16_t cx, int16_t cy, uint16_t radius, uint16_t width,
+                 int16_t start, int16_t end, uint16_t Color) {
+    if (width == 0) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    EPD_Raster_Sector(cx, cy, radius, (int32_t)radius - width + 1, start, end, Color);
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
+
+void EPD_FillPie(int16_t cx, int16_t cy, uint16_t radius, int16_t start, int16_t end, uint16_t Color) {
+    EPD_TRACE_BEGIN(span);
+    EPD_Raster_Sector(cx, cy, radius, 0, start, end, Color);
+    EPD_TRACE_END(span, EPD_PHASE_DRAW);
+}
@@ -0,0 +1,240 @@
+#include "epaper_refresh_policy.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "epaper_arena.h"
+#include "epaper_bits.h"
+#include <string.h>
+
+static const char *TAG = "epaper_policy";
+
+static struct {
+    EPD_PolicyConfig_t cfg;
+    uint8_t *shadow;                        // EPD_Arena_Shadow() the baseline refers to
+    bool has_baseline;                      // shadow matches what the panel shows
+    uint16_t fast_since_full;
+    int64_t last_full_us;
+    uint16_t tile_changed[EPD_TILE_COUNT];  // Changed pixels of the frame being decided
+    EPD_PolicyStats_t last;
+    bool ready;
+} s_policy;
+
+esp_err_t EPD_Policy_Init(const EPD_PolicyConfig_t *config) {
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!EPD_Arena_Ready()) {
+        EPD_ArenaConfig_t arena = EPD_ARENA_CONFIG_DEFAULT();
+        esp_err_t ret = EPD_Arena_Init(&arena);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    if (EPD_Arena_Shadow() == NULL) {
+        ESP_LOGE(TAG, "Framebuffer arena has no shadow frame");
+        return ESP_ERR_INVALID_STATE;
+    }
+    EPD_HeatConfig_t heat;
+    EPD_Heat_GetConfig(&heat);
+    heat.max_partials = config->max_partial_per_tile;
+    esp_err_t ret = EPD_Heat_SetConfig(&heat);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_policy.cfg = *config;
+    s_policy.ready = true;
+    EPD_Policy_ForceFull();
+    return ESP_OK;
+}
+
+void EPD_Policy_Deinit(void) {
+    memset(&s_policy, 0, sizeof(s_policy)); // the shadow belongs to the arena
+}
+
+bool EPD_Policy_Ready(void) {
+    return s_policy.ready;
+}
+
+void EPD_Policy_ForceFull(void) {
+    s_policy.has_baseline = false;
+}
+
+// Shadow in use, NULL when the arena has none. Fetched at each use so a
+// deinitialized arena is never touched; a different buffer than last time
+// holds no baseline.
+static uint8_t *EPD_Policy_Shadow(void) {
+    uint8_t *shadow = EPD_Arena_Shadow();
+    if (shadow != s_policy.shadow) {
+        s_policy.shadow = shadow;
+        s_policy.has_baseline = false;
+    }
+    return shadow;
+}
+
+// Popcount of the shadow/frame difference, binned per tile
+static void EPD_Policy_Diff(const uint8_t *shadow, const uint8_t *Image, EPD_PolicyStats_t *stats) {
+    uint16_t xb_min = EPD_FRAME_STRIDE, xb_max = 0;
+    uint16_t y_min = EPD_H, y_max = 0;
+
+    memset(s_policy.tile_changed, 0, sizeof(s_policy.tile_changed));
+    stats->changed_pixels = 0;
+
+    for (uint16_t y = 0; y < EPD_H; y++) {
+        const uint8_t *prev = shadow + (uint32_t)y * EPD_FRAME_STRIDE;
+        const uint8_t *next = Image + (uint32_t)y * EPD_FRAME_STRIDE;
+        uint16_t *tiles = &s_policy.tile_changed[(y / EPD_TILE_H) * EPD_TILES_X];
+
+        size_t first, last;
+
+        if (!EPD_Bits_DiffSpan(prev, next, EPD_FRAME_STRIDE, &first, &last)) {
+            continue;
+        }
+        if (first < xb_min) xb_min = first;
+        if (last > xb_max) xb_max = last;
+        if (y < y_min) y_min = y;
+        y_max = y;
+
+        // Only the tiles the changed span crosses
+        for (uint16_t t = first / (EPD_TILE_W / 8); t <= last / (EPD_TILE_W / 8); t++) {
+            uint16_t xb = t * (EPD_TILE_W / 8);
+            uint16_t wb = (EPD_FRAME_STRIDE - xb < EPD_TILE_W / 8) ? EPD_FRAME_STRIDE - xb : EPD_TILE_W / 8;
+            uint32_t bits = EPD_Bits_CountDiff(prev + xb, next + xb, wb);
+            stats->changed_pixels += bits;
+            tiles[t] += bits;
+        }
+    }
+
+    if (stats->changed_pixels == 0) {
+        memset(&stats->dirty, 0, sizeof(stats->dirty));
+    } else {
+        stats->dirty.x = xb_min * 8;
+        stats->dirty.y = y_min;
+        stats->dirty.width = (xb_max - xb_min + 1) * 8;
+        stats->dirty.height = y_max - y_min + 1;
+    }
+}
+
+// Change plus every worn tile, rounded out to whole tiles so that the clean
+// resets all of them; false when that is too much of the panel to clean in place
+static bool EPD_Policy_CleanArea(EPD_PolicyStats_t *st) {
+    EPD_HeatConfig_t heat;
+    EPD_Rect_t hot;
+    uint16_t x0 = st->dirty.x, y0 = st->dirty.y;
+    uint16_t x1 = st->dirty.x + st->dirty.width, y1 = st->dirty.y + st->dirty.height;
+
+    EPD_Heat_GetConfig(&heat);
+    if (EPD_Heat_Plan(&hot) != EPD_CLEANUP_NONE) {
+        if (hot.x < x0) x0 = hot.x;
+        if (hot.y < y0) y0 = hot.y;
+        if (hot.x + hot.width > x1) x1 = hot.x + hot.width;
+        if (hot.y + hot.height > y1) y1 = hot.y + hot.height;
+    }
+    x0 -= x0 % EPD_TILE_W;
+    y0 -= y0 % EPD_TILE_H;
+    x1 = (x1 + EPD_TILE_W - 1) / EPD_TILE_W * EPD_TILE_W;
+    y1 = (y1 + EPD_TILE_H - 1) / EPD_TILE_H * EPD_TILE_H;
+    if (x1 > EPD_W) x1 = EPD_W;
+    if (y1 > EPD_H) y1 = EPD_H;
+
+    st->clean.x = x0;
+    st->clean.y = y0;
+    st->clean.width = x1 - x0;
+    st->clean.height = y1 - y0;
+    return (uint32_t)st->clean.width * st->clean.height * 1000 <= (uint32_t)heat.full_permille * EPD_W * EPD_H;
+}
+
+EPD_RefreshMode_t EPD_Policy_Decide(const uint8_t *Image, EPD_PolicyStats_t *stats) {
+    EPD_PolicyStats_t *st = &s_policy.last;
+    const EPD_PolicyConfig_t *cfg = &s_policy.cfg;
+    const uint8_t *shadow = EPD_Policy_Shadow();
+    EPD_RefreshMode_t mode;
+
+    memset(st, 0, sizeof(*st));
+    st->fast_since_full = s_policy.fast_since_full;
+    st->ms_since_full = (uint32_t)((esp_timer_get_time() - s_policy.last_full_us) / 1000);
+
+    if (shadow == NULL || !s_policy.has_baseline) {
+        mode = EPD_REFRESH_FULL;
+        goto out;
+    }
+
+    EPD_Policy_Diff(shadow, Image, st);
+    if (st->changed_pixels == 0) {
+        mode = EPD_REFRESH_NONE;
+        goto out;
+    }
+
+    st->changed_permille = (uint16_t)(((uint64_t)st->changed_pixels * 1000) / ((uint32_t)EPD_W * EPD_H));
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        if (s_policy.tile_changed[t] == 0) continue;
+        EPD_HeatTile_t tile;
+        EPD_Heat_GetTile(t, &tile);
+        st->dirty_tiles++;
+        if (tile.partials > st->max_tile_partials) {
+            st->max_tile_partials = tile.partials;
+        }
+        if (EPD_Heat_IsHot(t)) {
+            st->hot_tiles++;
+        }
+    }
+
+    if (cfg->full_interval_ms != 0 && st->ms_since_full >= cfg->full_interval_ms) {
+        mode = EPD_REFRESH_FULL;
+    } else if (st->changed_permille <= cfg->partial_max_permille && st->hot_tiles == 0) {
+        mode = EPD_REFRESH_PARTIAL;
+    } else if (st->changed_permille <= cfg->partial_max_permille && EPD_Policy_CleanArea(st)) {
+        mode = EPD_REFRESH_CLEAN;
+    } else if (s_policy.fast_since_full < cfg->max_fast_between_full) {
+        mode = EPD_REFRESH_FAST;
+    } else {
+        mode = EPD_REFRESH_FULL;
+    }
+
+out:
+    if (stats) {
+        *stats = *st;
+    }
+    return mode;
+}
+
+EPD_RefreshMode_t EPD_Policy_Present(const uint8_t *Image) {
+    EPD_RefreshMode_t mode = EPD_Policy_Decide(Image, NULL);
+
+    switch (mode) {
+        case EPD_REFRESH_NONE:
+            return mode;
+        case EPD_REFRESH_PARTIAL:
+            EPD_Display_Part_Stride(s_policy.last.dirty.x, s_policy.last.dirty.y,
+                                    s_policy.last.dirty.width, s_policy.last.dirty.height, Image);
+            for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+                if (s_policy.tile_changed[t] != 0) {
+                    EPD_Heat_AddChanged(t, s_policy.tile_changed[t]);
+                }
+            }
+            break;
+        case EPD_REFRESH_CLEAN:
+            // Drives every pixel of the area, which resets its tiles
+            EPD_Display_Part_Clean(s_policy.last.clean.x, s_policy.last.clean.y,
+                                   s_policy.last.clean.width, s_policy.last.clean.height, Image);
+            break;
+        case EPD_REFRESH_FAST:
+            EPD_Init_Fast(s_policy.cfg.fast_mode); // no-op when already in fast mode
+            EPD_Display_Fast(Image);
+            s_policy.fast_since_full++;
+            break;
+        case EPD_REFRESH_FULL:
+            EPD_Init();
+            EPD_Display(Image);
+            s_policy.fast_since_full = 0;
+            s_policy.last_full_us = esp_timer_get_time();
+            break;
+    }
+
+    uint8_t *shadow = EPD_Policy_Shadow();
+    if (shadow) {
+        memcpy(shadow, Image, EPD_FRAME_SIZE);
+        s_policy.has_baseline = true;
+    }
+    ESP_LOGD(TAG, "mode %d, %lu px changed (%u permille)", mode,
+             (unsigned long)s_policy.last.changed_pixels, s_policy.last.changed_permille);
+    return mode;
+}
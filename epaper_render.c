@@ -0,0 +1,244 @@
+#include "epaper_render.h"
+#include "epaper_trace.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "epaper_render";
+
+static struct {
+    EPD_RenderConfig_t cfg;
+    bool ready;
+    volatile bool exit;         // Helpers leave their loop on the next start
+    // Frame being rendered, set by the caller before it wakes the helpers
+    const EPD_DrawCmd_t *cmds;
+    size_t count;
+    uint16_t rows;              // Frame buffer rows per band
+    // Run of bands per worker, lo | hi << 16: the owner takes lo, thieves hi - 1
+    uint32_t runs[EPD_RENDER_MAX_WORKERS];
+    EPD_RenderStats_t stats;
+} s_render;
+
+// Outlive Init/Deinit, like the canvas lock
+static SemaphoreHandle_t s_start[EPD_RENDER_MAX_WORKERS];
+static StaticSemaphore_t s_start_buf[EPD_RENDER_MAX_WORKERS];
+static SemaphoreHandle_t s_done;
+static StaticSemaphore_t s_done_buf;
+
+// Next band from worker w's own run (thief false) or from the far end of it
+static bool EPD_Render_Take(uint8_t w, bool thief, uint16_t *band) {
+    uint32_t run = __atomic_load_n(&s_render.runs[w], __ATOMIC_RELAXED);
+
+    for (;;) {
+        uint16_t lo = run & 0xFFFF, hi = run >> 16;
+        if (lo >= hi) {
+            return false;
+        }
+        uint32_t next = thief ? (lo | (uint32_t)(hi - 1) << 16) : (uint32_t)(lo + 1) | (uint32_t)hi << 16;
+        // On failure run is reloaded with the current value
+        if (__atomic_compare_exchange_n(&s_render.runs[w], &run, next, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            *band = thief ? hi - 1 : lo;
+            return true;
+        }
+    }
+}
+
+// cmd clipped to the logical interval [a0, a1) of the band on the axis that
+// maps to frame buffer rows (x when axis_x, else y). Only the commands that
+// loop over whole rows or columns are clipped here, the rest draw through
+// the band clip of Paint_SetPixel and EPD_Full.
+static void EPD_Render_Run(const EPD_DrawCmd_t *cmd, int32_t a0, int32_t a1, bool axis_x) {
+    EPD_DrawCmd_t c;
+
+    if (cmd->op == EPD_CMD_CLEAR_WINDOW || (cmd->op == EPD_CMD_RECT && cmd->mode && !axis_x)) {
+        // Half-open [x0, x1) x [y0, y1): rows of a filled rectangle are
+        // y0..y1 - 1 as well
+        c = *cmd;
+        uint16_t *lo = axis_x ? &c.x0 : &c.y0, *hi = axis_x ? &c.x1 : &c.y1;
+        if (*lo < a0) *lo = a0;
+        if (*hi > a1) *hi = a1;
+        if (*lo >= *hi) {
+            return;
+        }
+        cmd = &c;
+    } else if (cmd->op == EPD_CMD_RECT && cmd->mode) {
+        // Horizontal lines x0..x1 inclusive, in either direction
+        c = *cmd;
+        int32_t lo = (c.x0 < c.x1) ? c.x0 : c.x1, hi = (c.x0 < c.x1) ? c.x1 : c.x0;
+        if (lo < a0) lo = a0;
+        if (hi > a1 - 1) hi = a1 - 1;
+        if (lo > hi) {
+            return;
+        }
+        c.x0 = lo;
+        c.x1 = hi;
+        cmd = &c;
+    }
+    EPD_Cmd_Run(cmd);
+}
+
+static void EPD_Render_Band(uint16_t band) {
+    uint16_t hm = Paint.HeightMemory;
+    uint16_t y0 = band * s_render.rows;
+    uint16_t y1 = (hm - y0 > s_render.rows) ? y0 + s_render.rows : hm;
+    bool axis_x = (Paint.Rotate == ROTATE_90 || Paint.Rotate == ROTATE_270);
+    bool flip = (Paint.Rotate == ROTATE_180 || Paint.Rotate == ROTATE_270);
+    // Band in logical coordinates
+    int32_t a0 = flip ? hm - y1 : y0;
+    int32_t a1 = flip ? hm - y0 : y1;
+
+    EPD_Paint_SetBand(y0, y1);
+    for (size_t i = 0; i < s_render.count; i++) {
+        const EPD_DrawCmd_t *cmd = &s_render.cmds[i];
+        EPD_Rect_t box;
+        if (!EPD_Cmd_Bounds(cmd, &box)) {
+            continue;
+        }
+        int32_t b0 = axis_x ? box.x : box.y;
+        int32_t b1 = b0 + (axis_x ? box.width : box.height);
+        if (b0 < a1 && b1 > a0) {
+            EPD_Render_Run(cmd, a0, a1, axis_x);
+        }
+    }
+    EPD_Paint_SetBand(0, UINT16_MAX);
+}
+
+// Own bands first, then whatever the other workers have left
+static void EPD_Render_Work(uint8_t w) {
+    uint8_t n = s_render.cfg.workers;
+    uint16_t band;
+
+    for (;;) {
+        if (EPD_Render_Take(w, false, &band)) {
+            EPD_Render_Band(band);
+            s_render.stats.bands[w]++;
+            continue;
+        }
+        bool stole = false;
+        for (uint8_t v = 1; v < n && !stole; v++) {
+            stole = EPD_Render_Take((w + v) % n, true, &band);
+        }
+        if (!stole) {
+            return;
+        }
+        EPD_Render_Band(band);
+        s_render.stats.bands[w]++;
+        __atomic_fetch_add(&s_render.stats.steals, 1, __ATOMIC_RELAXED);
+    }
+}
+
+static void EPD_Render_Task(void *arg) {
+    uint8_t w = (uint8_t)(uintptr_t)arg;
+
+    EPD_Trace_Mute(true);
+    for (;;) {
+        xSemaphoreTake(s_start[w], portMAX_DELAY);
+        if (s_render.exit) {
+            break;
+        }
+        EPD_Render_Work(w);
+        xSemaphoreGive(s_done);
+    }
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+esp_err_t EPD_Render_Init(const EPD_RenderConfig_t *config) {
+    EPD_RenderConfig_t cfg = EPD_RENDER_CONFIG_DEFAULT();
+
+    if (config) {
+        cfg = *config;
+    }
+    if (cfg.workers < 1 || cfg.workers > EPD_RENDER_MAX_WORKERS || cfg.bands_per_worker < 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_render.ready) {
+        EPD_Render_Deinit();
+    }
+    if (s_done == NULL) {
+        s_done = xSemaphoreCreateCountingStatic(EPD_RENDER_MAX_WORKERS, 0, &s_done_buf);
+        for (uint8_t w = 0; w < EPD_RENDER_MAX_WORKERS; w++) {
+            s_start[w] = xSemaphoreCreateCountingStatic(1, 0, &s_start_buf[w]);
+        }
+    }
+
+    memset(&s_render, 0, sizeof(s_render));
+    s_render.cfg = cfg;
+    for (uint8_t w = 1; w < cfg.workers; w++) {
+        if (xTaskCreate(EPD_Render_Task, "epd_render", cfg.stack_size, (void *)(uintptr_t)w,
+                        cfg.priority, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to start render worker %u", w);
+            s_render.cfg.workers = w;
+            EPD_Render_Deinit();
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    s_render.ready = true;
+    return ESP_OK;
+}
+
+void EPD_Render_Deinit(void) {
+    uint8_t helpers = s_render.cfg.workers ? s_render.cfg.workers - 1 : 0;
+
+    s_render.exit = true;
+    for (uint8_t w = 1; w <= helpers; w++) {
+        xSemaphoreGive(s_start[w]);
+    }
+    for (uint8_t w = 1; w <= helpers; w++) {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+    }
+    s_render.ready = false;
+    s_render.exit = false;
+    s_render.cfg.workers = 1;
+}
+
+void EPD_Render(const EPD_DrawCmd_t *cmds, size_t count) {
+    uint8_t n = s_render.ready ? s_render.cfg.workers : 1;
+    uint16_t hm = Paint.HeightMemory;
+
+    if (count == 0 || hm == 0) {
+        return;
+    }
+    EPD_TRACE_BEGIN(span);
+    s_render.stats.frames++;
+    if (n == 1) {
+        for (size_t i = 0; i < count; i++) {
+            EPD_Cmd_Run(&cmds[i]);
+        }
+        s_render.stats.bands[0]++;
+        EPD_TRACE_END(span, EPD_PHASE_RENDER);
+        return;
+    }
+
+    uint32_t bands = (uint32_t)n * s_render.cfg.bands_per_worker;
+    if (bands > hm) bands = hm;
+    s_render.rows = (hm + bands - 1) / bands;
+    bands = (hm + s_render.rows - 1) / s_render.rows;
+    s_render.cmds = cmds;
+    s_render.count = count;
+    for (uint8_t w = 0; w < n; w++) {
+        uint32_t lo = w * bands / n, hi = (w + 1) * bands / n;
+        __atomic_store_n(&s_render.runs[w], lo | hi << 16, __ATOMIC_RELAXED);
+    }
+
+    // The semaphores order the stores above before the helpers start
+    for (uint8_t w = 1; w < n; w++) {
+        xSemaphoreGive(s_start[w]);
+    }
+    EPD_Render_Work(0);
+    for (uint8_t w = 1; w < n; w++) {
+        xSemaphoreTake(s_done, portMAX_DELAY);
+    }
+    EPD_TRACE_END(span, EPD_PHASE_RENDER);
+}
+
+void EPD_Render_GetStats(EPD_RenderStats_t *stats) {
+    *stats = s_render.stats;
+}
+
+void EPD_Render_ResetStats(void) {
+    memset(&s_render.stats, 0, sizeof(s_render.stats));
+}
@@ -0,0 +1,132 @@
+#include "epaper_trace.h"
+
+#if CONFIG_CROWPANEL_EPAPER_TRACE
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "epaper_trace";
+
+static const char *const s_phase_names[EPD_PHASE_COUNT] = {
+    [EPD_PHASE_INIT] = "init",
+    [EPD_PHASE_INIT_FAST] = "init_fast",
+    [EPD_PHASE_RESET] = "reset",
+    [EPD_PHASE_CLEAR] = "clear",
+    [EPD_PHASE_DISPLAY] = "display",
+    [EPD_PHASE_DISPLAY_FAST] = "display_fast",
+    [EPD_PHASE_DISPLAY_PART] = "display_part",
+    [EPD_PHASE_OLD_RAM] = "old_ram",
+    [EPD_PHASE_TRANSFORM] = "transform",
+    [EPD_PHASE_BUSY] = "busy",
+    [EPD_PHASE_SPI_CMD] = "spi_cmd",
+    [EPD_PHASE_SPI_DATA] = "spi_data",
+    [EPD_PHASE_SLEEP] = "sleep",
+    [EPD_PHASE_WAKE] = "wake",
+    [EPD_PHASE_SEED] = "seed",
+    [EPD_PHASE_DRAW] = "draw",
+    [EPD_PHASE_TEXT] = "text",
+    [EPD_PHASE_PICTURE] = "picture",
+    [EPD_PHASE_RENDER] = "render",
+};
+
+static struct {
+    EPD_TraceStats_t stats[EPD_PHASE_COUNT];
+    EPD_TraceEvent_t ring[CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE];
+    size_t ring_next;
+    size_t ring_used;
+    uint64_t spi_bytes;         // Running totals, sampled by open spans
+    uint32_t spi_transactions;
+} s_trace;
+
+static __thread bool s_muted;
+
+void EPD_Trace_Mute(bool mute) {
+    s_muted = mute;
+}
+
+void EPD_Trace_CountSpi(size_t bytes) {
+    if (s_muted) return;
+    s_trace.spi_bytes += bytes;
+    s_trace.spi_transactions++;
+}
+
+void EPD_Trace_Begin(EPD_TraceSpan_t *span) {
+    span->bytes = s_trace.spi_bytes;
+    span->transactions = s_trace.spi_transactions;
+    span->start_us = esp_timer_get_time();
+}
+
+void EPD_Trace_End(EPD_TraceSpan_t *span, EPD_TracePhase_t phase) {
+    if (s_muted) return;
+    int64_t now = esp_timer_get_time();
+    uint32_t duration = (uint32_t)(now - span->start_us);
+    uint64_t bytes = s_trace.spi_bytes - span->bytes;
+    EPD_TraceStats_t *st = &s_trace.stats[phase];
+
+    if (st->count == 0 || duration < st->min_us) st->min_us = duration;
+    if (duration > st->max_us) st->max_us = duration;
+    st->count++;
+    st->total_us += duration;
+    st->bytes += bytes;
+    st->transactions += s_trace.spi_transactions - span->transactions;
+
+    EPD_TraceEvent_t *ev = &s_trace.ring[s_trace.ring_next];
+    ev->start_us = span->start_us;
+    ev->duration_us = duration;
+    ev->bytes = (uint32_t)bytes;
+    ev->phase = phase;
+    s_trace.ring_next = (s_trace.ring_next + 1) % CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE;
+    if (s_trace.ring_used < CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE) {
+        s_trace.ring_used++;
+    }
+}
+
+void EPD_Trace_Reset(void) {
+    memset(s_trace.stats, 0, sizeof(s_trace.stats));
+    s_trace.ring_next = 0;
+    s_trace.ring_used = 0;
+}
+
+bool EPD_Trace_GetStats(EPD_TracePhase_t phase, EPD_TraceStats_t *stats) {
+    if (phase >= EPD_PHASE_COUNT || stats == NULL) {
+        return false;
+    }
+    *stats = s_trace.stats[phase];
+    return true;
+}
+
+size_t EPD_Trace_GetEvents(EPD_TraceEvent_t *events, size_t max) {
+    size_t n = (max < s_trace.ring_used) ? max : s_trace.ring_used;
+    size_t first = (s_trace.ring_next + CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE - s_trace.ring_used)
+                   % CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE;
+
+    for (size_t i = 0; i < n; i++) {
+        events[i] = s_trace.ring[(first + i) % CONFIG_CROWPANEL_EPAPER_TRACE_RING_SIZE];
+    }
+    return n;
+}
+
+const char *EPD_Trace_PhaseName(EPD_TracePhase_t phase) {
+    return (phase < EPD_PHASE_COUNT) ? s_phase_names[phase] : "?";
+}
+
+void EPD_Trace_Dump(void) {
+    ESP_LOGI(TAG, "%-13s %7s %9s %9s %9s %11s %9s %7s",
+             "phase", "count", "min_us", "avg_us", "max_us", "total_us", "bytes", "trans");
+    for (int p = 0; p < EPD_PHASE_COUNT; p++) {
+        const EPD_TraceStats_t *st = &s_trace.stats[p];
+        if (st->count == 0) continue;
+        ESP_LOGI(TAG, "%-13s %7lu %9lu %9lu %9lu %11llu %9llu %7lu",
+                 s_phase_names[p],
+                 (unsigned long)st->count,
+                 (unsigned long)st->min_us,
+                 (unsigned long)(st->total_us / st->count),
+                 (unsigned long)st->max_us,
+                 (unsigned long long)st->total_us,
+                 (unsigned long long)st->bytes,
+                 (unsigned long)st->transactions);
+    }
+}
+
+#endif // CONFIG_CROWPANEL_EPAPER_TRACE
@@ -0,0 +1,133 @@
+#include "epaper_warmboot.h"
+#include "epaper_driver.h"
+#include "epaper_asset.h"
+#include "epaper_arena.h"
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#include <stddef.h>
+#include <string.h>
+
+#define EPD_WARM_MAGIC  0x57424F54u     // "WBOT"
+#define EPD_WARM_COPY   CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE
+
+// Kept in RTC memory that no reset initializes: after power-on it holds
+// noise, which the magic, the geometry and the hash of the decoded copy
+// reject
+typedef struct {
+    uint32_t magic;                     // EPD_WARM_MAGIC while the record is valid
+    uint32_t hash;                      // FNV-1a of the frame
+    uint16_t width;                     // EPD_W, EPD_H of the panel it was saved for
+    uint16_t height;
+    uint32_t packed;                    // Bytes of the copy in data, 0 for the hash only
+    uint8_t data[EPD_WARM_COPY ? EPD_WARM_COPY : 1];   // One unused byte when there is no copy
+} EPD_WarmRecord_t;
+
+static RTC_NOINIT_ATTR EPD_WarmRecord_t s_warm;
+
+static uint32_t EPD_WarmBoot_Hash(const uint8_t *frame) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        h = (h ^ frame[i]) * 16777619u;
+    }
+    return h;
+}
+
+static bool EPD_WarmBoot_Valid(void) {
+    return s_warm.magic == EPD_WARM_MAGIC && s_warm.width == EPD_W && s_warm.height == EPD_H &&
+           s_warm.packed <= EPD_WARM_COPY;
+}
+
+esp_err_t EPD_WarmBoot_Save(void) {
+    const uint8_t *shown = EPD_Shown();
+    if (shown == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    EPD_Asset_t copy;
+
+    s_warm.magic = 0;
+    s_warm.hash = EPD_WarmBoot_Hash(shown);
+    s_warm.width = EPD_W;
+    s_warm.height = EPD_H;
+    s_warm.packed = 0;
+    if (EPD_WARM_COPY > 0 &&
+        EPD_Asset_Encode(shown, EPD_W, EPD_H, s_warm.data, EPD_WARM_COPY, &copy) == ESP_OK) {
+        s_warm.packed = copy.size;
+    }
+    s_warm.magic = EPD_WARM_MAGIC;
+    return ESP_OK;
+}
+
+esp_err_t EPD_WarmBoot_Restore(uint8_t *frame) {
+    if (!EPD_WarmBoot_Valid() || s_warm.packed == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    // Decoded straight into the mirror when the caller wants no copy
+    uint8_t *out = (frame != NULL) ? frame : (uint8_t *)EPD_Arena_OldRam();
+    if (out == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const EPD_Asset_t copy = {
+        .data = s_warm.data,
+        .size = s_warm.packed,
+        .raw_size = EPD_FRAME_SIZE,
+        .width = EPD_W,
+        .height = EPD_H,
+        .rotate = ROTATE_0,
+        .format = EPD_ASSET_CANVAS,
+        .compression = EPD_ASSET_PACKBITS,
+    };
+    if (EPD_Asset_Decode(&copy, out, EPD_FRAME_SIZE) != ESP_OK || EPD_WarmBoot_Hash(out) != s_warm.hash) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    EPD_Display_Seed(out);
+    return ESP_OK;
+}
+
+esp_err_t EPD_WarmBoot_Verify(const uint8_t *frame) {
+    if (!EPD_WarmBoot_Valid()) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (EPD_WarmBoot_Hash(frame) != s_warm.hash) {
+        return ESP_ERR_INVALID_CRC;
+    }
+    EPD_Display_Seed(frame);
+    return ESP_OK;
+}
+
+void EPD_WarmBoot_Forget(void) {
+    s_warm.magic = 0;
+}
+
+void EPD_WarmBoot_GetInfo(EPD_WarmBootInfo_t *info) {
+    memset(info, 0, sizeof(*info));
+    if (!EPD_WarmBoot_Valid()) {
+        return;
+    }
+    info->valid = true;
+    info->copy = (s_warm.packed != 0);
+    info->hash = s_warm.hash;
+    info->size = offsetof(EPD_WarmRecord_t, data) + s_warm.packed;
+}
+
+const void *EPD_WarmBoot_Record(size_t *size) {
+    if (!EPD_WarmBoot_Valid()) {
+        return NULL;
+    }
+    *size = offsetof(EPD_WarmRecord_t, data) + s_warm.packed;
+    return &s_warm;
+}
+
+esp_err_t EPD_WarmBoot_Import(const void *record, size_t size) {
+    const EPD_WarmRecord_t *r = record;
+    size_t header = offsetof(EPD_WarmRecord_t, data);
+    if (r == NULL || size < header || r->magic != EPD_WARM_MAGIC || r->width != EPD_W ||
+        r->height != EPD_H || r->packed > EPD_WARM_COPY || size != header + r->packed) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Valid again only once the rest is in place
+    s_warm.magic = 0;
+    memcpy((uint8_t *)&s_warm + sizeof(s_warm.magic), (const uint8_t *)record + sizeof(s_warm.magic),
+           size - sizeof(s_warm.magic));
+    s_warm.magic = EPD_WARM_MAGIC;
+    return ESP_OK;
+}
@@ -5,6 +5,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "epaper_driver.h"
+#include "epaper_arena.h"
 #include "esp_log.h"
 
 static const char *TAG = "example_2.13";
@@ -17,15 +18,12 @@ void app_main(void)
     EPD_Init();
     EPD_Clear();
 
-    // The display resolution is 122(W) x 250(H) but driver handles buffer alignment
-    // Buffer size calculation logic handling byte alignment:
-    uint16_t w_bytes = (EPD_W % 8 == 0) ? (EPD_W / 8) : (EPD_W / 8 + 1);
-    uint32_t buf_size = w_bytes * EPD_H;
-
-    ESP_LOGI(TAG, "Allocating frame buffer: %lu bytes", buf_size);
-    uint8_t *black_image = (uint8_t*)heap_caps_malloc(buf_size, MALLOC_CAP_DMA);
-    if (!black_image) {
-        ESP_LOGE(TAG, "Failed to allocate memory!");
+    // Frame buffer from the driver's arena (EPD_FRAME_SIZE bytes, DMA-capable
+    // unless PSRAM placement is selected in menuconfig)
+    EPD_ArenaConfig_t arena = EPD_ARENA_CONFIG_DEFAULT();
+    uint8_t *black_image = NULL;
+    if (EPD_Arena_Init(&arena) != ESP_OK || (black_image = EPD_Arena_Frame(0)) == NULL) {
+        ESP_LOGE(TAG, "Failed to reserve frame buffer!");
         return;
     }
 
@@ -42,5 +40,5 @@ void app_main(void)
     ESP_LOGI(TAG, "Display updated");
 
     EPD_Sleep();
-    free(black_image);
+    EPD_Arena_Deinit();
 }
@@ -5,8 +5,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "epaper_driver.h"
+#include "epaper_arena.h"
 #include "esp_log.h"
-#include "esp_heap_caps.h"
 
 static const char *TAG = "example_4.2";
 
@@ -18,15 +18,12 @@ void app_main(void)
     EPD_Init();
     EPD_Clear();
 
-    // The display resolution is 400x300.
-    // Buffer size = 400 * 300 / 8 = 15000 bytes
-    uint32_t buf_size = (EPD_W * EPD_H) / 8;
-
-    ESP_LOGI(TAG, "Allocating frame buffer: %lu bytes", buf_size);
-    // Use SPIRAM if available for larger buffers, though 15KB fits in internal safely
-    uint8_t *black_image = (uint8_t*)heap_caps_malloc(buf_size, MALLOC_CAP_DEFAULT);
-    if (!black_image) {
-        ESP_LOGE(TAG, "Failed to allocate memory!");
+    // Frame buffer from the driver's arena (EPD_FRAME_SIZE bytes, DMA-capable
+    // unless PSRAM placement is selected in menuconfig)
+    EPD_ArenaConfig_t arena = EPD_ARENA_CONFIG_DEFAULT();
+    uint8_t *black_image = NULL;
+    if (EPD_Arena_Init(&arena) != ESP_OK || (black_image = EPD_Arena_Frame(0)) == NULL) {
+        ESP_LOGE(TAG, "Failed to reserve frame buffer!");
         return;
     }
 
@@ -44,5 +41,5 @@ void app_main(void)
     ESP_LOGI(TAG, "Display updated");
 
     EPD_Sleep();
-    free(black_image);
+    EPD_Arena_Deinit();
 }
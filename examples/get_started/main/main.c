@@ -8,11 +8,12 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "epaper_driver.h"
+#include "epaper_arena.h"
 #include "esp_log.h"
 
 static const char *TAG = "example";
 
-// Allocate buffer in PSRAM if available, otherwise in Heap
+// Framebuffer from the driver's arena (placement set in menuconfig)
 // For 4.2" (400x300), buffer is ~15KB (1-bit), small enough for internal RAM
 static uint8_t *image_buffer = NULL;
 
@@ -29,21 +30,14 @@ void app_main(void)
     // 3. Clear the display to white
     EPD_Clear();
 
-    // 4. Allocate memory for the image buffer
+    // 4. Get the image buffer from the framebuffer arena
     // Width and Height are available from the driver headers/macros
     uint16_t width = EPD_W;
     uint16_t height = EPD_H;
-    uint32_t buf_size = (width * height) / 8;
-    
-    // Ensure width is byte-aligned for buffer calculation
-    if (width % 8 != 0) {
-        buf_size = ((width / 8) + 1) * height;
-    }
 
-    ESP_LOGI(TAG, "Allocating buffer size: %lu bytes", buf_size);
-    image_buffer = (uint8_t*)malloc(buf_size);
-    if (!image_buffer) {
-        ESP_LOGE(TAG, "Failed to allocate memory for image buffer");
+    EPD_ArenaConfig_t arena = EPD_ARENA_CONFIG_DEFAULT();
+    if (EPD_Arena_Init(&arena) != ESP_OK || (image_buffer = EPD_Arena_Frame(0)) == NULL) {
+        ESP_LOGE(TAG, "Failed to reserve the image buffer");
         return;
     }
 
@@ -73,8 +67,8 @@ void app_main(void)
     // 8. Put display to sleep to save power
     EPD_Sleep();
 
-    // Free memory
-    free(image_buffer);
+    // Release the arena
+    EPD_Arena_Deinit();
     
     ESP_LOGI(TAG, "Example finished.");
 }
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Compare two epaper_bench result files.
+
+Usage: compare_bench.py BASELINE.jsonl CANDIDATE.jsonl [--threshold PCT]
+
+Matches results by panel/bench/variant, prints the change of the median
+time per operation and of the SPI traffic, and exits with status 1 when any
+benchmark got slower than the threshold (default 10 %) or sends more SPI
+transactions than before.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("{"):
+                continue
+            r = json.loads(line)
+            results[(r["panel"], r["bench"], r["variant"])] = r
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline")
+    parser.add_argument("candidate")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent (default 10)")
+    args = parser.parse_args()
+
+    base = load(args.baseline)
+    cand = load(args.candidate)
+    regressions = 0
+
+    print(f"{'benchmark':40} {'base ns/op':>12} {'new ns/op':>12} {'change':>8} {'spi trans':>14}")
+    for key in sorted(base.keys() & cand.keys()):
+        b, c = base[key], cand[key]
+        old, new = b["ns_per_op_median"], c["ns_per_op_median"]
+        change = (new - old) / old * 100.0 if old else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressions += 1
+        if c["spi_transactions"] > b["spi_transactions"]:
+            flag += "  MORE SPI"
+            regressions += 1
+        name = "/".join(key)
+        trans = f"{b['spi_transactions']}->{c['spi_transactions']}"
+        print(f"{name:40} {old:12.2f} {new:12.2f} {change:+7.1f}% {trans:>14}{flag}")
+
+    for key in sorted(base.keys() - cand.keys()):
+        print(f"{'/'.join(key):40} missing from candidate")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
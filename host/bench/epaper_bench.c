@@ -0,0 +1,579 @@
+/*
+ * Host benchmark for the drawing, text, picture and transfer paths
+ *
+ * Usage: epaper_bench_<panel> [filter]
+ *
+ * Runs every benchmark whose "bench/variant" name contains filter (all when
+ * omitted) and prints one JSON object per line on stdout:
+ *
+ *   {"panel":"4.2","bench":"set_pixel","variant":"rot90","ops":120000,
+ *    "reps":7,"ns_per_op_min":2.1,"ns_per_op_median":2.2,
+ *    "spi_bytes":0,"spi_transactions":0}
+ *
+ * Each benchmark runs `reps` times; min and median are per operation. SPI
+ * counters come from the stubbed transport and cover one repetition.
+ * Compare two result files with compare_bench.py.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "epaper_driver.h"
+#include "epaper_arena.h"
+#include "epaper_numfield.h"
+#include "epaper_render.h"
+#include "epaper_raster.h"
+#include "epaper_chart.h"
+#include "epaper_image.h"
+#include "host_transport.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define BENCH_REPS 7
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_color[EPD_FRAME_SIZE];
+static uint8_t s_picture[64 * 64 / 8];
+
+typedef struct {
+    const char *bench;
+    const char *variant;
+    uint32_t ops;                   // Operations per repetition
+    void (*setup)(uint32_t arg);    // Not timed
+    void (*run)(uint32_t ops, uint32_t arg);
+    uint32_t arg;
+} bench_t;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Setup helpers
+
+static void setup_canvas(uint32_t rotate) {
+    host_dma_capable = true;
+    Paint_NewImage(s_frame, EPD_W, EPD_H, rotate, WHITE);
+    EPD_Full(WHITE);
+}
+
+static void setup_canvas_color(uint32_t rotate) {
+    uint8_t *planes[] = { s_frame, s_color };
+    Paint_NewImagePlanes(planes, 2, EPD_W, EPD_H, rotate, WHITE);
+    EPD_Full(WHITE);
+}
+
+static void setup_panel(uint32_t arg) {
+    (void)arg;
+    EPD_Arena_Deinit(); // no panel mirror: 0x26 sync off
+    setup_canvas(ROTATE_0);
+    EPD_Init();
+}
+
+// Arena with only the panel mirror, so partial updates keep 0x26 in sync
+static void setup_panel_old_ram(uint32_t arg) {
+    EPD_ArenaConfig_t arena = { .placement = EPD_ARENA_INTERNAL_DMA, .old_ram = true };
+    setup_panel(arg);
+    EPD_Arena_Init(&arena);
+    EPD_Display(s_frame);
+}
+
+// Frame in memory the SPI DMA cannot read (PSRAM): goes through the bounce buffers
+static void setup_panel_bounced(uint32_t arg) {
+    setup_panel(arg);
+    host_dma_capable = false;
+}
+
+static void setup_panel_fast(uint32_t arg) {
+    (void)arg;
+    setup_canvas(ROTATE_0);
+    EPD_Init_Fast(Fast_Seconds_1_5s);
+}
+
+// Benchmarks
+
+static void run_set_pixel(uint32_t ops, uint32_t arg) {
+    uint32_t n = 0;
+    (void)arg;
+    while (n < ops) {
+        for (uint16_t y = 0; y < Paint.Height && n < ops; y++) {
+            for (uint16_t x = 0; x < Paint.Width && n < ops; x++, n++) {
+                Paint_SetPixel(x, y, ((x ^ y) & 1) ? BLACK : ((x & 2) ? RED : WHITE));
+            }
+        }
+    }
+}
+
+static void run_full(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Full((i & 1) ? BLACK : WHITE);
+    }
+}
+
+static void run_draw_line(uint32_t ops, uint32_t arg) {
+    for (uint32_t i = 0; i < ops; i++) {
+        uint16_t o = i % 16;
+        switch (arg) {
+            case 0: EPD_DrawLine(0, o, Paint.Width - 1, o, BLACK); break;
+            case 1: EPD_DrawLine(o, 0, o, Paint.Height - 1, BLACK); break;
+            default: EPD_DrawLine(o, 0, Paint.Width - 1 - o, Paint.Height - 1, BLACK); break;
+        }
+    }
+}
+
+static void run_draw_rectangle(uint32_t ops, uint32_t arg) {
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_DrawRectangle(10, 10, Paint.Width - 10, Paint.Height - 10, (i & 1) ? BLACK : WHITE, arg);
+    }
+}
+
+static void run_draw_circle(uint32_t ops, uint32_t arg) {
+    uint16_t r = (Paint.Height / 2) - 10;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_DrawCircle(Paint.Width / 2, Paint.Height / 2, r, (i & 1) ? BLACK : WHITE, arg);
+    }
+}
+
+// Gauge needle from the center to the rim at a sweeping angle: filled
+// triangle as one polygon (arg 0), or as the fan of EPD_DrawLine from each
+// base pixel to the tip it used to take (arg 1)
+static void run_needle(uint32_t ops, uint32_t fan) {
+    int16_t cx = Paint.Width / 2, cy = Paint.Height / 2, r = Paint.Height / 2 - 10;
+    for (uint32_t i = 0; i < ops; i++) {
+        int16_t tx = cx + (int16_t)((i * 7) % (2 * r)) - r, ty = cy - r + (int16_t)((i * 3) % 20);
+        if (fan) {
+            for (int16_t b = -4; b <= 4; b++) {
+                EPD_DrawLine(cx + b, cy, tx, ty, (i & 1) ? BLACK : WHITE);
+            }
+            continue;
+        }
+        EPD_Point_t needle[] = { { cx - 4, cy }, { tx, ty }, { cx + 5, cy } };
+        EPD_FillPolygon(needle, 3, EPD_FILL_NONZERO, (i & 1) ? BLACK : WHITE);
+    }
+}
+
+static void run_thick_line(uint32_t ops, uint32_t cap) {
+    int16_t cx = Paint.Width / 2, cy = Paint.Height / 2, r = Paint.Height / 2 - 10;
+    for (uint32_t i = 0; i < ops; i++) {
+        int16_t tx = cx + (int16_t)((i * 7) % (2 * r)) - r;
+        EPD_DrawThickLine(cx, cy, tx, cy - r, 5, (EPD_LineCap_t)cap, (i & 1) ? BLACK : WHITE);
+    }
+}
+
+// 270 degree gauge scale 8 pixels wide
+static void run_gauge_arc(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    uint16_t r = Paint.Height / 2 - 10;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_DrawArc(Paint.Width / 2, Paint.Height / 2, r, 8, 135, 45, (i & 1) ? BLACK : WHITE);
+    }
+}
+
+// Strip chart of the full canvas width, 60 pixels high, one sample per
+// push: scrolled in place under ROTATE_0 (arg 0) and ROTATE_90 (arg 90), or
+// redrawn from the whole history with EPD_DrawLine as before (arg 1)
+static EPD_Chart_t s_chart;
+
+static int32_t chart_sample(uint32_t i) {
+    return (int32_t)((i * 37) % 101);
+}
+
+static void setup_chart(uint32_t arg) {
+    EPD_ChartConfig_t cfg = EPD_CHART_CONFIG_DEFAULT();
+    setup_canvas(arg == 90 ? ROTATE_90 : ROTATE_0);
+    cfg.y = 20;
+    cfg.width = Paint.Width;
+    cfg.height = 60;
+    EPD_Chart_Init(&s_chart, &cfg);
+    for (uint32_t i = 0; i < s_chart.shown; i++) {
+        EPD_Chart_Push(&s_chart, chart_sample(i), NULL);
+    }
+}
+
+static void run_chart(uint32_t ops, uint32_t arg) {
+    EPD_Rect_t dirty;
+    for (uint32_t i = 0; i < ops; i++) {
+        if (arg != 1) {
+            EPD_Chart_Push(&s_chart, chart_sample(i), &dirty);
+            continue;
+        }
+        const EPD_ChartConfig_t *cfg = &s_chart.cfg;
+        EPD_ClearWindows(cfg->x, cfg->y, cfg->x + cfg->width, cfg->y + cfg->height, WHITE);
+        for (uint16_t c = 1; c < cfg->width; c++) {
+            EPD_DrawLine(c - 1, cfg->y + 59 - chart_sample(i + c - 1) * 59 / 100,
+                         c, cfg->y + 59 - chart_sample(i + c) * 59 / 100, BLACK);
+        }
+    }
+}
+
+// Full-canvas image streamed from a temporary file: PBM P4 drawn upright
+// (arg 0) or turned 90 degrees (arg 90), 8-bit PGM P5 thresholded (arg 1)
+static FILE *s_image_file;
+
+static void setup_image(uint32_t arg) {
+    setup_canvas(ROTATE_0);
+    if (s_image_file) fclose(s_image_file);
+    s_image_file = tmpfile();
+    uint16_t w = (arg == 90) ? EPD_H : EPD_W, h = (arg == 90) ? EPD_W : EPD_H;
+    fprintf(s_image_file, "%s\n%u %u\n%s", (arg == 1) ? "P5" : "P4", w, h, (arg == 1) ? "255\n" : "");
+    for (uint32_t v = 0; v < h; v++) {
+        uint32_t n = (arg == 1) ? w : (w + 7) / 8u;
+        for (uint32_t u = 0; u < n; u++) fputc((u * 7 + v * 3) & 0xFF, s_image_file);
+    }
+}
+
+static void run_image(uint32_t ops, uint32_t arg) {
+    EPD_ImageOptions_t opt = EPD_IMAGE_OPTIONS_DEFAULT();
+    opt.rotate = (arg == 90) ? ROTATE_90 : ROTATE_0;
+    for (uint32_t i = 0; i < ops; i++) {
+        rewind(s_image_file);
+        EPD_Image_Draw(s_image_file, 0, 0, &opt, NULL);
+    }
+}
+
+static void run_show_string(uint32_t ops, uint32_t size) {
+    static const char text[] = "The quick brown fox 0123456789";
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_ShowString(0, (i * size) % (Paint.Height - size), text, size, BLACK);
+    }
+}
+
+// Counter ticking by one: every digit redrawn vs. only the ones that changed
+static void run_show_num(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_ShowNum(8, 8, 100000 + i, 6, 16, BLACK);
+    }
+}
+
+static EPD_NumField_t s_field;
+
+static void setup_numfield(uint32_t arg) {
+    EPD_NumFieldConfig_t cfg = EPD_NUMFIELD_CONFIG_DEFAULT();
+    cfg.x = 8;
+    cfg.y = 8;
+    cfg.digits = 6;
+    cfg.frac = arg;
+    setup_canvas(ROTATE_0);
+    EPD_NumField_Init(&s_field, &cfg);
+    EPD_NumField_Set(&s_field, 99999, NULL);
+}
+
+static void run_numfield(uint32_t ops, uint32_t arg) {
+    EPD_Rect_t dirty;
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_NumField_Set(&s_field, 100000 + i, &dirty);
+    }
+}
+
+static void setup_picture(uint32_t arg) {
+    uint32_t seed = 12345;
+    setup_canvas(arg);
+    for (size_t i = 0; i < sizeof(s_picture); i++) {
+        seed = seed * 1103515245 + 12345;
+        s_picture[i] = seed >> 16;
+    }
+}
+
+static void run_show_picture(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_ShowPicture((i * 8) % (Paint.Width - 64), 16, 64, 64, s_picture, BLACK);
+    }
+}
+
+// 32x32 sprite through its mask at an unaligned X
+static void run_blit_masked(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Blit(3 + (i * 8) % (Paint.Width - 64), 16, 32, 32, s_picture, s_picture + 128, EPD_ROP_COPY);
+    }
+}
+
+// Dashboard-like display list: text rows, gauges and a picture
+static EPD_DrawCmd_t s_list[40];
+static size_t s_list_len;
+
+static void render_init(uint32_t workers, uint16_t rotate) {
+    EPD_RenderConfig_t cfg = EPD_RENDER_CONFIG_DEFAULT();
+    cfg.workers = workers;
+    setup_picture(rotate);
+    EPD_Render_Init(&cfg);
+}
+
+static void setup_render(uint32_t workers) {
+    render_init(workers, ROTATE_0);
+
+    size_t n = 0;
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_FILL, .color = WHITE };
+    for (uint16_t row = 0; row < 8; row++) {
+        EPD_DrawCmd_t text = { .op = EPD_CMD_STRING, .size = 16, .x0 = 4, .y0 = 4 + row * 20 };
+        strcpy(text.text, "Sensor 0123 OK");
+        s_list[n++] = text;
+        s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_NUM, .mode = 6, .size = 16,
+                                       .x0 = 140, .y0 = 4 + row * 20, .num = 4711 * row };
+    }
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_RECT, .mode = 1, .x0 = 4, .y0 = Paint.Height - 30,
+                                   .x1 = Paint.Width / 2, .y1 = Paint.Height - 10 };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_CIRCLE, .mode = 1, .x0 = Paint.Width - 40,
+                                   .y0 = Paint.Height - 40, .x1 = 30 };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_PICTURE, .x0 = Paint.Width - 72, .y0 = 8,
+                                   .x1 = 64, .y1 = 64, .image = s_picture };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = 0, .y0 = 0,
+                                   .x1 = Paint.Width - 1, .y1 = Paint.Height - 1 };
+    s_list_len = n;
+}
+
+// Shapes that cross every band under ROTATE_90: a big filled circle, the
+// diagonals and text columns. Two workers should take about the serial time.
+static void setup_render_shapes(uint32_t workers) {
+    render_init(workers, ROTATE_90);
+
+    uint16_t r = ((Paint.Width < Paint.Height) ? Paint.Width : Paint.Height) / 2 - 10;
+    size_t n = 0;
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_FILL, .color = WHITE };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_CIRCLE, .mode = 1, .x0 = Paint.Width / 2,
+                                   .y0 = Paint.Height / 2, .x1 = r };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = 0, .y0 = 0,
+                                   .x1 = Paint.Width - 1, .y1 = Paint.Height - 1 };
+    s_list[n++] = (EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = 0, .y0 = Paint.Height - 1,
+                                   .x1 = Paint.Width - 1, .y1 = 0 };
+    for (uint16_t y = 4; y + 16 <= Paint.Height && n < sizeof(s_list) / sizeof(s_list[0]); y += 30) {
+        EPD_DrawCmd_t text = { .op = EPD_CMD_STRING, .size = 16, .x0 = 4, .y0 = y };
+        strcpy(text.text, "Outdoor 23.5 C 1013 hPa");
+        s_list[n++] = text;
+    }
+    s_list_len = n;
+}
+
+static void run_render(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Render(s_list, s_list_len);
+    }
+}
+
+static void run_display(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Display(s_frame);
+    }
+}
+
+static void run_display_fast(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Display_Fast(s_frame);
+    }
+}
+
+static void run_display_part(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Display_Part(0, 0, EPD_W, EPD_H, s_frame);
+    }
+}
+
+static void run_display_color(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Display_Color(s_frame, s_color);
+    }
+}
+
+// 100x40 widget at an unaligned X: copy it out and send it packed, or send it
+// straight from the frame
+#define WIDGET_X 13
+#define WIDGET_Y 20
+#define WIDGET_W 100
+#define WIDGET_H 40
+
+static void run_display_part_widget(uint32_t ops, uint32_t stride) {
+    static uint8_t packed[((WIDGET_W + 7 + 7) / 8) * WIDGET_H];
+    uint16_t xb = WIDGET_X / 8, wb = (WIDGET_X + WIDGET_W + 7) / 8 - xb;
+
+    for (uint32_t i = 0; i < ops; i++) {
+        if (stride) {
+            EPD_Display_Part_Stride(WIDGET_X, WIDGET_Y, WIDGET_W, WIDGET_H, s_frame);
+            continue;
+        }
+        for (uint16_t r = 0; r < WIDGET_H; r++) {
+            memcpy(packed + r * wb, s_frame + (WIDGET_Y + r) * EPD_FRAME_STRIDE + xb, wb);
+        }
+        EPD_Display_Part(xb * 8, WIDGET_Y, wb * 8, WIDGET_H, packed);
+    }
+}
+
+// The widget changes every frame (a blinking cursor): with a panel mirror each
+// partial update first rewrites the previous change in 0x26
+static void run_display_part_toggle(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        for (uint16_t r = 0; r < WIDGET_H; r++) {
+            s_frame[(WIDGET_Y + r) * EPD_FRAME_STRIDE + WIDGET_X / 8] ^= 0xFF;
+        }
+        EPD_Display_Part_Stride(WIDGET_X, WIDGET_Y, WIDGET_W, WIDGET_H, s_frame);
+    }
+}
+
+// In-place cleanup of a worn widget: two partial waveforms instead of a fast
+// or full refresh of the whole panel
+static void run_display_part_clean(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Display_Part_Clean(WIDGET_X, WIDGET_Y, WIDGET_W, WIDGET_H, s_frame);
+    }
+}
+
+// Three widgets changed in the same frame: one partial update each, or all
+// windows written first and refreshed together
+static const EPD_Rect_t s_widgets[] = {
+    { 13, 20, 100, 40 },
+    { 130, 4, 64, 24 },
+    { 40, 80, 150, 16 },
+};
+
+static void run_display_part_widgets(uint32_t ops, uint32_t multi) {
+    size_t count = sizeof(s_widgets) / sizeof(s_widgets[0]);
+
+    for (uint32_t i = 0; i < ops; i++) {
+        if (multi) {
+            EPD_Display_Part_Multi(s_widgets, count, s_frame);
+            continue;
+        }
+        for (size_t w = 0; w < count; w++) {
+            const EPD_Rect_t *r = &s_widgets[w];
+            EPD_Display_Part_Stride(r->x, r->y, r->width, r->height, s_frame);
+        }
+    }
+}
+
+// Sleep between widget updates: the wake restores the registers, and after
+// EPD_SLEEP_DEEP both RAMs from the panel mirror
+static void run_sleep_wake_part(uint32_t ops, uint32_t mode) {
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Sleep_Mode((EPD_SleepMode_t)mode);
+        for (uint16_t r = 0; r < WIDGET_H; r++) {
+            s_frame[(WIDGET_Y + r) * EPD_FRAME_STRIDE + WIDGET_X / 8] ^= 0xFF;
+        }
+        EPD_Display_Part_Stride(WIDGET_X, WIDGET_Y, WIDGET_W, WIDGET_H, s_frame);
+    }
+}
+
+static void run_clear(uint32_t ops, uint32_t arg) {
+    (void)arg;
+    for (uint32_t i = 0; i < ops; i++) {
+        EPD_Clear();
+    }
+}
+
+static const bench_t s_benches[] = {
+    { "set_pixel", "rot0", 200000, setup_canvas, run_set_pixel, ROTATE_0 },
+    { "set_pixel", "rot90", 200000, setup_canvas, run_set_pixel, ROTATE_90 },
+    { "set_pixel", "rot180", 200000, setup_canvas, run_set_pixel, ROTATE_180 },
+    { "set_pixel", "rot270", 200000, setup_canvas, run_set_pixel, ROTATE_270 },
+    { "set_pixel", "rot0_2planes", 200000, setup_canvas_color, run_set_pixel, ROTATE_0 },
+    { "set_pixel", "rot90_2planes", 200000, setup_canvas_color, run_set_pixel, ROTATE_90 },
+    { "full", "1plane", 2000, setup_canvas, run_full, 0 },
+    { "full", "2planes", 2000, setup_canvas_color, run_full, 0 },
+    { "draw_line", "horizontal", 2000, setup_canvas, run_draw_line, 0 },
+    { "draw_line", "vertical", 2000, setup_canvas, run_draw_line, 1 },
+    { "draw_line", "diagonal", 2000, setup_canvas, run_draw_line, 2 },
+    { "draw_rectangle", "outline", 2000, setup_canvas, run_draw_rectangle, 0 },
+    { "draw_rectangle", "filled", 50, setup_canvas, run_draw_rectangle, 1 },
+    { "draw_circle", "hollow", 2000, setup_canvas, run_draw_circle, 0 },
+    { "draw_circle", "filled", 50, setup_canvas, run_draw_circle, 1 },
+    { "raster", "needle_polygon", 2000, setup_canvas, run_needle, 0 },
+    { "raster", "needle_line_fan", 2000, setup_canvas, run_needle, 1 },
+    { "raster", "thick_line_w5_round", 2000, setup_canvas, run_thick_line, EPD_CAP_ROUND },
+    { "raster", "gauge_arc_270deg", 500, setup_canvas, run_gauge_arc, 0 },
+    { "chart", "push_scroll_rot0", 2000, setup_chart, run_chart, 0 },
+    { "chart", "push_scroll_rot90", 2000, setup_chart, run_chart, 90 },
+    { "chart", "redraw_history", 100, setup_chart, run_chart, 1 },
+    { "image", "pbm_full_rot0", 200, setup_image, run_image, 0 },
+    { "image", "pbm_full_rot90", 200, setup_image, run_image, 90 },
+    { "image", "pgm_full_threshold", 50, setup_image, run_image, 1 },
+    { "show_string", "font8", 2000, setup_canvas, run_show_string, 8 },
+    { "show_string", "font12", 2000, setup_canvas, run_show_string, 12 },
+    { "show_string", "font16", 1000, setup_canvas, run_show_string, 16 },
+    { "show_string", "font24", 500, setup_canvas, run_show_string, 24 },
+    { "show_num", "6digits_tick", 1000, setup_canvas, run_show_num, 0 },
+    { "numfield", "6digits_tick", 1000, setup_numfield, run_numfield, 0 },
+    { "numfield", "6digits_2frac_tick", 1000, setup_numfield, run_numfield, 2 },
+    { "show_picture", "64x64_rot0", 1000, setup_picture, run_show_picture, ROTATE_0 },
+    { "show_picture", "64x64_rot90", 1000, setup_picture, run_show_picture, ROTATE_90 },
+    { "blit", "32x32_mask_rot0", 5000, setup_picture, run_blit_masked, ROTATE_0 },
+    { "blit", "32x32_mask_rot90", 5000, setup_picture, run_blit_masked, ROTATE_90 },
+    { "blit", "32x32_mask_rot180", 5000, setup_picture, run_blit_masked, ROTATE_180 },
+    { "render", "dashboard_1worker", 200, setup_render, run_render, 1 },
+    { "render", "dashboard_2workers", 200, setup_render, run_render, 2 },
+    { "render", "shapes_1worker", 200, setup_render_shapes, run_render, 1 },
+    { "render", "shapes_2workers", 200, setup_render_shapes, run_render, 2 },
+    { "display", "full", 50, setup_panel, run_display, 0 },
+    { "display", "full_bounced", 50, setup_panel_bounced, run_display, 0 },
+    { "display", "fast", 50, setup_panel_fast, run_display_fast, 0 },
+    { "display", "part_full_frame", 50, setup_panel, run_display_part, 0 },
+    { "display", "part_widget_packed", 50, setup_panel, run_display_part_widget, 0 },
+    { "display", "part_widget_stride", 50, setup_panel, run_display_part_widget, 1 },
+    { "display", "part_toggle", 50, setup_panel, run_display_part_toggle, 0 },
+    { "display", "part_toggle_old_ram", 50, setup_panel_old_ram, run_display_part_toggle, 0 },
+    { "display", "part_clean_widget", 50, setup_panel_old_ram, run_display_part_clean, 0 },
+    { "display", "part_3widgets_separate", 50, setup_panel, run_display_part_widgets, 0 },
+    { "display", "part_3widgets_multi", 50, setup_panel, run_display_part_widgets, 1 },
+    { "display", "color", 50, setup_panel, run_display_color, 0 },
+    { "display", "clear", 50, setup_panel, run_clear, 0 },
+    { "sleep", "wake_part_retain", 50, setup_panel_old_ram, run_sleep_wake_part, EPD_SLEEP_RETAIN },
+    { "sleep", "wake_part_deep", 50, setup_panel_old_ram, run_sleep_wake_part, EPD_SLEEP_DEEP },
+};
+
+static void run_bench(const bench_t *b) {
+    uint64_t samples[BENCH_REPS];
+    host_transport_stats_t spi = { 0 };
+
+    for (int r = 0; r < BENCH_REPS; r++) {
+        b->setup(b->arg);
+        host_transport_reset();
+        uint64_t t0 = now_ns();
+        b->run(b->ops, b->arg);
+        samples[r] = now_ns() - t0;
+        if (r == 0) {
+            spi = host_transport_stats;
+        }
+    }
+    qsort(samples, BENCH_REPS, sizeof(samples[0]), cmp_u64);
+
+    printf("{\"panel\":\"%s\",\"bench\":\"%s\",\"variant\":\"%s\",\"ops\":%u,\"reps\":%d,"
+           "\"ns_per_op_min\":%.2f,\"ns_per_op_median\":%.2f,"
+           "\"spi_bytes\":%llu,\"spi_transactions\":%u}\n",
+           PANEL_NAME, b->bench, b->variant, (unsigned)b->ops, BENCH_REPS,
+           (double)samples[0] / b->ops, (double)samples[BENCH_REPS / 2] / b->ops,
+           (unsigned long long)spi.bytes, (unsigned)spi.transactions);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    const char *filter = (argc > 1) ? argv[1] : NULL;
+    char name[64];
+
+    EPD_GPIOInit();
+
+    for (size_t i = 0; i < sizeof(s_benches) / sizeof(s_benches[0]); i++) {
+        const bench_t *b = &s_benches[i];
+        snprintf(name, sizeof(name), "%s/%s", b->bench, b->variant);
+        if (filter && strstr(name, filter) == NULL) continue;
+        run_bench(b);
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * Check of the build-time asset pipeline against the runtime drawing paths
+ *
+ * Usage: epaper_asset_check_<panel>
+ *
+ * The assets in assets/ are converted at build time by
+ * crowpanel_epaper_add_assets() (tools/epaper_asset.py), then:
+ *  - the PNG and PBM copies of the sprite must decode to the same bits
+ *  - the sprite converted for each rotation and drawn with EPD_Asset_Draw
+ *    must leave the canvas exactly as EPD_Blit of the unrotated sprite does
+ *  - the full frame converted to the panel's RAM layout, raw and PackBits,
+ *    must reach RAM 0x24 byte for byte as EPD_Display sends the canvas frame
+ * Exit status is 0 when everything matches.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_asset.h"
+#include "host_transport.h"
+#include "check_assets.h"
+#include "check_assets_90.h"
+#include "check_assets_180.h"
+#include "check_assets_270.h"
+#include "check_assets_native.h"
+#include "check_assets_native_packbits.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_FRAME_SIZE];
+static uint8_t s_sprite[256];
+static uint8_t s_sent[EPD_NATIVE_FRAME_SIZE];
+static uint8_t s_expect[EPD_NATIVE_FRAME_SIZE];
+static int s_failures;
+
+static void fail(const char *what) {
+    printf("MISMATCH panel %s: %s\n", PANEL_NAME, what);
+    s_failures++;
+}
+
+static void check_sprite(void) {
+    uint8_t png[sizeof(s_sprite)];
+
+    if (EPD_Asset_Decode(&r0_sprite, s_sprite, sizeof(s_sprite)) != ESP_OK ||
+        EPD_Asset_Decode(&r0_sprite_rgba, png, sizeof(png)) != ESP_OK) {
+        fail("sprite does not decode");
+        return;
+    }
+    if (r0_sprite.raw_size != r0_sprite_rgba.raw_size || memcmp(s_sprite, png, r0_sprite.raw_size) != 0) {
+        fail("PNG and PBM sprites differ");
+    }
+}
+
+static void check_rotation(const EPD_Asset_t *asset) {
+    static const EPD_Rop_t rops[] = { EPD_ROP_COPY, EPD_ROP_XOR, EPD_ROP_AND };
+    uint16_t w = r0_sprite.width, h = r0_sprite.height;
+    char what[96];
+
+    Paint_NewImage(s_frame, EPD_W, EPD_H, asset->rotate, WHITE);
+    uint16_t xs[] = { 0, 7, (uint16_t)(Paint.Width - w), 13 };
+    uint16_t ys[] = { 0, 3, (uint16_t)(Paint.Height - h), (uint16_t)(Paint.Height - h - 5) };
+
+    for (size_t i = 0; i < sizeof(xs) / sizeof(xs[0]); i++) {
+        EPD_Rop_t rop = rops[i % (sizeof(rops) / sizeof(rops[0]))];
+
+        // Same patterned background on both canvases
+        for (size_t b = 0; b < EPD_FRAME_SIZE; b++) {
+            s_ref[b] = s_frame[b] = (uint8_t)(b * 37 + i);
+        }
+        Paint_NewImage(s_ref, EPD_W, EPD_H, asset->rotate, WHITE);
+        EPD_Blit(xs[i], ys[i], w, h, s_sprite, NULL, rop);
+        Paint_NewImage(s_frame, EPD_W, EPD_H, asset->rotate, WHITE);
+        if (EPD_Asset_Draw(asset, xs[i], ys[i], rop) != ESP_OK) {
+            snprintf(what, sizeof(what), "rotate %u: asset not drawn at (%u, %u)", asset->rotate, xs[i], ys[i]);
+            fail(what);
+        } else if (memcmp(s_frame, s_ref, EPD_FRAME_SIZE) != 0) {
+            snprintf(what, sizeof(what), "rotate %u: asset at (%u, %u) differs from EPD_Blit", asset->rotate, xs[i], ys[i]);
+            fail(what);
+        }
+    }
+
+    if (EPD_Asset_Draw(asset, Paint.Width - w + 1, 0, EPD_ROP_COPY) != ESP_ERR_INVALID_SIZE) {
+        fail("asset past the canvas edge not refused");
+    }
+    Paint_NewImage(s_frame, EPD_W, EPD_H, (asset->rotate + 90) % 360, WHITE);
+    if (EPD_Asset_Draw(asset, 0, 0, EPD_ROP_COPY) != ESP_ERR_INVALID_STATE) {
+        fail("asset for another rotation not refused");
+    }
+}
+
+static void check_display(const EPD_Asset_t *asset, const char *name) {
+    char what[96];
+
+    host_transport_capture(0x24, s_sent, sizeof(s_sent));
+    esp_err_t ret = EPD_Asset_Display(asset);
+    size_t len = host_transport_capture(0, NULL, 0);
+    if (ret != ESP_OK || len != EPD_NATIVE_FRAME_SIZE || memcmp(s_sent, s_expect, len) != 0) {
+        snprintf(what, sizeof(what), "%s frame differs from EPD_Display (%u bytes sent)", name, (unsigned)len);
+        fail(what);
+    }
+}
+
+int main(void) {
+    EPD_GPIOInit();
+    EPD_Init();
+
+    check_sprite();
+    check_rotation(&r0_sprite);
+    check_rotation(&r90_sprite);
+    check_rotation(&r180_sprite);
+    check_rotation(&r270_sprite);
+
+    // Reference: the canvas frame through EPD_Display (and its 2.13" rotation)
+    if (EPD_Asset_Decode(&r0_frame, s_frame, sizeof(s_frame)) != ESP_OK) {
+        fail("frame does not decode");
+        return 1;
+    }
+    host_transport_capture(0x24, s_expect, sizeof(s_expect));
+    EPD_Display(s_frame);
+    if (host_transport_capture(0, NULL, 0) != EPD_NATIVE_FRAME_SIZE) {
+        fail("EPD_Display frame not captured");
+        return 1;
+    }
+    check_display(&nr_frame, "raw native");
+    check_display(&np_frame, "PackBits native");
+    check_display(&r0_frame, "canvas");
+
+    EPD_Asset_t corrupt = np_frame;
+    corrupt.size -= 1;
+    if (EPD_Asset_Display(&corrupt) != ESP_ERR_INVALID_CRC) {
+        fail("truncated asset not refused");
+    }
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: assets match the runtime paths\n", PANEL_NAME);
+    return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Check of the word-wide framebuffer kernels against byte loops
+ *
+ * Usage: epaper_bits_check_<panel>
+ *
+ * Every kernel in epaper_bits.h runs on random buffers at every combination
+ * of start offsets within a word and lengths up to a few words, so each
+ * head/word/tail split and the unpaired byte path are covered, and is
+ * compared with the obvious byte-at-a-time definition. The bit-run kernels
+ * run at every bit offset, length and shift over a few words and are compared
+ * with a bit-at-a-time definition.
+ * Exit status is 0 when everything matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "epaper_bits.h"
+
+#define BUF 64
+#define MAX_LEN 40
+
+static uint32_t s_seed = 0x1234567;
+static int s_failures;
+
+static uint8_t rnd8(void) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return (uint8_t)s_seed;
+}
+
+static void fail(const char *kernel, size_t oa, size_t ob, size_t len) {
+    if (s_failures++ < 10) {
+        printf("MISMATCH %s: offsets %u/%u, length %u\n", kernel, (unsigned)oa, (unsigned)ob, (unsigned)len);
+    }
+}
+
+static void check(size_t oa, size_t ob, size_t len) {
+    _Alignas(4) uint8_t a[BUF], b[BUF], d[BUF], r[BUF];
+
+    for (size_t i = 0; i < BUF; i++) {
+        a[i] = rnd8();
+        b[i] = a[i];
+    }
+    // Sparse differences, so the spans have equal bytes and words around them
+    for (int k = rnd8() % 4; k > 0; k--) {
+        b[rnd8() % BUF] ^= 1 << (rnd8() % 8);
+    }
+    const uint8_t *pa = a + oa, *pb = b + ob;
+
+    memcpy(d, b, BUF);
+    memcpy(r, b, BUF);
+    EPD_Bits_Fill(d + ob, 0x5A, len);
+    memset(r + ob, 0x5A, len);
+    if (memcmp(d, r, BUF)) fail("fill", oa, ob, len);
+
+    memcpy(d, b, BUF);
+    memcpy(r, b, BUF);
+    EPD_Bits_Invert(d + ob, pa, len);
+    for (size_t i = 0; i < len; i++) r[ob + i] = ~pa[i];
+    if (memcmp(d, r, BUF)) fail("invert", oa, ob, len);
+
+    memcpy(d, b, BUF);
+    memcpy(r, b, BUF);
+    EPD_Bits_Or(d + ob, pa, len);
+    for (size_t i = 0; i < len; i++) r[ob + i] |= pa[i];
+    if (memcmp(d, r, BUF)) fail("or", oa, ob, len);
+
+    memcpy(d, b, BUF);
+    memcpy(r, b, BUF);
+    EPD_Bits_And(d + ob, pa, len);
+    for (size_t i = 0; i < len; i++) r[ob + i] &= pa[i];
+    if (memcmp(d, r, BUF)) fail("and", oa, ob, len);
+
+    memcpy(d, b, BUF);
+    memcpy(r, b, BUF);
+    EPD_Bits_Xor(d + ob, d + ob, pa, len);
+    for (size_t i = 0; i < len; i++) r[ob + i] ^= pa[i];
+    if (memcmp(d, r, BUF)) fail("xor", oa, ob, len);
+
+    uint32_t count = 0, diff = 0;
+    size_t first = len, last = 0;
+    for (size_t i = 0; i < len; i++) {
+        count += __builtin_popcount(pa[i]);
+        diff += __builtin_popcount(pa[i] ^ pb[i]);
+        if (pa[i] != pb[i]) {
+            if (first == len) first = i;
+            last = i;
+        }
+    }
+    if (EPD_Bits_Count(pa, len) != count) fail("count", oa, ob, len);
+    if (EPD_Bits_CountDiff(pa, pb, len) != diff) fail("count_diff", oa, ob, len);
+
+    size_t f = 0, l = 0;
+    bool differ = EPD_Bits_DiffSpan(pa, pb, len, &f, &l);
+    if (differ != (first < len) || (differ && (f != first || l != last))) fail("diff_span", oa, ob, len);
+}
+
+static void check_rects(void) {
+    _Alignas(4) uint8_t src[10 * 13], dst[10 * 13], ref[10 * 13];
+
+    for (size_t i = 0; i < sizeof(src); i++) {
+        src[i] = rnd8();
+        dst[i] = ref[i] = rnd8();
+    }
+    // 7 bytes x 9 rows at byte 2 of 13-byte rows
+    EPD_Bits_FillRect(dst + 2, 13, 7, 9, 0xC3);
+    EPD_Bits_CopyRect(dst + 3 * 13 + 1, 13, src, 13, 5, 4);
+    uint32_t n = EPD_Bits_CountRect(src + 2, 13, 7, 9), m = 0;
+    for (int r = 0; r < 9; r++) {
+        memset(ref + r * 13 + 2, 0xC3, 7);
+        for (int c = 0; c < 7; c++) m += __builtin_popcount(src[r * 13 + 2 + c]);
+    }
+    for (int r = 0; r < 4; r++) {
+        memcpy(ref + (3 + r) * 13 + 1, src + r * 13, 5);
+    }
+    if (memcmp(dst, ref, sizeof(dst)) || n != m) fail("rects", 0, 0, 7);
+}
+
+static int get_bit(const uint8_t *row, size_t i) {
+    return (row[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void put_bit(uint8_t *row, size_t i, int v) {
+    row[i / 8] = v ? (row[i / 8] | (0x80 >> (i % 8))) : (row[i / 8] & ~(0x80 >> (i % 8)));
+}
+
+#define RUN_BYTES 16
+
+// Bit runs [bit0, bit0 + nbits) of a RUN_BYTES row; returns the cases run
+static uint32_t check_bits(size_t bit0, size_t nbits) {
+    uint8_t src[RUN_BYTES], d[RUN_BYTES], r[RUN_BYTES];
+    uint32_t cases = 0;
+
+    for (size_t i = 0; i < RUN_BYTES; i++) src[i] = rnd8();
+    for (int f = 0; f < 2; f++) {
+        uint8_t fill = f ? 0xFF : 0x00;
+
+        memcpy(d, src, RUN_BYTES);
+        memcpy(r, src, RUN_BYTES);
+        EPD_Bits_FillBits(d, bit0, nbits, fill);
+        for (size_t i = 0; i < nbits; i++) put_bit(r, bit0 + i, f);
+        if (memcmp(d, r, RUN_BYTES)) fail("fill_bits", bit0, 0, nbits);
+
+        for (size_t shift = 0; shift <= nbits + 1; shift++, cases++) {
+            memcpy(d, src, RUN_BYTES);
+            memcpy(r, src, RUN_BYTES);
+            EPD_Bits_ShiftLeft(d, bit0, nbits, shift, fill);
+            for (size_t i = 0; i < nbits; i++) {
+                put_bit(r, bit0 + i, (i + shift < nbits) ? get_bit(src, bit0 + i + shift) : f);
+            }
+            if (memcmp(d, r, RUN_BYTES)) fail("shift_left", bit0, shift, nbits);
+
+            memcpy(d, src, RUN_BYTES);
+            memcpy(r, src, RUN_BYTES);
+            EPD_Bits_ShiftRight(d, bit0, nbits, shift, fill);
+            for (size_t i = 0; i < nbits; i++) {
+                put_bit(r, bit0 + i, (i >= shift) ? get_bit(src, bit0 + i - shift) : f);
+            }
+            if (memcmp(d, r, RUN_BYTES)) fail("shift_right", bit0, shift, nbits);
+        }
+    }
+
+    for (size_t i = 0; i < RUN_BYTES; i++) d[i] = r[i] = rnd8();
+    EPD_Bits_CopyBits(d, src, bit0, nbits);
+    for (size_t i = 0; i < nbits; i++) put_bit(r, bit0 + i, get_bit(src, bit0 + i));
+    if (memcmp(d, r, RUN_BYTES)) fail("copy_bits", bit0, 0, nbits);
+    return cases + 1;
+}
+
+int main(void) {
+    uint32_t cases = 0;
+
+    for (int round = 0; round < 20; round++) {
+        for (size_t oa = 0; oa < 8; oa++) {
+            for (size_t ob = 0; ob < 8; ob++) {
+                for (size_t len = 0; len <= MAX_LEN; len++, cases++) {
+                    check(oa, ob, len);
+                }
+            }
+        }
+    }
+    check_rects();
+    for (size_t bit0 = 0; bit0 < 16; bit0++) {
+        for (size_t nbits = 0; bit0 + nbits <= RUN_BYTES * 8; nbits++) {
+            cases += check_bits(bit0, nbits);
+        }
+    }
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("%u kernel cases match the byte loops\n", (unsigned)cases);
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ * Check of the in-place scroll and the strip chart
+ *
+ * Usage: epaper_chart_check_<panel>
+ *
+ * EPD_ScrollLeft runs on random canvases (black/white and black/white/red,
+ * all four rotations) over random rectangles, some reaching past the canvas,
+ * and is compared with the same move done pixel by pixel. Random charts then
+ * take random samples: after every push the canvas, drawn incrementally by
+ * scrolling, must equal the plot redrawn from the ring on a copy of the
+ * canvas, pixels outside the reported rectangle must be untouched, and a
+ * flat trace must sit on the row of its value.
+ * Exit status is 0 when everything matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_chart.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define CASES   40
+
+static uint8_t s_frame[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_orig[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint32_t s_seed = 0x2545F491;
+static int s_failures;
+static uint32_t s_cases;
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+static void fail(const char *what, uint8_t planes, uint16_t rotate, uint32_t n) {
+    if (s_failures++ < 10) {
+        printf("MISMATCH %s: %u plane(s), rotate %u, case %u\n", what, planes, rotate, (unsigned)n);
+    }
+}
+
+static void setup(uint8_t (*frames)[EPD_FRAME_SIZE], uint8_t planes, uint16_t rotate) {
+    uint8_t *p[EPD_MAX_PLANES] = { frames[0], frames[1] };
+    Paint_NewImagePlanes(p, planes, EPD_W, EPD_H, rotate, WHITE);
+}
+
+static void randomize(uint8_t (*frames)[EPD_FRAME_SIZE]) {
+    for (int p = 0; p < EPD_MAX_PLANES; p++) {
+        for (size_t i = 0; i < EPD_FRAME_SIZE; i++) frames[p][i] = rnd(256);
+    }
+}
+
+// Byte and mask of logical pixel (x, y) under Paint.Rotate
+static uint32_t locate(uint16_t x, uint16_t y, uint8_t *mask) {
+    uint16_t X = x, Y = y;
+    switch (Paint.Rotate) {
+        case ROTATE_90:  X = Paint.WidthMemory - y - 1; Y = x; break;
+        case ROTATE_180: X = Paint.WidthMemory - x - 1; Y = Paint.HeightMemory - y - 1; break;
+        case ROTATE_270: X = y; Y = Paint.HeightMemory - x - 1; break;
+    }
+    *mask = 0x80 >> (X % 8);
+    return (uint32_t)Y * Paint.WidthByte + X / 8;
+}
+
+static void put(uint8_t (*frames)[EPD_FRAME_SIZE], int p, uint32_t a, uint8_t m, bool v) {
+    frames[p][a] = v ? (frames[p][a] | m) : (frames[p][a] & ~m);
+}
+
+static void check_scroll(uint8_t planes, uint16_t rotate) {
+    static const uint16_t colors[] = { BLACK, WHITE, RED };
+    setup(s_frame, planes, rotate);
+    uint16_t x = rnd(Paint.Width), y = rnd(Paint.Height);
+    uint16_t w = 1 + rnd(Paint.Width), h = 1 + rnd(Paint.Height / 2);
+    uint16_t dx = rnd(w + 2), color = colors[rnd(planes == 1 ? 2 : 3)];
+    uint16_t xe = (x + w < Paint.Width) ? x + w : Paint.Width;
+    uint16_t ye = (y + h < Paint.Height) ? y + h : Paint.Height;
+    uint8_t bits = (color != BLACK) | ((color == RED) << 1);
+
+    randomize(s_frame);
+    memcpy(s_orig, s_frame, sizeof(s_orig));
+    memcpy(s_ref, s_frame, sizeof(s_ref));
+    EPD_ScrollLeft(x, y, w, h, dx, color);
+
+    for (uint16_t ly = y; ly < ye; ly++) {
+        for (uint16_t lx = x; lx < xe; lx++) {
+            uint8_t m, v = bits;
+            uint32_t a = locate(lx, ly, &m);
+            if (lx + dx < xe) {
+                uint8_t ms;
+                uint32_t s = locate(lx + dx, ly, &ms);
+                v = ((s_orig[0][s] & ms) != 0) | (((s_orig[1][s] & ms) != 0) << 1);
+            }
+            for (uint8_t p = 0; p < planes; p++) {
+                put(s_ref, p, a, m, (v >> p) & 1);
+            }
+        }
+    }
+    if (memcmp(s_frame, s_ref, sizeof(s_ref))) fail("scroll", planes, rotate, s_cases);
+    s_cases++;
+}
+
+// Every byte outside the frame rectangle r equals s_orig
+static bool outside_untouched(const EPD_Rect_t *r) {
+    for (uint8_t p = 0; p < EPD_MAX_PLANES; p++) {
+        for (uint16_t Y = 0; Y < Paint.HeightMemory; Y++) {
+            for (uint16_t X = 0; X < Paint.WidthMemory; X++) {
+                if (X >= r->x && X < r->x + r->width && Y >= r->y && Y < r->y + r->height) {
+                    continue;
+                }
+                uint32_t a = (uint32_t)Y * Paint.WidthByte + X / 8;
+                uint8_t m = 0x80 >> (X % 8);
+                if ((s_frame[p][a] ^ s_orig[p][a]) & m) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static void check_chart(uint8_t planes, uint16_t rotate) {
+    static EPD_Chart_t chart, copy;
+    EPD_ChartConfig_t cfg = EPD_CHART_CONFIG_DEFAULT();
+    EPD_Rect_t dirty;
+
+    setup(s_frame, planes, rotate);
+    cfg.x = rnd(Paint.Width - 8);
+    cfg.y = rnd(Paint.Height - 8);
+    cfg.width = 1 + rnd(Paint.Width - cfg.x + 20);
+    cfg.height = 2 + rnd(Paint.Height - cfg.y);
+    cfg.min = -(int32_t)rnd(1000);
+    cfg.max = cfg.min + 1 + rnd(5000);
+    cfg.step = 1 + rnd(4);
+    cfg.style = rnd(2) ? EPD_CHART_AREA : EPD_CHART_LINE;
+    cfg.color = (planes > 1 && rnd(2)) ? RED : BLACK;
+    if (EPD_Chart_Init(&chart, &cfg) != ESP_OK) {
+        fail("init", planes, rotate, s_cases);
+        return;
+    }
+
+    randomize(s_frame);
+    memcpy(s_orig, s_frame, sizeof(s_orig));
+    uint32_t pushes = 1 + rnd(2 * chart.shown + 4);
+    int32_t span = cfg.max - cfg.min;
+    for (uint32_t i = 0; i < pushes; i++, s_cases++) {
+        // Some values out of range, some repeated
+        int32_t v = cfg.min - span / 4 + (int32_t)rnd(span + span / 2 + 1);
+        copy = chart;
+        EPD_Chart_Push(&chart, v, &dirty);
+        if (!outside_untouched(&dirty)) fail("outside", planes, rotate, s_cases);
+
+        // The same plot redrawn from the ring on a copy of the canvas
+        memcpy(s_ref, s_frame, sizeof(s_ref));
+        setup(s_ref, planes, rotate);
+        EPD_Chart_Invalidate(&copy);
+        EPD_Chart_Push(&copy, v, NULL);
+        setup(s_frame, planes, rotate);
+        if (memcmp(s_frame, s_ref, sizeof(s_ref))) {
+            fail("redraw", planes, rotate, s_cases);
+            return;
+        }
+    }
+}
+
+// A constant line: every plot column holds the trace on the value's row only
+static void check_flat(uint8_t planes, uint16_t rotate) {
+    static EPD_Chart_t chart;
+    EPD_ChartConfig_t cfg = EPD_CHART_CONFIG_DEFAULT();
+
+    setup(s_frame, planes, rotate);
+    memset(s_frame, 0xFF, sizeof(s_frame));
+    cfg.x = 3;
+    cfg.y = 5;
+    cfg.height = 21;
+    cfg.min = 0;
+    cfg.max = 200;
+    cfg.step = 1 + rnd(3);
+    EPD_Chart_Init(&chart, &cfg);
+    for (int i = 0; i < 150; i++) {
+        EPD_Chart_Push(&chart, 50, NULL);
+    }
+    // 50 of 0..200 over rows 25 (bottom) to 5 (top): 5 rows up
+    for (uint16_t x = cfg.x; x < cfg.x + cfg.width; x++) {
+        for (uint16_t y = 0; y < Paint.Height; y++) {
+            uint8_t m;
+            uint32_t a = locate(x, y, &m);
+            bool black = !(s_frame[0][a] & m);
+            if (black != (y == 20)) {
+                fail("flat", planes, rotate, s_cases);
+                return;
+            }
+        }
+    }
+    s_cases++;
+}
+
+int main(void) {
+    static const uint16_t rotations[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+
+    for (int c = 0; c < CASES; c++) {
+        for (uint8_t planes = 1; planes <= EPD_MAX_PLANES; planes++) {
+            for (int r = 0; r < 4; r++) {
+                for (int k = 0; k < 10; k++) {
+                    check_scroll(planes, rotations[r]);
+                }
+                check_chart(planes, rotations[r]);
+            }
+        }
+    }
+    for (int r = 0; r < 4; r++) {
+        check_flat(1, rotations[r]);
+    }
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %u scrolls and chart pushes match\n", PANEL_NAME, (unsigned)s_cases);
+    return 0;
+}
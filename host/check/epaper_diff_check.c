@@ -0,0 +1,385 @@
+/*
+ * Differential check of the drawing code against the reference rasterizer
+ *
+ * Usage: epaper_diff_check_<panel> [seed] [cases]
+ *
+ * For every rotation, runs `cases` randomized scenes (default 500, seed 1)
+ * through both the driver (Paint / EPD_ drawing functions) and the frozen
+ * reference in epaper_reference.c, starting from the same random background,
+ * and compares the framebuffers bit for bit. A scene is a short sequence of
+ * pixels, lines, rectangles, circles, window fills, characters, strings,
+ * numbers, bitmaps, raster-op blits (with and without a mask) and numeric
+ * fields, with coordinates reaching past the canvas edges to exercise
+ * clipping. A numeric field is drawn with one value and then updated to a
+ * second one, which must look exactly like the second value drawn whole.
+ *
+ * On the first mismatch the scene is printed and the driver, reference and
+ * XOR difference frames are written as diff_<case>_{driver,ref,xor}.pbm in
+ * EPD_DIFF_DUMP_DIR, the build directory of the check (black = cleared bit in
+ * the frames, black = differing pixel in the xor image). Exit status is 0 when all scenes match.
+ *
+ * Every other scene is drawn on a two-plane canvas: its black/white plane
+ * must still match the reference and its color plane must stay clear, since
+ * scenes only use BLACK and WHITE. EPD_Full(RED) on a one-plane canvas must
+ * leave it white, as Paint_SetPixel draws RED there. EPD_ShowFloatNum1 outside
+ * the reference's range (negative, past 2^32, more than ten cells, ten or
+ * more decimals) must draw the text it documents.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_numfield.h"
+#include "epaper_reference.h"
+
+// Set by host/CMakeLists.txt; a standalone build dumps into the working directory
+#ifndef EPD_DIFF_DUMP_DIR
+#define EPD_DIFF_DUMP_DIR "."
+#endif
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define MAX_OPS     8
+#define MARGIN      24      // Coordinates reach this far past the canvas
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_FRAME_SIZE];
+static uint8_t s_color[EPD_FRAME_SIZE];
+static uint8_t s_picture[64 * 64 / 8];
+static uint8_t s_mask[64 * 64 / 8];
+static uint32_t s_seed;
+static char s_log[MAX_OPS][96];
+
+static const uint16_t s_rotations[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+static const uint16_t s_font_sizes[] = { 8, 12, 16, 24, 48 };
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return n ? s_seed % n : 0;
+}
+
+static bool plane_clear(const uint8_t *plane) {
+    for (uint32_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        if (plane[i] != 0x00) return false;
+    }
+    return true;
+}
+
+// The 8x6 font stops at '{' (92 glyphs), the others cover ' ' to '~'
+static char rnd_char(uint16_t size1) {
+    return (char)(' ' + rnd(size1 == 8 ? 92 : 95));
+}
+
+static uint16_t rnd_color(void) {
+    return rnd(2) ? BLACK : WHITE;
+}
+
+static uint16_t rnd_x(void) {
+    return rnd(Paint.Width + MARGIN);
+}
+
+static uint16_t rnd_y(void) {
+    return rnd(Paint.Height + MARGIN);
+}
+
+// Run one random drawing operation on both canvases and describe it in log
+static void run_op(char *log, size_t size) {
+    uint16_t c = rnd_color();
+
+    switch (rnd(13)) {
+        case 0: {
+            uint16_t x = rnd_x(), y = rnd_y();
+            snprintf(log, size, "SetPixel(%u, %u, 0x%02X)", x, y, c);
+            Paint_SetPixel(x, y, c);
+            Ref_SetPixel(x, y, c);
+            break;
+        }
+        case 1:
+        case 2: {
+            uint16_t xs = rnd_x(), ys = rnd_y(), xe = rnd_x(), ye = rnd_y();
+            if (rnd(3) == 0) ye = ys;           // Favour the straight cases
+            else if (rnd(3) == 0) xe = xs;
+            snprintf(log, size, "DrawLine(%u, %u, %u, %u, 0x%02X)", xs, ys, xe, ye, c);
+            EPD_DrawLine(xs, ys, xe, ye, c);
+            Ref_DrawLine(xs, ys, xe, ye, c);
+            break;
+        }
+        case 3: {
+            uint16_t xs = rnd_x(), ys = rnd_y(), xe = rnd_x(), ye = rnd_y();
+            uint8_t mode = rnd(2);
+            snprintf(log, size, "DrawRectangle(%u, %u, %u, %u, 0x%02X, %u)", xs, ys, xe, ye, c, mode);
+            EPD_DrawRectangle(xs, ys, xe, ye, c, mode);
+            Ref_DrawRectangle(xs, ys, xe, ye, c, mode);
+            break;
+        }
+        case 4: {
+            // Radius 0 makes the Bresenham loop wrap YCurrent and run ~2^31 steps
+            uint16_t x = rnd_x(), y = rnd_y(), r = 1 + rnd(Paint.Height / 2 + MARGIN);
+            uint8_t mode = rnd(2);
+            snprintf(log, size, "DrawCircle(%u, %u, %u, 0x%02X, %u)", x, y, r, c, mode);
+            EPD_DrawCircle(x, y, r, c, mode);
+            Ref_DrawCircle(x, y, r, c, mode);
+            break;
+        }
+        case 5: {
+            uint16_t xs = rnd_x(), ys = rnd_y(), xe = rnd_x(), ye = rnd_y();
+            snprintf(log, size, "ClearWindows(%u, %u, %u, %u, 0x%02X)", xs, ys, xe, ye, c);
+            EPD_ClearWindows(xs, ys, xe, ye, c);
+            Ref_ClearWindows(xs, ys, xe, ye, c);
+            break;
+        }
+        case 6: {
+            uint16_t x = rnd_x(), y = rnd_y(), size1 = s_font_sizes[rnd(5)];
+            uint16_t ch = (uint16_t)rnd_char(size1);
+            snprintf(log, size, "ShowChar(%u, %u, '%c', %u, 0x%02X)", x, y, ch, size1, c);
+            EPD_ShowChar(x, y, ch, size1, c);
+            Ref_ShowChar(x, y, ch, size1, c);
+            break;
+        }
+        case 7: {
+            char text[17];
+            uint16_t x = rnd_x(), y = rnd_y(), size1 = s_font_sizes[rnd(4)];
+            uint32_t len = rnd(sizeof(text));
+            for (uint32_t i = 0; i < len; i++) text[i] = rnd_char(size1);
+            text[len] = '\0';
+            snprintf(log, size, "ShowString(%u, %u, \"%s\", %u, 0x%02X)", x, y, text, size1, c);
+            EPD_ShowString(x, y, text, size1, c);
+            Ref_ShowString(x, y, text, size1, c);
+            break;
+        }
+        case 8: {
+            uint16_t x = rnd_x(), y = rnd_y(), size1 = s_font_sizes[rnd(4)];
+            uint16_t len = 1 + rnd(9);
+            uint32_t num = rnd(0xFFFFFFFF);
+            snprintf(log, size, "ShowNum(%u, %u, %lu, %u, %u, 0x%02X)", x, y, (unsigned long)num, len, size1, c);
+            EPD_ShowNum(x, y, num, len, size1, c);
+            Ref_ShowNum(x, y, num, len, size1, c);
+            break;
+        }
+        case 9: {
+            // Keep num * 10^pre inside the documented uint16_t range
+            uint16_t x = rnd_x(), y = rnd_y();
+            uint8_t pre = 1 + rnd(2), len = pre + 1 + rnd(4 - pre), sizey = s_font_sizes[rnd(4)];
+            float num = (float)rnd(65535) / (pre == 1 ? 10.0f : 100.0f);
+            snprintf(log, size, "ShowFloatNum1(%u, %u, %.2f, %u, %u, %u, 0x%02X)", x, y, num, len, pre, sizey, c);
+            EPD_ShowFloatNum1(x, y, num, len, pre, sizey, c);
+            Ref_ShowFloatNum1(x, y, num, len, pre, sizey, c);
+            break;
+        }
+        case 10: {
+            static const char *const rops[] = { "COPY", "OR", "AND", "XOR", "NOT", "SET", "CLEAR" };
+            uint16_t x = rnd_x(), y = rnd_y(), w = 1 + rnd(64), h = 1 + rnd(64);
+            EPD_Rop_t rop = (EPD_Rop_t)rnd(7);
+            bool masked = rnd(2);
+            for (size_t i = 0; i < sizeof(s_picture); i++) s_picture[i] = rnd(256);
+            for (size_t i = 0; i < sizeof(s_mask); i++) s_mask[i] = rnd(256);
+            snprintf(log, size, "Blit(%u, %u, %u, %u, <random>, %s, %s)", x, y, w, h,
+                     masked ? "<random>" : "NULL", rops[rop]);
+            EPD_Blit(x, y, w, h, s_picture, masked ? s_mask : NULL, rop);
+            Ref_Blit(x, y, w, h, s_picture, masked ? s_mask : NULL, rop);
+            break;
+        }
+        case 11: {
+            EPD_NumFieldConfig_t cfg = EPD_NUMFIELD_CONFIG_DEFAULT();
+            EPD_NumField_t field;
+            int32_t from = (int32_t)rnd(0xFFFFFFFF), to = from;
+            char text[32];
+            cfg.x = rnd_x();
+            cfg.y = rnd_y();
+            cfg.digits = 1 + rnd(EPD_NUMFIELD_MAX_DIGITS);
+            cfg.frac = rnd(cfg.digits);
+            cfg.size = s_font_sizes[rnd(4)];
+            cfg.color = c;
+            cfg.zero_pad = rnd(2);
+            cfg.sign = rnd(2);
+            // Mostly small steps, as a counter or clock would take
+            switch (rnd(3)) {
+                case 0: to = from + 1; break;
+                case 1: to = from - (int32_t)rnd(1000); break;
+                default: to = (int32_t)rnd(0xFFFFFFFF); break;
+            }
+            if (rnd(4) == 0) {
+                from %= 1000;
+                to %= 1000;
+            }
+            snprintf(log, size, "NumField(%u, %u, digits %u frac %u, %u, 0x%02X, pad %d sign %d): %ld -> %ld",
+                     cfg.x, cfg.y, cfg.digits, cfg.frac, cfg.size, c, cfg.zero_pad, cfg.sign, (long)from, (long)to);
+            EPD_NumField_Init(&field, &cfg);
+            EPD_NumField_Set(&field, from, NULL);
+            EPD_NumField_Set(&field, to, NULL);
+
+            // The same text built with printf, drawn cell by cell
+            uint32_t mag = (to < 0) ? 0u - (uint32_t)to : (uint32_t)to, scale = 1;
+            uint8_t int_digits = cfg.digits - cfg.frac;
+            char *p = text;
+            for (uint8_t i = 0; i < cfg.frac; i++) scale *= 10;
+            if (cfg.digits < 10) {
+                uint32_t wrap = 1;
+                for (uint8_t i = 0; i < cfg.digits; i++) wrap *= 10;
+                mag %= wrap;
+            }
+            if (cfg.sign && cfg.zero_pad) {
+                *p++ = (to < 0) ? '-' : ' ';
+            }
+            if (cfg.sign && !cfg.zero_pad) {
+                char num[16];
+                snprintf(num, sizeof(num), "%s%lu", (to < 0) ? "-" : "", (unsigned long)(mag / scale));
+                p += snprintf(p, text + sizeof(text) - p, "%*s", int_digits + 1, num);
+            } else {
+                p += snprintf(p, text + sizeof(text) - p, cfg.zero_pad ? "%0*lu" : "%*lu", int_digits,
+                              (unsigned long)(mag / scale));
+            }
+            if (cfg.frac) {
+                snprintf(p, text + sizeof(text) - p, ".%0*lu", cfg.frac, (unsigned long)(mag % scale));
+            }
+            uint16_t pitch = (cfg.size == 8) ? 6 : cfg.size / 2;
+            for (uint8_t i = 0; text[i]; i++) {
+                Ref_ShowChar(cfg.x + i * pitch, cfg.y, text[i], cfg.size, c);
+            }
+            break;
+        }
+        default: {
+            uint16_t x = rnd_x(), y = rnd_y();
+            uint16_t w = 8 * (1 + rnd(8)), h = 1 + rnd(64);
+            if (rnd(8) == 0) w = 1 + rnd(63);   // Odd widths take the legacy path
+            for (size_t i = 0; i < sizeof(s_picture); i++) s_picture[i] = rnd(256);
+            snprintf(log, size, "ShowPicture(%u, %u, %u, %u, <random>, 0x%02X)", x, y, w, h, c);
+            EPD_ShowPicture(x, y, w, h, s_picture, c);
+            Ref_ShowPicture(x, y, w, h, s_picture, c);
+            break;
+        }
+    }
+}
+
+// P4 bitmap: 1 = black, rows padded to whole bytes like the framebuffer
+static void write_pbm(const char *path, const uint8_t *a, const uint8_t *b) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return;
+    }
+    fprintf(f, "P4\n%d %d\n", EPD_W, EPD_H);
+    for (uint32_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        fputc(b ? (a[i] ^ b[i]) : (uint8_t)~a[i], f);
+    }
+    fclose(f);
+}
+
+static void report(uint16_t rotate, uint32_t index, int ops) {
+    char path[512];
+    uint32_t bits = 0, first = EPD_FRAME_SIZE;
+
+    for (uint32_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        if (s_frame[i] != s_ref[i]) {
+            bits += __builtin_popcount(s_frame[i] ^ s_ref[i]);
+            if (first == EPD_FRAME_SIZE) first = i;
+        }
+    }
+    printf("MISMATCH panel %s rotate %u case %lu: %lu pixels differ, first at x=%lu y=%lu (memory)\n",
+           PANEL_NAME, rotate, (unsigned long)index, (unsigned long)bits,
+           (unsigned long)(first % EPD_FRAME_STRIDE) * 8, (unsigned long)(first / EPD_FRAME_STRIDE));
+    for (int i = 0; i < ops; i++) {
+        printf("  %s\n", s_log[i]);
+    }
+
+    snprintf(path, sizeof(path), "%s/diff_%lu_driver.pbm", EPD_DIFF_DUMP_DIR, (unsigned long)index);
+    write_pbm(path, s_frame, NULL);
+    snprintf(path, sizeof(path), "%s/diff_%lu_ref.pbm", EPD_DIFF_DUMP_DIR, (unsigned long)index);
+    write_pbm(path, s_ref, NULL);
+    snprintf(path, sizeof(path), "%s/diff_%lu_xor.pbm", EPD_DIFF_DUMP_DIR, (unsigned long)index);
+    write_pbm(path, s_frame, s_ref);
+}
+
+// EPD_ShowFloatNum1 against EPD_ShowString of the text it should draw
+static bool check_float_num(void) {
+    static const struct {
+        float num;
+        uint8_t len, pre;
+        const char *text;
+    } cases[] = {
+        { 3.14159f, 3, 2, "3.14" },
+        { -3.5f, 3, 1, "00.0" },                    // Negative: 0
+        { 1e12f, 12, 1, "00429496729.5" },          // Clamped to 4294967295, zeros before it
+        { 1e12f, 4, 0, "7295" },                    // Low digits, as EPD_ShowNum
+        { 0.5f, 12, 12, ".004294967295" },          // 0.5 * 10^12 clamped
+        { 0.0125f, 13, 11, "00.01250000000" },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        Paint_NewImage(s_ref, EPD_W, EPD_H, ROTATE_0, WHITE);
+        EPD_Full(WHITE);
+        EPD_ShowString(0, 0, cases[i].text, 16, BLACK);
+        Paint_NewImage(s_frame, EPD_W, EPD_H, ROTATE_0, WHITE);
+        EPD_Full(WHITE);
+        EPD_ShowFloatNum1(0, 0, cases[i].num, cases[i].len, cases[i].pre, 16, BLACK);
+        if (memcmp(s_frame, s_ref, EPD_FRAME_SIZE) != 0) {
+            printf("MISMATCH panel %s: EPD_ShowFloatNum1(%g, %u, %u) is not \"%s\"\n", PANEL_NAME,
+                   cases[i].num, cases[i].len, cases[i].pre, cases[i].text);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    uint32_t seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    uint32_t cases = (argc > 2) ? strtoul(argv[2], NULL, 0) : 500;
+    uint32_t index = 0;
+
+    s_seed = seed ? seed : 1;
+
+    if (!check_float_num()) {
+        return 1;
+    }
+    Paint_NewImage(s_frame, EPD_W, EPD_H, ROTATE_0, WHITE);
+    EPD_Full(BLACK);
+    EPD_Full(RED);
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        if (s_frame[i] != 0xFF) {
+            printf("MISMATCH panel %s: EPD_Full(RED) on one plane is not white at byte %lu\n",
+                   PANEL_NAME, (unsigned long)i);
+            return 1;
+        }
+    }
+
+    for (size_t r = 0; r < sizeof(s_rotations) / sizeof(s_rotations[0]); r++) {
+        for (uint32_t n = 0; n < cases; n++, index++) {
+            int ops = 1 + rnd(MAX_OPS);
+            uint8_t *planes[] = { s_frame, s_color };
+            uint8_t fill;
+
+            // Same random background on both canvases
+            Paint_NewImagePlanes(planes, 1 + (n & 1), EPD_W, EPD_H, s_rotations[r], WHITE);
+            Ref_NewImage(s_ref, EPD_W, EPD_H, s_rotations[r], WHITE);
+            do {
+                fill = rnd(4) == 0 ? rnd(256) : (rnd(2) ? WHITE : BLACK);
+            } while (fill == RED);
+            memset(s_color, 0xAA, sizeof(s_color));
+            EPD_Full(fill);
+            Ref_Full(fill);
+
+            for (int i = 0; i < ops; i++) {
+                run_op(s_log[i], sizeof(s_log[i]));
+            }
+            if (memcmp(s_frame, s_ref, EPD_FRAME_SIZE) != 0) {
+                report(s_rotations[r], index, ops);
+                return 1;
+            }
+            if ((n & 1) && !plane_clear(s_color)) {
+                printf("MISMATCH panel %s rotate %u case %lu: color plane written by a black/white scene\n",
+                       PANEL_NAME, s_rotations[r], (unsigned long)index);
+                return 1;
+            }
+        }
+    }
+
+    printf("panel %s: %lu scenes match the reference (seed %lu)\n",
+           PANEL_NAME, (unsigned long)index, (unsigned long)seed);
+    return 0;
+}
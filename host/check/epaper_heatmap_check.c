@@ -0,0 +1,400 @@
+/*
+ * Check of the ghosting heat map
+ *
+ * Usage: epaper_heatmap_check_<panel> [seed] [steps]
+ *
+ * Random touches, commits, cleans and changed-pixel counts (default 20000
+ * steps, seed 1) run against a model that decides every tile from its pixel
+ * bounds: a touch marks the tiles it overlaps, a commit counts them once, a
+ * clean resets the tiles its area covers completely, and both counters
+ * saturate. After each step every tile must match the model, and
+ * EPD_Heat_Plan must give the bounding box of the hot tiles and pick AREA or
+ * FULL by its share of the panel. The edge tiles, narrower and shorter than
+ * the rest on both panels, are also checked one by one, as are the setter's
+ * limits and the plan threshold at exactly full_permille.
+ * Exit status is 0 when everything matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_heatmap.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+static EPD_HeatTile_t s_model[EPD_TILE_COUNT];
+static bool s_marked[EPD_TILE_COUNT];
+static EPD_HeatConfig_t s_cfg;
+static uint32_t s_plans[3];                 // Random steps by planned cleanup
+static uint32_t s_seed = 1;
+static int s_failures;
+
+#define CHECK(cond, what)                                       \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            printf("FAIL %s (line %d)\n", what, __LINE__);      \
+            s_failures++;                                       \
+        }                                                       \
+    } while (0)
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+// Pixel bounds of tile t on the panel, end exclusive
+static void tile_bounds(uint16_t t, uint32_t *x0, uint32_t *y0, uint32_t *x1, uint32_t *y1) {
+    *x0 = (t % EPD_TILES_X) * EPD_TILE_W;
+    *y0 = (t / EPD_TILES_X) * EPD_TILE_H;
+    *x1 = (*x0 + EPD_TILE_W > EPD_W) ? EPD_W : *x0 + EPD_TILE_W;
+    *y1 = (*y0 + EPD_TILE_H > EPD_H) ? EPD_H : *y0 + EPD_TILE_H;
+}
+
+// Area clipped to the panel, end exclusive; false when nothing is left
+static bool clip(uint32_t x, uint32_t y, uint32_t w, uint32_t h,
+                 uint32_t *x1, uint32_t *y1) {
+    if (x >= EPD_W || y >= EPD_H || w == 0 || h == 0) {
+        return false;
+    }
+    *x1 = (x + w > EPD_W) ? EPD_W : x + w;
+    *y1 = (y + h > EPD_H) ? EPD_H : y + h;
+    return true;
+}
+
+static void model_touch(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    uint32_t ax1, ay1, tx0, ty0, tx1, ty1;
+    if (!clip(x, y, w, h, &ax1, &ay1)) {
+        return;
+    }
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        tile_bounds(t, &tx0, &ty0, &tx1, &ty1);
+        if (tx0 < ax1 && x < tx1 && ty0 < ay1 && y < ty1) {
+            s_marked[t] = true;
+        }
+    }
+}
+
+static void model_commit(void) {
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        if (s_marked[t] && s_model[t].partials < UINT8_MAX) {
+            s_model[t].partials++;
+        }
+        s_marked[t] = false;
+    }
+}
+
+static void model_clean(const EPD_Rect_t *area) {
+    uint32_t ax1, ay1, tx0, ty0, tx1, ty1;
+    if (area == NULL) {
+        memset(s_model, 0, sizeof(s_model));
+        memset(s_marked, 0, sizeof(s_marked));
+        return;
+    }
+    if (!clip(area->x, area->y, area->width, area->height, &ax1, &ay1)) {
+        return;
+    }
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        tile_bounds(t, &tx0, &ty0, &tx1, &ty1);
+        if (tx0 >= area->x && ty0 >= area->y && tx1 <= ax1 && ty1 <= ay1) {
+            memset(&s_model[t], 0, sizeof(s_model[t]));
+        }
+    }
+}
+
+static void model_add(uint16_t t, uint32_t pixels) {
+    uint32_t sum = s_model[t].changed + pixels;
+    s_model[t].changed = (sum > UINT16_MAX || sum < pixels) ? UINT16_MAX : (uint16_t)sum;
+}
+
+static bool model_hot(uint16_t t) {
+    return s_model[t].partials >= s_cfg.max_partials ||
+           (s_cfg.max_changed != 0 && s_model[t].changed >= s_cfg.max_changed);
+}
+
+static bool compare(const char *op, uint32_t step) {
+    uint32_t x0 = EPD_W, y0 = EPD_H, x1 = 0, y1 = 0, tx0, ty0, tx1, ty1;
+    EPD_Cleanup_t want = EPD_CLEANUP_NONE, got;
+    EPD_Rect_t area = { 0 };
+    EPD_HeatTile_t tile;
+
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        EPD_Heat_GetTile(t, &tile);
+        if (tile.partials != s_model[t].partials || tile.changed != s_model[t].changed ||
+            EPD_Heat_IsHot(t) != model_hot(t)) {
+            printf("MISMATCH panel %s step %lu (%s): tile %u is %u partials %u changed, model %u %u\n",
+                   PANEL_NAME, (unsigned long)step, op, t, tile.partials, tile.changed,
+                   s_model[t].partials, s_model[t].changed);
+            s_failures++;
+            return false;
+        }
+        if (model_hot(t)) {
+            tile_bounds(t, &tx0, &ty0, &tx1, &ty1);
+            if (tx0 < x0) x0 = tx0;
+            if (ty0 < y0) y0 = ty0;
+            if (tx1 > x1) x1 = tx1;
+            if (ty1 > y1) y1 = ty1;
+        }
+    }
+    if (x0 < x1) {
+        uint64_t box = (uint64_t)(x1 - x0) * (y1 - y0);
+        want = (box * 1000 > (uint64_t)s_cfg.full_permille * EPD_W * EPD_H) ? EPD_CLEANUP_FULL : EPD_CLEANUP_AREA;
+    }
+    got = EPD_Heat_Plan(&area);
+    if (got != want || (want != EPD_CLEANUP_NONE &&
+        (area.x != x0 || area.y != y0 || area.x + area.width != x1 || area.y + area.height != y1))) {
+        printf("MISMATCH panel %s step %lu (%s): plan %d (%u,%u %ux%u), model %d (%lu,%lu %lux%lu)\n",
+               PANEL_NAME, (unsigned long)step, op, got, area.x, area.y, area.width, area.height,
+               want, (unsigned long)x0, (unsigned long)y0, (unsigned long)(x1 - x0), (unsigned long)(y1 - y0));
+        s_failures++;
+        return false;
+    }
+    if (want != EPD_CLEANUP_NONE && area.x % 8 != 0) {
+        printf("MISMATCH panel %s step %lu (%s): cleanup area at x %u is not byte aligned\n",
+               PANEL_NAME, (unsigned long)step, op, area.x);
+        s_failures++;
+        return false;
+    }
+    s_plans[want]++;
+    return true;
+}
+
+// Random coordinate, mostly near a tile edge or the panel edge
+static uint16_t coord(uint16_t size, uint16_t tile) {
+    switch (rnd(4)) {
+        case 0:  return rnd(size + 8);
+        case 1:  return size - 1 - rnd(3);
+        default: {
+            uint16_t c = rnd(size / tile + 1) * tile + rnd(3) - 1;
+            return c > size + 8 ? 0 : c;
+        }
+    }
+}
+
+static uint16_t extent(uint16_t size, uint16_t tile) {
+    switch (rnd(4)) {
+        case 0:  return rnd(3);
+        case 1:  return size + rnd(2);
+        default: return (1 + rnd(3)) * tile + rnd(3) - 1;
+    }
+}
+
+static void random_config(void) {
+    EPD_HeatConfig_t cfg = {
+        .max_partials = 1 + rnd(8),
+        .max_changed = rnd(3) ? 1 + rnd(4000) : 0,
+        .full_permille = rnd(1001),
+    };
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    s_cfg = cfg;
+}
+
+static void run_random(uint32_t steps) {
+    const char *op = "";
+
+    random_config();
+    EPD_Heat_Clean(NULL);
+    model_clean(NULL);
+    for (uint32_t step = 0; step < steps; step++) {
+        uint32_t k = rnd(100);
+        if (k < 40) {
+            op = "EPD_Heat_Touch";
+            uint16_t x = coord(EPD_W, EPD_TILE_W), y = coord(EPD_H, EPD_TILE_H);
+            uint16_t w = extent(EPD_W, EPD_TILE_W), h = extent(EPD_H, EPD_TILE_H);
+            EPD_Heat_Touch(x, y, w, h);
+            model_touch(x, y, w, h);
+        } else if (k < 70) {
+            op = "EPD_Heat_Commit";
+            EPD_Heat_Commit();
+            model_commit();
+        } else if (k < 85) {
+            op = "EPD_Heat_AddChanged";
+            uint16_t t = rnd(EPD_TILE_COUNT + 2);
+            uint32_t pixels = rnd(8) ? rnd(1500) : UINT32_MAX - rnd(3);
+            EPD_Heat_AddChanged(t, pixels);
+            if (t < EPD_TILE_COUNT) model_add(t, pixels);
+        } else if (k < 97) {
+            op = "EPD_Heat_Clean";
+            EPD_Rect_t area = {
+                .x = coord(EPD_W, EPD_TILE_W), .y = coord(EPD_H, EPD_TILE_H),
+                .width = extent(EPD_W, EPD_TILE_W), .height = extent(EPD_H, EPD_TILE_H),
+            };
+            EPD_Heat_Clean(&area);
+            model_clean(&area);
+        } else if (k < 99) {
+            op = "EPD_Heat_SetConfig";
+            random_config();
+        } else {
+            op = "EPD_Heat_Clean(NULL)";
+            EPD_Heat_Clean(NULL);
+            model_clean(NULL);
+        }
+        if (!compare(op, step)) {
+            return;
+        }
+    }
+}
+
+// The last column and row of tiles are cut by the panel edge
+static void check_edges(void) {
+    const uint16_t last = EPD_TILE_COUNT - 1;
+    const uint16_t ex = (EPD_TILES_X - 1) * EPD_TILE_W, ey = (EPD_TILES_Y - 1) * EPD_TILE_H;
+    EPD_HeatTile_t tile;
+    EPD_Rect_t area;
+
+    s_cfg = (EPD_HeatConfig_t){ .max_partials = 1, .max_changed = 0, .full_permille = 1000 };
+    CHECK(EPD_Heat_SetConfig(&s_cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    EPD_Heat_Clean(NULL);
+
+    // Only the bottom right pixel
+    EPD_Heat_Touch(EPD_W - 1, EPD_H - 1, 1, 1);
+    EPD_Heat_Commit();
+    for (uint16_t t = 0; t < EPD_TILE_COUNT; t++) {
+        EPD_Heat_GetTile(t, &tile);
+        CHECK(tile.partials == (t == last), "corner touch marks the last tile only");
+    }
+    CHECK(EPD_Heat_Plan(&area) == EPD_CLEANUP_AREA, "corner plan");
+    CHECK(area.x == ex && area.y == ey && area.x + area.width == EPD_W && area.y + area.height == EPD_H,
+          "corner plan box ends at the panel edge");
+
+    // Off the panel: nothing
+    EPD_Heat_Touch(EPD_W, 0, 8, 8);
+    EPD_Heat_Touch(0, EPD_H, 8, 8);
+    EPD_Heat_Touch(0, 0, 0, 8);
+    EPD_Heat_Commit();
+    EPD_Heat_GetTile(0, &tile);
+    CHECK(tile.partials == 0, "touches off the panel or empty mark nothing");
+
+    // Missing the last pixel column of the cut tile does not clean it, the
+    // cut tile exactly does, and so does an area running past the edge
+    EPD_Heat_Clean(&(EPD_Rect_t){ .x = ex, .y = ey, .width = EPD_W - ex - 1, .height = EPD_H - ey });
+    EPD_Heat_GetTile(last, &tile);
+    CHECK(tile.partials == 1, "clean one pixel short leaves the edge tile");
+    EPD_Heat_Clean(&(EPD_Rect_t){ .x = ex, .y = ey + 1, .width = EPD_W - ex, .height = EPD_H - ey });
+    EPD_Heat_GetTile(last, &tile);
+    CHECK(tile.partials == 1, "clean starting one row in leaves the edge tile");
+    EPD_Heat_Clean(&(EPD_Rect_t){ .x = ex, .y = ey, .width = EPD_W - ex, .height = EPD_H - ey });
+    EPD_Heat_GetTile(last, &tile);
+    CHECK(tile.partials == 0, "clean of exactly the edge tile");
+    EPD_Heat_Touch(EPD_W - 1, EPD_H - 1, 1, 1);
+    EPD_Heat_Commit();
+    EPD_Heat_Clean(&(EPD_Rect_t){ .x = ex, .y = ey, .width = 1000, .height = 1000 });
+    EPD_Heat_GetTile(last, &tile);
+    CHECK(tile.partials == 0, "clean past the panel edge");
+    CHECK(EPD_Heat_Plan(NULL) == EPD_CLEANUP_NONE, "nothing hot after the clean");
+
+    // Out-of-range tiles read as cold and empty
+    EPD_Heat_AddChanged(EPD_TILE_COUNT, 100);
+    EPD_Heat_GetTile(EPD_TILE_COUNT, &tile);
+    CHECK(tile.partials == 0 && tile.changed == 0 && !EPD_Heat_IsHot(EPD_TILE_COUNT), "tile past the grid");
+    CHECK(EPD_Heat_TileAt(EPD_W - 1, EPD_H - 1) == last, "EPD_Heat_TileAt of the last pixel");
+}
+
+static void check_saturation(void) {
+    EPD_HeatTile_t tile;
+
+    EPD_Heat_Clean(NULL);
+    EPD_Heat_AddChanged(0, UINT16_MAX - 1);
+    EPD_Heat_AddChanged(0, 1);
+    EPD_Heat_GetTile(0, &tile);
+    CHECK(tile.changed == UINT16_MAX, "changed reaches UINT16_MAX");
+    EPD_Heat_AddChanged(0, 1);
+    EPD_Heat_GetTile(0, &tile);
+    CHECK(tile.changed == UINT16_MAX, "changed stays at UINT16_MAX");
+    EPD_Heat_AddChanged(1, UINT32_MAX);
+    EPD_Heat_GetTile(1, &tile);
+    CHECK(tile.changed == UINT16_MAX, "changed of a huge count");
+
+    for (int i = 0; i < 300; i++) {
+        EPD_Heat_Touch(0, 0, 1, 1);
+        EPD_Heat_Commit();
+    }
+    EPD_Heat_GetTile(0, &tile);
+    CHECK(tile.partials == UINT8_MAX, "partials saturate");
+    EPD_Heat_Clean(NULL);
+}
+
+// The whole panel hot is FULL unless full_permille is 1000; a box of exactly
+// full_permille of the panel is still AREA
+static void check_threshold(void) {
+    EPD_HeatConfig_t cfg = { .max_partials = 1, .max_changed = 0 };
+    uint32_t panel = (uint32_t)EPD_W * EPD_H;
+    uint32_t tile = (uint32_t)EPD_TILE_W * EPD_TILE_H;
+    EPD_Rect_t area;
+
+    CHECK(EPD_Heat_SetConfig(NULL) == ESP_ERR_INVALID_ARG, "NULL config");
+    cfg.full_permille = 1001;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_ERR_INVALID_ARG, "full_permille over 1000");
+    cfg.full_permille = 500;
+    cfg.max_partials = 0;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_ERR_INVALID_ARG, "max_partials 0");
+    cfg.max_partials = 256;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_ERR_INVALID_ARG, "max_partials over 255");
+    cfg.max_partials = 1;
+
+    EPD_Heat_Clean(NULL);
+    EPD_Heat_Touch(0, 0, EPD_W, EPD_H);
+    EPD_Heat_Commit();
+    cfg.full_permille = 1000;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    CHECK(EPD_Heat_Plan(&area) == EPD_CLEANUP_AREA, "whole panel at 1000 per mille");
+    CHECK(area.x == 0 && area.y == 0 && area.width == EPD_W && area.height == EPD_H, "whole panel box");
+    cfg.full_permille = 999;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    CHECK(EPD_Heat_Plan(NULL) == EPD_CLEANUP_FULL, "whole panel at 999 per mille");
+
+    // One full tile: AREA at the largest permille below its share, FULL above
+    EPD_Heat_Clean(NULL);
+    EPD_Heat_Touch(0, 0, 1, 1);
+    EPD_Heat_Commit();
+    cfg.full_permille = tile * 1000 / panel;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    CHECK(EPD_Heat_Plan(NULL) == (tile * 1000 > cfg.full_permille * panel ? EPD_CLEANUP_FULL : EPD_CLEANUP_AREA),
+          "one tile at its share");
+    cfg.full_permille = (tile * 1000 + panel - 1) / panel;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    CHECK(EPD_Heat_Plan(NULL) == EPD_CLEANUP_AREA, "one tile under its share rounded up");
+    cfg.full_permille = 0;
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    CHECK(EPD_Heat_Plan(NULL) == EPD_CLEANUP_FULL, "one tile at 0 per mille");
+
+    // Hot by changed pixels alone
+    EPD_Heat_Clean(NULL);
+    cfg = (EPD_HeatConfig_t){ .max_partials = 255, .max_changed = 100, .full_permille = 1000 };
+    CHECK(EPD_Heat_SetConfig(&cfg) == ESP_OK, "EPD_Heat_SetConfig");
+    EPD_Heat_AddChanged(EPD_TILE_COUNT - 1, 99);
+    CHECK(EPD_Heat_Plan(NULL) == EPD_CLEANUP_NONE, "99 changed pixels of 100");
+    EPD_Heat_AddChanged(EPD_TILE_COUNT - 1, 1);
+    CHECK(EPD_Heat_Plan(&area) == EPD_CLEANUP_AREA, "100 changed pixels of 100");
+    CHECK(area.x + area.width == EPD_W && area.y + area.height == EPD_H, "changed-pixel hot tile box");
+    EPD_Heat_Clean(NULL);
+}
+
+int main(int argc, char **argv) {
+    EPD_HeatConfig_t saved;
+    uint32_t steps = (argc > 2) ? strtoul(argv[2], NULL, 0) : 20000;
+
+    s_seed = (argc > 1 && strtoul(argv[1], NULL, 0)) ? strtoul(argv[1], NULL, 0) : 1;
+    EPD_Heat_GetConfig(&saved);
+
+    check_edges();
+    check_saturation();
+    check_threshold();
+    run_random(steps);
+
+    CHECK(EPD_Heat_SetConfig(&saved) == ESP_OK, "restore the config");
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %ux%u tiles of %ux%u, heat map matched the model over %lu steps "
+           "(plans: %lu none, %lu area, %lu full)\n",
+           PANEL_NAME, EPD_TILES_X, EPD_TILES_Y, EPD_TILE_W, EPD_TILE_H, (unsigned long)steps,
+           (unsigned long)s_plans[EPD_CLEANUP_NONE], (unsigned long)s_plans[EPD_CLEANUP_AREA],
+           (unsigned long)s_plans[EPD_CLEANUP_FULL]);
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Check of the streaming image loaders
+ *
+ * Usage: epaper_image_check_<panel>
+ *
+ * Random gray images are written to temporary files as PBM (P1/P4), PGM
+ * (P2/P5, 8- and 16-bit) and BMP (1-, 4- and 8-bit, bottom-up and top-down,
+ * both 1-bit palette orders) and drawn with EPD_Image_Draw at random
+ * positions, some reaching past the canvas, under every canvas and image
+ * rotation with copy and xor. Each canvas is compared bit for bit with the
+ * image set pixel by pixel from its definition. Truncated and unsupported
+ * files must fail with the documented errors, EPD_Image_Probe must leave the
+ * file where it was, and rows past the canvas must not be read.
+ * Exit status is 0 when everything matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "epaper_driver.h"
+#include "epaper_image.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define CASES   12
+#define MAX_W   (EPD_W + 40)
+#define MAX_H   (EPD_H + 40)
+
+typedef enum {
+    FMT_P1, FMT_P4, FMT_P2, FMT_P5, FMT_P5_16,
+    FMT_BMP1, FMT_BMP1_INV, FMT_BMP4, FMT_BMP8,
+    FMT_COUNT,
+} Format_t;
+
+static const char *const s_names[FMT_COUNT] = {
+    "P1", "P4", "P2", "P5", "P5/16", "BMP1", "BMP1/inverted", "BMP4", "BMP8",
+};
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_FRAME_SIZE];
+static uint8_t s_gray[MAX_H][MAX_W];    // Level 0..255 of every pixel
+static uint32_t s_seed = 0x1F2E3D4C;
+static int s_failures;
+static uint32_t s_cases;
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+static void fail(const char *what, Format_t fmt, uint16_t rotate, uint16_t turn) {
+    if (s_failures++ < 10) {
+        printf("MISMATCH %s: %s, canvas rotate %u, image rotate %u\n", what, s_names[fmt], rotate, turn);
+    }
+}
+
+// Levels the format can store: black and white for the 1-bit ones, the
+// 16 grays of the 4-bit palette, any level otherwise
+static uint8_t level(Format_t fmt) {
+    switch (fmt) {
+        case FMT_P1: case FMT_P4: case FMT_BMP1: case FMT_BMP1_INV: return rnd(2) ? 0xFF : 0x00;
+        case FMT_BMP4: return rnd(16) * 17;
+        default: return rnd(256);
+    }
+}
+
+static void le(FILE *f, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) fputc((v >> (8 * i)) & 0xFF, f);
+}
+
+static void write_bmp(FILE *f, Format_t fmt, uint16_t w, uint16_t h, bool bottom_up) {
+    uint16_t bits = (fmt == FMT_BMP4) ? 4 : (fmt == FMT_BMP8) ? 8 : 1;
+    uint32_t colors = 1u << bits, row = ((uint32_t)w * bits + 31) / 32 * 4;
+    uint32_t offset = 14 + 40 + colors * 4 + 6;     // Gap before the pixels
+
+    fputs("BM", f);
+    le(f, offset + row * h, 4);
+    le(f, 0, 4);
+    le(f, offset, 4);
+    le(f, 40, 4);
+    le(f, w, 4);
+    le(f, bottom_up ? h : (uint32_t)-(int32_t)h, 4);
+    le(f, 1, 2);
+    le(f, bits, 2);
+    le(f, 0, 4);
+    le(f, row * h, 4);
+    le(f, 2835, 4);
+    le(f, 2835, 4);
+    le(f, 0, 4);
+    le(f, 0, 4);
+    for (uint32_t i = 0; i < colors; i++) {
+        uint8_t g = (bits == 1) ? ((fmt == FMT_BMP1_INV) ? (i ? 0x00 : 0xFF) : (i ? 0xFF : 0x00))
+                                : (uint8_t)(i * 255 / (colors - 1));
+        le(f, g | g << 8 | g << 16, 4);
+    }
+    for (int i = 0; i < 6; i++) fputc(0xEE, f);
+    for (uint16_t r = 0; r < h; r++) {
+        uint16_t v = bottom_up ? h - 1 - r : r;
+        uint8_t bytes[(MAX_W * 8 + 31) / 32 * 4] = { 0 };
+        for (uint16_t u = 0; u < w; u++) {
+            uint32_t index = s_gray[v][u];
+            if (bits == 1) {
+                index = (fmt == FMT_BMP1_INV) ? (index == 0) : (index != 0);
+                bytes[u / 8] |= index << (7 - u % 8);
+            } else if (bits == 4) {
+                bytes[u / 2] |= (index / 17) << ((u % 2) ? 0 : 4);
+            } else {
+                bytes[u] = index;
+            }
+        }
+        fwrite(bytes, 1, row, f);
+    }
+}
+
+static void write_image(FILE *f, Format_t fmt, uint16_t w, uint16_t h) {
+    static const char *const magic[] = { "P1", "P4", "P2", "P5", "P5" };
+    if (fmt >= FMT_BMP1) {
+        write_bmp(f, fmt, w, h, fmt != FMT_BMP4);
+        return;
+    }
+    bool pbm = (fmt == FMT_P1 || fmt == FMT_P4);
+    fprintf(f, "%s\n# comment\n%u %u\n", magic[fmt], w, h);
+    if (!pbm) {
+        fprintf(f, "%u\n", (fmt == FMT_P5_16) ? 1000 : 255);
+    }
+    for (uint16_t v = 0; v < h; v++) {
+        uint8_t packed = 0;
+        for (uint16_t u = 0; u < w; u++) {
+            uint8_t g = s_gray[v][u];
+            switch (fmt) {
+                case FMT_P1: fputc(g ? '0' : '1', f); if (u % 3 == 2) fputc(' ', f); break;
+                case FMT_P2: fprintf(f, "%u ", g); break;
+                case FMT_P5: fputc(g, f); break;
+                case FMT_P5_16: fputc((g * 1000 / 255) >> 8, f); fputc((g * 1000 / 255) & 0xFF, f); break;
+                default:
+                    packed |= (g ? 0 : 1) << (7 - u % 8);
+                    if (u % 8 == 7 || u == w - 1) {
+                        fputc(packed, f);
+                        packed = 0;
+                    }
+                    break;
+            }
+        }
+        if (fmt == FMT_P1 || fmt == FMT_P2) fputc('\n', f);
+    }
+}
+
+static bool expect_white(Format_t fmt, uint8_t g, uint8_t threshold) {
+    if (fmt == FMT_P5_16) {
+        return (uint32_t)(g * 1000 / 255) * 255 >= (uint32_t)threshold * 1000;
+    }
+    return g >= threshold;
+}
+
+// Byte and mask of logical pixel (x, y) under Paint.Rotate
+static uint32_t locate(uint16_t x, uint16_t y, uint8_t *mask) {
+    uint16_t X = x, Y = y;
+    switch (Paint.Rotate) {
+        case ROTATE_90:  X = Paint.WidthMemory - y - 1; Y = x; break;
+        case ROTATE_180: X = Paint.WidthMemory - x - 1; Y = Paint.HeightMemory - y - 1; break;
+        case ROTATE_270: X = y; Y = Paint.HeightMemory - x - 1; break;
+    }
+    *mask = 0x80 >> (X % 8);
+    return (uint32_t)Y * Paint.WidthByte + X / 8;
+}
+
+static void check_draw(Format_t fmt, uint16_t rotate, uint16_t turn) {
+    uint16_t w = 1 + rnd(MAX_W), h = 1 + rnd(MAX_H / (rnd(4) ? 3 : 1));
+    for (uint16_t v = 0; v < h; v++) {
+        for (uint16_t u = 0; u < w; u++) s_gray[v][u] = level(fmt);
+    }
+    FILE *f = tmpfile();
+    write_image(f, fmt, w, h);
+    rewind(f);
+
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) s_frame[i] = s_ref[i] = rnd(256);
+    Paint_NewImage(s_frame, EPD_W, EPD_H, rotate, WHITE);
+    uint16_t x = rnd(Paint.Width), y = rnd(Paint.Height);
+    EPD_ImageOptions_t opt = EPD_IMAGE_OPTIONS_DEFAULT();
+    opt.rotate = turn;
+    opt.threshold = 1 + rnd(255);
+    opt.invert = rnd(2);
+    opt.rop = rnd(2) ? EPD_ROP_COPY : EPD_ROP_XOR;
+
+    EPD_ImageInfo_t info;
+    if (EPD_Image_Draw(f, x, y, &opt, &info) != ESP_OK || info.width != w || info.height != h) {
+        fail("draw", fmt, rotate, turn);
+    }
+    fclose(f);
+
+    Paint_NewImage(s_ref, EPD_W, EPD_H, rotate, WHITE);
+    for (uint16_t v = 0; v < h; v++) {
+        for (uint16_t u = 0; u < w; u++) {
+            uint32_t lx, ly;
+            switch (turn) {
+                case ROTATE_90:  lx = h - 1 - v; ly = u; break;
+                case ROTATE_180: lx = w - 1 - u; ly = h - 1 - v; break;
+                case ROTATE_270: lx = v; ly = w - 1 - u; break;
+                default:         lx = u; ly = v; break;
+            }
+            lx += x;
+            ly += y;
+            if (lx >= Paint.Width || ly >= Paint.Height) continue;
+            bool white = expect_white(fmt, s_gray[v][u], opt.threshold) != opt.invert;
+            uint8_t m;
+            uint32_t a = locate(lx, ly, &m);
+            if (opt.rop == EPD_ROP_XOR) {
+                s_ref[a] ^= white ? m : 0;
+            } else {
+                s_ref[a] = white ? (s_ref[a] | m) : (s_ref[a] & ~m);
+            }
+        }
+    }
+    if (memcmp(s_frame, s_ref, EPD_FRAME_SIZE)) {
+        fail("pixels", fmt, rotate, turn);
+    }
+    s_cases++;
+}
+
+static void check_errors(void) {
+    for (uint16_t v = 0; v < 64; v++) {
+        for (uint16_t u = 0; u < 64; u++) s_gray[v][u] = rnd(256);
+    }
+    Paint_NewImage(s_frame, EPD_W, EPD_H, ROTATE_0, WHITE);
+
+    // Probe leaves the position; a truncated file fails after its rows
+    FILE *f = tmpfile();
+    write_image(f, FMT_P5, 64, 64);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    EPD_ImageInfo_t info;
+    if (EPD_Image_Probe(f, &info) != ESP_OK || ftell(f) != 0 || info.type != EPD_IMAGE_PGM ||
+        info.bits != 8 || info.width != 64 || info.height != 64) {
+        fail("probe", FMT_P5, 0, 0);
+    }
+    fclose(f);
+
+    char path[] = "/tmp/epaper_image_checkXXXXXX";
+    int fd = mkstemp(path);
+    f = fdopen(fd, "wb");
+    write_image(f, FMT_P5, 64, 64);
+    fclose(f);
+    if (truncate(path, size - 10) != 0 || EPD_Image_DrawFile(path, 0, 0, NULL, NULL) != ESP_ERR_INVALID_CRC) {
+        fail("truncated", FMT_P5, 0, 0);
+    }
+    remove(path);
+    if (EPD_Image_DrawFile(path, 0, 0, NULL, NULL) != ESP_ERR_NOT_FOUND) {
+        fail("missing", FMT_P5, 0, 0);
+    }
+
+    // Color formats are not supported
+    f = tmpfile();
+    fputs("P6\n4 4\n255\n", f);
+    rewind(f);
+    if (EPD_Image_Draw(f, 0, 0, NULL, NULL) != ESP_ERR_NOT_SUPPORTED) fail("ppm", FMT_P5, 0, 0);
+    fclose(f);
+    f = tmpfile();
+    write_bmp(f, FMT_BMP8, 8, 8, true);
+    fseek(f, 28, SEEK_SET);
+    le(f, 24, 2);
+    rewind(f);
+    if (EPD_Image_Draw(f, 0, 0, NULL, NULL) != ESP_ERR_NOT_SUPPORTED) fail("bmp24", FMT_BMP8, 0, 0);
+    fclose(f);
+
+    // Rows below the canvas are never read
+    f = tmpfile();
+    write_image(f, FMT_P5, 60, MAX_H);
+    size = ftell(f);
+    rewind(f);
+    if (EPD_Image_Draw(f, 0, Paint.Height - 20, NULL, NULL) != ESP_OK || ftell(f) > size / 2) {
+        fail("read past canvas", FMT_P5, 0, 0);
+    }
+    fclose(f);
+}
+
+int main(void) {
+    static const uint16_t rotations[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+
+    for (int c = 0; c < CASES; c++) {
+        for (int fmt = 0; fmt < FMT_COUNT; fmt++) {
+            for (int r = 0; r < 4; r++) {
+                for (int t = 0; t < 4; t++) {
+                    check_draw(fmt, rotations[r], rotations[t]);
+                }
+            }
+        }
+    }
+    check_errors();
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %u images drawn as defined\n", PANEL_NAME, (unsigned)s_cases);
+    return 0;
+}
@@ -0,0 +1,251 @@
+/*
+ * Check of the previous-image RAM (0x26) sync against a model of the
+ * controller RAM
+ *
+ * Usage: epaper_oldram_check_<panel> [seed] [steps]
+ *
+ * Random frames go out through full, fast, partial, stride, multi-window and
+ * clean updates, changing a few windows at a time (default 400 steps,
+ * seed 1). The host transport keeps the RAM the controller would hold; when
+ * a partial update starts (its 0x20 activation), 0x26 must hold exactly the
+ * frame the panel shows, in the layout (and on the 2.13" the inversion) of
+ * the partial writes. Along the way the sync is turned off and back on, a
+ * color frame suspends it, and the mirror is left invalid: with the sync off
+ * no 0x26 data may be sent, and after the next black/white full frame 0x26
+ * must be right again. Exit status is 0 when every update matches.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_arena.h"
+#include "host_transport.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#define RAM_INVERT 0xFF     // Partial writes send the frame inverted
+#else
+#define PANEL_NAME "4.2"
+#define RAM_INVERT 0x00
+#endif
+
+#define MAX_RECTS   4
+#define LOG_MAX     4096
+
+static uint8_t s_shown[EPD_FRAME_SIZE];     // What the panel shows
+static uint8_t s_next[EPD_FRAME_SIZE];
+static uint8_t s_color[EPD_FRAME_SIZE];
+static uint8_t s_window[EPD_FRAME_SIZE];
+static host_command_t s_log[LOG_MAX];
+static uint32_t s_seed = 1;
+static uint32_t s_step;
+static const char *s_op = "seed";
+static bool s_armed;                        // Check 0x26 at the next activation
+static uint32_t s_updates;                  // 0x20 activations
+static uint32_t s_checked;
+static int s_failures;
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+// 0x26 against the shown frame when the armed partial update starts
+static void on_command(uint8_t reg) {
+    if (reg != 0x20) {
+        return;
+    }
+    s_updates++;
+    if (!s_armed) {
+        return;
+    }
+    s_armed = false;
+    s_checked++;
+    for (uint16_t y = 0; y < EPD_H; y++) {
+        for (uint16_t xb = 0; xb < EPD_FRAME_STRIDE; xb++) {
+            uint8_t want = s_shown[y * EPD_FRAME_STRIDE + xb] ^ RAM_INVERT;
+            if (host_ram[1][y][xb] != want) {
+                printf("MISMATCH panel %s step %lu (%s): 0x26 byte %u of row %u is 0x%02X, panel shows 0x%02X\n",
+                       PANEL_NAME, (unsigned long)s_step, s_op, xb, y, host_ram[1][y][xb], want);
+                s_failures++;
+                return;
+            }
+        }
+    }
+}
+
+// Random window on whole bytes, changed in s_next
+static EPD_Rect_t change(void) {
+    EPD_Rect_t r;
+    uint16_t xb = rnd(EPD_FRAME_STRIDE);
+    uint16_t wb = 1 + rnd(EPD_FRAME_STRIDE - xb < 10 ? EPD_FRAME_STRIDE - xb : 10);
+
+    r.y = rnd(EPD_H);
+    r.height = 1 + rnd(EPD_H - r.y < 80 ? EPD_H - r.y : 80);
+    r.x = xb * 8;
+    r.width = (r.x + wb * 8 > EPD_W) ? EPD_W - r.x : wb * 8;
+    for (uint16_t y = r.y; y < r.y + r.height; y++) {
+        for (uint16_t b = xb; b < xb + wb; b++) {
+            if (rnd(4)) s_next[y * EPD_FRAME_STRIDE + b] = rnd(256);
+        }
+    }
+    return r;
+}
+
+// One partial update of a few changed windows; `check` arms the 0x26 check
+// for its first activation (EPD_Display_Part_Clean runs two, the second from
+// the inverted window)
+static void partial(bool check) {
+    EPD_Rect_t rects[MAX_RECTS];
+    size_t count = 1;
+    uint32_t updates = s_updates;
+
+    switch (rnd(4)) {
+        case 0:
+            s_op = "EPD_Display_Part";
+            rects[0] = change();
+            for (uint16_t r = 0, wb = (rects[0].width + 7) / 8; r < rects[0].height; r++) {
+                memcpy(s_window + r * wb, s_next + (rects[0].y + r) * EPD_FRAME_STRIDE + rects[0].x / 8, wb);
+            }
+            s_armed = check;
+            EPD_Display_Part(rects[0].x, rects[0].y, rects[0].width, rects[0].height, s_window);
+            break;
+        case 1:
+            s_op = "EPD_Display_Part_Stride";
+            rects[0] = change();
+            s_armed = check;
+            EPD_Display_Part_Stride(rects[0].x, rects[0].y, rects[0].width, rects[0].height, s_next);
+            break;
+        case 2:
+            s_op = "EPD_Display_Part_Multi";
+            count = 1 + rnd(MAX_RECTS);
+            for (size_t i = 0; i < count; i++) {
+                rects[i] = change();
+            }
+            s_armed = check;
+            EPD_Display_Part_Multi(rects, count, s_next);
+            break;
+        default:
+            s_op = "EPD_Display_Part_Clean";
+            rects[0] = change();
+            s_armed = check;
+            EPD_Display_Part_Clean(rects[0].x, rects[0].y, rects[0].width, rects[0].height, s_next);
+            break;
+    }
+    if (s_updates == updates) {
+        printf("MISMATCH panel %s step %lu (%s): no update\n", PANEL_NAME, (unsigned long)s_step, s_op);
+        s_failures++;
+    }
+    s_armed = false;
+}
+
+// Full frame, either waveform; leaves the sync valid again
+static void full(void) {
+    for (int n = 1 + rnd(6); n > 0; n--) {
+        change();
+    }
+    if (rnd(2)) {
+        s_op = "EPD_Display";
+        EPD_Init();
+        EPD_Display(s_next);
+    } else {
+        s_op = "EPD_Display_Fast";
+        EPD_Init_Fast(Fast_Seconds_1_5s);
+        EPD_Display_Fast(s_next);
+    }
+}
+
+int main(int argc, char **argv) {
+    EPD_ArenaConfig_t arena = { .placement = EPD_ARENA_INTERNAL_DMA, .old_ram = true };
+    uint32_t steps = (argc > 2) ? strtoul(argv[2], NULL, 0) : 400;
+    uint32_t syncs_off = 0, colors = 0, sleeps = 0;
+
+    s_seed = (argc > 1 && strtoul(argv[1], NULL, 0)) ? strtoul(argv[1], NULL, 0) : 1;
+    EPD_GPIOInit();
+    EPD_Arena_Init(&arena);
+    host_model_enable(true);
+    host_command_hook = on_command;
+
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        s_next[i] = rnd(256);
+    }
+    EPD_Display_Seed(s_next);
+    memcpy(s_shown, s_next, EPD_FRAME_SIZE);
+
+    for (s_step = 0; s_step < steps && !s_failures; s_step++) {
+        uint32_t op = rnd(16);
+        if (op < 10) {
+            partial(true);
+        } else if (op < 13) {
+            full();
+        } else if (op == 13) {
+            // Sync off: no 0x26 data, except the window EPD_Display_Part_Clean
+            // takes the panel to show when nothing tracks it
+            syncs_off++;
+            EPD_SetOldRamSync(false);
+            host_model_log(s_log, LOG_MAX);
+            partial(false);
+            size_t n = host_model_log(NULL, 0);
+            for (size_t i = 0; i < n && i < LOG_MAX; i++) {
+                if (s_log[i].reg == 0x26 && strcmp(s_op, "EPD_Display_Part_Clean") != 0) {
+                    printf("MISMATCH panel %s step %lu (%s): 0x26 written with the sync off\n",
+                           PANEL_NAME, (unsigned long)s_step, s_op);
+                    s_failures++;
+                    break;
+                }
+            }
+            // Back on, the mirror knows nothing until a full frame
+            memcpy(s_shown, s_next, EPD_FRAME_SIZE);
+            EPD_SetOldRamSync(true);
+            if (EPD_Shown() != NULL) {
+                printf("MISMATCH panel %s step %lu: mirror valid after the sync was off\n",
+                       PANEL_NAME, (unsigned long)s_step);
+                s_failures++;
+            }
+            full();
+        } else if (op == 14) {
+            // A color frame fills 0x26 with its red plane and suspends the
+            // sync until the next black/white full frame
+            s_op = "EPD_Display_Color";
+            colors++;
+            for (int n = 1 + rnd(6); n > 0; n--) {
+                change();
+            }
+            memset(s_color, 0, sizeof(s_color));
+            s_color[rnd(EPD_FRAME_SIZE)] = 0xFF;
+            EPD_Init();
+            EPD_Display_Color(s_next, s_color);
+            memcpy(s_shown, s_next, EPD_FRAME_SIZE);
+            if (EPD_Shown() != NULL) {
+                printf("MISMATCH panel %s step %lu: mirror valid over a color frame\n",
+                       PANEL_NAME, (unsigned long)s_step);
+                s_failures++;
+            }
+            full();
+        } else {
+            // Deep sleep drops both RAMs; the wake rewrites them from the mirror
+            s_op = "EPD_SLEEP_DEEP";
+            sleeps++;
+            EPD_Sleep_Mode(EPD_SLEEP_DEEP);
+            partial(true);
+        }
+        memcpy(s_shown, s_next, EPD_FRAME_SIZE);
+    }
+    if (!s_failures && (EPD_Shown() == NULL || memcmp(EPD_Shown(), s_shown, EPD_FRAME_SIZE) != 0)) {
+        printf("MISMATCH panel %s: EPD_Shown() is not the last frame\n", PANEL_NAME);
+        s_failures++;
+    }
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: 0x26 matched the shown frame at %lu partial updates over %lu steps "
+           "(%lu with the sync off, %lu color frames, %lu deep sleeps)\n",
+           PANEL_NAME, (unsigned long)s_checked, (unsigned long)s_step,
+           (unsigned long)syncs_off, (unsigned long)colors, (unsigned long)sleeps);
+    return 0;
+}
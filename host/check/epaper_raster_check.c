@@ -0,0 +1,319 @@
+/*
+ * Check of the polygon, thick line and arc rasterizer
+ *
+ * Usage: epaper_raster_check_<panel>
+ *
+ * Random polygons (both fill rules), pie slices and arcs are drawn with
+ * epaper_raster.h under all four rotations, on a black/white and on a
+ * black/white/red canvas, and compared bit for bit with the same shapes
+ * decided pixel by pixel from their definition (exact edge crossings for
+ * polygons, distance and angle tests for sectors) and drawn with
+ * Paint_SetPixel. Every shape is also drawn in random bands with
+ * EPD_Paint_SetBand and must come out the same, and drawn in a single band
+ * must leave the rows outside it untouched. Thick lines are checked
+ * geometrically: pixels well inside the stroke must be set, pixels well
+ * outside it clear.
+ * Exit status is 0 when everything matches.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_raster.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define CASES   60
+#define MARGIN  40
+
+static uint8_t s_frame[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_band[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_one[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint32_t s_seed = 0x9E3779B9;
+static int s_failures;
+static uint32_t s_shapes;
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+static int32_t rnd_range(int32_t lo, int32_t hi) {
+    return lo + (int32_t)rnd(hi - lo + 1);
+}
+
+static void setup(uint8_t (*frames)[EPD_FRAME_SIZE], uint8_t planes, uint16_t rotate) {
+    uint8_t *p[EPD_MAX_PLANES] = { frames[0], frames[1] };
+    memset(frames[0], 0xFF, EPD_FRAME_SIZE);
+    memset(frames[1], 0x00, EPD_FRAME_SIZE);
+    Paint_NewImagePlanes(p, planes, EPD_W, EPD_H, rotate, WHITE);
+}
+
+static void ref_pixel(int32_t x, int32_t y, uint16_t color) {
+    if (x >= 0 && y >= 0 && x < Paint.Width && y < Paint.Height) {
+        Paint_SetPixel(x, y, color);
+    }
+}
+
+static int64_t ceil_div(int64_t n, int64_t d) {
+    return (n >= 0) ? (n + d - 1) / d : -((-n) / d);
+}
+
+// Polygon by definition: on row y every edge crossing it counts for the
+// pixels at or right of ceil(x of the edge at y)
+static void ref_polygon(const EPD_Point_t *pts, size_t n, EPD_FillRule_t rule, uint16_t color) {
+    for (int32_t y = 0; y < Paint.Height; y++) {
+        for (int32_t x = 0; x < Paint.Width; x++) {
+            int32_t wind = 0;
+            for (size_t i = 0; i < n; i++) {
+                EPD_Point_t a = pts[i], b = pts[(i + 1) % n];
+                int dir = 1;
+                if (a.y == b.y) continue;
+                if (a.y > b.y) {
+                    EPD_Point_t t = a;
+                    a = b;
+                    b = t;
+                    dir = -1;
+                }
+                if (y < a.y || y >= b.y) continue;
+                int64_t q = ceil_div((int64_t)a.x * (b.y - a.y) + (int64_t)(y - a.y) * (b.x - a.x), b.y - a.y);
+                if (q <= x) wind += (rule == EPD_FILL_NONZERO) ? dir : 1;
+            }
+            if ((rule == EPD_FILL_NONZERO) ? (wind != 0) : (wind & 1)) {
+                ref_pixel(x, y, color);
+            }
+        }
+    }
+}
+
+static int32_t ref_sin(int32_t deg) {
+    deg %= 360;
+    if (deg < 0) deg += 360;
+    int sign = (deg >= 180) ? -1 : 1;
+    deg %= 180;
+    if (deg > 90) deg = 180 - deg;
+    return sign * (int32_t)lround(16384.0 * sin(deg * M_PI / 180.0));
+}
+
+static void ref_sector(int32_t cx, int32_t cy, int32_t ro, int32_t ri, int32_t start, int32_t end, uint16_t color) {
+    int32_t sweep = end - start;
+    while (sweep <= 0) sweep += 360;
+    int64_t c0 = ref_sin(start + 90), s0 = ref_sin(start);
+    int64_t c1 = ref_sin(start + sweep + 90), s1 = ref_sin(start + sweep);
+
+    for (int32_t y = 0; y < Paint.Height; y++) {
+        for (int32_t x = 0; x < Paint.Width; x++) {
+            int64_t dx = x - cx, dy = y - cy, d2 = dx * dx + dy * dy;
+            if (d2 > (int64_t)ro * ro + ro) continue;
+            if (ri > 0 && d2 <= (int64_t)ri * ri - ri) continue;
+            if (sweep < 360) {
+                bool h0 = c0 * dy - s0 * dx >= 0, h1 = s1 * dx - c1 * dy >= 0;
+                if ((sweep <= 180) ? !(h0 && h1) : !(h0 || h1)) continue;
+            }
+            ref_pixel(x, y, color);
+        }
+    }
+}
+
+typedef struct {
+    int kind;                       // 0 polygon, 1 pie, 2 arc
+    EPD_Point_t pts[EPD_RASTER_MAX_POINTS];
+    size_t count;
+    EPD_FillRule_t rule;
+    int16_t cx, cy, start, end;
+    uint16_t radius, width, color;
+} shape_t;
+
+static void draw(const shape_t *s) {
+    switch (s->kind) {
+        case 0:
+            EPD_FillPolygon(s->pts, s->count, s->rule, s->color);
+            break;
+        case 1:
+            EPD_FillPie(s->cx, s->cy, s->radius, s->start, s->end, s->color);
+            break;
+        default:
+            EPD_DrawArc(s->cx, s->cy, s->radius, s->width, s->start, s->end, s->color);
+            break;
+    }
+}
+
+static void draw_ref(const shape_t *s) {
+    switch (s->kind) {
+        case 0:
+            ref_polygon(s->pts, s->count, s->rule, s->color);
+            break;
+        case 1:
+            ref_sector(s->cx, s->cy, s->radius, 0, s->start, s->end, s->color);
+            break;
+        default:
+            ref_sector(s->cx, s->cy, s->radius, (int32_t)s->radius - s->width + 1, s->start, s->end, s->color);
+            break;
+    }
+}
+
+static void make_shape(shape_t *s, uint8_t planes) {
+    static const uint16_t colors[] = { BLACK, RED };
+    memset(s, 0, sizeof(*s));
+    s->kind = rnd(3);
+    s->color = colors[rnd(planes)];
+    if (s->kind == 0) {
+        // Small polygons inside, larger ones reaching past the edges
+        int32_t reach = rnd(2) ? 30 : MARGIN + EPD_W;
+        int32_t ox = rnd_range(-MARGIN, EPD_W + MARGIN), oy = rnd_range(-MARGIN, EPD_W + MARGIN);
+        s->count = 3 + rnd(rnd(4) ? 8 : EPD_RASTER_MAX_POINTS - 2);
+        s->rule = rnd(2);
+        for (size_t i = 0; i < s->count; i++) {
+            s->pts[i].x = ox + rnd_range(-reach, reach);
+            s->pts[i].y = oy + rnd_range(-reach, reach);
+        }
+        return;
+    }
+    s->cx = rnd_range(-MARGIN, EPD_W + MARGIN);
+    s->cy = rnd_range(-MARGIN, EPD_W + MARGIN);
+    s->radius = rnd(rnd(4) ? 60 : 200);
+    s->width = 1 + rnd(s->radius + 2);
+    s->start = rnd_range(-400, 400);
+    s->end = rnd(8) ? s->start + rnd_range(-30, 400) : s->start;
+    if (rnd(3) == 0) {
+        // Rays along the axes and diagonals, half turns
+        s->start = rnd_range(-8, 8) * 45;
+        s->end = s->start + (rnd(2) ? 180 : rnd_range(-8, 8) * 45);
+    }
+}
+
+// s_one holds the reference in memory rows [y0, y1) and the background
+// elsewhere
+static bool band_only(uint8_t p, uint16_t y0, uint16_t y1) {
+    uint8_t background = (p == 0) ? 0xFF : 0x00;
+    for (uint32_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        uint32_t row = i / Paint.WidthByte;
+        uint8_t expect = (row >= y0 && row < y1) ? s_ref[p][i] : background;
+        if (s_one[p][i] != expect) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void check_shape(const shape_t *s, uint8_t planes, uint16_t rotate) {
+    static const char *const kinds[] = { "polygon", "pie", "arc" };
+
+    setup(s_frame, planes, rotate);
+    draw(s);
+    setup(s_ref, planes, rotate);
+    draw_ref(s);
+
+    // Bands of random height cover the canvas
+    setup(s_band, planes, rotate);
+    for (uint16_t y0 = 0; y0 < Paint.HeightMemory;) {
+        uint16_t y1 = y0 + 1 + rnd(Paint.HeightMemory / 3);
+        EPD_Paint_SetBand(y0, y1);
+        draw(s);
+        y0 = y1;
+    }
+    EPD_Paint_SetBand(0, UINT16_MAX);
+
+    // A single band leaves the rows outside it alone
+    uint16_t b0 = rnd(Paint.HeightMemory), b1 = b0 + 1 + rnd(Paint.HeightMemory - b0);
+    setup(s_one, planes, rotate);
+    EPD_Paint_SetBand(b0, b1);
+    draw(s);
+    EPD_Paint_SetBand(0, UINT16_MAX);
+    s_shapes++;
+
+    for (uint8_t p = 0; p < planes; p++) {
+        const char *what = memcmp(s_frame[p], s_ref[p], EPD_FRAME_SIZE) ? "definition"
+                         : memcmp(s_band[p], s_ref[p], EPD_FRAME_SIZE) ? "banded drawing"
+                         : !band_only(p, b0, b1) ? "single band" : NULL;
+        if (what && s_failures++ < 10) {
+            printf("MISMATCH panel %s: %s vs %s, rotate %u, %u plane(s), plane %u", PANEL_NAME,
+                   kinds[s->kind], what, rotate, planes, p);
+            if (s->kind == 0) {
+                printf(", rule %d:", s->rule);
+                for (size_t i = 0; i < s->count; i++) printf(" (%d,%d)", s->pts[i].x, s->pts[i].y);
+            } else {
+                printf(", center (%d,%d) radius %u width %u, %d..%d", s->cx, s->cy, s->radius, s->width,
+                       s->start, s->end);
+            }
+            printf("\n");
+            break;
+        }
+    }
+}
+
+static bool pixel_set(int32_t x, int32_t y) {
+    return !(Paint.Image[y * Paint.WidthByte + x / 8] & (0x80 >> (x % 8)));
+}
+
+// Thick line: pixel centers closer than width / 2 - 1 to the stroke must be
+// drawn, those farther than width / 2 + 1 must not
+static void check_thick_line(void) {
+    setup(s_frame, 1, ROTATE_0);
+    int32_t x0 = rnd_range(-MARGIN, EPD_W + MARGIN), y0 = rnd_range(-MARGIN, EPD_H + MARGIN);
+    int32_t x1 = rnd(8) ? rnd_range(-MARGIN, EPD_W + MARGIN) : x0, y1 = rnd(8) ? rnd_range(-MARGIN, EPD_H + MARGIN) : y0;
+    uint16_t width = 1 + rnd(rnd(4) ? 8 : 40);
+    EPD_LineCap_t cap = rnd(3);
+    EPD_DrawThickLine(x0, y0, x1, y1, width, cap, BLACK);
+    s_shapes++;
+
+    double dx = x1 - x0, dy = y1 - y0, len = sqrt(dx * dx + dy * dy);
+    double ux = (len > 0) ? dx / len : 1, uy = (len > 0) ? dy / len : 0;
+    double half = width / 2.0, ext = (cap == EPD_CAP_SQUARE) ? half : 0;
+    for (int32_t y = 0; y < Paint.Height; y++) {
+        for (int32_t x = 0; x < Paint.Width; x++) {
+            double px = x - x0, py = y - y0;
+            double t = px * ux + py * uy, d = fabs(px * uy - py * ux);
+            double dist;        // From the stroke: positive outside, negative inside
+            if (cap == EPD_CAP_ROUND) {
+                double tc = (t < 0) ? 0 : (t > len) ? len : t;
+                dist = hypot(px - tc * ux, py - tc * uy) - half;
+            } else {
+                double along = (t < -ext) ? -ext - t : (t > len + ext) ? t - len - ext : -fmin(t + ext, len + ext - t);
+                dist = fmax(d - half, along);
+            }
+            if (len == 0 && cap == EPD_CAP_BUTT) {
+                dist = 2;
+            }
+            bool set = pixel_set(x, y);
+            if ((dist < -1 && !set) || (dist > 1 && set)) {
+                if (s_failures++ < 10) {
+                    printf("MISMATCH panel %s: thick line (%d,%d)-(%d,%d) width %u cap %d at (%d,%d): %s\n",
+                           PANEL_NAME, x0, y0, x1, y1, width, cap, x, y, set ? "set" : "clear");
+                }
+                return;
+            }
+        }
+    }
+}
+
+int main(void) {
+    static const uint16_t rotations[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+    shape_t shape;
+
+    for (int c = 0; c < CASES; c++) {
+        for (uint8_t planes = 1; planes <= EPD_MAX_PLANES; planes++) {
+            make_shape(&shape, planes);
+            for (int r = 0; r < 4; r++) {
+                check_shape(&shape, planes, rotations[r]);
+            }
+        }
+        for (int l = 0; l < 4; l++) {
+            check_thick_line();
+        }
+    }
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %u shapes match their definition\n", PANEL_NAME, (unsigned)s_shapes);
+    return 0;
+}
@@ -0,0 +1,356 @@
+/*
+ * Reference rasterizer
+ *
+ * Frozen copy of the original Paint_SetPixel-based drawing code, operating on
+ * its own canvas (Ref_Paint). The differential check compares the driver's
+ * drawing functions against it bit for bit, so optimized paths must keep the
+ * exact pixel output. Do not optimize or "fix" this file: it pins the
+ * behaviour the driver is expected to reproduce.
+ */
+#include "epaper_reference.h"
+#include "epaper_fonts.h"
+
+Paint_t Ref_Paint;
+
+void Ref_NewImage(uint8_t *image, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color) {
+    Ref_Paint.Image = 0x00;
+    Ref_Paint.Image = image;
+
+    Ref_Paint.WidthMemory = Width;
+    Ref_Paint.HeightMemory = Height;
+    Ref_Paint.Color = Color;
+    Ref_Paint.WidthByte = (Width % 8 == 0) ? (Width / 8 ) : (Width / 8 + 1);
+    Ref_Paint.HeightByte = Height;
+    Ref_Paint.Rotate = Rotate;
+    if (Rotate == ROTATE_0 || Rotate == ROTATE_180) {
+        Ref_Paint.Width = Width;
+        Ref_Paint.Height = Height;
+    } else {
+        Ref_Paint.Width = Height;
+        Ref_Paint.Height = Width;
+    }
+}
+
+void Ref_SetPixel(uint16_t Xpoint, uint16_t Ypoint, uint16_t Color) {
+    uint16_t X, Y;
+    uint32_t Addr;
+    uint8_t Rdata;
+    switch (Ref_Paint.Rotate) {
+        case 0:
+            X = Xpoint;
+            Y = Ypoint;
+            break;
+        case 90:
+            X = Ref_Paint.WidthMemory - Ypoint - 1;
+            Y = Xpoint;
+            break;
+        case 180:
+            X = Ref_Paint.WidthMemory - Xpoint - 1;
+            Y = Ref_Paint.HeightMemory - Ypoint - 1;
+            break;
+        case 270:
+            X = Ypoint;
+            Y = Ref_Paint.HeightMemory - Xpoint - 1;
+            break;
+        default:
+            return;
+    }
+    if (X >= Ref_Paint.WidthMemory || Y >= Ref_Paint.HeightMemory) return;
+
+    Addr = X / 8 + Y * Ref_Paint.WidthByte;
+    Rdata = Ref_Paint.Image[Addr];
+    if (Color == BLACK) {
+        Ref_Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8)); // clear bit
+    } else {
+        Ref_Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));  // set bit
+    }
+}
+
+void Ref_Full(uint8_t Color) {
+    uint16_t X, Y;
+    uint32_t Addr;
+    for (Y = 0; Y < Ref_Paint.HeightByte; Y++) {
+        for (X = 0; X < Ref_Paint.WidthByte; X++) {
+            Addr = X + Y * Ref_Paint.WidthByte;
+            Ref_Paint.Image[Addr] = Color;
+        }
+    }
+}
+
+void Ref_ShowPicture(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *BMP, uint16_t Color) {
+    uint16_t j = 0, t;
+    uint16_t i, n, temp;
+    uint16_t x0, width = 0;
+    x += 1; y += 1; x0 = x;
+    width = sizex;
+    sizex = sizex / 8 + ((sizex % 8) ? 1 : 0);
+    for (n = 0; n < sizey; n++) {
+        for (i = 0; i < sizex; i++) {
+            temp = BMP[j];
+            for (t = 0; t < 8; t++) {
+                if (temp & 0x80) {
+                    Ref_SetPixel(x - 1, y - 1, (Color == WHITE) ? BLACK : WHITE); // Inverse color check?
+                } else {
+                    Ref_SetPixel(x - 1, y - 1, Color);
+                }
+                x++;
+                temp <<= 1;
+            }
+            if ((x - x0) == width) {
+                x = x0;
+                y++;
+            }
+            j++;
+        }
+    }
+}
+
+// Clear a rectangular window
+void Ref_ClearWindows(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color) {
+    uint16_t i, j;
+    for (i = ys; i < ye; i++) {
+        for (j = xs; j < xe; j++) {
+            Ref_SetPixel(j, i, color);
+        }
+    }
+}
+
+// Draw a line using Bresenham algorithm
+void Ref_DrawLine(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend, uint16_t Color) {
+    uint16_t Xpoint, Ypoint;
+    int dx, dy;
+    int XAddway, YAddway;
+    int Esp;
+    Xpoint = Xstart;
+    Ypoint = Ystart;
+    dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+    XAddway = Xstart < Xend ? 1 : -1;
+    YAddway = Ystart < Yend ? 1 : -1;
+    Esp = dx + dy;
+    
+    for (;;) {
+        Ref_SetPixel(Xpoint, Ypoint, Color);
+        if (2 * Esp >= dy) {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx) {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+}
+
+// Draw a rectangle
+void Ref_DrawRectangle(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend, uint16_t Color, uint8_t mode) {
+    uint16_t i;
+    if (mode) {
+        // Filled rectangle
+        for (i = Ystart; i < Yend; i++) {
+            Ref_DrawLine(Xstart, i, Xend, i, Color);
+        }
+    } else {
+        // Outline only
+        Ref_DrawLine(Xstart, Ystart, Xend, Ystart, Color);
+        Ref_DrawLine(Xstart, Ystart, Xstart, Yend, Color);
+        Ref_DrawLine(Xend, Yend, Xend, Ystart, Color);
+        Ref_DrawLine(Xend, Yend, Xstart, Yend, Color);
+    }
+}
+
+// Draw a circle using Bresenham algorithm
+void Ref_DrawCircle(uint16_t X_Center, uint16_t Y_Center, uint16_t Radius, uint16_t Color, uint8_t mode) {
+    int Esp, sCountY;
+    uint16_t XCurrent, YCurrent;
+    XCurrent = 0;
+    YCurrent = Radius;
+    Esp = 3 - (Radius << 1);
+    
+    if (mode) {
+        // Filled circle
+        while (XCurrent <= YCurrent) {
+            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY++) {
+                Ref_SetPixel(X_Center + XCurrent, Y_Center + sCountY, Color);
+                Ref_SetPixel(X_Center - XCurrent, Y_Center + sCountY, Color);
+                Ref_SetPixel(X_Center - sCountY, Y_Center + XCurrent, Color);
+                Ref_SetPixel(X_Center - sCountY, Y_Center - XCurrent, Color);
+                Ref_SetPixel(X_Center - XCurrent, Y_Center - sCountY, Color);
+                Ref_SetPixel(X_Center + XCurrent, Y_Center - sCountY, Color);
+                Ref_SetPixel(X_Center + sCountY, Y_Center - XCurrent, Color);
+                Ref_SetPixel(X_Center + sCountY, Y_Center + XCurrent, Color);
+            }
+            if ((int)Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    } else {
+        // Hollow circle
+        while (XCurrent <= YCurrent) {
+            Ref_SetPixel(X_Center + XCurrent, Y_Center + YCurrent, Color);
+            Ref_SetPixel(X_Center - XCurrent, Y_Center + YCurrent, Color);
+            Ref_SetPixel(X_Center - YCurrent, Y_Center + XCurrent, Color);
+            Ref_SetPixel(X_Center - YCurrent, Y_Center - XCurrent, Color);
+            Ref_SetPixel(X_Center - XCurrent, Y_Center - YCurrent, Color);
+            Ref_SetPixel(X_Center + XCurrent, Y_Center - YCurrent, Color);
+            Ref_SetPixel(X_Center + YCurrent, Y_Center - XCurrent, Color);
+            Ref_SetPixel(X_Center + YCurrent, Y_Center + XCurrent, Color);
+            
+            if ((int)Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    }
+}
+
+// Text Rendering Functions
+
+// Helper function for exponentiation
+static uint32_t Ref_Pow(uint16_t m, uint16_t n) {
+    uint32_t result = 1;
+    while (n--) {
+        result *= m;
+    }
+    return result;
+}
+
+// Display a single character
+void Ref_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t color) {
+    uint16_t i, m, temp, size2, chr1;
+    uint16_t x0, y0;
+    x += 1; y += 1; x0 = x; y0 = y;
+    
+    if (size1 == 8) size2 = 6;
+    else size2 = (size1 / 8 + ((size1 % 8) ? 1 : 0)) * (size1 / 2);
+    
+    chr1 = chr - ' '; // Calculate offset from space character
+    
+    for (i = 0; i < size2; i++) {
+        if (size1 == 8) {
+            temp = ascii_0806[chr1][i];
+        } else if (size1 == 12) {
+            temp = ascii_1206[chr1][i];
+        } else if (size1 == 16) {
+            temp = ascii_1608[chr1][i];
+        } else if (size1 == 24) {
+            temp = ascii_2412[chr1][i];
+        } else {
+            return; // Unsupported size
+        }
+        
+        for (m = 0; m < 8; m++) {
+            if (temp & 0x01) {
+                Ref_SetPixel(x, y, color);
+            } else {
+                Ref_SetPixel(x, y, !color);
+            }
+            temp >>= 1;
+            y++;
+        }
+        x++;
+        if ((size1 != 8) && ((x - x0) == size1 / 2)) {
+            x = x0;
+            y0 = y0 + 8;
+        }
+        y = y0;
+    }
+}
+
+// Display a string
+void Ref_ShowString(uint16_t x, uint16_t y, const char *chr, uint16_t size1, uint16_t color) {
+    while (*chr != '\0') {
+        Ref_ShowChar(x, y, *chr, size1, color);
+        chr++;
+        x += size1 / 2;
+    }
+}
+
+// Display an integer number
+void Ref_ShowNum(uint16_t x, uint16_t y, uint32_t num, uint16_t len, uint16_t size1, uint16_t color) {
+    uint8_t t, temp, m = 0;
+    if (size1 == 8) m = 2;
+    
+    for (t = 0; t < len; t++) {
+        temp = (num / Ref_Pow(10, len - t - 1)) % 10;
+        if (temp == 0) {
+            Ref_ShowChar(x + (size1 / 2 + m) * t, y, '0', size1, color);
+        } else {
+            Ref_ShowChar(x + (size1 / 2 + m) * t, y, temp + '0', size1, color);
+        }
+    }
+}
+
+// Display a floating point number
+void Ref_ShowFloatNum1(uint16_t x, uint16_t y, float num, uint8_t len, uint8_t pre, uint8_t sizey, uint8_t color) {
+    uint8_t t, temp, sizex;
+    uint16_t num1;
+    sizex = sizey / 2;
+    num1 = num * Ref_Pow(10, pre);
+    
+    for (t = 0; t < len; t++) {
+        temp = (num1 / Ref_Pow(10, len - t - 1)) % 10;
+        if (t == (len - pre)) {
+            Ref_ShowChar(x + (len - pre) * sizex, y, '.', sizey, color);
+            t++;
+            len += 1;
+        }
+        Ref_ShowChar(x + t * sizex, y, temp + 48, sizey, color);
+    }
+}
+
+/*
+ * Functions added to the driver after the freeze, defined one pixel at a time
+ * on top of Ref_SetPixel. They spell out the intended result rather than
+ * preserve old code.
+ */
+
+// 1 = white; out-of-canvas pixels read as -1
+static int Ref_GetPixel(uint16_t Xpoint, uint16_t Ypoint) {
+    uint16_t X, Y;
+    switch (Ref_Paint.Rotate) {
+        case 0:   X = Xpoint; Y = Ypoint; break;
+        case 90:  X = Ref_Paint.WidthMemory - Ypoint - 1; Y = Xpoint; break;
+        case 180: X = Ref_Paint.WidthMemory - Xpoint - 1; Y = Ref_Paint.HeightMemory - Ypoint - 1; break;
+        case 270: X = Ypoint; Y = Ref_Paint.HeightMemory - Xpoint - 1; break;
+        default:  return -1;
+    }
+    if (X >= Ref_Paint.WidthMemory || Y >= Ref_Paint.HeightMemory) return -1;
+    return (Ref_Paint.Image[X / 8 + Y * Ref_Paint.WidthByte] >> (7 - X % 8)) & 1;
+}
+
+void Ref_Blit(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+              const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop) {
+    uint32_t stride = (sizex + 7) / 8;
+    for (uint16_t r = 0; r < sizey; r++) {
+        for (uint16_t i = 0; i < sizex; i++) {
+            uint32_t byte = r * stride + i / 8;
+            uint8_t bit = 0x80 >> (i % 8);
+            int d = Ref_GetPixel(x + i, y + r);
+            int s = Src ? ((Src[byte] & bit) != 0) : 0;
+            int v;
+            if (d < 0 || (Mask && !(Mask[byte] & bit))) continue;
+            switch (rop) {
+                case EPD_ROP_OR:    v = d | s; break;
+                case EPD_ROP_AND:   v = d & s; break;
+                case EPD_ROP_XOR:   v = d ^ s; break;
+                case EPD_ROP_NOT:   v = !s; break;
+                case EPD_ROP_SET:   v = 1; break;
+                case EPD_ROP_CLEAR: v = 0; break;
+                default:            v = s; break;
+            }
+            Ref_SetPixel(x + i, y + r, v ? WHITE : BLACK);
+        }
+    }
+}
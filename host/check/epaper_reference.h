@@ -0,0 +1,28 @@
+#ifndef __EPAPER_REFERENCE_H__
+#define __EPAPER_REFERENCE_H__
+
+#include <stdint.h>
+#include "epaper_driver.h"
+
+// Reference rasterizer for the differential check, see epaper_reference.c.
+// Same signatures as the driver's Paint_/EPD_ drawing functions, drawing into
+// Ref_Paint instead of Paint.
+
+extern Paint_t Ref_Paint;
+
+void Ref_NewImage(uint8_t *image, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color);
+void Ref_SetPixel(uint16_t Xpoint, uint16_t Ypoint, uint16_t Color);
+void Ref_Full(uint8_t Color);
+void Ref_ShowPicture(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *BMP, uint16_t Color);
+void Ref_ClearWindows(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
+void Ref_DrawLine(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend, uint16_t Color);
+void Ref_DrawRectangle(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend, uint16_t Color, uint8_t mode);
+void Ref_DrawCircle(uint16_t X_Center, uint16_t Y_Center, uint16_t Radius, uint16_t Color, uint8_t mode);
+void Ref_ShowChar(uint16_t x, uint16_t y, uint16_t chr, uint16_t size1, uint16_t color);
+void Ref_ShowString(uint16_t x, uint16_t y, const char *chr, uint16_t size1, uint16_t color);
+void Ref_ShowNum(uint16_t x, uint16_t y, uint32_t num, uint16_t len, uint16_t size1, uint16_t color);
+void Ref_ShowFloatNum1(uint16_t x, uint16_t y, float num, uint8_t len, uint8_t pre, uint8_t sizey, uint8_t color);
+void Ref_Blit(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+              const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop);
+
+#endif // __EPAPER_REFERENCE_H__
@@ -0,0 +1,237 @@
+/*
+ * Check of parallel band rendering against serial execution
+ *
+ * Usage: epaper_render_check_<panel>
+ *
+ * Random display lists covering every command are rendered with EPD_Render
+ * for 1 to EPD_RENDER_MAX_WORKERS workers and several band sizes, under all
+ * four rotations and on a black/white/red canvas, and compared bit for bit
+ * with the same list run in order through EPD_Cmd_Run. So is a frame of large
+ * shapes crossing every band (a filled circle, diagonals, long text), whose
+ * CPU time in bands against serially is reported but not checked: timing
+ * belongs to the benchmark (render/shapes_*).
+ * Exit status is 0 when every frame matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "epaper_driver.h"
+#include "epaper_render.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define LISTS     12
+#define LIST_MAX  64
+
+#define WORK_FRAMES     20
+
+static uint8_t s_ref[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_frame[EPD_MAX_PLANES][EPD_FRAME_SIZE];
+static uint8_t s_bitmap[64 * 64 / 8];
+static EPD_DrawCmd_t s_list[LIST_MAX];
+static uint32_t s_seed = 0x2545F491;
+static int s_failures;
+static uint32_t s_frames, s_steals;
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+// Draws a diagonal through Paint, as a CALL command may
+static void draw_diagonal(void *arg) {
+    uint16_t x = (uint16_t)(uintptr_t)arg;
+    for (uint16_t i = 0; i < 64; i++) {
+        Paint_SetPixel(x + i, i * 2, BLACK);
+    }
+}
+
+// The 8x6 font stops at '{' (92 glyphs), the others cover ' ' to '~'
+static char rnd_char(uint8_t size) {
+    return (char)(' ' + rnd(size == 8 ? 92 : 95));
+}
+
+static uint16_t rnd_color(uint8_t planes) {
+    static const uint16_t colors[] = { BLACK, WHITE, RED };
+    return colors[rnd(planes > 1 ? 3 : 2)];
+}
+
+static size_t make_list(uint8_t planes) {
+    uint16_t span = (EPD_W > EPD_H ? EPD_W : EPD_H) + 40;
+    static const uint8_t sizes[] = { 8, 12, 16, 24, 10 };
+    size_t count = 1 + rnd(LIST_MAX);
+
+    for (size_t i = 0; i < count; i++) {
+        EPD_DrawCmd_t *c = &s_list[i];
+        memset(c, 0, sizeof(*c));
+        c->op = rnd(EPD_CMD_CALL + 1);
+        c->color = rnd_color(planes);
+        c->x0 = rnd(span);
+        c->y0 = rnd(span);
+        c->x1 = rnd(span);
+        c->y1 = rnd(span);
+        switch (c->op) {
+            case EPD_CMD_FILL:
+                // Mostly late in the list, so the rest is not wiped out
+                if (rnd(4)) c->op = EPD_CMD_PIXEL;
+                break;
+            case EPD_CMD_RECT:
+            case EPD_CMD_CIRCLE:
+                c->mode = rnd(2);
+                if (c->op == EPD_CMD_CIRCLE) c->x1 = rnd(80);
+                break;
+            case EPD_CMD_STRING:
+                c->size = sizes[rnd(sizeof(sizes))];
+                for (uint32_t n = rnd(EPD_CMD_TEXT_MAX - 1), t = 0; t < n; t++) {
+                    c->text[t] = rnd_char(c->size);
+                }
+                break;
+            case EPD_CMD_NUM:
+                c->size = sizes[rnd(sizeof(sizes))];
+                c->mode = rnd(12);
+                c->num = s_seed;
+                break;
+            case EPD_CMD_PICTURE:
+            case EPD_CMD_BLIT:
+                c->x1 = 1 + rnd(64);
+                c->y1 = 1 + rnd(64);
+                if (c->op == EPD_CMD_PICTURE && rnd(3)) c->x1 = (c->x1 + 7) & ~7;
+                if (c->op == EPD_CMD_PICTURE && c->x1 % 8) c->y1 = 1 + rnd(8);
+                c->mode = rnd(EPD_ROP_CLEAR + 1);
+                c->image = s_bitmap;
+                break;
+            case EPD_CMD_CALL:
+                c->call.fn = draw_diagonal;
+                c->call.arg = (void *)(uintptr_t)rnd(EPD_W);
+                break;
+            default:
+                break;
+        }
+    }
+    return count;
+}
+
+static void setup(uint8_t (*frames)[EPD_FRAME_SIZE], uint8_t planes, uint16_t rotate) {
+    uint8_t *p[EPD_MAX_PLANES] = { frames[0], frames[1] };
+    memset(frames[0], 0xFF, EPD_FRAME_SIZE);
+    memset(frames[1], 0x00, EPD_FRAME_SIZE);
+    Paint_NewImagePlanes(p, planes, EPD_W, EPD_H, rotate, WHITE);
+}
+
+static void check_list(size_t count, uint8_t planes, uint16_t rotate) {
+    setup(s_ref, planes, rotate);
+    for (size_t i = 0; i < count; i++) {
+        EPD_Cmd_Run(&s_list[i]);
+    }
+
+    for (uint8_t workers = 1; workers <= EPD_RENDER_MAX_WORKERS; workers++) {
+        EPD_RenderConfig_t cfg = EPD_RENDER_CONFIG_DEFAULT();
+        cfg.workers = workers;
+        cfg.bands_per_worker = 1 + rnd(workers == 4 ? 200 : 8);
+        if (EPD_Render_Init(&cfg) != ESP_OK) {
+            printf("MISMATCH panel %s: render init with %u workers\n", PANEL_NAME, workers);
+            s_failures++;
+            return;
+        }
+        EPD_Render_ResetStats();
+        setup(s_frame, planes, rotate);
+        EPD_Render(s_list, count);
+
+        EPD_RenderStats_t stats;
+        EPD_Render_GetStats(&stats);
+        s_frames += stats.frames;
+        s_steals += stats.steals;
+        for (uint8_t p = 0; p < planes; p++) {
+            if (memcmp(s_frame[p], s_ref[p], EPD_FRAME_SIZE) != 0) {
+                printf("MISMATCH panel %s: rotate %u, %u plane(s), %u workers x %u bands, %u commands: plane %u\n",
+                       PANEL_NAME, rotate, planes, workers, cfg.bands_per_worker, (unsigned)count, p);
+                s_failures++;
+                break;
+            }
+        }
+    }
+}
+
+// CPU time of all threads, helpers included
+static double cpu_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Best of three runs of WORK_FRAMES frames
+static double render_ms(const EPD_DrawCmd_t *cmds, size_t count, uint8_t workers) {
+    EPD_RenderConfig_t cfg = EPD_RENDER_CONFIG_DEFAULT();
+    double best = 0;
+
+    cfg.workers = workers;
+    EPD_Render_Init(&cfg);
+    for (int run = 0; run < 3; run++) {
+        double t0 = cpu_ms();
+        for (int f = 0; f < WORK_FRAMES; f++) {
+            EPD_Render(cmds, count);
+        }
+        double ms = cpu_ms() - t0;
+        if (run == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// Shapes spanning every band, each clipped to the band by the primitives:
+// checked like the random lists, and the work in bands reported
+static void check_shapes(uint16_t rotate) {
+    uint16_t r = (EPD_W < EPD_H ? EPD_W : EPD_H) / 2 - 10;
+    size_t count = 0;
+
+    setup(s_frame, 1, rotate);
+    s_list[count++] = (EPD_DrawCmd_t){ .op = EPD_CMD_FILL, .color = WHITE };
+    s_list[count++] = (EPD_DrawCmd_t){ .op = EPD_CMD_CIRCLE, .mode = 1, .x0 = EPD_W / 2, .y0 = EPD_H / 2, .x1 = r };
+    s_list[count++] = (EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = 0, .y0 = 0, .x1 = EPD_W - 1, .y1 = EPD_H - 1 };
+    s_list[count++] = (EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = EPD_W - 1, .y0 = 0, .x1 = 0, .y1 = EPD_H - 1 };
+    for (uint16_t y = 4; y + 24 < Paint.Height && count < 8; y += 30) {
+        EPD_DrawCmd_t *c = &s_list[count++];
+        *c = (EPD_DrawCmd_t){ .op = EPD_CMD_STRING, .size = 16, .x0 = 2, .y0 = y };
+        strcpy(c->text, "Outdoor 23.5 C 1013 hPa");
+    }
+    check_list(count, 1, rotate);
+
+    EPD_RenderConfig_t cfg = EPD_RENDER_CONFIG_DEFAULT();
+    double serial = render_ms(s_list, count, 1);
+    double banded = render_ms(s_list, count, 2);
+    printf("panel %s: rotate %u, large shapes: %.3f ms a frame serially, %.3f ms in 2 workers x %u bands (%.2fx)\n",
+           PANEL_NAME, rotate, serial / WORK_FRAMES, banded / WORK_FRAMES,
+           (unsigned)cfg.bands_per_worker, banded / serial);
+}
+
+int main(void) {
+    static const uint16_t rotations[] = { ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270 };
+
+    for (size_t i = 0; i < sizeof(s_bitmap); i++) {
+        s_bitmap[i] = rnd(256);
+    }
+    for (int l = 0; l < LISTS; l++) {
+        for (uint8_t planes = 1; planes <= EPD_MAX_PLANES; planes++) {
+            size_t count = make_list(planes);
+            for (int r = 0; r < 4; r++) {
+                check_list(count, planes, rotations[r]);
+            }
+        }
+    }
+    check_shapes(ROTATE_0);
+    check_shapes(ROTATE_90);
+    EPD_Render_Deinit();
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %u frames rendered in bands match serial rendering (%u bands stolen)\n",
+           PANEL_NAME, (unsigned)s_frames, (unsigned)s_steals);
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Check of the draw command ring and the canvas lock under real threads
+ *
+ * Usage: epaper_ring_check_<panel>
+ *
+ *  - PRODUCERS threads push numbered EPD_CMD_CALL commands into a small ring
+ *    while the main thread drains it in batches: every command must run
+ *    exactly once and each producer's commands in the order it pushed them
+ *  - drawing commands drained into a canvas must leave it exactly as the same
+ *    calls made directly
+ *  - threads drawing under EPD_Canvas_Lock while another presents must not
+ *    lose pixels
+ *  - a canvas set up without EPD_Policy_Init must present small changes as
+ *    partial refreshes
+ *  - while a present waits for BUSY, even between the two waveforms of
+ *    EPD_REFRESH_CLEAN, another thread must get the canvas lock at once
+ *  - once the arena is deinitialized the refresh policy must not compare
+ *    against its shadow any more
+ * Exit status is 0 when everything matches.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_arena.h"
+#include "epaper_canvas.h"
+#include "epaper_cmdring.h"
+#include "epaper_refresh_policy.h"
+#include "host_transport.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+#define PRODUCERS   4
+#define PER_PRODUCER 20000
+#define RING_SLOTS  16
+
+static EPD_CmdSlot_t s_slots[RING_SLOTS];
+static EPD_CmdRing_t s_ring;
+static uint32_t s_next[PRODUCERS];      // Next number expected from each producer
+static uint32_t s_received;
+static int s_finished;                  // Producers done pushing
+static int s_failures;
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_ref[EPD_FRAME_SIZE];
+
+static void fail(const char *what) {
+    printf("MISMATCH panel %s: %s\n", PANEL_NAME, what);
+    s_failures++;
+}
+
+static void receive(void *arg) {
+    uintptr_t v = (uintptr_t)arg;
+    uint32_t producer = v >> 24, n = v & 0xFFFFFF;
+
+    if (producer >= PRODUCERS || n != s_next[producer]) {
+        fail("command lost, repeated or out of order");
+        return;
+    }
+    s_next[producer]++;
+    s_received++;
+}
+
+static void *produce(void *arg) {
+    uintptr_t producer = (uintptr_t)arg;
+    for (uint32_t n = 0; n < PER_PRODUCER; n++) {
+        EPD_DrawCmd_t cmd = {
+            .op = EPD_CMD_CALL,
+            .call = { .fn = receive, .arg = (void *)((producer << 24) | n) },
+        };
+        while (!EPD_CmdRing_Push(&s_ring, &cmd)) {
+            sched_yield();  // full: the consumer is behind
+        }
+    }
+    __atomic_fetch_add(&s_finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void check_ordering(void) {
+    pthread_t threads[PRODUCERS];
+
+    EPD_CmdRing_Init(&s_ring, s_slots, RING_SLOTS);
+    for (uintptr_t p = 0; p < PRODUCERS; p++) {
+        pthread_create(&threads[p], NULL, produce, (void *)p);
+    }
+    for (;;) {
+        bool finished = __atomic_load_n(&s_finished, __ATOMIC_ACQUIRE) == PRODUCERS;
+        if (EPD_CmdRing_Drain(&s_ring, 7) == 0) {
+            if (finished) break;
+            sched_yield();
+        }
+    }
+    for (int p = 0; p < PRODUCERS; p++) {
+        pthread_join(threads[p], NULL);
+    }
+    if (s_received != PRODUCERS * PER_PRODUCER) {
+        fail("commands lost");
+    }
+}
+
+static void draw_direct(void) {
+    EPD_Full(WHITE);
+    EPD_DrawLine(3, 5, 120, 90, BLACK);
+    EPD_DrawRectangle(10, 10, 60, 40, BLACK, 1);
+    EPD_DrawCircle(80, 60, 20, BLACK, 0);
+    EPD_ClearWindows(20, 20, 30, 30, WHITE);
+    EPD_ShowString(5, 100, "queued text", 16, BLACK);
+    EPD_ShowNum(150, 10, 4711, 5, 12, BLACK);
+}
+
+static void check_commands(void) {
+    Paint_NewImage(s_ref, EPD_W, EPD_H, ROTATE_0, WHITE);
+    draw_direct();
+
+    EPD_CmdRing_Init(&s_ring, s_slots, RING_SLOTS);
+    Paint_NewImage(s_frame, EPD_W, EPD_H, ROTATE_0, WHITE);
+    memset(s_frame, 0x00, sizeof(s_frame));
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_FILL, .color = WHITE });
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_LINE, .x0 = 3, .y0 = 5, .x1 = 120, .y1 = 90 });
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_RECT, .mode = 1, .x0 = 10, .y0 = 10, .x1 = 60, .y1 = 40 });
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_CIRCLE, .x0 = 80, .y0 = 60, .x1 = 20 });
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_CLEAR_WINDOW, .color = WHITE,
+                                                .x0 = 20, .y0 = 20, .x1 = 30, .y1 = 30 });
+    EPD_CmdRing_PushString(&s_ring, 5, 100, "queued text", 16, BLACK);
+    EPD_CmdRing_Push(&s_ring, &(EPD_DrawCmd_t){ .op = EPD_CMD_NUM, .mode = 5, .size = 12,
+                                                .x0 = 150, .y0 = 10, .num = 4711 });
+    if (EPD_CmdRing_Drain(&s_ring, 0) != 7) {
+        fail("drain did not run every command");
+    }
+    if (memcmp(s_frame, s_ref, sizeof(s_frame)) != 0) {
+        fail("drained commands differ from direct drawing");
+    }
+}
+
+#define DRAWERS     3
+#define DRAW_ROUNDS 200
+
+// Each drawer owns a column and blackens one pixel of it per round
+static void *draw_locked(void *arg) {
+    uint16_t x = 8 + 8 * (uint16_t)(uintptr_t)arg;
+    for (uint16_t y = 0; y < DRAW_ROUNDS && y < EPD_H; y++) {
+        EPD_Canvas_Lock(portMAX_DELAY);
+        Paint_SetPixel(x, y, BLACK);
+        EPD_Canvas_Unlock();
+    }
+    return NULL;
+}
+
+static void check_canvas_lock(void) {
+    pthread_t threads[DRAWERS];
+
+    if (EPD_Canvas_Init(NULL, NULL, ROTATE_0) != ESP_OK) {
+        fail("canvas init");
+        return;
+    }
+    for (uintptr_t t = 0; t < DRAWERS; t++) {
+        pthread_create(&threads[t], NULL, draw_locked, (void *)t);
+    }
+    for (int i = 0; i < 20; i++) {
+        EPD_Canvas_Present();
+    }
+    for (int t = 0; t < DRAWERS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    EPD_Canvas_Present();
+
+    // Present copies the new rows into the back canvas, so both must hold every pixel
+    const uint8_t *frames[] = { EPD_Canvas_Front(), EPD_Canvas_Back() };
+    for (int f = 0; f < 2; f++) {
+        for (uint16_t t = 0; t < DRAWERS; t++) {
+            uint16_t x = 8 + 8 * t;
+            for (uint16_t y = 0; y < DRAW_ROUNDS && y < EPD_H; y++) {
+                if (frames[f][y * EPD_FRAME_STRIDE + x / 8] & (0x80 >> (x % 8))) {
+                    fail("pixel drawn under the canvas lock was lost");
+                    EPD_Canvas_Deinit();
+                    return;
+                }
+            }
+        }
+    }
+    EPD_Canvas_Deinit();
+}
+
+// EPD_Canvas_Init sets up the default policy when the app has not
+static void check_default_policy(void) {
+    EPD_Policy_Deinit();
+    if (EPD_Canvas_Init(NULL, NULL, ROTATE_0) != ESP_OK || !EPD_Policy_Ready()) {
+        fail("canvas init without a policy");
+        return;
+    }
+    EPD_Canvas_Present();
+    EPD_ShowNum(10, 10, 7, 1, 16, BLACK);
+    if (EPD_Canvas_Present() != EPD_REFRESH_PARTIAL) {
+        fail("small change on a canvas without EPD_Policy_Init was not a partial refresh");
+    }
+    EPD_Canvas_Deinit();
+    EPD_Policy_Deinit();
+}
+
+static uint32_t s_busy_polls;
+static uint32_t s_busy_locked;          // Polls at which the canvas lock was taken
+
+static void *try_lock(void *arg) {
+    (void)arg;
+    if (EPD_Canvas_Lock(0)) {           // Tries once on the host
+        Paint_SetPixel(EPD_W - 1, EPD_H - 1, BLACK);
+        EPD_Canvas_Unlock();
+        s_busy_locked++;
+    }
+    return NULL;
+}
+
+// Another task wants to draw while the presenting one waits for the panel
+static void on_busy(void) {
+    pthread_t thread;
+    s_busy_polls++;
+    pthread_create(&thread, NULL, try_lock, NULL);
+    pthread_join(thread, NULL);
+}
+
+static void check_clean_present(void) {
+    EPD_PolicyConfig_t policy = EPD_POLICY_CONFIG_DEFAULT();
+    EPD_RefreshMode_t mode = EPD_REFRESH_NONE;
+
+    policy.max_partial_per_tile = 1;    // The second change to a tile cleans it
+    policy.full_interval_ms = 0;
+    if (EPD_Canvas_Init(NULL, NULL, ROTATE_0) != ESP_OK || EPD_Policy_Init(&policy) != ESP_OK) {
+        fail("canvas or policy init");
+        return;
+    }
+    EPD_Canvas_Present();
+    for (uint16_t i = 0; i < 4 && mode != EPD_REFRESH_CLEAN; i++) {
+        EPD_ShowNum(10, 10, i, 1, 16, BLACK);
+        if (EPD_Policy_Decide(EPD_Canvas_Back(), NULL) == EPD_REFRESH_CLEAN) {
+            host_busy_hook = on_busy;
+        }
+        mode = EPD_Canvas_Present();
+        host_busy_hook = NULL;
+    }
+    EPD_Canvas_Deinit();
+    EPD_Policy_Deinit();
+
+    if (mode != EPD_REFRESH_CLEAN) {
+        fail("no EPD_REFRESH_CLEAN present");
+    } else if (s_busy_polls == 0) {
+        fail("EPD_REFRESH_CLEAN never waited for BUSY");
+    } else if (s_busy_locked != s_busy_polls) {
+        fail("canvas lock held while EPD_REFRESH_CLEAN waited for BUSY");
+    }
+}
+
+// The shadow belongs to the arena: after EPD_Arena_Deinit the policy has no
+// baseline (and must not read the freed one)
+static void check_arena_deinit(void) {
+    EPD_PolicyConfig_t policy = EPD_POLICY_CONFIG_DEFAULT();
+
+    memset(s_frame, 0xFF, sizeof(s_frame));
+    if (EPD_Policy_Init(&policy) != ESP_OK) {
+        fail("policy init");
+        return;
+    }
+    EPD_Policy_Present(s_frame);
+    if (EPD_Policy_Decide(s_frame, NULL) != EPD_REFRESH_NONE) {
+        fail("presented frame is not the policy baseline");
+    }
+    EPD_Arena_Deinit();
+    if (EPD_Policy_Decide(s_frame, NULL) != EPD_REFRESH_FULL) {
+        fail("policy compared against the shadow of a deinitialized arena");
+    }
+    EPD_Policy_Present(s_frame);
+    EPD_Policy_Deinit();
+}
+
+int main(void) {
+    EPD_GPIOInit();
+    EPD_Init();
+
+    check_ordering();
+    check_commands();
+    check_canvas_lock();
+    check_default_policy();
+    check_clean_present();
+    check_arena_deinit();
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: %u ring commands from %d threads in order, canvas lock holds, "
+           "free at %u BUSY polls of a clean present, policy lets go of the arena\n",
+           PANEL_NAME, (unsigned)s_received, PRODUCERS, (unsigned)s_busy_polls);
+    return 0;
+}
@@ -0,0 +1,524 @@
+/*
+ * Check of the command stream the driver sends, against a model of the
+ * controller
+ *
+ * Usage: epaper_transport_check_<panel>
+ *
+ * The host transport logs every command and keeps the RAM the controller
+ * would hold. Register cache: no shadowed register is ever written with the
+ * value the controller already holds since its last reset (0x12), and after
+ * every partial update the window, data entry mode, update control and
+ * border registers hold what the update needs, through random partial, full
+ * and fast updates, soft resets and sleeps. Multi-window updates: each
+ * window of EPD_Display_Part_Multi gets its own 0x44/0x45 window and
+ * 0x4E/0x4F cursor before its 0x24 data, which must land in RAM where the
+ * frame has it, and the batch activates once (one 0x20), or not at all when
+ * every window is empty. Sleep: EPD_Sleep_Mode must end on
+ * 0x10 with the mode byte (on
+ * the 2.13" with the border at 0x01 before it), and the wake that follows
+ * must rewrite exactly the shadowed registers that differ from the reset
+ * state, put the RAM cursor at the window origin, and after mode 2 re-seed
+ * 0x24 and 0x26 from the mirror, or leave the mirror invalid when there is
+ * none. Exit status is 0 when everything matches.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_arena.h"
+#include "host_transport.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#define RAM_INVERT 0xFF     // Partial writes send the frame inverted
+#else
+#define PANEL_NAME "4.2"
+#define RAM_INVERT 0x00
+#endif
+
+#define LOG_MAX     1024
+
+// Registers the driver shadows (EPD_WR_CMD skips a write of the same value)
+static const uint8_t s_shadowed[] = { 0x01, 0x11, 0x18, 0x1A, 0x21, 0x22, 0x3C, 0x44, 0x45 };
+
+typedef struct {
+    uint8_t len;                // 0 = not written since the last 0x12
+    uint8_t data[6];
+} reg_t;
+
+static reg_t s_ctl[256];        // Controller registers as sent
+static host_command_t s_log[LOG_MAX];
+static size_t s_count;
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_window[EPD_FRAME_SIZE];
+static uint8_t s_ram[2][HOST_RAM_Y][HOST_RAM_X];
+static uint32_t s_seed = 1;
+static uint32_t s_sent;                     // Shadowed register writes seen
+static uint32_t s_batches, s_windows;       // EPD_Display_Part_Multi calls and windows sent
+static int s_failures;
+
+#define CHECK(cond, what)                                       \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            printf("FAIL panel %s: %s (line %d)\n", PANEL_NAME, what, __LINE__);  \
+            s_failures++;                                       \
+        }                                                       \
+    } while (0)
+
+static uint32_t rnd(uint32_t n) {
+    s_seed ^= s_seed << 13;
+    s_seed ^= s_seed >> 17;
+    s_seed ^= s_seed << 5;
+    return s_seed % n;
+}
+
+static bool shadowed(uint8_t reg) {
+    return memchr(s_shadowed, reg, sizeof(s_shadowed)) != NULL;
+}
+
+// Register file after command c
+static void apply(reg_t *regs, const host_command_t *c) {
+    if (c->reg == 0x12) {
+        memset(regs, 0, sizeof(reg_t) * 256);
+    } else if (shadowed(c->reg)) {
+        regs[c->reg].len = c->len;
+        memcpy(regs[c->reg].data, c->data, c->len);
+    }
+}
+
+static bool same(const reg_t *a, const reg_t *b) {
+    return a->len == b->len && memcmp(a->data, b->data, a->len) == 0;
+}
+
+static void log_begin(void) {
+    host_model_log(s_log, LOG_MAX);
+}
+
+// Stop logging and run the commands through s_ctl. A shadowed register
+// written with the value it already holds is a cache miss.
+static void log_end(void) {
+    s_count = host_model_log(NULL, 0);
+    CHECK(s_count <= LOG_MAX, "command log overflow");
+    if (s_count > LOG_MAX) s_count = LOG_MAX;
+    for (size_t i = 0; i < s_count; i++) {
+        const host_command_t *c = &s_log[i];
+        reg_t sent = { .len = c->len };
+        memcpy(sent.data, c->data, c->len);
+        if (shadowed(c->reg)) {
+            s_sent++;
+            if (same(&s_ctl[c->reg], &sent)) {
+                printf("FAIL panel %s: 0x%02X written again with the value it holds (command %u)\n",
+                       PANEL_NAME, c->reg, (unsigned)i);
+                s_failures++;
+            }
+        }
+        apply(s_ctl, c);
+    }
+}
+
+static size_t count(uint8_t reg) {
+    size_t n = 0;
+    for (size_t i = 0; i < s_count; i++) {
+        n += (s_log[i].reg == reg);
+    }
+    return n;
+}
+
+static size_t find(uint8_t reg, size_t from) {
+    for (size_t i = from; i < s_count; i++) {
+        if (s_log[i].reg == reg) return i;
+    }
+    return s_count;
+}
+
+// RAM reg (0 = 0x24, 1 = 0x26) holds Image in the partial update layout
+static bool ram_is(int ram, const uint8_t *Image) {
+    for (uint16_t y = 0; y < EPD_H; y++) {
+        for (uint16_t xb = 0; xb < EPD_FRAME_STRIDE; xb++) {
+            if (host_ram[ram][y][xb] != (Image[y * EPD_FRAME_STRIDE + xb] ^ RAM_INVERT)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool ram_is_noise(int ram) {
+    for (uint16_t y = 0; y < EPD_H; y++) {
+        for (uint16_t xb = 0; xb < EPD_FRAME_STRIDE; xb++) {
+            if (host_ram[ram][y][xb] != HOST_RAM_NOISE) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void partial(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    uint16_t wb = (w + 7) / 8;
+    for (uint16_t r = 0; r < h; r++) {
+        for (uint16_t b = 0; b < wb; b++) {
+            s_frame[(y + r) * EPD_FRAME_STRIDE + x / 8 + b] ^= 0x5A + r;
+        }
+        memcpy(s_window + r * wb, s_frame + (y + r) * EPD_FRAME_STRIDE + x / 8, wb);
+    }
+    EPD_Display_Part(x, y, w, h, s_window);
+}
+
+// Sleep in mode, wake with an empty bus section and check both streams
+static void check_sleep_wake(EPD_SleepMode_t mode, const char *what) {
+    reg_t saved[256], ctl[256];
+    size_t sleep, k, n4e;
+    bool deep = (mode == EPD_SLEEP_DEEP);
+    bool mirror = (EPD_Shown() != NULL);
+
+    memcpy(saved, s_ctl, sizeof(saved));
+    memcpy(s_ram, host_ram, sizeof(s_ram));
+    log_begin();
+    EPD_Sleep_Mode(mode);
+    log_end();
+
+    // 0x10 with the mode byte comes last; on the 2.13" the border is at 0x01
+    // when it goes out (sent before it, or already there)
+    sleep = find(0x10, 0);
+    CHECK(sleep + 1 == s_count, what);
+    CHECK(sleep < s_count && s_log[sleep].bytes == 1 && s_log[sleep].data[0] == mode, what);
+    memcpy(ctl, saved, sizeof(ctl));
+    for (size_t i = 0; i < sleep; i++) {
+        CHECK(shadowed(s_log[i].reg), "only register writes before 0x10");
+        apply(ctl, &s_log[i]);
+    }
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+    CHECK(ctl[0x3C].len == 1 && ctl[0x3C].data[0] == 0x01, "border 0x01 before 0x10");
+#endif
+    memcpy(saved, ctl, sizeof(saved));
+    CHECK(deep ? ram_is_noise(0) && ram_is_noise(1) : memcmp(s_ram, host_ram, sizeof(s_ram)) == 0,
+          "RAM after 0x10");
+
+    // Anything that takes the bus wakes the controller
+    log_begin();
+    EPD_Bus_Acquire();
+    EPD_Bus_Release();
+    log_end();
+
+    CHECK(s_count > 0 && s_log[0].reg == 0x12, "wake starts with the reset");
+    k = 1;
+    if (deep && mirror) {
+        size_t w24 = find(0x24, 0), w26 = find(0x26, 0);
+        CHECK(w24 < w26 && w26 < s_count, "mode 2 wake writes 0x24 then 0x26");
+        CHECK(w26 < s_count && s_log[w24].bytes == EPD_FRAME_SIZE && s_log[w26].bytes == EPD_FRAME_SIZE,
+              "mode 2 wake writes whole frames");
+        CHECK(ram_is(0, EPD_Shown()) && ram_is(1, EPD_Shown()), "mode 2 wake re-seeds both RAMs from the mirror");
+        k = (w26 < s_count) ? w26 + 1 : s_count;
+    } else {
+        CHECK(find(0x24, 0) == s_count && find(0x26, 0) == s_count, "no RAM writes without a mirror or in mode 1");
+    }
+    if (!deep) {
+        CHECK(memcmp(s_ram, host_ram, sizeof(s_ram)) == 0, "mode 1 wake leaves both RAMs");
+    } else if (!mirror) {
+        CHECK(ram_is_noise(0) && ram_is_noise(1), "both RAMs left alone without a mirror");
+    }
+
+    // From there on, each saved register that the controller does not hold
+    // yet, once, and nothing else before the cursor
+    memset(ctl, 0, sizeof(ctl));
+    for (size_t i = 0; i < k; i++) {
+        apply(ctl, &s_log[i]);
+    }
+    n4e = find(0x4E, k);
+    for (size_t i = k; i < n4e; i++) {
+        uint8_t reg = s_log[i].reg;
+        reg_t sent = { .len = s_log[i].len };
+        memcpy(sent.data, s_log[i].data, sent.len);
+        CHECK(shadowed(reg), "wake writes only shadowed registers");
+        CHECK(saved[reg].len != 0 && same(&sent, &saved[reg]), "wake writes the saved value");
+        CHECK(!same(&ctl[reg], &saved[reg]), "wake skips a register already holding its value");
+        apply(ctl, &s_log[i]);
+    }
+    for (size_t i = 0; i < sizeof(s_shadowed); i++) {
+        uint8_t reg = s_shadowed[i];
+        if (saved[reg].len != 0 && !same(&ctl[reg], &saved[reg])) {
+            printf("FAIL panel %s: %s wake leaves 0x%02X unrestored\n", PANEL_NAME, what, reg);
+            s_failures++;
+        }
+    }
+
+    // Cursor at the window origin, and that is all
+    CHECK(n4e + 2 == s_count && s_log[n4e + 1].reg == 0x4F, "wake ends with the cursor");
+    if (n4e + 2 == s_count) {
+        CHECK(s_log[n4e].data[0] == saved[0x44].data[0], "cursor X at the window start");
+        CHECK(s_log[n4e + 1].data[0] == saved[0x45].data[0] && s_log[n4e + 1].data[1] == saved[0x45].data[1],
+              "cursor Y at the window start");
+    }
+}
+
+// Registers a partial update of x, y, w, h leaves in the controller
+static void check_part_regs(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const char *what) {
+    uint16_t xe = x + w - 1, ye = y + h - 1;
+    const reg_t want[] = {
+        { 2, { x >> 3, xe >> 3 } },
+        { 4, { y & 0xFF, y >> 8, ye & 0xFF, ye >> 8 } },
+        { 1, { 0x03 } },
+        { 2, { 0x00, 0x00 } },
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+        { 1, { 0xFC } },
+        { 1, { 0x01 } },        // Restored after the update
+#else
+        { 1, { 0xFF } },
+        { 1, { 0x80 } },
+#endif
+    };
+    const uint8_t regs[] = { 0x44, 0x45, 0x11, 0x21, 0x22, 0x3C };
+
+    for (size_t i = 0; i < sizeof(regs); i++) {
+        if (!same(&s_ctl[regs[i]], &want[i])) {
+            printf("FAIL panel %s: %s leaves 0x%02X unset or stale\n", PANEL_NAME, what, regs[i]);
+            s_failures++;
+        }
+    }
+}
+
+static void check_cache(void) {
+    size_t reset;
+
+    // The same window twice: the second update sends no setup register
+    // the first one left in place
+    log_begin();
+    EPD_Init();
+    EPD_Display_Seed(s_frame);
+    partial(24, 16, 48, 30);
+    log_end();
+    check_part_regs(24, 16, 48, 30, "first partial update");
+    log_begin();
+    partial(24, 16, 48, 30);
+    log_end();
+    check_part_regs(24, 16, 48, 30, "repeated partial update");
+    CHECK(count(0x44) == 0 && count(0x45) == 0 && count(0x11) == 0 && count(0x21) == 0 && count(0x22) == 0,
+          "repeated window and update control skipped");
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+    CHECK(count(0x3C) == 2, "border switched for the update and back");
+#else
+    CHECK(count(0x3C) == 0, "repeated border skipped");
+#endif
+
+    // A changed window goes out, the rest stays skipped
+    log_begin();
+    partial(32, 16, 48, 30);
+    log_end();
+    check_part_regs(32, 16, 48, 30, "moved partial update");
+    CHECK(count(0x44) == 1 && count(0x45) == 0, "changed X window sent, same Y window skipped");
+    log_begin();
+    partial(32, 17, 48, 30);
+    log_end();
+    check_part_regs(32, 17, 48, 30, "moved partial update");
+    CHECK(count(0x44) == 0 && count(0x45) == 1, "changed Y window sent, same X window skipped");
+
+    // A soft reset (leaving fast mode) forgets every value
+    log_begin();
+    EPD_Init_Fast(Fast_Seconds_1_5s);
+    EPD_Init();
+    log_end();
+    CHECK(count(0x12) == 2, "soft resets into and out of fast mode");
+    reset = find(0x12, find(0x12, 0) + 1);
+    CHECK(find(0x11, reset) < s_count, "data entry mode sent again after the soft reset");
+    log_begin();
+    partial(32, 17, 48, 30);
+    log_end();
+    check_part_regs(32, 17, 48, 30, "partial update after a soft reset");
+
+    // So does sleep: the wake sends the window again although it is unchanged
+    log_begin();
+    EPD_Sleep_Mode(EPD_SLEEP_RETAIN);
+    EPD_Bus_Acquire();
+    EPD_Bus_Release();
+    log_end();
+    CHECK(count(0x44) == 1 && count(0x45) == 1, "window sent again after sleep");
+    log_begin();
+    partial(32, 17, 48, 30);
+    log_end();
+    check_part_regs(32, 17, 48, 30, "partial update after sleep");
+
+    // Random traffic: never a repeated value, always the right registers
+    for (uint32_t step = 0; step < 400 && !s_failures; step++) {
+        uint16_t x = rnd(EPD_FRAME_STRIDE) * 8, y = rnd(EPD_H);
+        uint16_t w = 8 * (1 + rnd(4)), h = 1 + rnd(20);
+        if (x + w > EPD_FRAME_STRIDE * 8) w = EPD_FRAME_STRIDE * 8 - x;
+        if (y + h > EPD_H) h = EPD_H - y;
+
+        log_begin();
+        switch (rnd(10)) {
+            case 0:
+                EPD_Init();
+                EPD_Display(s_frame);
+                break;
+            case 1:
+                EPD_Init_Fast(Fast_Seconds_1_5s);
+                EPD_Display_Fast(s_frame);
+                break;
+            case 2:
+                EPD_Sleep_Mode(rnd(2) ? EPD_SLEEP_DEEP : EPD_SLEEP_RETAIN);
+                break;
+            default:
+                break;
+        }
+        partial(x, y, w, h);
+        log_end();
+        check_part_regs(x, y, w, h, "random partial update");
+    }
+}
+
+// Random window, partly unaligned or past the edge, sometimes empty
+static EPD_Rect_t random_rect(void) {
+    EPD_Rect_t r = {
+        .x = rnd(EPD_W + 8),
+        .y = rnd(EPD_H + 4),
+        .width = rnd(10) ? 1 + rnd(70) : 0,
+        .height = rnd(10) ? 1 + rnd(40) : 0,
+    };
+    return r;
+}
+
+static void check_multi(void) {
+    EPD_Rect_t rects[6];
+    reg_t ctl[256];
+
+    log_begin();
+    EPD_Init();
+    EPD_Display_Seed(s_frame);
+    log_end();
+
+    for (uint32_t step = 0; step < 300 && !s_failures; step++) {
+        size_t n = 1 + rnd(6), nonempty = 0, sent = 0, cursor_x = 0, cursor_y = 0, w = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            EPD_Rect_t *r = &rects[i];
+            *r = random_rect();
+            if (r->x >= EPD_W || r->y >= EPD_H || r->width == 0 || r->height == 0) continue;
+            nonempty++;
+            uint16_t xe = (r->x + r->width > EPD_W) ? EPD_W : r->x + r->width;
+            uint16_t ye = (r->y + r->height > EPD_H) ? EPD_H : r->y + r->height;
+            for (uint16_t y = r->y; y < ye; y++) {
+                for (uint16_t b = r->x / 8; b < (xe + 7) / 8; b++) {
+                    s_frame[y * EPD_FRAME_STRIDE + b] = rnd(256);
+                }
+            }
+        }
+
+        memcpy(ctl, s_ctl, sizeof(ctl));
+        log_begin();
+        EPD_Display_Part_Multi(rects, n, s_frame);
+        log_end();
+        if (nonempty == 0) {
+            CHECK(s_count == 0, "nothing sent for empty windows only");
+            continue;
+        }
+        s_batches++;
+        CHECK(count(0x20) == 1, "one activation per batch");
+
+        // Walk the stream: the state before each 0x24 is the next window's
+        for (size_t i = 0; i < s_count; i++) {
+            const host_command_t *c = &s_log[i];
+            if (c->reg == 0x4E) cursor_x = c->data[0];
+            if (c->reg == 0x4F) cursor_y = c->data[0] | (c->data[1] << 8);
+            if (c->reg == 0x20) CHECK(sent > 0, "activation after the window data");
+            if (c->reg != 0x24) {
+                apply(ctl, c);
+                continue;
+            }
+            while (w < n && (rects[w].x >= EPD_W || rects[w].y >= EPD_H ||
+                             rects[w].width == 0 || rects[w].height == 0)) {
+                w++;
+            }
+            if (w == n) {
+                CHECK(false, "more 0x24 writes than windows");
+                break;
+            }
+            const EPD_Rect_t *r = &rects[w++];
+            uint16_t xb = r->x / 8;
+            uint16_t xe = (r->x + r->width > EPD_W) ? EPD_W : r->x + r->width;
+            uint16_t wb = (xe + 7) / 8 - xb;
+            uint16_t ye = ((r->y + r->height > EPD_H) ? EPD_H : r->y + r->height) - 1;
+            const reg_t wx = { 2, { xb, xb + wb - 1 } };
+            const reg_t wy = { 4, { r->y & 0xFF, r->y >> 8, ye & 0xFF, ye >> 8 } };
+            if (!same(&ctl[0x44], &wx) || !same(&ctl[0x45], &wy) || cursor_x != xb || cursor_y != r->y ||
+                c->bytes != (uint32_t)wb * (ye - r->y + 1)) {
+                printf("FAIL panel %s: step %lu window %u (%u,%u %ux%u) not set up for its data\n",
+                       PANEL_NAME, (unsigned long)step, (unsigned)(w - 1), r->x, r->y, r->width, r->height);
+                s_failures++;
+            }
+            sent++;
+        }
+        s_windows += sent;
+        CHECK(sent == nonempty, "one 0x24 write per window");
+        CHECK(ram_is(0, s_frame), "every window in 0x24 where the frame has it");
+    }
+}
+
+static void check_sleep(void) {
+    // Mode 1 keeps the RAM: the wake only restores registers and cursor
+    log_begin();
+    EPD_Init();
+    EPD_Display_Seed(s_frame);
+    partial(16, 8, 40, 20);
+    log_end();
+    check_sleep_wake(EPD_SLEEP_RETAIN, "mode 1 after a partial update");
+
+    // Right after the seed the 2.13" border is 0x80 and must go out before
+    // 0x10; the wake rewrites it
+    log_begin();
+    EPD_Display_Seed(s_frame);
+    log_end();
+    check_sleep_wake(EPD_SLEEP_RETAIN, "mode 1 after the seed");
+
+    // Mode 2 drops both RAMs; the mirror puts them back
+    log_begin();
+    partial(EPD_W - 24, EPD_H - 10, 24, 10);
+    log_end();
+    check_sleep_wake(EPD_SLEEP_DEEP, "mode 2 after a partial update");
+    log_begin();
+    EPD_Display_Seed(s_frame);
+    log_end();
+    check_sleep_wake(EPD_SLEEP_DEEP, "mode 2 after the seed");
+
+    // Without a mirror nothing is written and the mirror knows nothing after
+    log_begin();
+    EPD_SetOldRamSync(false);
+    partial(0, 0, 8, 1);
+    log_end();
+    check_sleep_wake(EPD_SLEEP_DEEP, "mode 2 without a mirror");
+    EPD_SetOldRamSync(true);
+    CHECK(EPD_Shown() == NULL, "mirror invalid after a mode 2 wake without it");
+
+    // A full frame brings the sync back
+    log_begin();
+    EPD_Init();
+    EPD_Display(s_frame);
+    partial(8, 8, 8, 8);
+    log_end();
+    CHECK(EPD_Shown() != NULL && memcmp(EPD_Shown(), s_frame, EPD_FRAME_SIZE) == 0, "mirror after a full frame");
+}
+
+int main(void) {
+    EPD_ArenaConfig_t arena = { .placement = EPD_ARENA_INTERNAL_DMA, .old_ram = true };
+
+    EPD_GPIOInit();
+    EPD_Arena_Init(&arena);
+    host_model_enable(true);
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) {
+        s_frame[i] = rnd(256);
+    }
+
+    check_cache();
+    check_multi();
+    check_sleep();
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: command stream matched, %lu shadowed register writes sent, "
+           "%lu windows in %lu multi-window updates\n",
+           PANEL_NAME, (unsigned long)s_sent, (unsigned long)s_windows, (unsigned long)s_batches);
+    return 0;
+}
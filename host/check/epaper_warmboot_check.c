@@ -0,0 +1,199 @@
+/*
+ * Check of the warm-boot record
+ *
+ * Usage: epaper_warmboot_check_<panel>
+ *
+ * A dashboard-like frame is displayed, recorded and the reboot simulated
+ * (controller powered up cold, panel mirror overwritten). Restoring from the
+ * record must give back the frame, send it to RAM 0x24 and 0x26 as the
+ * driver's own full-frame writes do and let a partial update follow with no
+ * full refresh. The hash-only path must accept the same frame and reject a
+ * different one, a refresh must drop the record, a corrupted copy must be
+ * rejected, and the record must survive a round trip through
+ * EPD_WarmBoot_Record / EPD_WarmBoot_Import. It also reports the SPI
+ * traffic up to the first partial update with EPD_Clear and with the record.
+ * With CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE at 0 (hash only) the frame
+ * is redrawn and resumed with EPD_WarmBoot_Verify instead, and the same RAM
+ * and refresh checks apply.
+ * Exit status is 0 when everything matches.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_driver.h"
+#include "epaper_arena.h"
+#include "epaper_warmboot.h"
+#include "host_transport.h"
+
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define PANEL_NAME "2.13"
+#else
+#define PANEL_NAME "4.2"
+#endif
+
+static uint8_t s_frame[EPD_FRAME_SIZE];
+static uint8_t s_back[EPD_FRAME_SIZE];
+static uint8_t s_ref24[EPD_FRAME_SIZE + 64];
+static uint8_t s_cap24[EPD_FRAME_SIZE + 64];
+static uint8_t s_cap26[EPD_FRAME_SIZE + 64];
+static uint8_t s_update[64];
+static uint8_t s_saved[sizeof(uint32_t) * 4 + CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE];
+static int s_failures;
+
+#define WARM_COPY (CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE > 0)
+
+#define CHECK(cond, what)                                       \
+    do {                                                        \
+        if (!(cond)) {                                          \
+            printf("FAIL %s (line %d)\n", what, __LINE__);      \
+            s_failures++;                                       \
+        }                                                       \
+    } while (0)
+
+static void draw_dashboard(void) {
+    Paint_NewImage(s_frame, EPD_W, EPD_H, ROTATE_0, WHITE);
+    EPD_Full(WHITE);
+    EPD_ShowString(4, 4, "Warm boot 23.5 C", 16, BLACK);
+    EPD_DrawRectangle(2, 30, EPD_W - 3, EPD_H - 3, BLACK, 0);
+    EPD_DrawCircle(EPD_W / 2, EPD_H / 2 + 10, 30, BLACK, 1);
+    EPD_ShowNum(10, EPD_H - 30, 123456, 6, 16, BLACK);
+}
+
+// The driver forgets the panel and the mirror holds noise, as after a reset
+static void reboot(void) {
+    EPD_ArenaConfig_t arena = { .placement = EPD_ARENA_INTERNAL_DMA, .old_ram = true };
+    EPD_Arena_Deinit();
+    EPD_Shown();
+    EPD_Arena_Init(&arena);
+    memset(EPD_Arena_OldRam(), 0x5A, EPD_FRAME_SIZE);
+}
+
+// A full refresh among the Display Update Control 2 values sent
+static bool full_refresh(size_t len) {
+    return memchr(s_update, 0xF7, len) != NULL;
+}
+
+// Back to the recorded frame in back: decoded from the copy, or redrawn by
+// the application and verified against the hash when there is none
+static esp_err_t resume(uint8_t *back) {
+#if WARM_COPY
+    return EPD_WarmBoot_Restore(back);
+#else
+    CHECK(EPD_WarmBoot_Restore(back) == ESP_ERR_NOT_FOUND, "restore without a copy");
+    if (back == NULL) {
+        return EPD_WarmBoot_Verify(s_frame);
+    }
+    memcpy(back, s_frame, EPD_FRAME_SIZE);
+    return EPD_WarmBoot_Verify(back);
+#endif
+}
+
+static void partial_update(void) {
+    EPD_ShowString(4, 4, "Warm boot 23.6 C", 16, BLACK);
+    EPD_Display_Part_Stride(0, 0, EPD_W, 24, s_frame);
+}
+
+int main(void) {
+    EPD_ArenaConfig_t arena = { .placement = EPD_ARENA_INTERNAL_DMA, .old_ram = true };
+    EPD_WarmBootInfo_t info;
+    size_t size;
+
+    EPD_GPIOInit();
+    EPD_Arena_Init(&arena);
+    draw_dashboard();
+    EPD_Init();
+    host_transport_capture(0x24, s_ref24, sizeof(s_ref24));
+    EPD_Display_Seed(s_frame);
+    size_t ref_len = host_transport_capture(0x24, s_cap24, sizeof(s_cap24));
+
+    // Displayed, then saved by the sleep
+    EPD_Display(s_frame);
+    EPD_Sleep_Mode(EPD_SLEEP_DEEP);
+    EPD_WarmBoot_GetInfo(&info);
+    CHECK(info.valid && info.copy == WARM_COPY, "record after sleep");
+    printf("panel %s: %u-byte frame recorded in %u bytes\n", PANEL_NAME,
+           (unsigned)EPD_FRAME_SIZE, (unsigned)info.size);
+
+    // Restore: same frame back, both RAMs written as a seed does, then a
+    // partial update with no full refresh
+    reboot();
+    memset(s_back, 0, sizeof(s_back));
+    host_transport_capture(0x26, s_cap26, sizeof(s_cap26));
+    CHECK(resume(s_back) == ESP_OK, "restore");
+    size_t len26 = host_transport_capture(0x24, s_cap24, sizeof(s_cap24));
+    // Once more for RAM 0x24: no refresh yet, the record is still there
+    reboot();
+    host_transport_reset();
+    CHECK(resume(s_back) == ESP_OK, "restore again");
+    size_t len24 = host_transport_capture(0x22, s_update, sizeof(s_update));
+    CHECK(memcmp(s_back, s_frame, EPD_FRAME_SIZE) == 0, "restored frame");
+    CHECK(memcmp(EPD_Shown(), s_frame, EPD_FRAME_SIZE) == 0, "mirror after restore");
+    CHECK(len24 == ref_len && memcmp(s_cap24, s_ref24, ref_len) == 0, "RAM 0x24 after restore");
+    CHECK(len26 == ref_len && memcmp(s_cap26, s_ref24, ref_len) == 0, "RAM 0x26 after restore");
+    partial_update();
+    CHECK(!full_refresh(host_transport_capture(0x22, NULL, 0)), "no full refresh after restore");
+    host_transport_stats_t warm = host_transport_stats;
+
+    // The partial update dropped the record
+    EPD_WarmBoot_GetInfo(&info);
+    CHECK(!info.valid, "record dropped by a refresh");
+    CHECK(EPD_WarmBoot_Restore(NULL) == ESP_ERR_NOT_FOUND, "restore without a record");
+
+    // The usual cold start for comparison
+    reboot();
+    host_transport_capture(0x22, s_update, sizeof(s_update));
+    host_transport_reset();
+    EPD_Clear();
+    partial_update();
+    CHECK(full_refresh(host_transport_capture(0x22, NULL, 0)), "full refresh after EPD_Clear");
+    printf("panel %s: to the first partial update, EPD_Clear: full refresh, %llu bytes in %u transactions; "
+           "warm boot: no refresh, %llu bytes in %u transactions\n", PANEL_NAME,
+           (unsigned long long)host_transport_stats.bytes, (unsigned)host_transport_stats.transactions,
+           (unsigned long long)warm.bytes, (unsigned)warm.transactions);
+
+    // Round trip through the application's storage, then a corrupted copy
+    EPD_Display(s_frame);
+    CHECK(EPD_WarmBoot_Save() == ESP_OK, "save");
+    const void *record = EPD_WarmBoot_Record(&size);
+    CHECK(record != NULL && size <= sizeof(s_saved), "record");
+    memcpy(s_saved, record, size);
+    EPD_WarmBoot_Forget();
+    CHECK(EPD_WarmBoot_Record(&size) == NULL, "forgotten");
+    CHECK(EPD_WarmBoot_Import(s_saved, size - 1) == ESP_ERR_INVALID_ARG, "import truncated");
+    CHECK(EPD_WarmBoot_Import(s_saved, size) == ESP_OK, "import");
+    reboot();
+    CHECK(resume(NULL) == ESP_OK, "restore into the mirror");
+    CHECK(memcmp(EPD_Shown(), s_frame, EPD_FRAME_SIZE) == 0, "mirror after import");
+    // The last byte of the copy, or a byte of the hash when there is none
+    s_saved[WARM_COPY ? size - 1 : sizeof(uint32_t)] ^= 0x01;
+    CHECK(EPD_WarmBoot_Import(s_saved, size) == ESP_OK, "import corrupted");
+    reboot();
+    CHECK(resume(NULL) == ESP_ERR_INVALID_CRC, "corrupted copy");
+    CHECK(EPD_Shown() == NULL, "nothing known after a failed restore");
+
+    // Noise does not pack: hash only, the redrawn frame is verified
+    for (size_t i = 0; i < EPD_FRAME_SIZE; i++) s_frame[i] = (uint8_t)rand();
+    EPD_Display(s_frame);
+    EPD_Sleep();
+    EPD_WarmBoot_GetInfo(&info);
+    CHECK(info.valid, "record of noise");
+    // Frames up to about COPY_SIZE bytes fit even as noise (the 2.13")
+    CHECK(info.copy == (EPD_FRAME_SIZE + EPD_H * ((EPD_FRAME_STRIDE + 127) / 128) <=
+                        CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE), "copy of noise");
+    reboot();
+    if (!info.copy) {
+        CHECK(EPD_WarmBoot_Restore(s_back) == ESP_ERR_NOT_FOUND, "restore without a copy");
+    }
+    s_frame[7] ^= 0x10;
+    CHECK(EPD_WarmBoot_Verify(s_frame) == ESP_ERR_INVALID_CRC, "verify a different frame");
+    s_frame[7] ^= 0x10;
+    CHECK(EPD_WarmBoot_Verify(s_frame) == ESP_OK, "verify the same frame");
+    CHECK(memcmp(EPD_Shown(), s_frame, EPD_FRAME_SIZE) == 0, "mirror after verify");
+
+    if (s_failures) {
+        return 1;
+    }
+    printf("panel %s: warm boot record checks pass\n", PANEL_NAME);
+    return 0;
+}
@@ -0,0 +1,379 @@
+#include "host_transport.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_rom_sys.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+
+host_transport_stats_t host_transport_stats;
+bool host_dma_capable = true;
+void (*host_busy_hook)(void);
+
+static int s_dc_level;
+static uint64_t s_delay_us;
+
+struct spi_device_t {
+    spi_device_interface_config_t cfg;
+};
+
+static struct spi_device_t s_device;
+
+static struct {
+    uint8_t reg;
+    bool active;                // Last command was reg
+    uint8_t *buf;
+    size_t cap, len;
+} s_capture;
+
+size_t host_transport_capture(uint8_t reg, uint8_t *buf, size_t cap) {
+    size_t len = s_capture.len;
+    s_capture.reg = reg;
+    s_capture.active = false;
+    s_capture.buf = buf;
+    s_capture.cap = cap;
+    s_capture.len = 0;
+    return len;
+}
+
+uint8_t host_ram[2][HOST_RAM_Y][HOST_RAM_X];
+void (*host_command_hook)(uint8_t reg);
+
+static struct {
+    bool enabled;
+    uint8_t reg;                // Last command
+    uint32_t index;             // Data bytes after it so far
+    uint16_t xs, xe, ys, ye;    // Window, inclusive
+    uint16_t x, y;              // Address counter
+    uint8_t param[4];           // Data of a window or counter command
+    host_command_t *log;
+    size_t cap, count;
+} s_model;
+
+void host_model_enable(bool enable) {
+    memset(&s_model, 0, sizeof(s_model));
+    memset(host_ram, HOST_RAM_NOISE, sizeof(host_ram));
+    s_model.enabled = enable;
+    s_model.xe = HOST_RAM_X - 1;
+    s_model.ye = HOST_RAM_Y - 1;
+}
+
+size_t host_model_log(host_command_t *buf, size_t cap) {
+    size_t count = s_model.count;
+    s_model.log = buf;
+    s_model.cap = cap;
+    s_model.count = 0;
+    return count;
+}
+
+static void host_model_command(uint8_t reg) {
+    if (host_command_hook) {
+        host_command_hook(reg);
+    }
+    s_model.reg = reg;
+    s_model.index = 0;
+    if (s_model.log != NULL) {
+        if (s_model.count < s_model.cap) {
+            memset(&s_model.log[s_model.count], 0, sizeof(host_command_t));
+            s_model.log[s_model.count].reg = reg;
+        }
+        s_model.count++;
+    }
+}
+
+static void host_model_data(uint8_t byte) {
+    uint32_t i = s_model.index++;
+
+    if (s_model.log != NULL && s_model.count > 0 && s_model.count <= s_model.cap) {
+        host_command_t *c = &s_model.log[s_model.count - 1];
+        if (c->len < sizeof(c->data)) {
+            c->data[c->len++] = byte;
+        }
+        c->bytes++;
+    }
+    if (i < sizeof(s_model.param)) {
+        s_model.param[i] = byte;
+    }
+    switch (s_model.reg) {
+        case 0x24:
+        case 0x26:
+            if (s_model.x < HOST_RAM_X && s_model.y < HOST_RAM_Y) {
+                host_ram[s_model.reg == 0x26][s_model.y][s_model.x] = byte;
+            }
+            if (s_model.x++ >= s_model.xe) {
+                s_model.x = s_model.xs;
+                if (s_model.y++ >= s_model.ye) {
+                    s_model.y = s_model.ys;
+                }
+            }
+            break;
+        case 0x44:
+            if (i == 1) {
+                s_model.xs = s_model.param[0];
+                s_model.xe = s_model.param[1];
+            }
+            break;
+        case 0x45:
+            if (i == 3) {
+                s_model.ys = s_model.param[0] | (s_model.param[1] << 8);
+                s_model.ye = s_model.param[2] | (s_model.param[3] << 8);
+            }
+            break;
+        case 0x4E:
+            s_model.x = byte;
+            break;
+        case 0x4F:
+            if (i == 1) {
+                s_model.y = s_model.param[0] | (s_model.param[1] << 8);
+            }
+            break;
+        case 0x10:
+            if (byte == 0x03) {
+                memset(host_ram, HOST_RAM_NOISE, sizeof(host_ram));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void host_model(const spi_transaction_t *trans) {
+    const uint8_t *data = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : trans->tx_buffer;
+    size_t len = trans->length / 8;
+
+    if (!s_model.enabled) return;
+    if (s_dc_level == 0) {
+        for (size_t i = 0; i < len; i++) {
+            host_model_command(data[i]);
+        }
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        host_model_data(data[i]);
+    }
+}
+
+static void host_capture(const spi_transaction_t *trans) {
+    const uint8_t *data = (trans->flags & SPI_TRANS_USE_TXDATA) ? trans->tx_data : trans->tx_buffer;
+    size_t len = trans->length / 8;
+
+    if (s_capture.buf == NULL) return;
+    if (s_dc_level == 0) {
+        s_capture.active = (len == 1 && data[0] == s_capture.reg);
+        return;
+    }
+    if (!s_capture.active) return;
+    if (len > s_capture.cap - s_capture.len) len = s_capture.cap - s_capture.len;
+    memcpy(s_capture.buf + s_capture.len, data, len);
+    s_capture.len += len;
+}
+
+void host_transport_reset(void) {
+    memset(&host_transport_stats, 0, sizeof(host_transport_stats));
+    s_delay_us = 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    s_delay_us += (uint64_t)ticks * 1000 * portTICK_PERIOD_MS;
+    host_transport_stats.delay_ms = s_delay_us / 1000;
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(s_delay_us / 1000 / portTICK_PERIOD_MS);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&buffer->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    return buffer;
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t wait) {
+    if (wait == portMAX_DELAY) {
+        return pthread_mutex_lock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+    }
+    return pthread_mutex_trylock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem) {
+    return pthread_mutex_unlock(&sem->mutex) == 0 ? pdTRUE : pdFALSE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCountingStatic(UBaseType_t max, UBaseType_t initial, StaticSemaphore_t *buffer) {
+    pthread_mutex_init(&buffer->mutex, NULL);
+    pthread_cond_init(&buffer->cond, NULL);
+    buffer->count = initial;
+    buffer->max = max;
+    return buffer;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+    BaseType_t taken = pdFALSE;
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0 && wait == portMAX_DELAY) {
+        pthread_cond_wait(&sem->cond, &sem->mutex);
+    }
+    if (sem->count > 0) {
+        sem->count--;
+        taken = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return taken;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    BaseType_t given = pdFALSE;
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count < sem->max) {
+        sem->count++;
+        given = pdTRUE;
+        pthread_cond_signal(&sem->cond);
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return given;
+}
+
+struct host_task {
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static void *host_task_main(void *arg) {
+    struct host_task task = *(struct host_task *)arg;
+    free(arg);
+    task.fn(task.arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+    (void)name;
+    (void)stack_depth;
+    (void)priority;
+    struct host_task *task = malloc(sizeof(*task));
+    pthread_t thread;
+
+    if (task == NULL) {
+        return pdFALSE;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    if (pthread_create(&thread, NULL, host_task_main, task) != 0) {
+        free(task);
+        return pdFALSE;
+    }
+    pthread_detach(thread);
+    if (handle) {
+        *handle = (TaskHandle_t)(uintptr_t)thread;  // Opaque, never dereferenced
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    s_delay_us += us;
+    host_transport_stats.delay_ms = s_delay_us / 1000;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config) {
+    (void)config;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level) {
+    if (gpio_num == CONFIG_CROWPANEL_EPAPER_DC_PIN) {
+        s_dc_level = (int)level;
+    }
+    host_transport_stats.gpio_writes++;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num) {
+    if (gpio_num == CONFIG_CROWPANEL_EPAPER_BUSY_PIN) {
+        host_transport_stats.busy_polls++;
+        if (host_busy_hook) {
+            host_busy_hook();
+        }
+    }
+    return 0;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config, int dma_chan) {
+    (void)host; (void)config; (void)dma_chan;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t *config, spi_device_handle_t *handle) {
+    (void)host;
+    s_device.cfg = *config;
+    *handle = &s_device;
+    return ESP_OK;
+}
+
+static esp_err_t host_spi_run(spi_device_handle_t handle, spi_transaction_t *trans) {
+    if (handle->cfg.pre_cb) {
+        handle->cfg.pre_cb(trans);
+    }
+    host_capture(trans);
+    host_model(trans);
+    host_transport_stats.transactions++;
+    host_transport_stats.bytes += trans->length / 8;
+    if (s_dc_level == 0) {
+        host_transport_stats.commands++;
+    }
+    if (handle->cfg.post_cb) {
+        handle->cfg.post_cb(trans);
+    }
+    return ESP_OK;
+}
+
+esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    return host_spi_run(handle, trans);
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t *trans) {
+    host_transport_stats.polling++;
+    return host_spi_run(handle, trans);
+}
+
+#define HOST_QUEUE_DEPTH 64
+static spi_transaction_t *s_queue[HOST_QUEUE_DEPTH];
+static int s_queue_head, s_queue_tail;
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t *trans, TickType_t ticks_to_wait) {
+    (void)ticks_to_wait;
+    host_spi_run(handle, trans);
+    s_queue[s_queue_tail] = trans;
+    s_queue_tail = (s_queue_tail + 1) % HOST_QUEUE_DEPTH;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t **trans, TickType_t ticks_to_wait) {
+    (void)handle; (void)ticks_to_wait;
+    if (s_queue_head == s_queue_tail) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = s_queue[s_queue_head];
+    s_queue_head = (s_queue_head + 1) % HOST_QUEUE_DEPTH;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait) {
+    (void)handle; (void)wait;
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle) {
+    (void)handle;
+}
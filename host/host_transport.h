@@ -0,0 +1,81 @@
+/*
+ * Host transport
+ *
+ * Stubbed GPIO/SPI/FreeRTOS layer used to run the driver on Linux. Nothing
+ * reaches real hardware: SPI transactions are counted, BUSY always reads
+ * idle and delays only advance a virtual clock. An optional model of the
+ * controller keeps its RAM and a log of the commands for the checks.
+ */
+#ifndef __HOST_TRANSPORT_H__
+#define __HOST_TRANSPORT_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t transactions;      // spi_device_transmit + queued + polling
+    uint32_t polling;           // spi_device_polling_transmit only
+    uint32_t commands;          // transactions sent with DC low
+    uint64_t bytes;             // payload bytes on MOSI
+    uint32_t gpio_writes;
+    uint32_t busy_polls;
+    uint64_t delay_ms;          // virtual time spent in vTaskDelay / esp_rom_delay_us
+} host_transport_stats_t;
+
+extern host_transport_stats_t host_transport_stats;
+
+// Answer of esp_ptr_dma_capable() for every buffer (default true)
+extern bool host_dma_capable;
+
+// Called on every BUSY poll (default NULL), i.e. while the driver waits for a
+// waveform that would be running on the panel
+extern void (*host_busy_hook)(void);
+
+void host_transport_reset(void);
+
+// Copy the data bytes written after command `reg` into buf (up to cap bytes)
+// until host_transport_capture is called again; returns the bytes captured
+// so far by the previous call's buffer
+size_t host_transport_capture(uint8_t reg, uint8_t *buf, size_t cap);
+
+// Controller model (off by default, so the benchmark only counts traffic)
+//
+// Data after 0x24/0x26 lands in host_ram at the address counter (0x4E/0x4F),
+// stepping X+ then Y+ within the window (0x44/0x45) as data entry mode 0x03
+// does; X counts bytes. Both RAMs share the counter. Deep sleep mode 2
+// (0x10 with 0x03) leaves both RAMs full of HOST_RAM_NOISE.
+#define HOST_RAM_X      64
+#define HOST_RAM_Y      512
+#define HOST_RAM_NOISE  0xA5
+
+typedef struct {
+    uint8_t reg;
+    uint8_t len;                // Data bytes kept in data
+    uint8_t data[6];
+    uint32_t bytes;             // Data bytes sent after the command
+} host_command_t;
+
+extern uint8_t host_ram[2][HOST_RAM_Y][HOST_RAM_X];    // 0x24, 0x26
+
+// Turn the model on with both RAMs full of noise and the window over all of
+// them, or off
+void host_model_enable(bool enable);
+
+// Log the commands into buf (up to cap) until called again; returns how many
+// were sent while the previous buffer was in place (more than its cap when
+// it overflowed)
+size_t host_model_log(host_command_t *buf, size_t cap);
+
+// Called with each command byte, once the data of the command before is in
+extern void (*host_command_hook)(uint8_t reg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
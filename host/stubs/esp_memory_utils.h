@@ -0,0 +1,15 @@
+#ifndef __HOST_ESP_MEMORY_UTILS_H__
+#define __HOST_ESP_MEMORY_UTILS_H__
+
+#include <stdbool.h>
+
+// Host memory is treated as DMA-capable; set host_dma_capable to false to
+// push every buffer through the driver's bounce path
+extern bool host_dma_capable;
+
+static inline bool esp_ptr_dma_capable(const void *p) {
+    (void)p;
+    return host_dma_capable;
+}
+
+#endif
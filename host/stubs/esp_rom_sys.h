@@ -0,0 +1,8 @@
+#ifndef __HOST_ESP_ROM_SYS_H__
+#define __HOST_ESP_ROM_SYS_H__
+
+#include <stdint.h>
+
+void esp_rom_delay_us(uint32_t us);
+
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Host build configuration
+ *
+ * Stands in for the sdkconfig.h generated by menuconfig. The panel model is
+ * selected on the compiler command line (-DCONFIG_CROWPANEL_EPAPER_4_2_INCH=1
+ * or -DCONFIG_CROWPANEL_EPAPER_2_13_INCH=1); everything else uses the Kconfig
+ * defaults.
+ */
+#ifndef __HOST_SDKCONFIG_H__
+#define __HOST_SDKCONFIG_H__
+
+#if !defined(CONFIG_CROWPANEL_EPAPER_4_2_INCH) && !defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define CONFIG_CROWPANEL_EPAPER_4_2_INCH 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_INTERNAL_DMA 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_FRAMES 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_SHADOW 1
+
+#endif
+
+#define CONFIG_CROWPANEL_EPAPER_SPI_HOST 1
+#define CONFIG_CROWPANEL_EPAPER_SPI_CLOCK_MHZ 10
+#define CONFIG_CROWPANEL_EPAPER_SPI_MOSI 11
+#define CONFIG_CROWPANEL_EPAPER_SPI_CLK  12
+#define CONFIG_CROWPANEL_EPAPER_SPI_CS   45
+#define CONFIG_CROWPANEL_EPAPER_DC_PIN   46
+#define CONFIG_CROWPANEL_EPAPER_RST_PIN  47
+#define CONFIG_CROWPANEL_EPAPER_BUSY_PIN 48
+#define CONFIG_CROWPANEL_EPAPER_POWER_PIN 7
+#define CONFIG_CROWPANEL_EPAPER_POWER_ON_DELAY_MS 200
+
+#define CONFIG_CROWPANEL_EPAPER_POLICY_MAX_PARTIAL 5
+#define CONFIG_CROWPANEL_EPAPER_POLICY_MAX_FAST 10
+#define CONFIG_CROWPANEL_EPAPER_POLICY_PARTIAL_MAX_PERMILLE 250
+#define CONFIG_CROWPANEL_EPAPER_POLICY_FULL_INTERVAL_S 3600
+#define CONFIG_CROWPANEL_EPAPER_HEAT_MAX_CHANGED 2048
+#define CONFIG_CROWPANEL_EPAPER_HEAT_FULL_PERMILLE 400
+
+#define CONFIG_CROWPANEL_EPAPER_ARENA_INTERNAL_DMA 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_FRAMES 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_SHADOW 1
+#define CONFIG_CROWPANEL_EPAPER_ARENA_OLD_RAM 1
+
+// Not the default (0): the host checks cover the copy path. The
+// epaper_warmboot_nocopy_check targets build the default with -D...=0.
+#ifndef CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE
+#define CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE 4096
+#endif
+#define CONFIG_CROWPANEL_EPAPER_WARM_BOOT_SAVE_ON_SLEEP 1
+
+#define CONFIG_CROWPANEL_EPAPER_RENDER_WORKERS 2
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef __EPAPER_ARENA_H__
+#define __EPAPER_ARENA_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Framebuffer arena
+//
+// Driver-owned memory for everything the refresh path touches, reserved once
+// so that drawing and display calls never allocate:
+//  - application framebuffers, the refresh policy shadow frame and the driver's
+//    mirror of the panel for previous-image RAM (0x26) sync, placed in
+//    internal DMA RAM, PSRAM or .bss according to the placement policy
+//  - SPI bounce buffers and the 2.13" rotation buffer, which are always static
+//    internal DMA memory and usable before (or without) EPD_Arena_Init
+// Buffers that are not DMA-capable (PSRAM, flash) are streamed to the panel
+// through the bounce buffers instead of letting the SPI driver allocate a
+// temporary copy per transaction.
+
+#define EPD_ARENA_BOUNCE_SIZE   512
+#define EPD_ARENA_BOUNCE_COUNT  2
+
+typedef enum {
+    EPD_ARENA_INTERNAL_DMA = 0, // heap_caps_malloc(MALLOC_CAP_DMA)
+    EPD_ARENA_PSRAM,            // heap_caps_malloc(MALLOC_CAP_SPIRAM), internal DMA if that fails
+    EPD_ARENA_STATIC,           // .bss, sized by the Kconfig options
+} EPD_ArenaPlacement_t;
+
+typedef struct {
+    EPD_ArenaPlacement_t placement;
+    uint8_t frames;             // Application framebuffers (EPD_Arena_Frame)
+    bool shadow;                // Shadow frame for the refresh policy (EPD_Arena_Shadow)
+    bool old_ram;               // Panel mirror for 0x26 sync (EPD_Arena_OldRam)
+} EPD_ArenaConfig_t;
+
+#if defined(CONFIG_CROWPANEL_EPAPER_ARENA_STATIC)
+#define EPD_ARENA_PLACEMENT_DEFAULT EPD_ARENA_STATIC
+#elif defined(CONFIG_CROWPANEL_EPAPER_ARENA_PSRAM)
+#define EPD_ARENA_PLACEMENT_DEFAULT EPD_ARENA_PSRAM
+#else
+#define EPD_ARENA_PLACEMENT_DEFAULT EPD_ARENA_INTERNAL_DMA
+#endif
+
+#if CONFIG_CROWPANEL_EPAPER_ARENA_SHADOW
+#define EPD_ARENA_SHADOW_DEFAULT true
+#else
+#define EPD_ARENA_SHADOW_DEFAULT false
+#endif
+
+#if CONFIG_CROWPANEL_EPAPER_ARENA_OLD_RAM
+#define EPD_ARENA_OLD_RAM_DEFAULT true
+#else
+#define EPD_ARENA_OLD_RAM_DEFAULT false
+#endif
+
+#define EPD_ARENA_CONFIG_DEFAULT() {                    \
+    .placement = EPD_ARENA_PLACEMENT_DEFAULT,           \
+    .frames = CONFIG_CROWPANEL_EPAPER_ARENA_FRAMES,     \
+    .shadow = EPD_ARENA_SHADOW_DEFAULT,                 \
+    .old_ram = EPD_ARENA_OLD_RAM_DEFAULT,               \
+}
+
+typedef struct {
+    EPD_ArenaPlacement_t placement; // Where the frames ended up
+    uint8_t frames;
+    bool shadow;
+    bool old_ram;
+    size_t frame_bytes;             // Framebuffers + shadow + mirror
+    size_t heap_bytes;              // Part of frame_bytes taken from the heap
+    size_t scratch_bytes;           // Static bounce and rotation buffers
+} EPD_ArenaFootprint_t;
+
+// Reserve the frames; ESP_ERR_INVALID_STATE if already initialized
+esp_err_t EPD_Arena_Init(const EPD_ArenaConfig_t *config);
+void EPD_Arena_Deinit(void);
+bool EPD_Arena_Ready(void);
+
+// Frame `index` (EPD_FRAME_SIZE bytes, word aligned), NULL if not reserved
+uint8_t *EPD_Arena_Frame(uint8_t index);
+uint8_t *EPD_Arena_Shadow(void);
+uint8_t *EPD_Arena_OldRam(void);
+
+// Scratch used by the driver's SPI layer
+uint8_t *EPD_Arena_Bounce(uint8_t index);
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+uint8_t *EPD_Arena_Native(void);    // EPD_NATIVE_FRAME_SIZE rotation buffer
+#endif
+
+void EPD_Arena_GetFootprint(EPD_ArenaFootprint_t *footprint);
+void EPD_Arena_LogFootprint(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_ARENA_H__
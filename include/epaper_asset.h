@@ -0,0 +1,69 @@
+#ifndef __EPAPER_ASSET_H__
+#define __EPAPER_ASSET_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Build-time image assets
+//
+// tools/epaper_asset.py, run by crowpanel_epaper_add_assets() (see
+// project_include.cmake), converts PBM/PNG files into EPD_Asset_t constants
+// that are already laid out the way the driver needs them:
+//  - EPD_ASSET_CANVAS: canvas memory rows for the canvas rotation the asset
+//    was converted for, drawn with EPD_Asset_Draw without per-pixel rotation
+//  - EPD_ASSET_NATIVE: a full frame in the controller's RAM layout (2.13"
+//    rotation included), streamed to RAM 0x24 by EPD_Asset_Display
+// Either may be PackBits-compressed; every row is encoded on its own, so it
+// is decoded one row at a time without a frame-sized buffer.
+
+typedef enum {
+    EPD_ASSET_CANVAS = 0,
+    EPD_ASSET_NATIVE,
+} EPD_AssetFormat_t;
+
+typedef enum {
+    EPD_ASSET_RAW = 0,
+    EPD_ASSET_PACKBITS,
+} EPD_AssetCompression_t;
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t size;          // Bytes in data
+    uint32_t raw_size;      // Bytes once decoded: height rows of (width + 7) / 8
+    uint16_t width;         // Pixels per decoded row (memory orientation)
+    uint16_t height;
+    uint16_t rotate;        // Canvas rotation the asset was converted for
+    uint8_t format;         // EPD_AssetFormat_t
+    uint8_t compression;    // EPD_AssetCompression_t
+} EPD_Asset_t;
+
+// Expand into out (raw_size bytes); ESP_ERR_INVALID_SIZE if out_size is too
+// small, ESP_ERR_INVALID_CRC if the compressed data is corrupt
+esp_err_t EPD_Asset_Decode(const EPD_Asset_t *asset, uint8_t *out, size_t out_size);
+
+// PackBits-compress height rows of (width + 7) / 8 bytes from src into out,
+// as the converter does, and describe the result in asset (a canvas asset at
+// rotation 0); ESP_ERR_INVALID_SIZE when it does not fit in out_size
+esp_err_t EPD_Asset_Encode(const uint8_t *src, uint16_t width, uint16_t height,
+                           uint8_t *out, size_t out_size, EPD_Asset_t *asset);
+
+// Canvas asset onto the canvas with its top-left corner at logical (x, y).
+// The asset must be converted for Paint.Rotate (ESP_ERR_INVALID_STATE
+// otherwise) and lie inside the canvas (ESP_ERR_INVALID_SIZE).
+esp_err_t EPD_Asset_Draw(const EPD_Asset_t *asset, uint16_t x, uint16_t y, EPD_Rop_t rop);
+
+// Full update with a native asset (or a full-frame uncompressed canvas
+// asset at rotation 0, which is the same on the 4.2")
+esp_err_t EPD_Asset_Display(const EPD_Asset_t *asset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_ASSET_H__
@@ -0,0 +1,57 @@
+#ifndef __EPAPER_BITS_H__
+#define __EPAPER_BITS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Framebuffer kernels
+//
+// Bulk operations on 1bpp frame bytes, 32 bits at a time: the head up to the
+// first word boundary and the tail go byte by byte, the middle as whole
+// words in plain loops the compiler can unroll or vectorize. Kernels over two
+// buffers use words when both sit at the same offset from a word boundary,
+// as the same rows of two frames of one geometry do, and bytes otherwise.
+// Regions of a canvas are rows of `wb` bytes, `stride` bytes apart.
+
+void EPD_Bits_Fill(uint8_t *dst, uint8_t value, size_t len);
+// dst = ~src; dst may be src
+void EPD_Bits_Invert(uint8_t *dst, const uint8_t *src, size_t len);
+// dst = a ^ b; dst may be a or b
+void EPD_Bits_Xor(uint8_t *dst, const uint8_t *a, const uint8_t *b, size_t len);
+// dst |= src, dst &= src
+void EPD_Bits_Or(uint8_t *dst, const uint8_t *src, size_t len);
+void EPD_Bits_And(uint8_t *dst, const uint8_t *src, size_t len);
+
+// Set bits, and bits that differ between a and b
+uint32_t EPD_Bits_Count(const uint8_t *src, size_t len);
+uint32_t EPD_Bits_CountDiff(const uint8_t *a, const uint8_t *b, size_t len);
+// First and last byte where a and b differ (either may be NULL); false when
+// they are equal
+bool EPD_Bits_DiffSpan(const uint8_t *a, const uint8_t *b, size_t len, size_t *first, size_t *last);
+
+void EPD_Bits_FillRect(uint8_t *dst, size_t stride, size_t wb, uint16_t h, uint8_t value);
+void EPD_Bits_CopyRect(uint8_t *dst, size_t dst_stride, const uint8_t *src, size_t src_stride,
+                       size_t wb, uint16_t h);
+uint32_t EPD_Bits_CountRect(const uint8_t *src, size_t stride, size_t wb, uint16_t h);
+
+// Bit runs within a row: bits [bit0, bit0 + nbits), bit 0 being the MSB of
+// row[0] (the leftmost pixel). Bits outside the run are left as they are.
+// value/fill is 0xFF to set bits, 0x00 to clear them.
+void EPD_Bits_FillBits(uint8_t *row, size_t bit0, size_t nbits, uint8_t value);
+// Copy the run from src to the same bits of dst (another row)
+void EPD_Bits_CopyBits(uint8_t *dst, const uint8_t *src, size_t bit0, size_t nbits);
+// Move the run `shift` bits towards bit0 (left) or away from it (right) in
+// place, 32 bits per step; the bits shifted in take fill
+void EPD_Bits_ShiftLeft(uint8_t *row, size_t bit0, size_t nbits, size_t shift, uint8_t fill);
+void EPD_Bits_ShiftRight(uint8_t *row, size_t bit0, size_t nbits, size_t shift, uint8_t fill);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_BITS_H__
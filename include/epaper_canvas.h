@@ -0,0 +1,65 @@
+#ifndef __EPAPER_CANVAS_H__
+#define __EPAPER_CANVAS_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "epaper_driver.h"
+#include "epaper_refresh_policy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Double-buffered canvas
+//
+// Drawing always targets the back canvas (Paint points at it). Present swaps
+// first: the back canvas becomes the front and the old front becomes the new
+// back after copying over only the rows that differ. Then it hands the new
+// front to the refresh policy with async refresh enabled, so it returns once
+// the panel waveform has started. The next frame can be drawn
+// while the panel is still refreshing; the next present waits for BUSY only
+// when it needs the bus.
+//
+// Several tasks may draw into the canvas if each wraps its drawing in
+// EPD_Canvas_Lock/Unlock; present takes the same lock for the swap only,
+// after waiting for the previous refresh, and refreshes from the front canvas
+// without it, so the lock is never held across a waveform (not even between
+// the two of EPD_REFRESH_CLEAN). Presents from several tasks run one at a time. Tasks that
+// must not wait at all push commands into a ring instead (epaper_cmdring.h).
+
+typedef struct {
+    EPD_RefreshMode_t mode;     // Mode used by the last present
+    uint16_t copied_rows;       // Rows copied front -> back by the last swap
+    uint32_t presents;
+} EPD_CanvasStats_t;
+
+// front/back: EPD_FRAME_SIZE buffers, or NULL for arena frames 0 and 1
+// (the arena is initialized with at least two frames if needed). Both are
+// cleared to white and Paint is set up on the back canvas with Rotate.
+// Presents go through the refresh policy, which needs the arena's shadow
+// frame: a policy the app set up with EPD_Policy_Init beforehand is kept,
+// otherwise it is initialized with EPD_POLICY_CONFIG_DEFAULT(). The error of
+// that init (e.g. ESP_ERR_INVALID_STATE for an arena without a shadow) is
+// returned. EPD_Canvas_Deinit leaves the policy initialized.
+esp_err_t EPD_Canvas_Init(uint8_t *front, uint8_t *back, uint16_t Rotate);
+void EPD_Canvas_Deinit(void);
+
+uint8_t *EPD_Canvas_Back(void);
+const uint8_t *EPD_Canvas_Front(void);
+
+// Recursive lock on the canvas (Paint and both buffers); false when wait ran out
+bool EPD_Canvas_Lock(TickType_t wait);
+void EPD_Canvas_Unlock(void);
+
+// Present the back canvas and swap; returns the refresh mode that was used
+EPD_RefreshMode_t EPD_Canvas_Present(void);
+
+void EPD_Canvas_GetStats(EPD_CanvasStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_CANVAS_H__
@@ -0,0 +1,94 @@
+#ifndef __EPAPER_CHART_H__
+#define __EPAPER_CHART_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scrolling strip chart
+//
+// A plot rectangle that shows the last width / step samples (rounded up, the
+// oldest partly scrolled out), newest at the right. A new sample scrolls the plot `step` pixels left in place with
+// EPD_ScrollLeft and draws only the new column(s), so the cost of a sample
+// does not depend on how many are shown. The samples are also kept in a ring,
+// from which the whole plot is redrawn after the canvas was cleared. Values
+// are integers (fixed-point as for the numeric field) mapped linearly from
+// [min, max] to the bottom and top rows; values outside are clamped.
+
+#define EPD_CHART_MAX_SAMPLES   400
+
+typedef enum {
+    EPD_CHART_LINE = 0,         // Samples joined by lines
+    EPD_CHART_AREA,             // Filled down to the bottom row
+} EPD_ChartStyle_t;
+
+typedef struct {
+    uint16_t x;                 // Plot rectangle, in canvas coordinates
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    int32_t min;                // Value on the bottom row
+    int32_t max;                // Value on the top row, greater than min
+    uint8_t step;               // Pixels per sample (at least 1)
+    EPD_ChartStyle_t style;
+    uint16_t color;             // Trace color; the plot background is background
+    uint16_t background;
+} EPD_ChartConfig_t;
+
+#define EPD_CHART_CONFIG_DEFAULT() {    \
+    .x = 0,                             \
+    .y = 0,                             \
+    .width = 100,                       \
+    .height = 40,                       \
+    .min = 0,                           \
+    .max = 100,                         \
+    .step = 1,                          \
+    .style = EPD_CHART_LINE,            \
+    .color = BLACK,                     \
+    .background = WHITE,                \
+}
+
+typedef struct {
+    EPD_ChartConfig_t cfg;
+    uint16_t shown;                     // Samples with a column in the plot
+    uint16_t count;                     // Samples in the ring, up to shown + 1
+    uint16_t head;                      // Slot of the next sample
+    bool drawn;                         // The canvas shows the ring
+    // One more than shown: the sample the oldest column's line starts from
+    int32_t samples[EPD_CHART_MAX_SAMPLES + 1];
+} EPD_Chart_t;
+
+// ESP_ERR_INVALID_ARG for an empty range or rectangle, a step of 0 or more
+// than EPD_CHART_MAX_SAMPLES samples. Nothing is drawn until the first
+// EPD_Chart_Push.
+esp_err_t EPD_Chart_Init(EPD_Chart_t *chart, const EPD_ChartConfig_t *config);
+
+// Add a sample and draw it on the Paint canvas: scroll and one new column
+// once the plot is drawn, the whole plot from the ring otherwise. When dirty
+// is not NULL it receives the plot rectangle in frame coordinates (memory
+// pixels of Paint.Rotate), ready for EPD_Display_Part_Stride.
+void EPD_Chart_Push(EPD_Chart_t *chart, int32_t value, EPD_Rect_t *dirty);
+
+// EPD_Chart_Push, then a partial update of the plot rectangle from Paint.Image
+void EPD_Chart_Update(EPD_Chart_t *chart, int32_t value);
+
+// Forget what is on the canvas (e.g. after clearing it): the next
+// EPD_Chart_Push redraws the whole plot from the ring
+void EPD_Chart_Invalidate(EPD_Chart_t *chart);
+
+// Drop all samples; the next EPD_Chart_Push starts an empty plot
+void EPD_Chart_Reset(EPD_Chart_t *chart);
+
+// Plot rectangle in frame coordinates, as reported by EPD_Chart_Push
+void EPD_Chart_GetRect(const EPD_Chart_t *chart, EPD_Rect_t *rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_CHART_H__
@@ -0,0 +1,93 @@
+#ifndef __EPAPER_CMDRING_H__
+#define __EPAPER_CMDRING_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Draw command ring
+//
+// Multi-producer, single-consumer queue of drawing commands. Any task on
+// either core (or an ISR) pushes commands without taking a lock, so it never
+// waits behind a refresh; the task that owns Paint drains them in batches,
+// typically right before presenting the frame. A push claims a slot with one
+// compare-and-swap on the head index and publishes it through the slot's
+// sequence number; a full ring refuses the push instead of blocking.
+
+#define EPD_CMD_TEXT_MAX 24     // EPD_CMD_STRING text, including the terminator
+
+typedef enum {
+    EPD_CMD_FILL = 0,           // EPD_Full(color)
+    EPD_CMD_PIXEL,              // Paint_SetPixel(x0, y0, color)
+    EPD_CMD_LINE,               // EPD_DrawLine(x0, y0, x1, y1, color)
+    EPD_CMD_RECT,               // EPD_DrawRectangle(x0, y0, x1, y1, color, mode)
+    EPD_CMD_CIRCLE,             // EPD_DrawCircle(x0, y0, radius = x1, color, mode)
+    EPD_CMD_CLEAR_WINDOW,       // EPD_ClearWindows(x0, y0, x1, y1, color)
+    EPD_CMD_STRING,             // EPD_ShowString(x0, y0, text, size, color)
+    EPD_CMD_NUM,                // EPD_ShowNum(x0, y0, num, len = mode, size, color)
+    EPD_CMD_PICTURE,            // EPD_ShowPicture(x0, y0, sizex = x1, sizey = y1, image, color)
+    EPD_CMD_BLIT,               // EPD_Blit(x0, y0, sizex = x1, sizey = y1, image, NULL, rop = mode)
+    EPD_CMD_CALL,               // call.fn(call.arg) on the draining task
+} EPD_CmdOp_t;
+
+typedef struct {
+    uint8_t op;                 // EPD_CmdOp_t
+    uint8_t mode;               // Fill mode, digit count or raster operation
+    uint8_t size;               // Font size
+    uint16_t color;
+    uint16_t x0, y0, x1, y1;
+    union {
+        char text[EPD_CMD_TEXT_MAX];
+        uint32_t num;
+        const uint8_t *image;   // Must stay valid until drained
+        struct {
+            void (*fn)(void *arg);
+            void *arg;
+        } call;
+    };
+} EPD_DrawCmd_t;
+
+typedef struct {
+    uint32_t seq;               // Push/drain handshake, see epaper_cmdring.c
+    EPD_DrawCmd_t cmd;
+} EPD_CmdSlot_t;
+
+typedef struct {
+    EPD_CmdSlot_t *slots;
+    uint32_t mask;              // Capacity - 1
+    uint32_t head;              // Next slot to claim (producers)
+    uint32_t tail;              // Next slot to drain (consumer)
+    uint32_t dropped;           // Pushes refused because the ring was full
+} EPD_CmdRing_t;
+
+// capacity: power of two, at least 2; slots holds capacity entries
+esp_err_t EPD_CmdRing_Init(EPD_CmdRing_t *ring, EPD_CmdSlot_t *slots, uint32_t capacity);
+
+// Producers: false when the ring is full (the command is counted as dropped)
+bool EPD_CmdRing_Push(EPD_CmdRing_t *ring, const EPD_DrawCmd_t *cmd);
+// EPD_CMD_STRING with the text copied into the command (truncated to fit)
+bool EPD_CmdRing_PushString(EPD_CmdRing_t *ring, uint16_t x, uint16_t y, const char *text,
+                            uint8_t size, uint16_t color);
+
+// Consumer (one task): run up to max commands (0 = all published so far) on
+// Paint in push order; returns how many ran. With the double-buffered canvas,
+// drain from the presenting task or under EPD_Canvas_Lock.
+size_t EPD_CmdRing_Drain(EPD_CmdRing_t *ring, size_t max);
+
+// Run one command on Paint, as the drain does
+void EPD_Cmd_Run(const EPD_DrawCmd_t *cmd);
+// Logical box that holds every pixel the command may draw (the whole canvas
+// for FILL and CALL), not clipped to the canvas; false when it draws nothing
+bool EPD_Cmd_Bounds(const EPD_DrawCmd_t *cmd, EPD_Rect_t *rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_CMDRING_H__
@@ -2,6 +2,8 @@
 #define __EPAPER_DRIVER_H__
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
 #include "sdkconfig.h"
 
@@ -24,9 +26,21 @@ extern "C" {
 #define EPD_H 300
 #endif
 
+// Logical frame buffer geometry (1bpp, MSB first, rows padded to a byte)
+#define EPD_FRAME_STRIDE ((EPD_W + 7) / 8)
+#define EPD_FRAME_SIZE   (EPD_FRAME_STRIDE * EPD_H)
+
+// Frame in controller RAM order (the 2.13" is 122 gates, padded to 16 bytes, x 250 sources)
+#if defined(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+#define EPD_NATIVE_FRAME_SIZE (16 * 250)
+#else
+#define EPD_NATIVE_FRAME_SIZE EPD_FRAME_SIZE
+#endif
+
 // Colors
 #define WHITE 0xFF
 #define BLACK 0x00
+#define RED   0x0F  // Needs a color plane, see Paint_NewImagePlanes
 
 // Rotation
 #define ROTATE_0   0
@@ -38,9 +52,15 @@ extern "C" {
 #define Fast_Seconds_1_5s 1
 #define Fast_Seconds_1_s  2
 
+// Bitplanes per canvas: plane 0 is black/white (RAM 0x24, 1 = white), plane 1
+// is the color plane of black/white/red panels (RAM 0x26, 1 = red)
+#define EPD_MAX_PLANES 2
+
 // Paint Structure
 typedef struct {
-    uint8_t *Image;
+    uint8_t *Image;                     // Plane 0
+    uint8_t *Planes[EPD_MAX_PLANES];
+    uint8_t PlaneCount;
     uint16_t Width;
     uint16_t Height;
     uint16_t WidthMemory;
@@ -53,27 +73,153 @@ typedef struct {
 
 extern Paint_t Paint;
 
+// Raster operations for EPD_Blit, applied to the black/white plane (1 = white)
+typedef enum {
+    EPD_ROP_COPY = 0,   // dst = src
+    EPD_ROP_OR,         // dst |= src: src 1 bits draw white, 0 bits are transparent
+    EPD_ROP_AND,        // dst &= src: src 0 bits draw black, 1 bits are transparent
+    EPD_ROP_XOR,        // dst ^= src: src 1 bits invert the canvas
+    EPD_ROP_NOT,        // dst = ~src
+    EPD_ROP_SET,        // dst = 1 (white), src ignored; with a mask, paints the mask shape
+    EPD_ROP_CLEAR,      // dst = 0 (black), src ignored
+} EPD_Rop_t;
+
+// Rectangle in logical pixel coordinates
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} EPD_Rect_t;
+
 // Function Prototypes
 
 // Hardware / GPIO / SPI
 void EPD_GPIOInit(void);
 void EPD_PowerOn(void); // Toggles pin 7
-void EPD_Sleep(void);
+
+// Deep sleep. Both modes stop the controller until the next hardware reset,
+// which also resets its registers; EPD_SLEEP_RETAIN keeps the two frame RAMs,
+// EPD_SLEEP_DEEP drops them as well for the lowest current. The next panel
+// call wakes the controller and restores only what the mode lost: the
+// registers and loaded waveform mode, and after EPD_SLEEP_DEEP both RAMs from
+// the panel mirror when there is one (see EPD_SetOldRamSync), so partial
+// updates continue without a full refresh. A call while asleep does nothing.
+typedef enum {
+    EPD_SLEEP_RETAIN = 0x01,    // Deep sleep mode 1
+    EPD_SLEEP_DEEP = 0x03,      // Deep sleep mode 2
+} EPD_SleepMode_t;
+
+// Wake-up cost per sleep mode: from the start of the wake to the start of the
+// first update after it, and of the restore alone (microseconds)
+typedef struct {
+    uint32_t wakes;
+    uint32_t resume_us_last;
+    uint32_t latency_us_last;
+    uint32_t latency_us_max;
+    uint64_t latency_us_total;
+} EPD_WakeStats_t;
+
+void EPD_Sleep(void); // EPD_Sleep_Mode(EPD_SLEEP_RETAIN)
+void EPD_Sleep_Mode(EPD_SleepMode_t mode);
+void EPD_Sleep_GetStats(EPD_SleepMode_t mode, EPD_WakeStats_t *stats);
+void EPD_Sleep_ResetStats(void);
+
+// Hold the SPI bus across several EPD_* calls (nestable). Every panel
+// function already holds it for its own sequence; the bus is released while
+// waiting for a refresh, so other devices can use it in the meantime, and
+// taking it wakes a sleeping controller (EPD_Sleep_Mode).
+// After EPD_GPIOInit it is also a recursive lock: panel calls from several
+// tasks run one sequence at a time. Drawing into Paint is not covered, see
+// EPD_Canvas_Lock and epaper_cmdring.h.
+void EPD_Bus_Acquire(void);
+void EPD_Bus_Release(void);
+
+// Async refresh: EPD_Display*, EPD_Clear return as soon as the panel update
+// has started instead of blocking on BUSY for the waveform (1-3 s). The next
+// EPD_* call that talks to the panel, or EPD_WaitIdle, waits for it first.
+void EPD_SetAsyncRefresh(bool enable);
+bool EPD_IsBusy(void);
+void EPD_WaitIdle(void);
 
 // Basic EPD commands
 void EPD_Init(void);
 void EPD_Init_Fast(uint8_t mode);
 void EPD_Clear(void);
 void EPD_Clear_R26H(void);
+// Previous-image RAM (0x26) sync, on by default when the arena reserves a
+// panel mirror. EPD_Display_Color suspends it, since 0x26 is then the color
+// plane; the next black/white full frame (EPD_Display, EPD_Display_Fast,
+// EPD_Clear, EPD_Display_Seed) resumes it.
+void EPD_SetOldRamSync(bool enable);
+// Full frame the panel shows, as kept by the panel mirror, once an update
+// still running has finished; NULL without a mirror or before the driver
+// has written a whole frame
+const uint8_t *EPD_Shown(void);
+// Load the full frame Image into both RAMs (0x24 and 0x26) and the mirror
+// without a refresh, for a panel that already shows it (e.g. after a reset,
+// see epaper_warmboot.h); partial updates can follow right away
+void EPD_Display_Seed(const uint8_t *Image);
 void EPD_Display(const uint8_t *Image);
 void EPD_Display_Part(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image);
+// Partial update of a window of the full frame Image (EPD_FRAME_STRIDE bytes
+// per row), no packed copy needed. X is widened to byte boundaries and the
+// window clipped to the panel.
+void EPD_Display_Part_Stride(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image);
+// Several windows of the full frame Image written to RAM, then one partial
+// update for all of them (one waveform instead of one per window)
+void EPD_Display_Part_Multi(const EPD_Rect_t *rects, size_t count, const uint8_t *Image);
+// Clean a window of the full frame Image with two partial updates: every
+// pixel to its opposite color, then back to Image. Clears the ghosting that
+// repeated partial updates leave without a full-screen flash (see
+// epaper_heatmap.h).
+void EPD_Display_Part_Clean(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image);
 void EPD_Display_Fast(const uint8_t *Image);
+// Black/white/red panels: black/white plane to 0x24, red plane to 0x26, one full update
+void EPD_Display_Color(const uint8_t *Image, const uint8_t *Color);
+// Full update from a frame already in the controller's RAM layout
+// (EPD_NATIVE_FRAME_SIZE bytes: what EPD_Display sends after the 2.13"
+// rotation), e.g. a native asset. Begin/Write/End stream the same frame
+// in pieces. The driver cannot read such a frame back, so the 0x26 mirror
+// starts over with the next EPD_Display.
+void EPD_Display_Native(const uint8_t *Native);
+void EPD_Display_Native_Begin(void);
+void EPD_Display_Native_Write(const uint8_t *Data, size_t len);
+void EPD_Display_Native_End(void);
 
 // GUI / Paint
 void Paint_NewImage(uint8_t *image, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color);
+// Canvas over `count` (1..EPD_MAX_PLANES) frame buffers of EPD_FRAME_SIZE geometry;
+// every drawing function then writes all planes in the same pass
+void Paint_NewImagePlanes(uint8_t *const planes[], uint8_t count, uint16_t Width, uint16_t Height, uint16_t Rotate, uint16_t Color);
 void Paint_SetPixel(uint16_t Xpoint, uint16_t Ypoint, uint16_t Color);
+// Restrict drawing by the calling task to memory rows [y0, y1) of the canvas
+// (rows of the frame buffer, whatever Paint.Rotate is); (0, UINT16_MAX)
+// lifts it. Per task, so workers can render disjoint bands of one canvas at
+// the same time, see epaper_render.h.
+void EPD_Paint_SetBand(uint16_t y0, uint16_t y1);
+// Logical pixels x0..x1 of row y, clipped to the canvas and band: whole
+// bytes (and words) of a memory row under ROTATE_0/180, a memory column under
+// ROTATE_90/270. The fill kernel of the shapes in epaper_raster.h.
+void EPD_FillSpan(int32_t x0, int32_t x1, int32_t y, uint16_t Color);
+// Move the pixels of a logical rectangle dx columns left, in place and on
+// every plane; the columns freed at the right take Color. Bit shifts within
+// memory rows under ROTATE_0/180, row copies under ROTATE_90/270. Clipped to
+// the canvas but not to the band: under ROTATE_90/270 the pixels come from
+// other memory rows, so it is not for band workers.
+void EPD_ScrollLeft(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t dx, uint16_t Color);
 void EPD_Full(uint8_t Color);
 void EPD_ShowPicture(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey, const uint8_t *Image, uint16_t Color);
+// Combine a sizex x sizey bitmap (rows padded to whole bytes, MSB first,
+// 1 = white) with the canvas at logical (x, y) under any rotation, clipped to
+// the canvas. Mask (same layout, may be NULL) selects the pixels that are
+// drawn. Works on the black/white plane; a color plane is left untouched.
+void EPD_Blit(uint16_t x, uint16_t y, uint16_t sizex, uint16_t sizey,
+              const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop);
+// EPD_Blit for a bitmap already laid out in canvas memory orientation (e.g.
+// an asset converted for Paint.Rotate): (X, Y) and the size in memory pixels
+void EPD_Blit_Memory(uint16_t X, uint16_t Y, uint16_t sizex, uint16_t sizey,
+                     const uint8_t *Src, const uint8_t *Mask, EPD_Rop_t rop);
 
 // Drawing Functions
 void EPD_ClearWindows(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye, uint16_t color);
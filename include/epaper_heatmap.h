@@ -0,0 +1,89 @@
+#ifndef __EPAPER_HEATMAP_H__
+#define __EPAPER_HEATMAP_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ghosting heat map
+//
+// Per-tile record of the partial refreshing each area of the panel has taken
+// since a cleaning waveform last drove it: partial updates that touched the
+// tile and pixels changed in it. The driver's partial paths count the
+// updates; callers that know the changed pixels (the refresh policy diffs
+// against its shadow) add those. Full and fast refreshes clean every tile,
+// EPD_Display_Part_Clean the tiles of its area.
+//
+// A tile is hot once it has used up its budget. EPD_Heat_Plan turns the hot
+// tiles into a cleanup: an invert-flash of their bounding box, or a full
+// refresh when that box covers too much of the panel.
+
+// Tile grid (tile width is a multiple of 8)
+#define EPD_TILE_W       32
+#define EPD_TILE_H       32
+#define EPD_TILES_X      ((EPD_W + EPD_TILE_W - 1) / EPD_TILE_W)
+#define EPD_TILES_Y      ((EPD_H + EPD_TILE_H - 1) / EPD_TILE_H)
+#define EPD_TILE_COUNT   (EPD_TILES_X * EPD_TILES_Y)
+
+// Refresh budget per tile
+typedef struct {
+    uint16_t max_partials;      // Partial updates a tile may take (1..255)
+    uint16_t max_changed;       // Changed pixels a tile may accumulate (0 = no limit)
+    uint16_t full_permille;     // Cleanup area (per mille of the panel) above which the whole screen is refreshed
+} EPD_HeatConfig_t;
+
+#define EPD_HEAT_CONFIG_DEFAULT() {                                         \
+    .max_partials = CONFIG_CROWPANEL_EPAPER_POLICY_MAX_PARTIAL,             \
+    .max_changed = CONFIG_CROWPANEL_EPAPER_HEAT_MAX_CHANGED,                \
+    .full_permille = CONFIG_CROWPANEL_EPAPER_HEAT_FULL_PERMILLE,            \
+}
+
+typedef enum {
+    EPD_CLEANUP_NONE = 0,   // No tile over budget
+    EPD_CLEANUP_AREA,       // EPD_Display_Part_Clean of the hot tiles' bounding box
+    EPD_CLEANUP_FULL,       // EPD_Init + EPD_Display
+} EPD_Cleanup_t;
+
+typedef struct {
+    uint8_t partials;       // Partial updates since the last cleaning waveform (saturates)
+    uint16_t changed;       // Changed pixels since then (saturates)
+} EPD_HeatTile_t;
+
+esp_err_t EPD_Heat_SetConfig(const EPD_HeatConfig_t *config);
+void EPD_Heat_GetConfig(EPD_HeatConfig_t *config);
+
+// Bookkeeping, called by the driver: Touch marks the tiles under a window
+// written for the coming partial update, Commit counts the update once for
+// every marked tile, Clean resets the tiles a cleaning waveform drove
+// (area NULL = all)
+void EPD_Heat_Touch(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+void EPD_Heat_Commit(void);
+void EPD_Heat_Clean(const EPD_Rect_t *area);
+
+// Add changed pixels to tile t (0..EPD_TILE_COUNT-1)
+void EPD_Heat_AddChanged(uint16_t t, uint32_t pixels);
+
+void EPD_Heat_GetTile(uint16_t t, EPD_HeatTile_t *tile);
+bool EPD_Heat_IsHot(uint16_t t);
+// Tile under pixel (x, y) of the frame
+static inline uint16_t EPD_Heat_TileAt(uint16_t x, uint16_t y) {
+    return (y / EPD_TILE_H) * EPD_TILES_X + x / EPD_TILE_W;
+}
+
+// Cleanup the hot tiles need; area receives the bounding box to clean for
+// EPD_CLEANUP_AREA (X on byte boundaries) and may be NULL
+EPD_Cleanup_t EPD_Heat_Plan(EPD_Rect_t *area);
+
+// Plan and run it with the frame on the panel (EPD_FRAME_SIZE bytes)
+EPD_Cleanup_t EPD_Heat_Cleanup(const uint8_t *Image);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_HEATMAP_H__
@@ -0,0 +1,80 @@
+#ifndef __EPAPER_IMAGE_H__
+#define __EPAPER_IMAGE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Image files at run time
+//
+// Loaders for PBM (P1/P4), PGM (P2/P5) and uncompressed 1-, 4- and 8-bit
+// BMP that read a stdio stream (a file on SPIFFS, FAT or an SD card through
+// the VFS, or a plain file on the host) EPD_IMAGE_CHUNK bytes at a time and
+// draw each row into the Paint canvas with EPD_Blit as soon as it is
+// decoded. Nothing is allocated: the stack holds one chunk and a strip of
+// eight rows, whatever the image size, so artwork can be replaced (e.g. on a
+// data partition) without rebuilding the firmware.
+//
+// Gray pixels (PGM, and BMP palette entries by luminance) are white at or
+// above the threshold, black below it. PBM 1 bits are black; 1-bit BMP
+// pixels take the gray of their palette entry, so either palette order works.
+
+#define EPD_IMAGE_CHUNK         256
+
+typedef enum {
+    EPD_IMAGE_PBM = 0,
+    EPD_IMAGE_PGM,
+    EPD_IMAGE_BMP,
+} EPD_ImageType_t;
+
+typedef struct {
+    uint16_t rotate;            // ROTATE_0..ROTATE_270: image turned clockwise on the canvas
+    uint8_t threshold;          // Gray level (0..255) from which pixels are white
+    bool invert;                // Swap black and white after thresholding
+    EPD_Rop_t rop;              // How the image combines with the canvas, as for EPD_Blit
+} EPD_ImageOptions_t;
+
+#define EPD_IMAGE_OPTIONS_DEFAULT() {   \
+    .rotate = ROTATE_0,                 \
+    .threshold = 128,                   \
+    .invert = false,                    \
+    .rop = EPD_ROP_COPY,                \
+}
+
+typedef struct {
+    EPD_ImageType_t type;
+    uint8_t bits;               // Bits per pixel in the file: 1, 4, 8 or 16 (PGM with maxval > 255)
+    uint16_t width;             // As stored, before options.rotate
+    uint16_t height;
+} EPD_ImageInfo_t;
+
+// Read the header at the current position of f into info and seek back, so
+// the image can be placed (e.g. centered) before it is drawn.
+// ESP_ERR_NOT_SUPPORTED for other formats or BMP variants (compressed,
+// 16/24/32-bit), ESP_ERR_INVALID_CRC for a malformed header.
+esp_err_t EPD_Image_Probe(FILE *f, EPD_ImageInfo_t *info);
+
+// Draw the image read from f with its top-left corner (after rotation) at
+// logical (x, y); the part outside the canvas is clipped and rows below it
+// are not read. options may be NULL for EPD_IMAGE_OPTIONS_DEFAULT() and
+// info, when not NULL, receives the header. Errors as for EPD_Image_Probe;
+// a file that ends early also gives ESP_ERR_INVALID_CRC, with the rows
+// before the end already drawn. Works on the black/white plane only.
+esp_err_t EPD_Image_Draw(FILE *f, uint16_t x, uint16_t y, const EPD_ImageOptions_t *options,
+                         EPD_ImageInfo_t *info);
+
+// EPD_Image_Draw of the file at path; ESP_ERR_NOT_FOUND if it cannot be opened
+esp_err_t EPD_Image_DrawFile(const char *path, uint16_t x, uint16_t y,
+                             const EPD_ImageOptions_t *options, EPD_ImageInfo_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_IMAGE_H__
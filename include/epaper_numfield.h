@@ -0,0 +1,77 @@
+#ifndef __EPAPER_NUMFIELD_H__
+#define __EPAPER_NUMFIELD_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Odometer-style numeric field
+//
+// A fixed row of character cells (optional sign, integer digits, decimal
+// point, fraction digits) that remembers what it last drew. Setting a new
+// value formats it with one divide by ten per digit, redraws only the cells
+// whose character changed and reports their bounding box, ready for
+// EPD_Display_Part_Stride or the refresh policy. Values are fixed-point
+// integers: 2350 with two fraction digits shows as 23.50. Values with more
+// digits than the field wrap like an odometer (the low digits are shown).
+
+#define EPD_NUMFIELD_MAX_DIGITS 10
+#define EPD_NUMFIELD_MAX_CELLS  (EPD_NUMFIELD_MAX_DIGITS + 2)
+
+typedef struct {
+    uint16_t x;             // Top-left corner, as for EPD_ShowChar
+    uint16_t y;
+    uint8_t digits;         // Digit cells including fraction digits (1..10)
+    uint8_t frac;           // Fraction digits, less than digits (0 = integer)
+    uint8_t size;           // Font size: 8, 12, 16 or 24
+    uint16_t color;         // Digit color (BLACK or WHITE), cells are filled with the other
+    bool zero_pad;          // Leading zeros instead of blank cells
+    bool sign;              // Leading cell for '-' (negative values otherwise show their magnitude)
+} EPD_NumFieldConfig_t;
+
+#define EPD_NUMFIELD_CONFIG_DEFAULT() { \
+    .x = 0,                             \
+    .y = 0,                             \
+    .digits = 5,                        \
+    .frac = 0,                          \
+    .size = 16,                         \
+    .color = BLACK,                     \
+    .zero_pad = false,                  \
+    .sign = false,                      \
+}
+
+typedef struct {
+    EPD_NumFieldConfig_t cfg;
+    uint8_t cells;                      // Cells in use
+    uint8_t pitch;                      // Cell width in pixels
+    uint8_t height;                     // Cell height in pixels
+    bool drawn;                         // shown[] is on the canvas
+    char shown[EPD_NUMFIELD_MAX_CELLS]; // Characters last drawn
+} EPD_NumField_t;
+
+// ESP_ERR_INVALID_ARG for an unsupported size or digit count. Nothing is
+// drawn until the first EPD_NumField_Set.
+esp_err_t EPD_NumField_Init(EPD_NumField_t *field, const EPD_NumFieldConfig_t *config);
+
+// Draw value on the Paint canvas, touching only the cells that changed.
+// Returns the number of cells redrawn; when dirty is not NULL it receives
+// their bounding box in canvas coordinates (width 0 when nothing changed).
+uint8_t EPD_NumField_Set(EPD_NumField_t *field, int32_t value, EPD_Rect_t *dirty);
+
+// Forget what is on the canvas (e.g. after clearing it): the next
+// EPD_NumField_Set redraws every cell
+void EPD_NumField_Invalidate(EPD_NumField_t *field);
+
+// Bounding box of the whole field
+void EPD_NumField_GetRect(const EPD_NumField_t *field, EPD_Rect_t *rect);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_NUMFIELD_H__
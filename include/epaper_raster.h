@@ -0,0 +1,60 @@
+#ifndef __EPAPER_RASTER_H__
+#define __EPAPER_RASTER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "epaper_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Filled shapes
+//
+// Polygons, thick lines and arcs are rasterized a row at a time into spans
+// for EPD_FillSpan, so a shape costs one span fill per row it covers instead
+// of a Paint_SetPixel per pixel. Coordinates are logical, as for the other
+// drawing functions, and may lie outside the canvas. A pixel is drawn when
+// its center lies inside the outline, with points on the left and top edges
+// counting as inside and those on the right and bottom edges not, so shapes
+// that share an edge never overlap.
+
+#define EPD_RASTER_MAX_POINTS   32
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} EPD_Point_t;
+
+typedef enum {
+    EPD_FILL_EVEN_ODD = 0,      // Inside when an odd number of edges lie to the left
+    EPD_FILL_NONZERO,           // Inside when the edges to the left do not cancel out
+} EPD_FillRule_t;
+
+typedef enum {
+    EPD_CAP_BUTT = 0,           // Ends at the end points
+    EPD_CAP_SQUARE,             // Extended by half the width
+    EPD_CAP_ROUND,              // Half circle of the width
+} EPD_LineCap_t;
+
+// Convex or concave, self-intersecting allowed; the last point connects back
+// to the first. At most EPD_RASTER_MAX_POINTS points, extra ones are ignored.
+void EPD_FillPolygon(const EPD_Point_t *points, size_t count, EPD_FillRule_t rule, uint16_t Color);
+
+// Line of `width` pixels centered on (x0, y0)-(x1, y1)
+void EPD_DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t width,
+                       EPD_LineCap_t cap, uint16_t Color);
+
+// Angles in degrees, 0 pointing right (+x) and growing clockwise on the
+// screen; the shape runs clockwise from start to end, and end == start is a
+// whole turn. EPD_DrawArc draws a ring segment `width` pixels thick whose
+// outer edge is `radius`; EPD_FillPie the slice of the disc.
+void EPD_DrawArc(int16_t cx, int16_t cy, uint16_t radius, uint16_t width,
+                 int16_t start, int16_t end, uint16_t Color);
+void EPD_FillPie(int16_t cx, int16_t cy, uint16_t radius, int16_t start, int16_t end, uint16_t Color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_RASTER_H__
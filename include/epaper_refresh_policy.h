@@ -0,0 +1,80 @@
+#ifndef __EPAPER_REFRESH_POLICY_H__
+#define __EPAPER_REFRESH_POLICY_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "epaper_driver.h"
+#include "epaper_heatmap.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Refresh policy
+//
+// Chooses between EPD_Display_Part, EPD_Display_Part_Clean, EPD_Display_Fast
+// and EPD_Display for each frame. The policy keeps a shadow of the last
+// presented frame and feeds the changed pixels of each partial refresh to the
+// ghosting heat map (epaper_heatmap.h); it picks the cheapest mode whose
+// ghosting stays within the configured budget. A change touching worn tiles
+// cleans just the worn area in place, the whole screen is flashed only when
+// that area is too large.
+
+// Refresh modes, ordered from cheapest to most expensive
+typedef enum {
+    EPD_REFRESH_NONE = 0,   // Frame identical to the panel, nothing sent
+    EPD_REFRESH_PARTIAL,    // EPD_Display_Part
+    EPD_REFRESH_CLEAN,      // EPD_Display_Part_Clean of the change and the worn tiles
+    EPD_REFRESH_FAST,       // EPD_Init_Fast + EPD_Display_Fast
+    EPD_REFRESH_FULL,       // EPD_Init + EPD_Display
+} EPD_RefreshMode_t;
+
+// Ghosting budget
+typedef struct {
+    uint16_t max_partial_per_tile;  // Partial refreshes a tile may take before it needs a cleaning waveform
+    uint16_t max_fast_between_full; // Fast refreshes allowed between two full refreshes (0 disables fast mode)
+    uint16_t partial_max_permille;  // Largest changed-pixel ratio (per mille) still sent as a partial refresh
+    uint32_t full_interval_ms;      // Force a full refresh after this long (0 disables)
+    uint8_t fast_mode;              // Fast_Seconds_1_5s or Fast_Seconds_1_s
+} EPD_PolicyConfig_t;
+
+#define EPD_POLICY_CONFIG_DEFAULT() {                                                   \
+    .max_partial_per_tile = CONFIG_CROWPANEL_EPAPER_POLICY_MAX_PARTIAL,               \
+    .max_fast_between_full = CONFIG_CROWPANEL_EPAPER_POLICY_MAX_FAST,                 \
+    .partial_max_permille = CONFIG_CROWPANEL_EPAPER_POLICY_PARTIAL_MAX_PERMILLE,      \
+    .full_interval_ms = CONFIG_CROWPANEL_EPAPER_POLICY_FULL_INTERVAL_S * 1000UL,      \
+    .fast_mode = Fast_Seconds_1_5s,                                                   \
+}
+
+// What the policy saw in the last decision
+typedef struct {
+    uint32_t changed_pixels;        // Popcount of (shadow XOR frame)
+    uint16_t changed_permille;      // changed_pixels relative to the whole frame
+    EPD_Rect_t dirty;               // Bounding box of the change, X widened to bytes
+    uint16_t dirty_tiles;           // Tiles with at least one changed pixel
+    uint16_t max_tile_partials;     // Highest partial count among the dirty tiles
+    uint16_t hot_tiles;             // Dirty tiles over their heat map budget
+    EPD_Rect_t clean;               // Area cleaned by EPD_REFRESH_CLEAN, whole tiles
+    uint16_t fast_since_full;
+    uint32_t ms_since_full;
+} EPD_PolicyStats_t;
+
+esp_err_t EPD_Policy_Init(const EPD_PolicyConfig_t *config);
+void EPD_Policy_Deinit(void);
+bool EPD_Policy_Ready(void);
+
+// Pick a mode for Image (EPD_FRAME_SIZE bytes) without touching the panel
+EPD_RefreshMode_t EPD_Policy_Decide(const uint8_t *Image, EPD_PolicyStats_t *stats);
+
+// Pick a mode, refresh the panel with it and update the bookkeeping
+EPD_RefreshMode_t EPD_Policy_Present(const uint8_t *Image);
+
+// Make the next present a full refresh (e.g. after the app drove the panel directly)
+void EPD_Policy_ForceFull(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_REFRESH_POLICY_H__
@@ -0,0 +1,70 @@
+#ifndef __EPAPER_RENDER_H__
+#define __EPAPER_RENDER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "epaper_cmdring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parallel band rendering
+//
+// EPD_Render draws a display list (EPD_DrawCmd_t, see epaper_cmdring.h) into
+// Paint on several tasks at once. The canvas is cut into horizontal bands of
+// frame buffer rows; every worker starts with an equal run of bands and, once
+// its own run is empty, steals bands from the far end of another worker's
+// run, so a band full of text does not leave the other core idle. Each band
+// runs the list clipped to the band (EPD_Paint_SetBand), skipping commands
+// whose bounds miss it. Lines, circles, spans and glyphs clip themselves to
+// the band before rasterizing, so all bands together cost about one serial
+// pass, and the frame comes out bit for bit as if the list had run in order
+// on one task.
+//
+// The calling task is worker 0; the others are tasks created by
+// EPD_Render_Init that sleep between frames. EPD_CMD_CALL commands run once
+// per band, on any worker, and must only draw through Paint.
+
+#define EPD_RENDER_MAX_WORKERS 4
+
+typedef struct {
+    uint8_t workers;            // 1..EPD_RENDER_MAX_WORKERS, the caller included
+    uint8_t bands_per_worker;   // Bands each worker starts with; more balance better
+    UBaseType_t priority;       // Helper task priority
+    uint32_t stack_size;        // Helper task stack, bytes
+} EPD_RenderConfig_t;
+
+#define EPD_RENDER_CONFIG_DEFAULT() {                         \
+    .workers = CONFIG_CROWPANEL_EPAPER_RENDER_WORKERS,        \
+    .bands_per_worker = 4,                                    \
+    .priority = 5,                                            \
+    .stack_size = 4096,                                       \
+}
+
+typedef struct {
+    uint32_t frames;
+    uint32_t bands[EPD_RENDER_MAX_WORKERS];     // Bands rendered per worker
+    uint32_t steals;                            // Bands taken from another worker
+} EPD_RenderStats_t;
+
+// config NULL for EPD_RENDER_CONFIG_DEFAULT(); starts workers - 1 helper tasks
+esp_err_t EPD_Render_Init(const EPD_RenderConfig_t *config);
+// Stops the helper tasks; EPD_Render then runs on the caller only
+void EPD_Render_Deinit(void);
+
+// Render count commands into Paint, in order, and return when all bands are
+// done. One caller at a time (the task that owns Paint).
+void EPD_Render(const EPD_DrawCmd_t *cmds, size_t count);
+
+void EPD_Render_GetStats(EPD_RenderStats_t *stats);
+void EPD_Render_ResetStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_RENDER_H__
@@ -0,0 +1,108 @@
+#ifndef __EPAPER_TRACE_H__
+#define __EPAPER_TRACE_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Refresh path tracing
+//
+// With CONFIG_CROWPANEL_EPAPER_TRACE enabled the driver timestamps its phases
+// with esp_timer, keeps the last events in a ring buffer and aggregates
+// count/min/avg/max time plus SPI bytes and transactions per phase. Phases
+// nest (EPD_PHASE_DISPLAY includes its EPD_PHASE_SPI_DATA and EPD_PHASE_BUSY
+// time). With tracing disabled the instrumentation compiles to nothing and
+// the query functions report empty statistics.
+
+typedef enum {
+    EPD_PHASE_INIT = 0,     // EPD_Init
+    EPD_PHASE_INIT_FAST,    // EPD_Init_Fast
+    EPD_PHASE_RESET,        // Hardware reset until BUSY clears
+    EPD_PHASE_CLEAR,        // EPD_Clear / EPD_Clear_R26H
+    EPD_PHASE_DISPLAY,      // EPD_Display
+    EPD_PHASE_DISPLAY_FAST, // EPD_Display_Fast
+    EPD_PHASE_DISPLAY_PART, // EPD_Display_Part
+    EPD_PHASE_OLD_RAM,      // 0x26 sync before a partial update
+    EPD_PHASE_TRANSFORM,    // Logical to panel-native frame conversion
+    EPD_PHASE_BUSY,         // EPD_ReadBusy
+    EPD_PHASE_SPI_CMD,      // Command + parameter writes
+    EPD_PHASE_SPI_DATA,     // RAM data writes
+    EPD_PHASE_SLEEP,        // EPD_Sleep
+    EPD_PHASE_WAKE,         // Reset and restore after EPD_Sleep
+    EPD_PHASE_SEED,         // EPD_Display_Seed
+    EPD_PHASE_DRAW,         // Lines, circles, fills
+    EPD_PHASE_TEXT,         // EPD_ShowChar
+    EPD_PHASE_PICTURE,      // EPD_ShowPicture
+    EPD_PHASE_RENDER,       // EPD_Render, all bands
+    EPD_PHASE_COUNT
+} EPD_TracePhase_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint64_t bytes;         // SPI payload bytes sent inside the phase
+    uint32_t transactions;  // SPI transactions sent inside the phase
+} EPD_TraceStats_t;
+
+typedef struct {
+    int64_t start_us;
+    uint32_t duration_us;
+    uint32_t bytes;
+    uint8_t phase;
+} EPD_TraceEvent_t;
+
+// Open span; lives on the caller's stack
+typedef struct {
+    int64_t start_us;
+    uint64_t bytes;
+    uint32_t transactions;
+} EPD_TraceSpan_t;
+
+#if CONFIG_CROWPANEL_EPAPER_TRACE
+
+void EPD_Trace_Begin(EPD_TraceSpan_t *span);
+void EPD_Trace_End(EPD_TraceSpan_t *span, EPD_TracePhase_t phase);
+void EPD_Trace_CountSpi(size_t bytes);
+// The trace state is not locked: tasks that draw next to the one being
+// traced (render workers) mute themselves. Per task.
+void EPD_Trace_Mute(bool mute);
+
+#define EPD_TRACE_BEGIN(span)       EPD_TraceSpan_t span; EPD_Trace_Begin(&span)
+#define EPD_TRACE_END(span, phase)  EPD_Trace_End(&span, phase)
+#define EPD_TRACE_SPI(bytes)        EPD_Trace_CountSpi(bytes)
+
+void EPD_Trace_Reset(void);
+bool EPD_Trace_GetStats(EPD_TracePhase_t phase, EPD_TraceStats_t *stats);
+// Copy up to max events, oldest first; returns the number copied
+size_t EPD_Trace_GetEvents(EPD_TraceEvent_t *events, size_t max);
+const char *EPD_Trace_PhaseName(EPD_TracePhase_t phase);
+// Log the per-phase table
+void EPD_Trace_Dump(void);
+
+#else
+
+#define EPD_TRACE_BEGIN(span)
+#define EPD_TRACE_END(span, phase)  do { } while (0)
+#define EPD_TRACE_SPI(bytes)        do { } while (0)
+
+static inline void EPD_Trace_Mute(bool mute) { (void)mute; }
+static inline void EPD_Trace_Reset(void) { }
+static inline bool EPD_Trace_GetStats(EPD_TracePhase_t phase, EPD_TraceStats_t *stats) { (void)phase; (void)stats; return false; }
+static inline size_t EPD_Trace_GetEvents(EPD_TraceEvent_t *events, size_t max) { (void)events; (void)max; return 0; }
+static inline const char *EPD_Trace_PhaseName(EPD_TracePhase_t phase) { (void)phase; return ""; }
+static inline void EPD_Trace_Dump(void) { }
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_TRACE_H__
@@ -0,0 +1,70 @@
+#ifndef __EPAPER_WARMBOOT_H__
+#define __EPAPER_WARMBOOT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Warm boot
+//
+// The panel keeps its image through a reset or deep sleep, the controller
+// RAM and the driver's panel mirror do not, so a fresh boot would need
+// EPD_Clear (two RAM fills and a full refresh) before partial updates are
+// safe. Instead the driver keeps a record of the frame the panel shows in
+// RTC memory that survives both: its hash, and a PackBits copy when it fits
+// in CONFIG_CROWPANEL_EPAPER_WARM_BOOT_COPY_SIZE bytes (0 by default, RTC
+// memory is scarce). At boot the frame is
+// restored from the copy, or the application redraws its last screen and
+// the hash confirms it, and EPD_Display_Seed loads it into both RAMs: the
+// first partial update follows without a refresh.
+//
+// The record is saved when the panel goes to sleep (see Kconfig) or by
+// EPD_WarmBoot_Save, and dropped when the next refresh starts, so it never
+// describes a frame the panel does not show. RTC memory is lost with power;
+// keep the record in NVS with EPD_WarmBoot_Record / EPD_WarmBoot_Import to
+// survive that too.
+
+typedef struct {
+    bool valid;                 // A record of the frame the panel shows
+    bool copy;                  // ... with a copy of it, for EPD_WarmBoot_Restore
+    uint32_t hash;              // FNV-1a of the frame
+    uint32_t size;              // Bytes of the record (header and copy)
+} EPD_WarmBootInfo_t;
+
+// Record the frame the panel shows (EPD_Shown): ESP_ERR_INVALID_STATE when
+// the driver does not know it, ESP_OK otherwise, with or without a copy
+esp_err_t EPD_WarmBoot_Save(void);
+
+// Seed the panel from the saved copy; frame (EPD_FRAME_SIZE bytes, may be
+// NULL) receives it too, e.g. the canvas so drawing continues from what is
+// shown. ESP_ERR_NOT_FOUND without a record or when it has no copy,
+// ESP_ERR_INVALID_STATE when frame is NULL and there is no panel mirror to
+// decode into, ESP_ERR_INVALID_CRC when the copy does not match its hash.
+esp_err_t EPD_WarmBoot_Restore(uint8_t *frame);
+
+// Seed the panel from frame, redrawn by the application, if it is the one
+// recorded: ESP_ERR_NOT_FOUND without a record, ESP_ERR_INVALID_CRC when the
+// panel shows something else (refresh it in full then)
+esp_err_t EPD_WarmBoot_Verify(const uint8_t *frame);
+
+// Drop the record; the driver calls it when a refresh starts
+void EPD_WarmBoot_Forget(void);
+
+void EPD_WarmBoot_GetInfo(EPD_WarmBootInfo_t *info);
+
+// The record as bytes (NULL when there is none), and back: Import takes a
+// record from EPD_WarmBoot_Record of the same panel and firmware
+// configuration, ESP_ERR_INVALID_ARG otherwise
+const void *EPD_WarmBoot_Record(size_t *size);
+esp_err_t EPD_WarmBoot_Import(const void *record, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __EPAPER_WARMBOOT_H__
@@ -0,0 +1,82 @@
+# Build-time image assets (see include/epaper_asset.h)
+#
+# ESP-IDF includes this file at project level, so any component can call the
+# function; the host build includes it from the component's CMakeLists.txt.
+#
+# crowpanel_epaper_add_assets(<target>
+#     ASSETS <image>...             PBM (P1/P4) or PNG files
+#     [NAME <name>]                 Output files <name>.c/.h (default epaper_assets)
+#     [PREFIX <prefix>]             Symbol prefix (default asset_)
+#     [ROTATE 0|90|180|270]         Canvas rotation the images are drawn for (default 0)
+#     [FORMAT CANVAS|NATIVE]        Canvas rows (default) or full frames in the panel's RAM layout
+#     [PANEL 4_2|2_13]              Default: the configured panel
+#     [THRESHOLD <0-255>]           PNG luminance below which a pixel is black (default 128)
+#     [COMPRESS])                   PackBits, decoded a row at a time
+#
+# Each image becomes `extern const EPD_Asset_t <prefix><file name>` declared in
+# <name>.h; the generated source is added to <target> and its directory to
+# the include path. Images are converted again whenever they change.
+
+set(CROWPANEL_EPAPER_ASSET_TOOL ${CMAKE_CURRENT_LIST_DIR}/tools/epaper_asset.py)
+
+function(crowpanel_epaper_add_assets target)
+    cmake_parse_arguments(arg "COMPRESS" "NAME;PREFIX;ROTATE;FORMAT;PANEL;THRESHOLD" "ASSETS" ${ARGN})
+    if(NOT arg_ASSETS)
+        message(FATAL_ERROR "crowpanel_epaper_add_assets: no ASSETS given")
+    endif()
+    if(NOT arg_NAME)
+        set(arg_NAME epaper_assets)
+    endif()
+    if(NOT arg_PREFIX)
+        set(arg_PREFIX asset_)
+    endif()
+    if(NOT arg_ROTATE)
+        set(arg_ROTATE 0)
+    endif()
+    if(NOT arg_FORMAT)
+        set(arg_FORMAT CANVAS)
+    endif()
+    if(NOT arg_THRESHOLD)
+        set(arg_THRESHOLD 128)
+    endif()
+    if(NOT arg_PANEL)
+        if(CONFIG_CROWPANEL_EPAPER_2_13_INCH)
+            set(arg_PANEL 2_13)
+        else()
+            set(arg_PANEL 4_2)
+        endif()
+    endif()
+    string(TOLOWER ${arg_FORMAT} format)
+
+    # ESP-IDF's Python environment when available
+    if(python)
+        set(py ${python})
+    else()
+        find_package(Python3 REQUIRED COMPONENTS Interpreter)
+        set(py ${Python3_EXECUTABLE})
+    endif()
+
+    set(images)
+    foreach(image ${arg_ASSETS})
+        get_filename_component(image ${image} ABSOLUTE)
+        list(APPEND images ${image})
+    endforeach()
+
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/${target}_assets/${arg_NAME})
+    set(out_c ${out_dir}/${arg_NAME}.c)
+    set(out_h ${out_dir}/${arg_NAME}.h)
+    set(options --panel ${arg_PANEL} --rotate ${arg_ROTATE} --format ${format} --threshold ${arg_THRESHOLD} --prefix ${arg_PREFIX})
+    if(arg_COMPRESS)
+        list(APPEND options --compress)
+    endif()
+
+    file(MAKE_DIRECTORY ${out_dir})
+    add_custom_command(
+        OUTPUT ${out_c} ${out_h}
+        COMMAND ${py} ${CROWPANEL_EPAPER_ASSET_TOOL} --out-c ${out_c} --out-h ${out_h} ${options} ${images}
+        DEPENDS ${images} ${CROWPANEL_EPAPER_ASSET_TOOL}
+        COMMENT "Converting e-paper assets for ${target}: ${arg_NAME}"
+        VERBATIM)
+    target_sources(${target} PRIVATE ${out_c} ${out_h})
+    target_include_directories(${target} PRIVATE ${out_dir})
+endfunction()
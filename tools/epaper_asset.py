@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""Convert PBM/PNG images into packed 1bpp arrays for the e-paper driver.
+
+Usage: epaper_asset.py --out-c assets.c --out-h assets.h [options] IMAGE...
+
+Each image becomes a `const EPD_Asset_t asset_<file name>` (see
+epaper_asset.h; --prefix changes the asset_ part):
+
+  --format canvas   rows of the canvas memory for --rotate, MSB first,
+                    1 = white: what Paint.Image holds, drawn with
+                    EPD_Asset_Draw (default)
+  --format native   the bytes EPD_Display sends to RAM 0x24 for a full frame
+                    (the 2.13" rotation to its native 122x250 layout is done
+                    here instead of at runtime), sent with EPD_Asset_Display
+
+--rotate is the canvas rotation the image is drawn for; the pixels are laid
+out the way Paint_SetPixel would place them under that rotation. With
+--compress every row is PackBits-encoded on its own, so the driver can
+decode one row at a time.
+
+PBM (P1/P4) is read directly. PNG (8-bit or less per channel, not
+interlaced) is decoded with zlib and thresholded on luminance; transparent
+pixels count as white.
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+import zlib
+
+PANELS = {
+    # name: (EPD_W, EPD_H), controller RAM layout (width, height)
+    "4_2": ((400, 300), (400, 300)),
+    "2_13": ((250, 122), (122, 250)),
+}
+
+
+def read_tokens(data, pos, count):
+    """Read `count` whitespace separated header tokens, skipping comments."""
+    tokens = []
+    while len(tokens) < count:
+        while pos < len(data) and data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            while pos < len(data) and data[pos:pos + 1] not in (b"\n", b"\r"):
+                pos += 1
+            continue
+        start = pos
+        while pos < len(data) and not data[pos:pos + 1].isspace():
+            pos += 1
+        tokens.append(data[start:pos])
+    return tokens, pos
+
+
+def load_pbm(data):
+    """Return (width, height, rows) with rows of 0/1 ints, 1 = black."""
+    magic = data[:2]
+    (w, h), pos = read_tokens(data, 2, 2)
+    w, h = int(w), int(h)
+    if magic == b"P4":
+        pos += 1  # single whitespace after the header
+        stride = (w + 7) // 8
+        if len(data) < pos + stride * h:
+            raise ValueError("truncated P4 data")
+        rows = []
+        for y in range(h):
+            row = data[pos + y * stride:pos + (y + 1) * stride]
+            rows.append([(row[x >> 3] >> (7 - (x & 7))) & 1 for x in range(w)])
+        return w, h, rows
+    if magic == b"P1":
+        bits = [c - 48 for c in data[pos:] if c in (48, 49)]
+        if len(bits) < w * h:
+            raise ValueError("truncated P1 data")
+        return w, h, [bits[y * w:(y + 1) * w] for y in range(h)]
+    raise ValueError("not a P1/P4 PBM file")
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def load_png(data, threshold):
+    """Return (width, height, rows) with rows of 0/1 ints, 1 = black."""
+    if data[:8] != b"\x89PNG\r\n\x1a\n":
+        raise ValueError("not a PNG file")
+    pos, idat, palette, trns = 8, b"", None, None
+    while pos < len(data):
+        length, ctype = struct.unpack(">I4s", data[pos:pos + 8])
+        body = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b"IHDR":
+            w, h, depth, color, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif ctype == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif ctype == b"tRNS":
+            trns = body
+        elif ctype == b"IDAT":
+            idat += body
+        elif ctype == b"IEND":
+            break
+    if interlace:
+        raise ValueError("interlaced PNG is not supported")
+    if depth > 8:
+        raise ValueError("16-bit PNG is not supported")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color]
+    bpp = max(1, channels * depth // 8)
+    stride = (w * channels * depth + 7) // 8
+    raw = zlib.decompress(idat)
+
+    rows, prev = [], bytearray(stride)
+    for y in range(h):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                line[i] = (line[i] + paeth(a, b, c)) & 0xFF
+        prev = line
+
+        if depth < 8:
+            per = 8 // depth
+            mask = (1 << depth) - 1
+            samples = [(line[x // per] >> ((per - 1 - x % per) * depth)) & mask for x in range(w)]
+        else:
+            samples = list(line)
+        out = []
+        for x in range(w):
+            alpha = 255
+            if color == 3:
+                r, g, b = palette[samples[x]]
+                if trns is not None and samples[x] < len(trns):
+                    alpha = trns[samples[x]]
+            elif color in (0, 4):
+                v = samples[x * channels]
+                if depth < 8:
+                    v = v * 255 // ((1 << depth) - 1)
+                r = g = b = v
+                if color == 4:
+                    alpha = samples[x * 2 + 1]
+            else:
+                r, g, b = samples[x * channels:x * channels + 3]
+                if color == 6:
+                    alpha = samples[x * 4 + 3]
+            lum = (299 * r + 587 * g + 114 * b) // 1000
+            out.append(1 if alpha >= 128 and lum < threshold else 0)
+        rows.append(out)
+    return w, h, rows
+
+
+def rotate(w, h, rows, rot):
+    """Lay the logical image out in canvas memory order (Paint_SetPixel)."""
+    if rot == 0:
+        return w, h, rows
+    if rot == 180:
+        return w, h, [list(reversed(r)) for r in reversed(rows)]
+    mw, mh = h, w
+    mem = [[0] * mw for _ in range(mh)]
+    for y in range(h):
+        for x in range(w):
+            if rot == 90:
+                mem[x][mw - y - 1] = rows[y][x]
+            else:  # 270
+                mem[mh - x - 1][y] = rows[y][x]
+    return mw, mh, mem
+
+
+def pack_rows(w, rows):
+    """1bpp rows, MSB first, 1 = white, padding bits white."""
+    out = []
+    for r in rows:
+        b = bytearray((w + 7) // 8)
+        for x in range((w + 7) // 8 * 8):
+            white = x >= w or not r[x]
+            if white:
+                b[x >> 3] |= 0x80 >> (x & 7)
+        out.append(bytes(b))
+    return out
+
+
+def native_rows(panel, w, h, rows):
+    """Rows of the RAM 0x24 image EPD_Display sends for this logical frame."""
+    if panel == "4_2":
+        return pack_rows(w, rows)
+    # 2.13": native 122 x 250, 16 bytes per row, see EPD_Transform_Frame
+    out = []
+    for y_phys in range(250):
+        b = bytearray(16)
+        for x_phys in range(128):
+            white = True
+            if x_phys < 122:
+                white = not rows[x_phys][249 - y_phys]
+            if white:
+                b[x_phys >> 3] |= 0x80 >> (x_phys & 7)
+        out.append(bytes(b))
+    return out
+
+
+def packbits(row):
+    out = bytearray()
+    i = 0
+    while i < len(row):
+        run = 1
+        while i + run < len(row) and run < 128 and row[i + run] == row[i]:
+            run += 1
+        if run >= 2:
+            out += bytes([(257 - run) & 0xFF, row[i]])
+            i += run
+            continue
+        start = i
+        while i < len(row) and i - start < 128:
+            if i + 1 < len(row) and row[i + 1] == row[i]:
+                break
+            i += 1
+        if i == start:  # lone byte before a run
+            i += 1
+        out += bytes([i - start - 1]) + row[start:i]
+    return bytes(out)
+
+
+def symbol(prefix, path):
+    name = os.path.splitext(os.path.basename(path))[0]
+    return prefix + re.sub(r"[^0-9A-Za-z_]", "_", name)
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join(f"0x{b:02X}" for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("images", nargs="+")
+    parser.add_argument("--out-c", required=True)
+    parser.add_argument("--out-h", required=True)
+    parser.add_argument("--panel", choices=sorted(PANELS), default="4_2")
+    parser.add_argument("--rotate", type=int, choices=(0, 90, 180, 270), default=0)
+    parser.add_argument("--format", choices=("canvas", "native"), default="canvas")
+    parser.add_argument("--compress", action="store_true", help="PackBits, one row at a time")
+    parser.add_argument("--prefix", default="asset_", help="symbol prefix (default asset_)")
+    parser.add_argument("--threshold", type=int, default=128,
+                        help="PNG luminance below which a pixel is black (default 128)")
+    args = parser.parse_args()
+
+    header = os.path.basename(args.out_h)
+    guard = re.sub(r"[^0-9A-Za-z]", "_", header).upper()
+    c_out = [f"// Generated by epaper_asset.py, do not edit\n#include \"{header}\"\n"]
+    h_out = [f"// Generated by epaper_asset.py, do not edit\n#ifndef __{guard}__\n#define __{guard}__\n\n",
+             "#include \"epaper_asset.h\"\n\n"]
+
+    names = set()
+    for path in args.images:
+        with open(path, "rb") as f:
+            data = f.read()
+        try:
+            if data[:8] == b"\x89PNG\r\n\x1a\n":
+                w, h, rows = load_png(data, args.threshold)
+            else:
+                w, h, rows = load_pbm(data)
+        except (ValueError, KeyError, zlib.error) as e:
+            sys.exit(f"{path}: {e}")
+
+        mw, mh, mem = rotate(w, h, rows, args.rotate)
+        if args.format == "native":
+            frame, native = PANELS[args.panel]
+            if (mw, mh) != frame:
+                sys.exit(f"{path}: native format needs a full frame, {w}x{h} under rotation "
+                         f"{args.rotate} is {mw}x{mh} in memory, the panel is {frame[0]}x{frame[1]}")
+            packed = native_rows(args.panel, mw, mh, mem)
+            mw, mh = native
+        else:
+            packed = pack_rows(mw, mem)
+
+        raw = b"".join(packed)
+        blob = b"".join(packbits(r) for r in packed) if args.compress else raw
+        name = symbol(args.prefix, path)
+        if name in names:
+            sys.exit(f"{path}: {name} is already taken by another image")
+        names.add(name)
+        c_out.append(f"\n// {os.path.basename(path)}: {w}x{h}, rotate {args.rotate}, "
+                     f"{len(raw)} bytes{' -> %d PackBits' % len(blob) if args.compress else ''}\n")
+        c_out.append(f"static const uint8_t {name}_data[{len(blob)}] = {{\n{c_bytes(blob)}\n}};\n\n")
+        c_out.append(f"const EPD_Asset_t {name} = {{\n"
+                     f"    .data = {name}_data,\n"
+                     f"    .size = {len(blob)},\n"
+                     f"    .raw_size = {len(raw)},\n"
+                     f"    .width = {mw},\n"
+                     f"    .height = {mh},\n"
+                     f"    .rotate = {args.rotate},\n"
+                     f"    .format = {'EPD_ASSET_NATIVE' if args.format == 'native' else 'EPD_ASSET_CANVAS'},\n"
+                     f"    .compression = {'EPD_ASSET_PACKBITS' if args.compress else 'EPD_ASSET_RAW'},\n"
+                     f"}};\n")
+        h_out.append(f"extern const EPD_Asset_t {name};\n")
+
+    h_out.append(f"\n#endif // __{guard}__\n")
+    with open(args.out_c, "w") as f:
+        f.write("".join(c_out))
+    with open(args.out_h, "w") as f:
+        f.write("".join(h_out))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())